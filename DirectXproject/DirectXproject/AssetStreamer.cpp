@@ -0,0 +1,328 @@
+#include "AssetStreamer.h"
+
+#include <algorithm>
+
+#include "MeshFile.h"
+
+AssetStreamer* AssetStreamer::instance = nullptr;
+
+namespace {
+	bool QueueLess(float aPriority, uint64_t aSequence, float bPriority, uint64_t bSequence){
+		if(aPriority != bPriority){
+			return aPriority < bPriority;
+		}
+		// Equal priority loads in request order.
+		return aSequence > bSequence;
+	}
+
+	bool LoadMeshFile(const std::string& path, std::shared_ptr<const void>& data, size_t& size){
+		std::shared_ptr<MeshFile> mesh = std::make_shared<MeshFile>();
+		if(!mesh->Open(path.c_str())){
+			return false;
+		}
+		size = static_cast<size_t>(mesh->GetHeader().fileSize);
+		data = mesh;
+		return true;
+	}
+}
+
+AssetStreamer* AssetStreamer::GetInstance(){
+	if(instance == nullptr){
+		instance = new AssetStreamer();
+	}
+
+	return instance;
+}
+
+AssetStreamer::~AssetStreamer(){
+	Shutdown();
+}
+
+bool AssetStreamer::Init(uint32_t ioThreadCount, size_t budgetBytes){
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(!mIoThreads.empty()){
+		return false;
+	}
+
+	mShuttingDown = false;
+	mBudgetBytes = budgetBytes;
+	ioThreadCount = std::max(ioThreadCount, 1u);
+	for(uint32_t i = 0; i < ioThreadCount; i++){
+		mIoThreads.emplace_back(&AssetStreamer::IoThreadLoop, this);
+	}
+	return true;
+}
+
+void AssetStreamer::Shutdown(){
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShuttingDown = true;
+		mQueue.clear();
+	}
+	mWorkAvailable.notify_all();
+
+	for(std::thread& thread : mIoThreads){
+		thread.join();
+	}
+	mIoThreads.clear();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mAssets.clear();
+	mHandlesByPath.clear();
+	mResidentBytes = 0;
+	mLoadsCompleted = 0;
+	mLoadsFailed = 0;
+	mEvictions = 0;
+}
+
+void AssetStreamer::ForgetIfUnusedLocked(AssetHandle handle){
+	auto found = mAssets.find(handle);
+	if(found == mAssets.end() || found->second.refCount != 0){
+		return;
+	}
+	// A load still in flight finds the handle gone and drops its result.
+	if(found->second.state == AssetState::Unloaded || found->second.state == AssetState::Failed){
+		mHandlesByPath.erase(found->second.path);
+		mAssets.erase(found);
+	}
+}
+
+void AssetStreamer::PushLocked(AssetHandle handle, Asset& asset){
+	mQueue.push_back({ asset.priority, mNextSequence++, handle, asset.generation });
+	std::push_heap(mQueue.begin(), mQueue.end(), [](const QueueEntry& a, const QueueEntry& b){
+		return QueueLess(a.priority, a.sequence, b.priority, b.sequence);
+	});
+}
+
+AssetHandle AssetStreamer::Request(const std::string& path, float priority, AssetLoader loader){
+	std::unique_lock<std::mutex> lock(mMutex);
+	if(mShuttingDown){
+		return kInvalidAsset;
+	}
+
+	AssetHandle handle;
+	auto found = mHandlesByPath.find(path);
+	if(found != mHandlesByPath.end()){
+		handle = found->second;
+	}else{
+		handle = mNextHandle++;
+		mHandlesByPath.emplace(path, handle);
+		Asset& asset = mAssets[handle];
+		asset.path = path;
+		asset.loader = loader ? std::move(loader) : AssetLoader(LoadMeshFile);
+		asset.priority = priority;
+	}
+
+	Asset& asset = mAssets[handle];
+	asset.refCount++;
+	asset.lastUsedFrame = mFrame;
+
+	bool queue = false;
+	if(asset.state == AssetState::Unloaded || asset.state == AssetState::Failed){
+		asset.state = AssetState::Queued;
+		asset.priority = priority;
+		queue = true;
+	}else if(asset.state == AssetState::Queued && priority > asset.priority){
+		asset.priority = priority;
+		queue = true;
+	}
+
+	if(queue){
+		PushLocked(handle, asset);
+		lock.unlock();
+		mWorkAvailable.notify_one();
+	}
+	return handle;
+}
+
+void AssetStreamer::Release(AssetHandle handle){
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mAssets.find(handle);
+	if(found == mAssets.end() || found->second.refCount == 0){
+		return;
+	}
+
+	Asset& asset = found->second;
+	asset.refCount--;
+	if(asset.refCount == 0 && asset.state == AssetState::Queued){
+		// Its heap entry goes stale and is skipped.
+		asset.state = AssetState::Unloaded;
+		asset.generation++;
+	}
+	ForgetIfUnusedLocked(handle);
+	EvictLocked();
+}
+
+void AssetStreamer::Cancel(AssetHandle handle){
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mAssets.find(handle);
+	if(found == mAssets.end()){
+		return;
+	}
+
+	Asset& asset = found->second;
+	asset.refCount = 0;
+	if(asset.state == AssetState::Queued || asset.state == AssetState::Loading){
+		asset.state = AssetState::Unloaded;
+		asset.generation++;
+	}
+	ForgetIfUnusedLocked(handle);
+	EvictLocked();
+}
+
+void AssetStreamer::SetPriority(AssetHandle handle, float priority){
+	std::unique_lock<std::mutex> lock(mMutex);
+	auto found = mAssets.find(handle);
+	if(found == mAssets.end()){
+		return;
+	}
+
+	Asset& asset = found->second;
+	asset.priority = priority;
+	if(asset.state == AssetState::Queued){
+		// Invalidate the old entry and queue under the new priority.
+		asset.generation++;
+		PushLocked(handle, asset);
+		lock.unlock();
+		mWorkAvailable.notify_one();
+	}
+}
+
+AssetState AssetStreamer::GetState(AssetHandle handle) const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mAssets.find(handle);
+	return found == mAssets.end() ? AssetState::Unloaded : found->second.state;
+}
+
+std::shared_ptr<const void> AssetStreamer::Get(AssetHandle handle, const std::shared_ptr<const void>& placeholder){
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mAssets.find(handle);
+	if(found == mAssets.end() || found->second.state != AssetState::Resident){
+		return placeholder;
+	}
+
+	found->second.lastUsedFrame = mFrame;
+	return found->second.data;
+}
+
+void AssetStreamer::Update(){
+	std::lock_guard<std::mutex> lock(mMutex);
+	mFrame++;
+	EvictLocked();
+}
+
+void AssetStreamer::SetBudget(size_t budgetBytes){
+	std::lock_guard<std::mutex> lock(mMutex);
+	mBudgetBytes = budgetBytes;
+	EvictLocked();
+}
+
+AssetStreamerStats AssetStreamer::GetStats() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	AssetStreamerStats stats = {};
+	stats.residentBytes = mResidentBytes;
+	stats.budgetBytes = mBudgetBytes;
+	stats.loadsCompleted = mLoadsCompleted;
+	stats.loadsFailed = mLoadsFailed;
+	stats.evictions = mEvictions;
+	for(const auto& entry : mAssets){
+		switch(entry.second.state){
+			case AssetState::Queued: stats.queued++; break;
+			case AssetState::Loading: stats.loading++; break;
+			case AssetState::Resident: stats.resident++; break;
+			default: break;
+		}
+	}
+	return stats;
+}
+
+void AssetStreamer::EvictLocked(){
+	if(mResidentBytes <= mBudgetBytes){
+		return;
+	}
+
+	// Unreferenced resident assets, oldest first. Anything still referenced
+	// stays even if that leaves us over budget.
+	std::vector<std::pair<uint64_t, AssetHandle>> candidates;
+	for(const auto& entry : mAssets){
+		if(entry.second.state == AssetState::Resident && entry.second.refCount == 0){
+			candidates.push_back({ entry.second.lastUsedFrame, entry.first });
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for(const auto& candidate : candidates){
+		if(mResidentBytes <= mBudgetBytes){
+			break;
+		}
+		Asset& asset = mAssets[candidate.second];
+		mResidentBytes -= asset.size;
+		asset.data.reset();
+		asset.size = 0;
+		asset.state = AssetState::Unloaded;
+		mEvictions++;
+		ForgetIfUnusedLocked(candidate.second);
+	}
+}
+
+void AssetStreamer::IoThreadLoop(){
+	auto heapLess = [](const QueueEntry& a, const QueueEntry& b){
+		return QueueLess(a.priority, a.sequence, b.priority, b.sequence);
+	};
+
+	while(true){
+		AssetHandle handle;
+		uint32_t generation;
+		std::string path;
+		AssetLoader loader;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mWorkAvailable.wait(lock, [this]{ return mShuttingDown || !mQueue.empty(); });
+			if(mShuttingDown){
+				return;
+			}
+
+			std::pop_heap(mQueue.begin(), mQueue.end(), heapLess);
+			QueueEntry entry = mQueue.back();
+			mQueue.pop_back();
+
+			auto found = mAssets.find(entry.handle);
+			if(found == mAssets.end() || found->second.state != AssetState::Queued || found->second.generation != entry.generation){
+				continue;
+			}
+
+			Asset& asset = found->second;
+			asset.state = AssetState::Loading;
+			handle = entry.handle;
+			generation = asset.generation;
+			path = asset.path;
+			loader = asset.loader;
+		}
+
+		std::shared_ptr<const void> data;
+		size_t size = 0;
+		bool loaded = loader(path, data, size);
+
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto found = mAssets.find(handle);
+		if(found == mAssets.end() || found->second.generation != generation || found->second.state != AssetState::Loading){
+			// Cancelled while loading, drop the result.
+			continue;
+		}
+
+		Asset& asset = found->second;
+		if(loaded){
+			asset.state = AssetState::Resident;
+			asset.data = std::move(data);
+			asset.size = size;
+			asset.lastUsedFrame = mFrame;
+			mResidentBytes += size;
+			mLoadsCompleted++;
+			EvictLocked();
+		}else{
+			asset.state = AssetState::Failed;
+			mLoadsFailed++;
+			ForgetIfUnusedLocked(handle);
+		}
+	}
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Loads assets on a small pool of I/O threads, most important first, and
+// keeps the resident set inside a memory budget by evicting the least
+// recently used assets nobody holds. Until an asset arrives, Get hands back
+// the caller's placeholder so rendering never waits on disk. Assets that
+// are neither referenced nor resident are forgotten, their handles then
+// read as Unloaded and a new Request starts over.
+
+using AssetHandle = uint32_t;
+static constexpr AssetHandle kInvalidAsset = 0;
+
+enum class AssetState { Unloaded, Queued, Loading, Resident, Failed };
+
+// Reads path and returns the loaded object and its size in bytes, or false.
+// Runs on an I/O thread.
+using AssetLoader = std::function<bool(const std::string& path, std::shared_ptr<const void>& data, size_t& size)>;
+
+struct AssetStreamerStats {
+	size_t residentBytes;
+	size_t budgetBytes;
+	uint32_t queued;
+	uint32_t loading;
+	uint32_t resident;
+	uint64_t loadsCompleted;
+	uint64_t loadsFailed;
+	uint64_t evictions;
+};
+
+class AssetStreamer {
+public:
+	static AssetStreamer* GetInstance();
+
+	bool Init(uint32_t ioThreadCount, size_t budgetBytes);
+	// Drops queued work, waits for in flight loads and frees everything.
+	void Shutdown();
+
+	// Queues path, or adds a reference if it is already known. priority is
+	// anything where larger means sooner, e.g. screen size or negative
+	// distance. The default loader maps the file as a MeshFile.
+	AssetHandle Request(const std::string& path, float priority, AssetLoader loader = AssetLoader());
+	// Drops a reference. An unreferenced asset stops loading if it had not
+	// started yet and becomes a candidate for eviction once resident.
+	void Release(AssetHandle handle);
+	// Same as dropping every reference and abandoning any in flight load.
+	void Cancel(AssetHandle handle);
+	void SetPriority(AssetHandle handle, float priority);
+
+	AssetState GetState(AssetHandle handle) const;
+	// The loaded data, or placeholder until it is resident. Marks the asset used.
+	std::shared_ptr<const void> Get(AssetHandle handle, const std::shared_ptr<const void>& placeholder = nullptr);
+	template<typename T>
+	std::shared_ptr<const T> Get(AssetHandle handle, const std::shared_ptr<const T>& placeholder = nullptr){
+		return std::static_pointer_cast<const T>(Get(handle, std::static_pointer_cast<const void>(placeholder)));
+	}
+
+	// Once per frame: advances the LRU clock and trims to the budget.
+	void Update();
+	void SetBudget(size_t budgetBytes);
+	AssetStreamerStats GetStats() const;
+
+private:
+	AssetStreamer() = default;
+	~AssetStreamer();
+
+	struct Asset {
+		std::string path;
+		AssetLoader loader;
+		AssetState state = AssetState::Unloaded;
+		float priority = 0.0f;
+		uint32_t refCount = 0;
+		// Bumped on cancel so a load that finishes late is thrown away.
+		uint32_t generation = 0;
+		uint64_t lastUsedFrame = 0;
+		std::shared_ptr<const void> data;
+		size_t size = 0;
+	};
+
+	struct QueueEntry {
+		float priority;
+		uint64_t sequence;
+		AssetHandle handle;
+		uint32_t generation;
+	};
+
+	void IoThreadLoop();
+	void PushLocked(AssetHandle handle, Asset& asset);
+	void EvictLocked();
+	// Erases handle if nothing references it and it holds no data.
+	void ForgetIfUnusedLocked(AssetHandle handle);
+
+	static AssetStreamer* instance;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mWorkAvailable;
+	std::vector<std::thread> mIoThreads;
+	bool mShuttingDown = false;
+
+	std::unordered_map<AssetHandle, Asset> mAssets;
+	std::unordered_map<std::string, AssetHandle> mHandlesByPath;
+	// Binary heap on (priority, -sequence). Entries go stale when the
+	// priority changes or the asset is cancelled and are skipped on pop.
+	std::vector<QueueEntry> mQueue;
+	AssetHandle mNextHandle = 1;
+	uint64_t mNextSequence = 0;
+	uint64_t mFrame = 0;
+
+	size_t mBudgetBytes = 0;
+	size_t mResidentBytes = 0;
+	uint64_t mLoadsCompleted = 0;
+	uint64_t mLoadsFailed = 0;
+	uint64_t mEvictions = 0;
+
+	AssetStreamer(const AssetStreamer&) = delete;
+	AssetStreamer(AssetStreamer&&) = delete;
+	AssetStreamer& operator=(const AssetStreamer&) = delete;
+	AssetStreamer& operator=(AssetStreamer&&) = delete;
+};
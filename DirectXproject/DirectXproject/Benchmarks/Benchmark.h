@@ -0,0 +1,41 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Shared by the benchmark executables. They are built with the tests but
+// not registered with CTest, run them by hand on a quiet machine:
+//   ./Benchmarks/FrustumCullingBenchmark
+
+// Best of repeats runs of func in milliseconds, after one warm-up run. The
+// best run is the one least disturbed by the rest of the machine.
+template<typename Func>
+double MeasureMilliseconds(int repeats, Func func){
+	typedef std::chrono::high_resolution_clock Clock;
+	func();
+	double best = 1e30;
+	for(int i = 0; i < repeats; i++){
+		Clock::time_point start = Clock::now();
+		func();
+		best = std::min(best, std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+	}
+	return best;
+}
+
+// Keeps a result alive so the optimizer can't drop the work behind it:
+// its address escapes and memory counts as read.
+template<typename T>
+void KeepAlive(const T& value){
+#if defined(_MSC_VER)
+	// No inline assembly on x64, a volatile store escapes the address.
+	static const void* volatile sink;
+	sink = &value;
+	_ReadWriteBarrier();
+#else
+	asm volatile("" : : "g"(&value) : "memory");
+#endif
+}
@@ -0,0 +1,96 @@
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawPacket.h"
+#include "JobSystem.h"
+
+// SortDrawPackets from 1K to 1M packets spread over 1, 4 and 8 streams,
+// then the state changes the translation loop records for the same packets
+// unsorted and sorted, counted with a sink that records nothing.
+
+namespace {
+	struct CountingSink {
+		uint32_t calls = 0;
+
+		uint32_t GetRootSignature(PipelineHandle pipeline) { return pipeline / 4; }
+		void SetRootSignature(uint32_t) { calls++; }
+		void SetPipeline(PipelineHandle) { calls++; }
+		void SetVertexBuffer(BufferHandle) { calls++; }
+		void SetIndexBuffer(BufferHandle) { calls++; }
+		void SetConstantBuffer(PipelineHandle, BufferHandle, uint32_t) { calls++; }
+		void SetRootConstants(PipelineHandle, uint32_t, const uint32_t*) { calls++; }
+		void Draw(const DrawPacket&) { calls++; }
+		void DrawIndexed(const DrawPacket&) { calls++; }
+	};
+
+	// Packets in emit order, round robin over the streams the way several
+	// recording threads would fill them.
+	void MakeStreams(uint32_t count, uint32_t streamCount, std::vector<DrawPacketStream>& streams){
+		streams.assign(streamCount, DrawPacketStream());
+		uint32_t state = 12345;
+		auto next = [&state](uint32_t range){
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) % range;
+		};
+		for(uint32_t i = 0; i < count; i++){
+			DrawKeyFields fields = {};
+			fields.pipeline = next(16);
+			fields.material = next(256);
+			fields.mesh = next(1024);
+			fields.depth = next(kDrawKeyMaxDepth + 1);
+
+			DrawPacket& packet = streams[i % streamCount].Emit(EncodeDrawKey(fields));
+			packet.pipeline = static_cast<PipelineHandle>(fields.pipeline);
+			packet.vertexBuffer = static_cast<BufferHandle>(fields.mesh);
+			packet.indexBuffer = static_cast<BufferHandle>(fields.mesh);
+			packet.constantBuffer = 0;
+			packet.constantOffset = 256 * fields.material;
+			packet.count = 36;
+		}
+	}
+
+	uint32_t CountStateChanges(const DrawPacketStream& stream){
+		DrawPacketState state;
+		state.Invalidate();
+		DrawPacketStats stats = {};
+		CountingSink sink;
+		TranslateDrawPackets(stream.GetPackets(), stream.GetCount(), state, stats, sink);
+		return stats.rootSignatureChanges + stats.pipelineChanges + stats.vertexBufferChanges +
+			stats.indexBufferChanges + stats.constantBufferChanges + stats.rootConstantChanges;
+	}
+}
+
+int main(){
+	printf("%u workers\n\n", JobSystem::GetInstance()->GetWorkerCount());
+	printf("%9s %8s %10s %10s %14s %14s\n", "packets", "streams", "sort ms", "ns/packet", "changes before", "changes after");
+	const uint32_t counts[] = { 1000, 10000, 100000, 1000000 };
+	const uint32_t streamCounts[] = { 1, 4, 8 };
+	std::vector<DrawPacketStream> streams;
+	DrawList order;
+	DrawPacketStream sorted;
+	for(uint32_t count : counts){
+		for(uint32_t streamCount : streamCounts){
+			MakeStreams(count, streamCount, streams);
+			const int repeats = count >= 1000000 ? 5 : 20;
+			const double sort = MeasureMilliseconds(repeats, [&](){
+				SortDrawPackets(streams.data(), streamCount, order, sorted);
+				KeepAlive(sorted);
+			});
+
+			// Before is what a single stream would record in emit order.
+			uint32_t before = 0;
+			if(streamCount == 1){
+				before = CountStateChanges(streams[0]);
+			}
+			const uint32_t after = CountStateChanges(sorted);
+			if(streamCount == 1){
+				printf("%9u %8u %10.3f %10.1f %14u %14u\n", count, streamCount, sort, sort * 1e6 / count, before, after);
+			}else{
+				printf("%9u %8u %10.3f %10.1f %14s %14u\n", count, streamCount, sort, sort * 1e6 / count, "", after);
+			}
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,154 @@
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "EntityWorld.h"
+#include "RenderComponents.h"
+
+// EntityWorld against the array of game objects it replaced, where every
+// object carries all of its data in one struct. Times the two loops the
+// renderer runs every frame, gathering world bounds and moving transforms,
+// and the cost of structural changes: create, add and remove a component,
+// destroy.
+
+namespace {
+	struct Velocity {
+		float x, y, z;
+	};
+
+	// The array-of-structs layout: hot render data interleaved with the
+	// gameplay state a typical object carries along.
+	struct SceneObject {
+		Float4x4 world;
+		Float4x4 local;
+		BoundsComponent bounds;
+		RenderableComponent renderable;
+		Velocity velocity;
+		uint32_t flags;
+		float health;
+		char name[32];
+	};
+
+	void FillWorld(EntityWorld& world, uint32_t count){
+		for(uint32_t i = 0; i < count; i++){
+			world.CreateEntity(TransformComponent{ Float4x4::Translation(static_cast<float>(i % 1000), static_cast<float>(i / 1000), 0.0f) },
+				BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.5f }, RenderableComponent{ 0, 0, 3, 0, 0, 0, DrawPass::Opaque }, Velocity{ 0.01f, 0.0f, 0.0f });
+		}
+	}
+
+	void FillObjects(std::vector<SceneObject>& objects, uint32_t count){
+		objects.resize(count);
+		for(uint32_t i = 0; i < count; i++){
+			SceneObject& object = objects[i];
+			object = SceneObject();
+			object.world = Float4x4::Translation(static_cast<float>(i % 1000), static_cast<float>(i / 1000), 0.0f);
+			object.local = object.world;
+			object.bounds = BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.5f };
+			object.renderable = RenderableComponent{ 0, 0, 3, 0, 0, 0, DrawPass::Opaque };
+			object.velocity = Velocity{ 0.01f, 0.0f, 0.0f };
+		}
+	}
+}
+
+int main(){
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	printf("sizeof(SceneObject) %zu, ECS touches %zu bytes per object for bounds\n\n",
+		sizeof(SceneObject), sizeof(TransformComponent) + sizeof(BoundsComponent));
+
+	printf("%-8s %-22s %10s %10s\n", "count", "loop", "ECS ms", "AoS ms");
+	for(uint32_t count : counts){
+		EntityWorld world;
+		FillWorld(world, count);
+		std::vector<SceneObject> objects;
+		FillObjects(objects, count);
+
+		// Gathering world space spheres, as GatherRenderBounds does.
+		SphereBoundsSoA bounds;
+		std::vector<Entity> entities;
+		bounds.Reserve(count);
+		entities.reserve(count);
+		double ecsBounds = MeasureMilliseconds(10, [&]{ GatherRenderBounds(world, bounds, entities); KeepAlive(bounds); });
+		double aosBounds = MeasureMilliseconds(10, [&]{
+			bounds.Clear();
+			for(const SceneObject& object : objects){
+				if(object.renderable.vertexCount == 0){
+					continue;
+				}
+				const float (&m)[4][4] = object.world.m;
+				const float* c = object.bounds.center;
+				const float center[3] = {
+					c[0] * m[0][0] + c[1] * m[1][0] + c[2] * m[2][0] + m[3][0],
+					c[0] * m[0][1] + c[1] * m[1][1] + c[2] * m[2][1] + m[3][1],
+					c[0] * m[0][2] + c[1] * m[1][2] + c[2] * m[2][2] + m[3][2]
+				};
+				bounds.Add(center, object.bounds.radius);
+			}
+			KeepAlive(bounds);
+		});
+		printf("%-8u %-22s %10.3f %10.3f\n", count, "gather bounds", ecsBounds, aosBounds);
+
+		// Moving every object by its velocity.
+		double ecsMove = MeasureMilliseconds(10, [&]{
+			world.ForEachChunk<TransformComponent, Velocity>([](uint32_t n, const Entity*, TransformComponent* transforms, Velocity* velocities){
+				for(uint32_t i = 0; i < n; i++){
+					transforms[i].world.m[3][0] += velocities[i].x;
+					transforms[i].world.m[3][1] += velocities[i].y;
+					transforms[i].world.m[3][2] += velocities[i].z;
+				}
+			});
+		});
+		double aosMove = MeasureMilliseconds(10, [&]{
+			for(SceneObject& object : objects){
+				object.world.m[3][0] += object.velocity.x;
+				object.world.m[3][1] += object.velocity.y;
+				object.world.m[3][2] += object.velocity.z;
+			}
+			KeepAlive(objects);
+		});
+		printf("%-8u %-22s %10.3f %10.3f\n", count, "move transforms", ecsMove, aosMove);
+	}
+
+	// Structural changes. The array only ever appends and swap-removes, it
+	// has no notion of adding a component, so only the ECS side has numbers.
+	printf("\n%-8s %-22s %10s %14s\n", "count", "operation", "ms", "ns/entity");
+	for(uint32_t count : counts){
+		std::vector<Entity> entities(count);
+		double create = 0.0;
+		double add = 0.0;
+		double remove = 0.0;
+		double destroy = 0.0;
+		typedef std::chrono::high_resolution_clock Clock;
+		const int kRepeats = 5;
+		for(int repeat = 0; repeat < kRepeats; repeat++){
+			EntityWorld world;
+			Clock::time_point start = Clock::now();
+			for(uint32_t i = 0; i < count; i++){
+				entities[i] = world.CreateEntity(TransformComponent{ Float4x4::Identity() }, BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.5f });
+			}
+			Clock::time_point created = Clock::now();
+			for(uint32_t i = 0; i < count; i++){
+				world.AddComponent(entities[i], Velocity{ 1.0f, 0.0f, 0.0f });
+			}
+			Clock::time_point added = Clock::now();
+			for(uint32_t i = 0; i < count; i++){
+				world.RemoveComponent<Velocity>(entities[i]);
+			}
+			Clock::time_point removed = Clock::now();
+			for(uint32_t i = 0; i < count; i++){
+				world.DestroyEntity(entities[i]);
+			}
+			Clock::time_point destroyed = Clock::now();
+
+			create += std::chrono::duration<double, std::milli>(created - start).count() / kRepeats;
+			add += std::chrono::duration<double, std::milli>(added - created).count() / kRepeats;
+			remove += std::chrono::duration<double, std::milli>(removed - added).count() / kRepeats;
+			destroy += std::chrono::duration<double, std::milli>(destroyed - removed).count() / kRepeats;
+		}
+		printf("%-8u %-22s %10.3f %14.1f\n", count, "create", create, create * 1e6 / count);
+		printf("%-8u %-22s %10.3f %14.1f\n", count, "add component", add, add * 1e6 / count);
+		printf("%-8u %-22s %10.3f %14.1f\n", count, "remove component", remove, remove * 1e6 / count);
+		printf("%-8u %-22s %10.3f %14.1f\n", count, "destroy", destroy, destroy * 1e6 / count);
+	}
+	return 0;
+}
@@ -0,0 +1,88 @@
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "CpuFeatures.h"
+#include "FrustumCulling.h"
+#include "MathBatch.h"
+
+// CullSpheres and CullAabbs over 10k, 100k and 1M objects on every kernel
+// the CPU has. Counts past 16k also split across the JobSystem workers.
+
+namespace {
+	struct Random {
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high){
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * static_cast<float>(state >> 8) / 16777216.0f;
+		}
+	};
+
+	Frustum MakePerspectiveFrustum(){
+		const float nearZ = 0.1f;
+		const float farZ = 100.0f;
+		Float4x4 projection = {};
+		projection.m[0][0] = 1.0f / (16.0f / 9.0f);
+		projection.m[1][1] = 1.0f;
+		projection.m[2][2] = farZ / (farZ - nearZ);
+		projection.m[2][3] = 1.0f;
+		projection.m[3][2] = -nearZ * farZ / (farZ - nearZ);
+		return Frustum::FromViewProjection(&projection.m[0][0]);
+	}
+
+	const char* GetPathName(CullPath path){
+		switch(path){
+			case CullPath::Scalar: return "Scalar";
+			case CullPath::SSE: return "SSE";
+			case CullPath::AVX2: return "AVX2";
+			default: return "Auto";
+		}
+	}
+
+	bool IsSupported(CullPath path){
+		const CpuFeatures& features = CpuFeatures::Get();
+		#if defined(CPU_X86)
+		return path == CullPath::Scalar || (path == CullPath::SSE && features.sse41) || (path == CullPath::AVX2 && features.avx2);
+		#else
+		(void)features;
+		return path == CullPath::Scalar;
+		#endif
+	}
+}
+
+int main(){
+	const Frustum frustum = MakePerspectiveFrustum();
+	const uint32_t counts[] = { 10000, 100000, 1000000 };
+	const CullPath paths[] = { CullPath::Scalar, CullPath::SSE, CullPath::AVX2 };
+
+	printf("%-8s %-7s %-7s %10s %12s %10s\n", "bounds", "count", "path", "ms", "ns/object", "visible");
+	for(uint32_t count : counts){
+		Random random(count);
+		SphereBoundsSoA spheres;
+		AabbBoundsSoA boxes;
+		spheres.Reserve(count);
+		boxes.Reserve(count);
+		for(uint32_t i = 0; i < count; i++){
+			float center[3] = { random.Next(-120.0f, 120.0f), random.Next(-120.0f, 120.0f), random.Next(-20.0f, 120.0f) };
+			spheres.Add(center, random.Next(0.0f, 4.0f));
+			float boxMax[3] = { center[0] + random.Next(0.0f, 8.0f), center[1] + random.Next(0.0f, 8.0f), center[2] + random.Next(0.0f, 8.0f) };
+			boxes.Add(center, boxMax);
+		}
+
+		std::vector<uint32_t> visible;
+		visible.reserve(count);
+		for(CullPath path : paths){
+			if(!IsSupported(path)){
+				continue;
+			}
+			double sphereMs = MeasureMilliseconds(20, [&]{ CullSpheres(frustum, spheres, visible, path); KeepAlive(visible); });
+			printf("%-8s %-7u %-7s %10.3f %12.2f %10zu\n", "sphere", count, GetPathName(path), sphereMs, sphereMs * 1e6 / count, visible.size());
+			double boxMs = MeasureMilliseconds(20, [&]{ CullAabbs(frustum, boxes, visible, path); KeepAlive(visible); });
+			printf("%-8s %-7u %-7s %10.3f %12.2f %10zu\n", "aabb", count, GetPathName(path), boxMs, boxMs * 1e6 / count, visible.size());
+		}
+	}
+	return 0;
+}
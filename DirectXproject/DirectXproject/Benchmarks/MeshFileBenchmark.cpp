@@ -0,0 +1,128 @@
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "MeshFile.h"
+
+// Load time of a cooked mesh: MeshFile maps the file and checks the header,
+// against reading the whole file into memory with fread. Both then touch
+// every page of the vertex and index streams, as the upload copy would.
+// The file stays in the OS cache between runs, so this measures the load
+// path, not the disk.
+
+namespace {
+	const char* kBenchmarkPath = "MeshFileBenchmark.mesh";
+
+	bool WriteGrid(uint32_t size){
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+		for(uint32_t y = 0; y <= size; y++){
+			for(uint32_t x = 0; x <= size; x++){
+				positions.push_back(static_cast<float>(x));
+				positions.push_back(static_cast<float>(y));
+				positions.push_back(0.0f);
+			}
+		}
+		for(uint32_t y = 0; y < size; y++){
+			for(uint32_t x = 0; x < size; x++){
+				uint32_t a = y * (size + 1) + x;
+				uint32_t c = a + size + 1;
+				indices.insert(indices.end(), { a, a + 1, c + 1, a, c + 1, c });
+			}
+		}
+
+		MeshFileDesc desc;
+		desc.vertices = reinterpret_cast<const uint8_t*>(positions.data());
+		desc.vertexCount = static_cast<uint32_t>(positions.size() / 3);
+		desc.format.ComputeLayout();
+		desc.indices = indices.data();
+		desc.indexCount = static_cast<uint32_t>(indices.size());
+		desc.positions = positions.data();
+		return WriteMeshFile(kBenchmarkPath, desc);
+	}
+
+	uint32_t TouchPages(const uint8_t* data, size_t size){
+		uint32_t sum = 0;
+		for(size_t i = 0; i < size; i += 4096){
+			sum += data[i];
+		}
+		return sum;
+	}
+
+	uint32_t LoadMapped(){
+		MeshFile mesh;
+		if(!mesh.Open(kBenchmarkPath)){
+			return 0;
+		}
+		return TouchPages(mesh.GetVertexData(), mesh.GetVertexDataSize()) + TouchPages(mesh.GetIndexData(), mesh.GetIndexDataSize());
+	}
+
+	uint32_t LoadRead(std::vector<uint8_t>& bytes){
+		FILE* file = fopen(kBenchmarkPath, "rb");
+		if(!file){
+			return 0;
+		}
+		fseek(file, 0, SEEK_END);
+		bytes.resize(static_cast<size_t>(ftell(file)));
+		fseek(file, 0, SEEK_SET);
+		const size_t read = fread(bytes.data(), 1, bytes.size(), file);
+		fclose(file);
+
+		MeshFileHeader header;
+		if(read != bytes.size() || read < sizeof(header)){
+			return 0;
+		}
+		memcpy(&header, bytes.data(), sizeof(header));
+		if(header.magic != kMeshFileMagic || header.fileSize != read){
+			return 0;
+		}
+		return TouchPages(bytes.data() + header.vertexOffset, static_cast<size_t>(header.vertexSize))
+			+ TouchPages(bytes.data() + header.indexOffset, static_cast<size_t>(header.indexSize));
+	}
+}
+
+int main(){
+	const uint32_t sizes[] = { 32, 256, 1024, 2048 };
+
+	printf("%-10s %10s %12s %12s %12s\n", "vertices", "file KB", "header ms", "map ms", "fread ms");
+	for(uint32_t size : sizes){
+		if(!WriteGrid(size)){
+			printf("Can't write %s\n", kBenchmarkPath);
+			return 1;
+		}
+
+		MeshFile probe;
+		probe.Open(kBenchmarkPath);
+		const uint32_t vertexCount = probe.GetHeader().vertexCount;
+		const uint64_t fileSize = probe.GetHeader().fileSize;
+		probe.Close();
+
+		const double header = MeasureMilliseconds(20, [](){
+			MeshFile mesh;
+			KeepAlive(mesh.Open(kBenchmarkPath));
+		});
+		uint32_t mappedSum = 0;
+		const double mapped = MeasureMilliseconds(20, [&](){
+			mappedSum = LoadMapped();
+			KeepAlive(mappedSum);
+		});
+		std::vector<uint8_t> bytes;
+		uint32_t readSum = 0;
+		const double read = MeasureMilliseconds(20, [&](){
+			readSum = LoadRead(bytes);
+			KeepAlive(readSum);
+		});
+		if(mappedSum != readSum){
+			printf("Loads disagree\n");
+			return 1;
+		}
+
+		printf("%-10u %10llu %12.3f %12.3f %12.3f\n", vertexCount, static_cast<unsigned long long>(fileSize / 1024), header, mapped, read);
+	}
+
+	remove(kBenchmarkPath);
+	return 0;
+}
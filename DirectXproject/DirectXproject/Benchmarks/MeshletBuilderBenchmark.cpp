@@ -0,0 +1,68 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "MeshletBuilder.h"
+
+// BuildMeshlets on grids from 8K to 2M triangles, in mesh order and with
+// the triangles shuffled. Reports build speed and how full the meshlets
+// come out, since every half empty meshlet costs a mesh shader group.
+
+namespace {
+	void MakeGrid(uint32_t size, bool shuffle, std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		for(uint32_t y = 0; y <= size; y++){
+			for(uint32_t x = 0; x <= size; x++){
+				positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+			}
+		}
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for(uint32_t y = 0; y < size; y++){
+			for(uint32_t x = 0; x < size; x++){
+				uint32_t a = y * (size + 1) + x;
+				uint32_t c = a + size + 1;
+				triangles.push_back({ a, c + 1, a + 1 });
+				triangles.push_back({ a, c, c + 1 });
+			}
+		}
+		uint32_t state = 12345;
+		for(size_t i = triangles.size(); shuffle && i > 1; i--){
+			state = state * 1664525u + 1013904223u;
+			std::swap(triangles[i - 1], triangles[(state >> 8) % i]);
+		}
+		for(const std::array<uint32_t, 3>& triangle : triangles){
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+}
+
+int main(){
+	const uint32_t sizes[] = { 64, 256, 1024 };
+
+	printf("%-10s %-9s %10s %10s %10s %10s %10s\n", "triangles", "order", "ms", "Mtri/s", "meshlets", "verts/m", "tris/m");
+	for(uint32_t size : sizes){
+		for(int shuffle = 0; shuffle < 2; shuffle++){
+			std::vector<float> positions;
+			std::vector<uint32_t> indices;
+			MakeGrid(size, shuffle != 0, positions, indices);
+			const size_t triangleCount = indices.size() / 3;
+
+			MeshletMesh mesh;
+			const double milliseconds = MeasureMilliseconds(size >= 1024 ? 3 : 10, [&](){
+				BuildMeshlets(positions.data(), positions.size() / 3, sizeof(float) * 3, indices.data(), indices.size(), mesh);
+				KeepAlive(mesh);
+			});
+
+			const double meshlets = static_cast<double>(mesh.meshlets.size());
+			printf("%-10zu %-9s %10.2f %10.2f %10zu %10.1f %10.1f\n", triangleCount, shuffle ? "shuffled" : "mesh",
+				milliseconds, triangleCount / 1e3 / milliseconds, mesh.meshlets.size(),
+				mesh.vertices.size() / meshlets, mesh.triangles.size() / meshlets);
+		}
+	}
+	printf("\nlimits: %u vertices, %u triangles\n", kMeshletMaxVertices, kMeshletMaxTriangles);
+	return 0;
+}
@@ -0,0 +1,132 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "JobSystem.h"
+#include "SoftwareOcclusion.h"
+
+// Occluder rasterization and the occludee test, scalar against AVX2, over
+// buffer sizes and occluder triangle counts. The scene is a field of boxes
+// in front of a perspective camera: the near ones occlude, and the
+// occludees are spread through the whole volume.
+
+namespace {
+	Float4x4 Perspective(float fovY, float aspect, float nearZ, float farZ){
+		Float4x4 m;
+		memset(&m, 0, sizeof(m));
+		const float yScale = 1.0f / tanf(fovY * 0.5f);
+		m.m[0][0] = yScale / aspect;
+		m.m[1][1] = yScale;
+		m.m[2][2] = farZ / (farZ - nearZ);
+		m.m[2][3] = 1.0f;
+		m.m[3][2] = -nearZ * farZ / (farZ - nearZ);
+		return m;
+	}
+
+	float Random(uint32_t& state){
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / 16777216.0f;
+	}
+
+	// Closed boxes, 12 triangles each, clockwise seen from outside.
+	void MakeBoxes(uint32_t boxCount, std::vector<Float3>& positions, std::vector<uint32_t>& indices){
+		const uint32_t faces[12][3] = {
+			{ 0, 2, 3 }, { 0, 3, 1 }, { 4, 5, 7 }, { 4, 7, 6 }, { 0, 1, 5 }, { 0, 5, 4 },
+			{ 2, 6, 7 }, { 2, 7, 3 }, { 0, 4, 6 }, { 0, 6, 2 }, { 1, 3, 7 }, { 1, 7, 5 }
+		};
+		uint32_t state = 1234;
+		for(uint32_t b = 0; b < boxCount; b++){
+			const float center[3] = { (Random(state) - 0.5f) * 60.0f, (Random(state) - 0.5f) * 30.0f, 5.0f + 40.0f * Random(state) };
+			const float extent = 0.5f + 2.0f * Random(state);
+			const uint32_t base = static_cast<uint32_t>(positions.size());
+			for(int corner = 0; corner < 8; corner++){
+				positions.push_back({ center[0] + ((corner & 1) ? extent : -extent), center[1] + ((corner & 2) ? extent : -extent),
+					center[2] + ((corner & 4) ? extent : -extent) });
+			}
+			for(const uint32_t* face : faces){
+				indices.insert(indices.end(), { base + face[0], base + face[1], base + face[2] });
+			}
+		}
+	}
+}
+
+int main(){
+	const Float4x4 projection = Perspective(1.0f, 2.0f, 0.5f, 200.0f);
+	const bool hasAvx2 = GetBestOcclusionPath() == OcclusionPath::AVX2;
+	printf("%u workers%s\n\n", JobSystem::GetInstance()->GetWorkerCount(), hasAvx2 ? "" : ", no AVX2");
+
+	const uint32_t sizes[][2] = { { 256, 128 }, { 512, 256 }, { 1024, 512 } };
+	const uint32_t occluderBoxes[] = { 100, 1000, 10000 };
+
+	printf("%-10s %10s %12s %12s\n", "buffer", "triangles", "scalar ms", "AVX2 ms");
+	for(const uint32_t* size : sizes){
+		for(uint32_t boxCount : occluderBoxes){
+			std::vector<Float3> positions;
+			std::vector<uint32_t> indices;
+			MakeBoxes(boxCount, positions, indices);
+			const OccluderMesh mesh = { positions.data(), static_cast<uint32_t>(positions.size()), indices.data(),
+				static_cast<uint32_t>(indices.size()), Float4x4::Identity(), false };
+
+			double milliseconds[2] = { 0.0, 0.0 };
+			for(int p = 0; p < (hasAvx2 ? 2 : 1); p++){
+				SoftwareOcclusion occlusion;
+				occlusion.Resize(size[0], size[1]);
+				occlusion.SetPath(p ? OcclusionPath::AVX2 : OcclusionPath::Scalar);
+				milliseconds[p] = MeasureMilliseconds(10, [&](){
+					occlusion.BeginFrame(projection);
+					occlusion.AddOccluder(mesh);
+					occlusion.RasterizeOccluders();
+					KeepAlive(occlusion);
+				});
+			}
+			char buffer[32];
+			snprintf(buffer, sizeof(buffer), "%ux%u", size[0], size[1]);
+			printf("%-10s %10zu %12.3f %12.3f\n", buffer, indices.size() / 3, milliseconds[0], milliseconds[1]);
+		}
+	}
+
+	// Occludees against the 512x256 buffer with 1000 occluder boxes.
+	std::vector<Float3> positions;
+	std::vector<uint32_t> indices;
+	MakeBoxes(1000, positions, indices);
+	const OccluderMesh mesh = { positions.data(), static_cast<uint32_t>(positions.size()), indices.data(),
+		static_cast<uint32_t>(indices.size()), Float4x4::Identity(), false };
+
+	printf("\n%-10s %12s %12s %10s\n", "occludees", "scalar ms", "AVX2 ms", "culled");
+	const uint32_t occludeeCounts[] = { 10000, 100000, 1000000 };
+	for(uint32_t count : occludeeCounts){
+		AabbBoundsSoA boxes;
+		boxes.Reserve(count);
+		std::vector<uint32_t> candidates(count);
+		uint32_t state = 99;
+		for(uint32_t i = 0; i < count; i++){
+			const float center[3] = { (Random(state) - 0.5f) * 60.0f, (Random(state) - 0.5f) * 30.0f, 10.0f + 150.0f * Random(state) };
+			const float extent = 0.2f + Random(state);
+			const float boxMin[3] = { center[0] - extent, center[1] - extent, center[2] - extent };
+			const float boxMax[3] = { center[0] + extent, center[1] + extent, center[2] + extent };
+			candidates[i] = boxes.Add(boxMin, boxMax);
+		}
+
+		double milliseconds[2] = { 0.0, 0.0 };
+		size_t visibleCount = 0;
+		for(int p = 0; p < (hasAvx2 ? 2 : 1); p++){
+			SoftwareOcclusion occlusion;
+			occlusion.Resize(512, 256);
+			occlusion.SetPath(p ? OcclusionPath::AVX2 : OcclusionPath::Scalar);
+			occlusion.BeginFrame(projection);
+			occlusion.AddOccluder(mesh);
+			occlusion.RasterizeOccluders();
+			std::vector<uint32_t> visible;
+			milliseconds[p] = MeasureMilliseconds(10, [&](){
+				occlusion.CullOccludees(boxes, candidates.data(), count, visible);
+				KeepAlive(visible);
+			});
+			visibleCount = visible.size();
+		}
+		printf("%-10u %12.3f %12.3f %9.1f%%\n", count, milliseconds[0], milliseconds[1], 100.0 * (count - visibleCount) / count);
+	}
+	return 0;
+}
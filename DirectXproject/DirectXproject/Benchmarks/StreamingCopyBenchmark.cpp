@@ -0,0 +1,63 @@
+#include "Benchmark.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "StreamingCopy.h"
+
+// StreamCopy on each path against memcpy, from 64 B to 64 MB. The
+// destination is ordinary cached memory, there is no write combined
+// mapping outside a GPU driver, so up to the cache size memcpy keeps the
+// destination hot and is expected to win. Small sizes repeat the copy
+// over fresh offsets of a 64 MB buffer, which is closer to filling an
+// upload heap than copying to one place over and over.
+
+namespace {
+	const size_t kBufferSize = 64u << 20;
+
+	double MeasureGigabytesPerSecond(size_t size, std::vector<uint8_t>& destination, const std::vector<uint8_t>& source,
+		void(*copy)(void*, const void*, size_t, CopyPath), CopyPath path){
+		const size_t copies = kBufferSize / size;
+		const double milliseconds = MeasureMilliseconds(size >= (16u << 20) ? 5 : 10, [&](){
+			for(size_t i = 0; i < copies; i++){
+				copy(destination.data() + i * size, source.data() + i * size, size, path);
+			}
+			StreamFence();
+			KeepAlive(destination);
+		});
+		return static_cast<double>(copies * size) / (milliseconds * 1e6);
+	}
+
+	void Memcpy(void* destination, const void* source, size_t size, CopyPath){
+		memcpy(destination, source, size);
+	}
+}
+
+int main(){
+	std::vector<uint8_t> source(kBufferSize);
+	std::vector<uint8_t> destination(kBufferSize);
+	for(size_t i = 0; i < kBufferSize; i++){
+		source[i] = static_cast<uint8_t>(i * 7);
+	}
+
+	printf("Auto is %s\n\n", GetBestCopyPath() == CopyPath::AVX2 ? "AVX2" : GetBestCopyPath() == CopyPath::SSE2 ? "SSE2" : "Scalar");
+	printf("%10s %12s %12s %12s %12s\n", "size", "memcpy GB/s", "SSE2 GB/s", "AVX2 GB/s", "Auto GB/s");
+	for(size_t size = 64; size <= kBufferSize; size *= 4){
+		// The fenced copy is what callers use for one large block, many
+		// small ones go without the fence.
+		auto stream = size >= 4096 ? StreamCopy : StreamCopyNoFence;
+		const double plain = MeasureGigabytesPerSecond(size, destination, source, Memcpy, CopyPath::Scalar);
+		const double sse2 = MeasureGigabytesPerSecond(size, destination, source, stream, CopyPath::SSE2);
+		const double avx2 = MeasureGigabytesPerSecond(size, destination, source, stream, CopyPath::AVX2);
+		const double best = MeasureGigabytesPerSecond(size, destination, source, stream, CopyPath::Auto);
+		if(size >= (1u << 20)){
+			printf("%7zu MB %12.2f %12.2f %12.2f %12.2f\n", size >> 20, plain, sse2, avx2, best);
+		}else if(size >= 1024){
+			printf("%7zu KB %12.2f %12.2f %12.2f %12.2f\n", size >> 10, plain, sse2, avx2, best);
+		}else{
+			printf("%8zu B %12.2f %12.2f %12.2f %12.2f\n", size, plain, sse2, avx2, best);
+		}
+	}
+	return 0;
+}
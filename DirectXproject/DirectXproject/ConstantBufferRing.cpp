@@ -0,0 +1,62 @@
+#include "ConstantBufferRing.h"
+
+#include "d3dx12.h"
+
+#include "Helpers.h"
+#include "StreamingCopy.h"
+
+using namespace Microsoft::WRL;
+
+ConstantBufferRing::ConstantBufferRing() :mCpuAddress(nullptr), mGpuAddress(0) {
+
+}
+
+ConstantBufferRing::~ConstantBufferRing() {
+	if(mBuffer){
+		UnregisterWriteCombined(mCpuAddress);
+		mBuffer->Unmap(0, nullptr);
+	}
+}
+
+void ConstantBufferRing::Init(ComPtr<ID3D12Device2> device, uint32_t size){
+	size = GetStride(size);
+
+	ThrowIfFailed(device->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mBuffer)));
+
+	// Upload heaps may stay mapped while the GPU reads them. The CPU never
+	// reads back, the memory is write combined.
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(mBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mCpuAddress)));
+	RegisterWriteCombined(mCpuAddress, size);
+	mGpuAddress = mBuffer->GetGPUVirtualAddress();
+
+	mRing.Init(size);
+}
+
+void ConstantBufferRing::BeginFrame(uint64_t completedFenceValue){
+	mRing.Retire(completedFenceValue);
+}
+
+void ConstantBufferRing::EndFrame(uint64_t fenceValue){
+	mRing.EndFrame(fenceValue);
+}
+
+bool ConstantBufferRing::Allocate(uint32_t elementSize, uint32_t count, ConstantAllocation& allocation){
+	const uint32_t stride = GetStride(elementSize);
+	uint64_t offset;
+	if(count == 0 || !mRing.Allocate(static_cast<uint64_t>(stride) * count, Alignment, offset)){
+		return false;
+	}
+
+	allocation.cpuAddress = mCpuAddress + offset;
+	allocation.gpuAddress = mGpuAddress + offset;
+	allocation.offset = static_cast<uint32_t>(offset);
+	allocation.stride = stride;
+	return true;
+}
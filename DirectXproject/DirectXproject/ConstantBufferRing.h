@@ -0,0 +1,49 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+
+#include "RingAllocator.h"
+
+// Slots handed out by ConstantBufferRing::Allocate. Slot i starts at
+// cpuAddress + i * stride on the CPU and gpuAddress + i * stride on the GPU.
+struct ConstantAllocation {
+	uint8_t* cpuAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress;
+	// Byte offset of the first slot from the start of the ring.
+	uint32_t offset;
+	uint32_t stride;
+};
+
+// Upload heap buffer for constants rewritten every frame. It stays mapped
+// for its whole life and is sub-allocated with RingAllocator, so writing a
+// draw's constants is a copy into memory the GPU reads directly, with no Map
+// or heap allocation per draw. Every slot is aligned for use as a CBV.
+class ConstantBufferRing {
+public:
+	static const uint32_t Alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+	ConstantBufferRing();
+	~ConstantBufferRing();
+
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t size);
+
+	// Frees the slots of frames the GPU has finished. Call before allocating.
+	void BeginFrame(uint64_t completedFenceValue);
+	// Slots allocated this frame stay valid until fenceValue completes.
+	void EndFrame(uint64_t fenceValue);
+
+	// count contiguous slots of elementSize bytes each. Returns false when
+	// the GPU still holds too much of the ring.
+	bool Allocate(uint32_t elementSize, uint32_t count, ConstantAllocation& allocation);
+
+	inline D3D12_GPU_VIRTUAL_ADDRESS GetGpuAddress() const { return mGpuAddress; }
+	static inline uint32_t GetStride(uint32_t elementSize) { return (elementSize + Alignment - 1) & ~(Alignment - 1); }
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	uint8_t* mCpuAddress;
+	D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress;
+	RingAllocator mRing;
+};
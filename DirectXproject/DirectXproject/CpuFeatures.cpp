@@ -0,0 +1,66 @@
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(CPU_X86)
+#include <cpuid.h>
+#endif
+
+namespace {
+	#if defined(CPU_X86)
+	void CpuId(int leaf, int subLeaf, unsigned int regs[4]){
+		#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, leaf, subLeaf);
+		for(int i = 0; i < 4; i++){
+			regs[i] = static_cast<unsigned int>(info[i]);
+		}
+		#else
+		__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+		#endif
+	}
+
+	// AVX state has to be enabled by the OS, not just supported by the CPU.
+	bool OsSavesYmmRegisters(){
+		#if defined(_MSC_VER)
+		return (_xgetbv(0) & 0x6) == 0x6;
+		#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (eax & 0x6) == 0x6;
+		#endif
+	}
+	#endif
+
+	CpuFeatures Detect(){
+		CpuFeatures features;
+
+		#if defined(CPU_X86)
+		unsigned int regs[4] = {};
+		CpuId(0, 0, regs);
+		const unsigned int maxLeaf = regs[0];
+
+		CpuId(1, 0, regs);
+		features.sse41 = (regs[2] & (1u << 19)) != 0;
+		const bool osxsave = (regs[2] & (1u << 27)) != 0;
+		const bool avx = (regs[2] & (1u << 28)) != 0;
+		const bool fma = (regs[2] & (1u << 12)) != 0;
+
+		if(maxLeaf >= 7 && osxsave && avx && OsSavesYmmRegisters()){
+			CpuId(7, 0, regs);
+			features.avx2 = (regs[1] & (1u << 5)) != 0;
+			features.fma = fma;
+		}
+		#elif defined(CPU_ARM)
+		// NEON is part of the base AArch64 instruction set.
+		features.neon = true;
+		#endif
+
+		return features;
+	}
+}
+
+const CpuFeatures& CpuFeatures::Get(){
+	static const CpuFeatures features = Detect();
+	return features;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+// Instruction sets usable by the SIMD kernels, detected once at startup so
+// a single binary can pick the widest path the machine supports.
+struct CpuFeatures {
+	bool sse41 = false;
+	bool avx2 = false;
+	bool fma = false;
+	bool neon = false;
+
+	static const CpuFeatures& Get();
+};
+
+// Architecture of the build, the kernels for other architectures compile out.
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define CPU_ARM 1
+#endif
+
+// MSVC lets any function use any intrinsic. GCC and Clang need the function
+// itself marked with the instruction set it was written for. FMA is left
+// out on purpose so the compiler never fuses a kernel's multiply and add,
+// which keeps the SIMD paths bit-identical to the scalar ones.
+#if defined(__GNUC__) && defined(CPU_X86)
+#define SIMD_TARGET_SSE41 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define SIMD_TARGET_SSE41
+#define SIMD_TARGET_AVX2
+#endif
@@ -1,19 +1,19 @@
-#include "Cube.h"
-
-using namespace DirectX;
-
-Cube::Cube(){
-	// Refused to work any other way 
-	g_Vertices[0] = { XMFLOAT3(-1.0f, -1.0f, -1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f) }; // 0
-	g_Vertices[1] = { XMFLOAT3(-1.0f,  1.0f, -1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) }; // 1
-	g_Vertices[2] = { XMFLOAT3(1.0f,  1.0f, -1.0f), XMFLOAT3(1.0f, 1.0f, 0.0f) }; // 2
-	g_Vertices[3] = { XMFLOAT3(1.0f, -1.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) }; // 3
-	g_Vertices[4] = { XMFLOAT3(-1.0f, -1.0f,  1.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) }; // 4
-	g_Vertices[5] = { XMFLOAT3(-1.0f,  1.0f,  1.0f), XMFLOAT3(0.0f, 1.0f, 1.0f) }; // 5
-	g_Vertices[6] = { XMFLOAT3(1.0f,  1.0f,  1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) }; // 6
-	g_Vertices[7] = { XMFLOAT3(1.0f, -1.0f,  1.0f), XMFLOAT3(1.0f, 0.0f, 1.0f) }; // 7
-}
-
-Cube::~Cube(){
-
-}
+#include "Cube.h"
+
+using namespace DirectX;
+
+Cube::Cube(){
+	// Refused to work any other way 
+	g_Vertices[0] = { XMFLOAT3(-1.0f, -1.0f, -1.0f), XMFLOAT3(0.0f, 0.0f, 0.0f) }; // 0
+	g_Vertices[1] = { XMFLOAT3(-1.0f,  1.0f, -1.0f), XMFLOAT3(0.0f, 1.0f, 0.0f) }; // 1
+	g_Vertices[2] = { XMFLOAT3(1.0f,  1.0f, -1.0f), XMFLOAT3(1.0f, 1.0f, 0.0f) }; // 2
+	g_Vertices[3] = { XMFLOAT3(1.0f, -1.0f, -1.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) }; // 3
+	g_Vertices[4] = { XMFLOAT3(-1.0f, -1.0f,  1.0f), XMFLOAT3(0.0f, 0.0f, 1.0f) }; // 4
+	g_Vertices[5] = { XMFLOAT3(-1.0f,  1.0f,  1.0f), XMFLOAT3(0.0f, 1.0f, 1.0f) }; // 5
+	g_Vertices[6] = { XMFLOAT3(1.0f,  1.0f,  1.0f), XMFLOAT3(1.0f, 1.0f, 1.0f) }; // 6
+	g_Vertices[7] = { XMFLOAT3(1.0f, -1.0f,  1.0f), XMFLOAT3(1.0f, 0.0f, 1.0f) }; // 7
+}
+
+Cube::~Cube(){
+
+}
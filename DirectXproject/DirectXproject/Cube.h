@@ -1,63 +1,63 @@
-#pragma once
-
-#include <wrl.h>
-
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
-
-class Cube {
-public:
-	Cube();
-	~Cube();
-
-private:
-	// Vertex buffer for the cube.
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_VertexBuffer;
-	D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;
-	// Index buffer for the cube.
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_IndexBuffer;
-	D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
-
-	// Depth buffer.
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthBuffer;
-	// Descriptor heap for depth buffer.
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DSVHeap;
-	// Root signature
-	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
-
-	// Pipeline state object.
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
-
-	D3D12_VIEWPORT m_Viewport;
-	D3D12_RECT m_ScissorRect;
-
-	float m_FoV;
-
-	DirectX::XMMATRIX m_ModelMatrix;
-	DirectX::XMMATRIX m_ViewMatrix;
-	DirectX::XMMATRIX m_ProjectionMatrix;
-
-	bool m_ContentLoaded;
-
-
-	// Vertex data for a colored cube.
-	struct VertexPosColor
-	{
-		DirectX::XMFLOAT3 Position;
-		DirectX::XMFLOAT3 Color;
-	};
-
-	VertexPosColor g_Vertices[8];
-	inline static WORD g_Indicies[36] =
-	{
-		0, 1, 2, 0, 2, 3,
-		4, 6, 5, 4, 7, 6,
-		4, 5, 1, 4, 1, 0,
-		3, 2, 6, 3, 6, 7,
-		1, 5, 6, 1, 6, 2,
-		4, 0, 3, 4, 3, 7
-	};
-};
-
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <d3dcompiler.h>
+#include <DirectXMath.h>
+
+class Cube {
+public:
+	Cube();
+	~Cube();
+
+private:
+	// Vertex buffer for the cube.
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_VertexBuffer;
+	D3D12_VERTEX_BUFFER_VIEW m_VertexBufferView;
+	// Index buffer for the cube.
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_IndexBuffer;
+	D3D12_INDEX_BUFFER_VIEW m_IndexBufferView;
+
+	// Depth buffer.
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_DepthBuffer;
+	// Descriptor heap for depth buffer.
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_DSVHeap;
+	// Root signature
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> m_RootSignature;
+
+	// Pipeline state object.
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> m_PipelineState;
+
+	D3D12_VIEWPORT m_Viewport;
+	D3D12_RECT m_ScissorRect;
+
+	float m_FoV;
+
+	DirectX::XMMATRIX m_ModelMatrix;
+	DirectX::XMMATRIX m_ViewMatrix;
+	DirectX::XMMATRIX m_ProjectionMatrix;
+
+	bool m_ContentLoaded;
+
+
+	// Vertex data for a colored cube.
+	struct VertexPosColor
+	{
+		DirectX::XMFLOAT3 Position;
+		DirectX::XMFLOAT3 Color;
+	};
+
+	VertexPosColor g_Vertices[8];
+	inline static WORD g_Indicies[36] =
+	{
+		0, 1, 2, 0, 2, 3,
+		4, 6, 5, 4, 7, 6,
+		4, 5, 1, 4, 1, 0,
+		3, 2, 6, 3, 6, 7,
+		1, 5, 6, 1, 6, 2,
+		4, 0, 3, 4, 3, 7
+	};
+};
+
@@ -0,0 +1,72 @@
+#include "DeferredReleaseQueue.h"
+
+#include <algorithm>
+
+DeferredReleaseQueue::DeferredReleaseQueue() : mIncoming(nullptr), mFenceValue(0), mPendingCount(0) {
+
+}
+
+DeferredReleaseQueue::~DeferredReleaseQueue(){
+	Flush();
+}
+
+void DeferredReleaseQueue::Defer(std::function<void()> release){
+	Node* node = new Node();
+	node->release = std::move(release);
+	node->fenceValue = mFenceValue.load(std::memory_order_acquire);
+	mPendingCount.fetch_add(1, std::memory_order_relaxed);
+
+	node->next = mIncoming.load(std::memory_order_relaxed);
+	while(!mIncoming.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)){
+	}
+}
+
+void DeferredReleaseQueue::Collect(){
+	Node* stack = mIncoming.exchange(nullptr, std::memory_order_acquire);
+
+	// The stack is newest first, flip it onto the end of the pending list.
+	size_t first = mPending.size();
+	for(Node* node = stack; node != nullptr; node = node->next){
+		mPending.push_back(node);
+	}
+	std::reverse(mPending.begin() + first, mPending.end());
+}
+
+void DeferredReleaseQueue::Run(Node* node){
+	if(node->release){
+		node->release();
+	}
+	delete node;
+	mPendingCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+uint32_t DeferredReleaseQueue::Retire(uint64_t completedFenceValue){
+	Collect();
+
+	// Threads tag with whatever fence value they saw, so the list is only
+	// mostly sorted. Keep the ones still in flight in their order.
+	uint32_t released = 0;
+	size_t kept = 0;
+	for(size_t i = 0; i < mPending.size(); i++){
+		Node* node = mPending[i];
+		if(node->fenceValue <= completedFenceValue){
+			Run(node);
+			released++;
+		}else{
+			mPending[kept++] = node;
+		}
+	}
+	mPending.resize(kept);
+	return released;
+}
+
+uint32_t DeferredReleaseQueue::Flush(){
+	Collect();
+
+	uint32_t released = static_cast<uint32_t>(mPending.size());
+	for(Node* node : mPending){
+		Run(node);
+	}
+	mPending.clear();
+	return released;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Holds on to objects the GPU may still be using until a fence says it is
+// done with them, so freeing mid-run never needs a full GPU wait. Any thread
+// can defer a release, the render thread retires them once per frame.
+//
+// Defer tags the release with the fence value of the frame currently being
+// recorded, set with SetFenceValue. The caller has to stop referencing the
+// object in new work first, anything submitted up to that frame is covered.
+// Only the fence values matter here, so the queue runs against a fake fence
+// as well as an ID3D12Fence.
+class DeferredReleaseQueue {
+public:
+	DeferredReleaseQueue();
+	~DeferredReleaseQueue();
+
+	// Any thread. release runs on the retiring thread, destroying it is part
+	// of the release too: capturing a ComPtr by value is enough to keep the
+	// object alive until then.
+	void Defer(std::function<void()> release);
+
+	// Render thread. fenceValue is what the next Signal will write.
+	inline void SetFenceValue(uint64_t fenceValue) { mFenceValue.store(fenceValue, std::memory_order_release); }
+	inline uint64_t GetFenceValue() const { return mFenceValue.load(std::memory_order_acquire); }
+
+	// Render thread. Runs every release whose fence value is at most
+	// completedFenceValue, in the order they were deferred. Returns how many ran.
+	uint32_t Retire(uint64_t completedFenceValue);
+	// Runs everything left, once the GPU is idle.
+	uint32_t Flush();
+
+	// Deferred and not run yet, from any thread.
+	inline uint32_t GetPendingCount() const { return mPendingCount.load(std::memory_order_relaxed); }
+
+private:
+	struct Node {
+		std::function<void()> release;
+		uint64_t fenceValue;
+		Node* next;
+	};
+
+	void Collect();
+	void Run(Node* node);
+
+	// Producers push onto this stack with a compare exchange. The consumer
+	// takes the whole stack in one exchange, so popping has no ABA problem.
+	std::atomic<Node*> mIncoming;
+	std::atomic<uint64_t> mFenceValue;
+	std::atomic<uint32_t> mPendingCount;
+	// Consumer only, oldest first.
+	std::vector<Node*> mPending;
+
+	DeferredReleaseQueue(const DeferredReleaseQueue&) = delete;
+	DeferredReleaseQueue& operator=(const DeferredReleaseQueue&) = delete;
+};
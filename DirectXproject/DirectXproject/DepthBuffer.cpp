@@ -0,0 +1,87 @@
+#include "DepthBuffer.h"
+
+#include "d3dx12.h"
+
+#include <algorithm>
+
+#include "Helpers.h"
+
+using namespace Microsoft::WRL;
+
+void ApplyGeometryPass(D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, GeometryPass pass, DXGI_FORMAT depthFormat){
+	desc.DSVFormat = depthFormat;
+	desc.DepthStencilState = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	desc.DepthStencilState.StencilEnable = FALSE;
+
+	switch(pass){
+		case GeometryPass::DepthAndColor:
+			desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+			break;
+		case GeometryPass::DepthOnly:
+			// No pixel shader and no color target, the rasterizer only writes depth.
+			desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS;
+			desc.PS = {};
+			desc.NumRenderTargets = 0;
+			std::fill(std::begin(desc.RTVFormats), std::end(desc.RTVFormats), DXGI_FORMAT_UNKNOWN);
+			break;
+		case GeometryPass::ColorAfterDepth:
+			// Depth is final already. EQUAL keeps only the front most fragment
+			// and without writes the depth buffer can stay compressed.
+			desc.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_EQUAL;
+			desc.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO;
+			break;
+	}
+}
+
+DepthBuffer::DepthBuffer() :mWidth(0), mHeight(0) {
+
+}
+
+DepthBuffer::~DepthBuffer() {
+
+}
+
+void DepthBuffer::Init(ComPtr<ID3D12Device2> device, uint32_t width, uint32_t height){
+	mDevice = device;
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = 1;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+	ThrowIfFailed(mDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&mDsvHeap)));
+
+	Resize(width, height);
+}
+
+void DepthBuffer::Resize(uint32_t width, uint32_t height){
+	// A minimized window reports zero, keep at least one texel.
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+	if(mResource && width == mWidth && height == mHeight){
+		return;
+	}
+
+	mResource.Reset();
+	mWidth = width;
+	mHeight = height;
+
+	D3D12_CLEAR_VALUE clearValue = {};
+	clearValue.Format = Format;
+	clearValue.DepthStencil = { 1.0f, 0 };
+
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_TYPELESS, width, height, 1, 1, 1, 0,
+		D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL);
+	ThrowIfFailed(mDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+		D3D12_RESOURCE_STATE_DEPTH_WRITE, &clearValue, IID_PPV_ARGS(&mResource)));
+
+	D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
+	dsvDesc.Format = Format;
+	dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
+	dsvDesc.Flags = D3D12_DSV_FLAG_NONE;
+	mDevice->CreateDepthStencilView(mResource.Get(), &dsvDesc, mDsvHeap->GetCPUDescriptorHandleForHeapStart());
+}
+
+void DepthBuffer::Clear(ID3D12GraphicsCommandList* commandList, float depth){
+	commandList->ClearDepthStencilView(GetDsv(), D3D12_CLEAR_FLAG_DEPTH, depth, 0, 0, nullptr);
+}
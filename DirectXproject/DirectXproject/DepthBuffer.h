@@ -0,0 +1,51 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <cstdint>
+
+// Which part of the frame a graphics pipeline is built for. With a depth
+// pre-pass the scene is drawn twice: DepthOnly lays down depth without a
+// pixel shader, then ColorAfterDepth shades only the fragments whose depth
+// matches, so each pixel runs the pixel shader about once.
+enum class GeometryPass {
+	DepthAndColor,
+	DepthOnly,
+	ColorAfterDepth
+};
+
+// Turns a color pipeline description into the variant used by pass.
+// depthFormat is the format of the bound DepthBuffer.
+void ApplyGeometryPass(D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, GeometryPass pass, DXGI_FORMAT depthFormat);
+
+// Depth target sized with the swap chain. Lives in its own DSV heap and
+// is recreated by Resize whenever the back buffers are.
+class DepthBuffer {
+public:
+	static const DXGI_FORMAT Format = DXGI_FORMAT_D32_FLOAT;
+	// The resource is typeless so occlusion culling can read it through this.
+	static const DXGI_FORMAT SrvFormat = DXGI_FORMAT_R32_FLOAT;
+
+	DepthBuffer();
+	~DepthBuffer();
+
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, uint32_t width, uint32_t height);
+	// The GPU must be done with the old buffer.
+	void Resize(uint32_t width, uint32_t height);
+
+	void Clear(ID3D12GraphicsCommandList* commandList, float depth = 1.0f);
+
+	inline D3D12_CPU_DESCRIPTOR_HANDLE GetDsv() const { return mDsvHeap->GetCPUDescriptorHandleForHeapStart(); }
+	inline ID3D12Resource* GetResource() const { return mResource.Get(); }
+	inline uint32_t GetWidth() const { return mWidth; }
+	inline uint32_t GetHeight() const { return mHeight; }
+
+private:
+	uint32_t mWidth;
+	uint32_t mHeight;
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mResource;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDsvHeap;
+};
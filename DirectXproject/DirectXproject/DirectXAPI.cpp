@@ -1,488 +1,1050 @@
-#include "DirectXAPI.h"
-
-
-#include "d3dx12.h"
-#include <d3dcompiler.h>
-
-// STL Headers
-#include <algorithm>
-#include <cassert>
-#include <iostream>
-// My headers
-#include "RenderEngine.h"
-#include "Helpers.h"
-
-// The min/max macros conflict with like-named member functions.
-// Only use std::min and std::max defined in <algorithm>.
-#if defined(min)
-#undef min
-#endif
-#if defined(max)
-#undef max
-#endif
-
-
-using namespace Microsoft::WRL;
-
-DirectXAPI* DirectXAPI::instance = nullptr;
-
-DirectXAPI* DirectXAPI::GetInstance(){
-	if(instance == nullptr){
-		instance = new DirectXAPI();
-	}
-
-	return instance;
-}
-
-void DirectXAPI::EnableDebugLayer(){
-	#if defined(_DEBUG)
-		// Always enable the debug layer before doing anything DX12 related
-		// so all possible errors generated while creating DX12 objects
-		// are caught by the debug layer.
-	ComPtr<ID3D12Debug> debugInterface;
-	ThrowIfFailed(D3D12GetDebugInterface(IID_PPV_ARGS(&debugInterface)));
-	debugInterface->EnableDebugLayer();
-	#endif
-}
-
-ComPtr<IDXGIAdapter4> DirectXAPI::GetAdapter(bool useWarp){
-	ComPtr<IDXGIFactory4> dxgiFactory;
-	UINT createFactoryFlags = 0;
-	#if defined(_DEBUG)
-	createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
-	#endif
-
-	ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory)));
-	ComPtr<IDXGIAdapter1> dxgiAdapter1;
-	ComPtr<IDXGIAdapter4> dxgiAdapter4;
-
-	if(useWarp){
-		ThrowIfFailed(dxgiFactory->EnumWarpAdapter(IID_PPV_ARGS(&dxgiAdapter1)));
-		ThrowIfFailed(dxgiAdapter1.As(&dxgiAdapter4));
-	}else{
-		SIZE_T maxDedicatedVideoMemory = 0;
-		for(UINT i = 0; dxgiFactory->EnumAdapters1(i, &dxgiAdapter1) != DXGI_ERROR_NOT_FOUND; ++i){
-			DXGI_ADAPTER_DESC1 dxgiAdapterDesc1;
-			dxgiAdapter1->GetDesc1(&dxgiAdapterDesc1);
-
-			// Check to see if the adapter can create a D3D12 device without actually 
-			// creating it. The adapter with the largest dedicated video memory
-			// is favored.
-			if((dxgiAdapterDesc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0 &&
-				SUCCEEDED(D3D12CreateDevice(dxgiAdapter1.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr)) &&
-				dxgiAdapterDesc1.DedicatedVideoMemory > maxDedicatedVideoMemory) {
-				maxDedicatedVideoMemory = dxgiAdapterDesc1.DedicatedVideoMemory;
-				ThrowIfFailed(dxgiAdapter1.As(&dxgiAdapter4));
-			}
-		}
-	}
-
-	return dxgiAdapter4;
-}
-
-ComPtr<ID3D12Device2> DirectXAPI::CreateDevice(ComPtr<IDXGIAdapter4> adapter){
-	ComPtr<ID3D12Device2> d3d12Device2;
-	ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3d12Device2)));
-
-	// Enable debug messages in debug mode.
-	#if defined(_DEBUG)
-	ComPtr<ID3D12InfoQueue> pInfoQueue;
-	if(SUCCEEDED(d3d12Device2.As(&pInfoQueue))){
-		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
-		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
-		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, TRUE);
-		// Suppress whole categories of messages
-		//D3D12_MESSAGE_CATEGORY Categories[] = {};
-
-		// Suppress messages based on their severity level
-		D3D12_MESSAGE_SEVERITY Severities[] =
-		{
-			D3D12_MESSAGE_SEVERITY_INFO
-		};
-
-		// Suppress individual messages by their ID
-		D3D12_MESSAGE_ID DenyIds[] = {
-			D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
-			D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
-			D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
-		};
-
-		D3D12_INFO_QUEUE_FILTER NewFilter = {};
-		//NewFilter.DenyList.NumCategories = _countof(Categories);
-		//NewFilter.DenyList.pCategoryList = Categories;
-		NewFilter.DenyList.NumSeverities = _countof(Severities);
-		NewFilter.DenyList.pSeverityList = Severities;
-		NewFilter.DenyList.NumIDs = _countof(DenyIds);
-		NewFilter.DenyList.pIDList = DenyIds;
-
-		ThrowIfFailed(pInfoQueue->PushStorageFilter(&NewFilter));
-	}
-	#endif
-
-	return d3d12Device2;
-}
-
-ComPtr<ID3D12CommandQueue> DirectXAPI::CreateCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
-{
-	ComPtr<ID3D12CommandQueue> d3d12CommandQueue;
-
-	D3D12_COMMAND_QUEUE_DESC desc = {};
-	desc.Type = type;
-	desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
-	desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-	desc.NodeMask = 0;
-
-	ThrowIfFailed(device->CreateCommandQueue(&desc, IID_PPV_ARGS(&d3d12CommandQueue)));
-
-	return d3d12CommandQueue;
-}
-
-bool DirectXAPI::CheckTearingSupport(){
-	bool allowTearing = FALSE;
-
-	// Rather than create the DXGI 1.5 factory interface directly, we create the
-	// DXGI 1.4 interface and query for the 1.5 interface. This is to enable the 
-	// graphics debugging tools which will not support the 1.5 factory interface 
-	// until a future update.
-	ComPtr<IDXGIFactory4> factory4;
-	if(SUCCEEDED(CreateDXGIFactory1(IID_PPV_ARGS(&factory4)))){
-		ComPtr<IDXGIFactory5> factory5;
-		if(SUCCEEDED(factory4.As(&factory5))){
-			if(FAILED(factory5->CheckFeatureSupport( DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing)))){
-				allowTearing = FALSE;
-			}
-		}
-	}
-
-	return (allowTearing == TRUE);
-}
-
-ComPtr<IDXGISwapChain4> DirectXAPI::CreateSwapChain(HWND hWnd, ComPtr<ID3D12CommandQueue> commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount){
-	ComPtr<IDXGISwapChain4> dxgiSwapChain4;
-	ComPtr<IDXGIFactory4> dxgiFactory4;
-	UINT createFactoryFlags = 0;
-	#if defined(_DEBUG)
-	createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
-	#endif
-
-	ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory4)));
-
-	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
-	swapChainDesc.Width = width;
-	swapChainDesc.Height = height;
-	swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-	//swapChainDesc.Stereo = FALSE;
-	swapChainDesc.SampleDesc = { 1, 0 };
-	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-	swapChainDesc.BufferCount = bufferCount;
-	swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
-	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
-	swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-	// It is recommended to always allow tearing if tearing support is available.
-	swapChainDesc.Flags = CheckTearingSupport() ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
-
-	ComPtr<IDXGISwapChain1> swapChain1;
-	ThrowIfFailed(dxgiFactory4->CreateSwapChainForHwnd(commandQueue.Get(), hWnd, &swapChainDesc, 0, 0, &swapChain1));
-
-	// Disable the Alt+Enter fullscreen toggle feature. Switching to fullscreen
-	// will be handled manually.
-	ThrowIfFailed(dxgiFactory4->MakeWindowAssociation(hWnd, DXGI_MWA_NO_ALT_ENTER));
-
-	ThrowIfFailed(swapChain1.As(&dxgiSwapChain4));
-
-	dxgiFactory4->Release();
-
-	return dxgiSwapChain4;
-}
-
-ComPtr<ID3D12DescriptorHeap> DirectXAPI::CreateDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors){
-	ComPtr<ID3D12DescriptorHeap> descriptorHeap;
-
-	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
-	desc.NumDescriptors = numDescriptors;
-	desc.Type = type;
-
-	ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptorHeap)));
-
-	mRTVDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(type);
-
-	return descriptorHeap;
-}
-
-void DirectXAPI::UpdateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swapChain, ComPtr<ID3D12DescriptorHeap> descriptorHeap){
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(descriptorHeap->GetCPUDescriptorHandleForHeapStart());
-
-	for(int i = 0; i < mNumFrames; i++){
-		ThrowIfFailed(swapChain->GetBuffer(i, IID_PPV_ARGS(&mRenderTargets[i])));
-
-		device->CreateRenderTargetView(mRenderTargets[i].Get(), nullptr, rtvHandle);
-		// Sets offset I think
-		rtvHandle.Offset(1, mRTVDescriptorSize);
-	}
-}
-
-/*
-	---------Steps to init------
-	Create device
-	*Check feature support*
-	Create command queue allocator
-	Create command queue
-	Create swap chain
-	create RTV(render target view) descriptor heap with front & back buffer count (Swap chain resource rotation no longer automatic)
-	Create command list
-		Create fence
-		Create fence event
-	Create Sampler descriptor heap abd valid Sampler descriptor
-*/
-
-void DirectXAPI::Init(HWND windowhandle, Rect windowRect){
-	/*						Pipeline setup								*/		
-	EnableDebugLayer();
-	// Gets adapter for device creation
-	ComPtr<IDXGIAdapter4> dxgiAdapter4 = GetAdapter(mUseWarp);
-	// Creates Device
-	mDevice = CreateDevice(dxgiAdapter4);
-	
-	// Create command queue
-	mCommandQueue = CreateCommandQueue(mDevice, D3D12_COMMAND_LIST_TYPE_DIRECT);
-
-	// Creates Swap Chain
-	mSwapChain = CreateSwapChain(windowhandle, mCommandQueue, windowRect.x, windowRect.y, mNumFrames);
-
-	// Creates RTV Descriptor Heap
-	mRTVDescriptorHeap = CreateDescriptorHeap(mDevice, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, mNumFrames);
-
-	UpdateRenderTargetViews(mDevice, mSwapChain, mRTVDescriptorHeap);
-
-	// Create Command allocator
-	ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mCommandAllocator)));
-
-	mAspectRatio = static_cast<float>(windowRect.x) / static_cast<float>(windowRect.y);
-	m_viewport = { 0.0f, 0.0f, static_cast<float>(windowRect.x), static_cast<float>(windowRect.y) };
-
-	m_scissorRect.right = static_cast<float>(windowRect.x);
-	m_scissorRect.bottom = static_cast<float>(windowRect.y);
-	mframeIndex = 0;
-
-									// Loads assest for rendering triangle
-	LoadAssets();
-	/*						Init has finished								*/
-	mIsInitialized = true;
-}
-
-void DirectXAPI::Render(){
-	// If window resized then change swap chain too
-	//if(mRequestResize) ResizeSwapChain();
-
-	// Populate command list
-	PopulateCommandList();
-
-	// Execute the command list.
-	ID3D12CommandList* ppCommandLists[] = { mCommandList.Get() };
-	mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
-
-	// Present the frame.
-	ThrowIfFailed(mSwapChain->Present(1, 0));
-	// Wait for frame to finish
-	WaitForPreviousFrame();
-}
-
-void DirectXAPI::Resize(uint32_t width, uint32_t height){
-
-}
-
-void DirectXAPI::WaitForPreviousFrame(){
-	// WAITING FOR THE FRAME TO COMPLETE BEFORE CONTINUING IS NOT BEST PRACTICE.
-	// This is code implemented as such for simplicity. More advanced samples 
-	// illustrate how to use fences for efficient resource usage.
-
-	// Signal and increment the fence value.
-	const UINT64 fence = mFenceValue;
-	ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), fence));
-	mFenceValue++;
-
-	// Wait until the previous frame is finished.
-	if(mFence->GetCompletedValue() < fence){
-		ThrowIfFailed(mFence->SetEventOnCompletion(fence, mFenceEvent));
-		WaitForSingleObject(mFenceEvent, INFINITE);
-	}
-
-	mframeIndex = mSwapChain->GetCurrentBackBufferIndex();
-}
-
-void DirectXAPI::Destroy(){
-	// Wait for the GPU to be done with all resources.
-	WaitForPreviousFrame();
-
-	CloseHandle(mFenceEvent);
-
-}
-
-void DirectXAPI::LoadAssets(){
-	//  compiling and loading shaders.
-	ComPtr<ID3DBlob> vertexShader;
-	ComPtr<ID3DBlob> pixelShader;
-
-	UINT compileFlags = 0;
-	#if defined(_DEBUG)
-			// Enable better shader debugging with the graphics debugging tools.
-		compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
-	#endif
-	ID3DBlob* errorBlob = nullptr;
-	ThrowIfFailed(D3DCompileFromFile(L"shader.hlsl", nullptr, 0, "VSMain", "vs_5_1", compileFlags, 0, &vertexShader, &errorBlob));
-	
-
-	if(errorBlob)
-		{
-			std::cout << ((char*)errorBlob->GetBufferPointer()) << std::endl;
-			errorBlob->Release();
-		}
-
-	ThrowIfFailed(D3DCompileFromFile(L"shader.hlsl", nullptr, 0, "PSMain", "ps_5_1", compileFlags, 0, &pixelShader, &errorBlob));
-
-	if(errorBlob)
-		{
-			std::cout << ((char*)errorBlob->GetBufferPointer()) << std::endl;
-			errorBlob->Release();
-		}
-	
-	// Create an empty root signature.
-	
-	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
-	rootSignatureDesc.Init(0, nullptr, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
-
-	ComPtr<ID3DBlob> signature;
-	ComPtr<ID3DBlob> error;
-	ThrowIfFailed(D3D12SerializeRootSignature(&rootSignatureDesc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error));
-	if(error) {
-		std::cout << ((char*)error->GetBufferPointer()) << std::endl;
-		error->Release();
-	}
-	// Create root signature
-	ThrowIfFailed(mDevice->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&mRootSignature)));
-	
-	// Create the pipeline state
-	
-	// Define the vertex input layout.
-	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
-	};
-
-	// Describe and create the graphics pipeline state object (PSO).
-	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {0};
-	psoDesc.InputLayout = { inputElementDescs, _countof(inputElementDescs) };
-	psoDesc.pRootSignature = mRootSignature.Get();
-	psoDesc.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
-	psoDesc.PS = { reinterpret_cast<UINT8*>(pixelShader->GetBufferPointer()), pixelShader->GetBufferSize() };
-	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
-	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
-	psoDesc.DepthStencilState.DepthEnable = FALSE;
-	psoDesc.DepthStencilState.StencilEnable = FALSE;
-	psoDesc.SampleMask = UINT_MAX;
-	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	psoDesc.NumRenderTargets = 1;
-	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
-	psoDesc.SampleDesc.Count = 1;
-		
-	ThrowIfFailed(mDevice->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(&mPipelineState)));
-
-	// Create the command list.
-	ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mCommandAllocator.Get(), mPipelineState.Get(), IID_PPV_ARGS(&mCommandList)));
-
-	// Command lists are created in the recording state, but there is nothing
-	// to record yet. The main loop expects it to be closed, so close it now.
-	ThrowIfFailed(mCommandList->Close());
-
-	// Create the vertex buffer.
-	{
-		// Define the geometry for a triangle.
-		Vertex triangleVertices[] =
-		{
-			{ { 0.0f, 0.25f * mAspectRatio, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f, 1.0f } },
-			{ { 0.25f, -0.25f * mAspectRatio, 0.0f, 1.0f }, { 0.0f, 1.0f, 0.0f, 1.0f } },
-			{ { -0.25f, -0.25f * mAspectRatio, 0.0f, 1.0f }, { 0.0f, 0.0f, 1.0f, 1.0f } }
-		};
-
-		const UINT vertexBufferSize = sizeof(triangleVertices);
-
-		// Note: using upload heaps to transfer static data like vert buffers is not 
-		// recommended. Every time the GPU needs it, the upload heap will be marshalled 
-		// over. Please read up on Default Heap usage. An upload heap is used here for 
-		// code simplicity and because there are very few verts to actually transfer.
-		ThrowIfFailed(mDevice->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
-			D3D12_HEAP_FLAG_NONE,
-			&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
-			D3D12_RESOURCE_STATE_GENERIC_READ,
-			nullptr,
-			IID_PPV_ARGS(&m_vertexBuffer)));
-
-		// Copy the triangle data to the vertex buffer.
-		UINT8* pVertexDataBegin;
-		CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
-		ThrowIfFailed(m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&pVertexDataBegin)));
-		memcpy(pVertexDataBegin, triangleVertices, sizeof(triangleVertices));
-		m_vertexBuffer->Unmap(0, nullptr);
-
-		// Initialize the vertex buffer view.
-		m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
-		m_vertexBufferView.StrideInBytes = sizeof(Vertex);
-		m_vertexBufferView.SizeInBytes = vertexBufferSize;
-	}
-
-	 // Create synchronization objects and wait until assets have been uploaded to the GPU.
-	{
-		ThrowIfFailed(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
-		mFenceValue = 1;
-
-		// Create an event handle to use for frame synchronization.
-		mFenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-		if(mFenceEvent == nullptr){
-			ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
-		}
-
-		// Wait for the command list to execute; we are reusing the same command 
-		// list in our main loop but for now, we just want to wait for setup to 
-		// complete before continuing.
-		WaitForPreviousFrame();
-	}
-}
-
-void DirectXAPI::PopulateCommandList()
-{
-	// Command list allocators can only be reset when the associated 
-	// command lists have finished execution on the GPU; apps should use 
-	// fences to determine GPU execution progress.
-	ThrowIfFailed(mCommandAllocator->Reset());
-
-	// However, when ExecuteCommandList() is called on a particular command 
-	// list, that command list can then be reset at any time and must be before 
-	// re-recording.
-	ThrowIfFailed(mCommandList->Reset(mCommandAllocator.Get(), mPipelineState.Get()));
-
-	// Set necessary state.
-	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
-	mCommandList->RSSetViewports(1, &m_viewport);
-	mCommandList->RSSetScissorRects(1, &m_scissorRect);
-
-	// Indicate that the back buffer will be used as a render target.
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mframeIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
-
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), mframeIndex, mRTVDescriptorSize);
-	mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, nullptr);
-
-	// Record commands.
-	const float clearColor[] = { 0.8f, 0.2f, 0.4f, 1.0f };
-	mCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
-	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	mCommandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
-	mCommandList->DrawInstanced(3, 1, 0, 0);
-
-	// Indicate that the back buffer will now be used to present.
-	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mframeIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
-
-	ThrowIfFailed(mCommandList->Close());
-}
\ No newline at end of file
+#include "DirectXAPI.h"
+
+
+#include "d3dx12.h"
+#include <d3dcompiler.h>
+
+// STL Headers
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+// My headers
+#include "RenderEngine.h"
+#include "Helpers.h"
+#include "MathBatch.h"
+#include "StartupGraph.h"
+#include "StreamingCopy.h"
+
+// The min/max macros conflict with like-named member functions.
+// Only use std::min and std::max defined in <algorithm>.
+#if defined(min)
+#undef min
+#endif
+#if defined(max)
+#undef max
+#endif
+
+
+using namespace Microsoft::WRL;
+
+DirectXAPI* DirectXAPI::instance = nullptr;
+
+namespace {
+	enum RootParameters { ObjectConstantsSlot = 0, FrameConstantsSlot, RootParameterCount };
+
+	// Mirrors ObjectConstants in shader.hlsl.
+	struct ObjectConstants {
+		Float4x4 modelViewProjection;
+	};
+
+	// Mirrors FrameConstants in shader.hlsl.
+	struct FrameConstants {
+		Float4x4 viewProjection;
+	};
+
+	// Enough for a few frames in flight of a few thousand objects.
+	const uint32_t kConstantRingSize = 4 * 1024 * 1024;
+
+	// PipelineCache names of the pass pipelines, indexed by GeometryPass.
+	const char* const kPassPipelineNames[] = { "Geometry.DepthAndColor", "Geometry.DepthOnly", "Geometry.ColorAfterDepth" };
+	// Names read back from and written to the warm-up list next to the shaders.
+	const char* const kPipelineWarmUpPath = "pipelines.txt";
+	// mPassPipelines entry of a pass whose pipeline is still compiling.
+	const PipelineHandle kUnregisteredPipeline = 0xFFFF;
+
+	// Depth buffer of the CPU path's occlusion test, coarse on purpose.
+	const uint32_t kOcclusionWidth = 256;
+	const uint32_t kOcclusionHeight = 128;
+
+	// Streamed texture. A 720p or 1080p window asks for its mip 2 chain,
+	// 1.3 MB, the budget is kept below that so trimming runs as well.
+	const UINT kStreamedTextureSize = 2048;
+	const UINT16 kStreamedTextureMips = 12;
+	const size_t kStreamedTextureBudget = 1024 * 1024;
+
+	// Until there is texture data to stream every mip is cleared to its own
+	// gray, which shows the resident mip once the texture is sampled.
+	UINT8 GetMipGray(UINT mip){
+		return static_cast<UINT8>(255 - 16 * mip);
+	}
+
+	// The triangle every object draws, in clip space and wound clockwise.
+	void GetTrianglePositions(float aspectRatio, Float3 positions[3]){
+		positions[0] = { 0.0f, 0.25f * aspectRatio, 0.0f };
+		positions[1] = { 0.25f, -0.25f * aspectRatio, 0.0f };
+		positions[2] = { -0.25f, -0.25f * aspectRatio, 0.0f };
+	}
+
+	// The demo triangle streams in through AssetStreamer. Its vertex buffer
+	// holds a gray placeholder first and the streamed triangle after it.
+	const char* const kDemoMeshPath = "demo/triangle";
+	const uint32_t kDemoMeshVertexCount = 3;
+	const uint32_t kDemoMeshStartVertex = kDemoMeshVertexCount;
+
+	// The triangle in one color per corner, or gray for the placeholder.
+	std::vector<uint8_t> EncodeTriangle(float aspectRatio, const VertexFormat& format, bool placeholder){
+		SourceVertex vertices[kDemoMeshVertexCount] = {};
+		Float3 positions[kDemoMeshVertexCount];
+		GetTrianglePositions(aspectRatio, positions);
+		for(uint32_t i = 0; i < kDemoMeshVertexCount; i++){
+			memcpy(vertices[i].position, &positions[i], sizeof(positions[i]));
+			for(int k = 0; k < 3; k++){
+				vertices[i].color[k] = placeholder ? 0.5f : (k == static_cast<int>(i) ? 1.0f : 0.0f);
+			}
+			vertices[i].color[3] = 1.0f;
+		}
+		return EncodeVertices(vertices, kDemoMeshVertexCount, format, ComputeQuantizationBounds(vertices, kDemoMeshVertexCount));
+	}
+}
+
+DirectXAPI* DirectXAPI::GetInstance(){
+	if(instance == nullptr){
+		instance = new DirectXAPI();
+	}
+
+	return instance;
+}
+
+void DirectXAPI::EnableDebugLayer(){
+	#if defined(_DEBUG)
+		// Always enable the debug layer before doing anything DX12 related
+		// so all possible errors generated while creating DX12 objects
+		// are caught by the debug layer.
+	ComPtr<ID3D12Debug> debugInterface;
+	ThrowIfFailed(D3D12GetDebugInterface(IID_PPV_ARGS(&debugInterface)));
+	debugInterface->EnableDebugLayer();
+	#endif
+}
+
+ComPtr<IDXGIFactory4> DirectXAPI::CreateFactory(){
+	ComPtr<IDXGIFactory4> dxgiFactory;
+	UINT createFactoryFlags = 0;
+	#if defined(_DEBUG)
+	createFactoryFlags = DXGI_CREATE_FACTORY_DEBUG;
+	#endif
+
+	ThrowIfFailed(CreateDXGIFactory2(createFactoryFlags, IID_PPV_ARGS(&dxgiFactory)));
+	return dxgiFactory;
+}
+
+ComPtr<IDXGIAdapter4> DirectXAPI::GetAdapter(bool useWarp){
+	ComPtr<IDXGIAdapter1> dxgiAdapter1;
+	ComPtr<IDXGIAdapter4> dxgiAdapter4;
+
+	if(useWarp){
+		ThrowIfFailed(mFactory->EnumWarpAdapter(IID_PPV_ARGS(&dxgiAdapter1)));
+		ThrowIfFailed(dxgiAdapter1.As(&dxgiAdapter4));
+		return dxgiAdapter4;
+	}
+
+	// The adapter with the largest dedicated video memory is favored. Sort
+	// first, then probe, so usually only one adapter gets probed at all.
+	std::vector<std::pair<SIZE_T, ComPtr<IDXGIAdapter1>>> candidates;
+	for(UINT i = 0; mFactory->EnumAdapters1(i, &dxgiAdapter1) != DXGI_ERROR_NOT_FOUND; ++i){
+		DXGI_ADAPTER_DESC1 dxgiAdapterDesc1;
+		dxgiAdapter1->GetDesc1(&dxgiAdapterDesc1);
+		if((dxgiAdapterDesc1.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) == 0){
+			candidates.emplace_back(dxgiAdapterDesc1.DedicatedVideoMemory, dxgiAdapter1);
+		}
+	}
+	std::stable_sort(candidates.begin(), candidates.end(), [](const std::pair<SIZE_T, ComPtr<IDXGIAdapter1>>& a, const std::pair<SIZE_T, ComPtr<IDXGIAdapter1>>& b){
+		return a.first > b.first;
+	});
+
+	for(const std::pair<SIZE_T, ComPtr<IDXGIAdapter1>>& candidate : candidates){
+		// Check to see if the adapter can create a D3D12 device without actually 
+		// creating it.
+		if(SUCCEEDED(D3D12CreateDevice(candidate.second.Get(), D3D_FEATURE_LEVEL_11_0, __uuidof(ID3D12Device), nullptr))){
+			ThrowIfFailed(candidate.second.As(&dxgiAdapter4));
+			break;
+		}
+	}
+
+	return dxgiAdapter4;
+}
+
+ComPtr<ID3D12Device2> DirectXAPI::CreateDevice(ComPtr<IDXGIAdapter4> adapter){
+	ComPtr<ID3D12Device2> d3d12Device2;
+	ThrowIfFailed(D3D12CreateDevice(adapter.Get(), D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&d3d12Device2)));
+
+	// Enable debug messages in debug mode.
+	#if defined(_DEBUG)
+	ComPtr<ID3D12InfoQueue> pInfoQueue;
+	if(SUCCEEDED(d3d12Device2.As(&pInfoQueue))){
+		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
+		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
+		pInfoQueue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_WARNING, TRUE);
+		// Suppress whole categories of messages
+		//D3D12_MESSAGE_CATEGORY Categories[] = {};
+
+		// Suppress messages based on their severity level
+		D3D12_MESSAGE_SEVERITY Severities[] =
+		{
+			D3D12_MESSAGE_SEVERITY_INFO
+		};
+
+		// Suppress individual messages by their ID
+		D3D12_MESSAGE_ID DenyIds[] = {
+			D3D12_MESSAGE_ID_CLEARRENDERTARGETVIEW_MISMATCHINGCLEARVALUE,   // I'm really not sure how to avoid this message.
+			D3D12_MESSAGE_ID_MAP_INVALID_NULLRANGE,                         // This warning occurs when using capture frame while graphics debugging.
+			D3D12_MESSAGE_ID_UNMAP_INVALID_NULLRANGE,                       // This warning occurs when using capture frame while graphics debugging.
+		};
+
+		D3D12_INFO_QUEUE_FILTER NewFilter = {};
+		//NewFilter.DenyList.NumCategories = _countof(Categories);
+		//NewFilter.DenyList.pCategoryList = Categories;
+		NewFilter.DenyList.NumSeverities = _countof(Severities);
+		NewFilter.DenyList.pSeverityList = Severities;
+		NewFilter.DenyList.NumIDs = _countof(DenyIds);
+		NewFilter.DenyList.pIDList = DenyIds;
+
+		ThrowIfFailed(pInfoQueue->PushStorageFilter(&NewFilter));
+	}
+	#endif
+
+	return d3d12Device2;
+}
+
+ComPtr<ID3D12CommandQueue> DirectXAPI::CreateCommandQueue(ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type)
+{
+	ComPtr<ID3D12CommandQueue> d3d12CommandQueue;
+
+	D3D12_COMMAND_QUEUE_DESC desc = {};
+	desc.Type = type;
+	desc.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL;
+	desc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	desc.NodeMask = 0;
+
+	ThrowIfFailed(device->CreateCommandQueue(&desc, IID_PPV_ARGS(&d3d12CommandQueue)));
+
+	return d3d12CommandQueue;
+}
+
+bool DirectXAPI::CheckTearingSupport(){
+	bool allowTearing = FALSE;
+
+	// Rather than create the DXGI 1.5 factory interface directly, we create the
+	// DXGI 1.4 interface and query for the 1.5 interface. This is to enable the 
+	// graphics debugging tools which will not support the 1.5 factory interface 
+	// until a future update.
+	ComPtr<IDXGIFactory5> factory5;
+	if(SUCCEEDED(mFactory.As(&factory5))){
+		if(FAILED(factory5->CheckFeatureSupport( DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing)))){
+			allowTearing = FALSE;
+		}
+	}
+
+	return (allowTearing == TRUE);
+}
+
+ComPtr<IDXGISwapChain4> DirectXAPI::CreateSwapChain(HWND hWnd, ComPtr<ID3D12CommandQueue> commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount){
+	ComPtr<IDXGISwapChain4> dxgiSwapChain4;
+
+	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
+	swapChainDesc.Width = width;
+	swapChainDesc.Height = height;
+	swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+	//swapChainDesc.Stereo = FALSE;
+	swapChainDesc.SampleDesc = { 1, 0 };
+	swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
+	swapChainDesc.BufferCount = bufferCount;
+	swapChainDesc.Scaling = DXGI_SCALING_STRETCH;
+	swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
+	swapChainDesc.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
+	// It is recommended to always allow tearing if tearing support is available.
+	swapChainDesc.Flags = mTearingSupported ? DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING : 0;
+
+	ComPtr<IDXGISwapChain1> swapChain1;
+	ThrowIfFailed(mFactory->CreateSwapChainForHwnd(commandQueue.Get(), hWnd, &swapChainDesc, 0, 0, &swapChain1));
+
+	// Disable the Alt+Enter fullscreen toggle feature. Switching to fullscreen
+	// will be handled manually.
+	ThrowIfFailed(mFactory->MakeWindowAssociation(hWnd, DXGI_MWA_NO_ALT_ENTER));
+
+	ThrowIfFailed(swapChain1.As(&dxgiSwapChain4));
+
+	return dxgiSwapChain4;
+}
+
+ComPtr<ID3D12DescriptorHeap> DirectXAPI::CreateDescriptorHeap(ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors){
+	ComPtr<ID3D12DescriptorHeap> descriptorHeap;
+
+	D3D12_DESCRIPTOR_HEAP_DESC desc = {};
+	desc.NumDescriptors = numDescriptors;
+	desc.Type = type;
+
+	ThrowIfFailed(device->CreateDescriptorHeap(&desc, IID_PPV_ARGS(&descriptorHeap)));
+
+	mRTVDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(type);
+
+	return descriptorHeap;
+}
+
+void DirectXAPI::UpdateRenderTargetViews(ComPtr<ID3D12Device2> device, ComPtr<IDXGISwapChain4> swapChain, ComPtr<ID3D12DescriptorHeap> descriptorHeap){
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(descriptorHeap->GetCPUDescriptorHandleForHeapStart());
+
+	for(int i = 0; i < mNumFrames; i++){
+		ThrowIfFailed(swapChain->GetBuffer(i, IID_PPV_ARGS(&mRenderTargets[i])));
+
+		device->CreateRenderTargetView(mRenderTargets[i].Get(), nullptr, rtvHandle);
+		// Sets offset I think
+		rtvHandle.Offset(1, mRTVDescriptorSize);
+	}
+}
+
+/*
+	---------Steps to init------
+	Create device
+	*Check feature support*
+	Create command queue allocator
+	Create command queue
+	Create swap chain
+	create RTV(render target view) descriptor heap with front & back buffer count (Swap chain resource rotation no longer automatic)
+	Create command list
+		Create fence
+		Create fence event
+	Create Sampler descriptor heap abd valid Sampler descriptor
+*/
+
+void DirectXAPI::Init(const std::function<HWND()>& createWindow, Rect windowRect){
+	/*						Pipeline setup								*/		
+	mAspectRatio = static_cast<float>(windowRect.x) / static_cast<float>(windowRect.y);
+	m_viewport = { 0.0f, 0.0f, static_cast<float>(windowRect.x), static_cast<float>(windowRect.y), 0.0f, 1.0f };
+
+	m_scissorRect.right = static_cast<float>(windowRect.x);
+	m_scissorRect.bottom = static_cast<float>(windowRect.y);
+	mBackBufferWidth = static_cast<uint32_t>(windowRect.x);
+	mBackBufferHeight = static_cast<uint32_t>(windowRect.y);
+	mframeIndex = 0;
+	for(int i = 0; i < mNumFrames; i++){
+		mFrameFenceValues[i] = 0;
+	}
+
+	// Half positions and 8 bit colors.
+	mVertexFormat.position = PositionEncoding::Half;
+	mVertexFormat.color = ColorEncoding::Unorm8;
+	mVertexFormat.ComputeLayout();
+
+	// Everything below as a dependency graph. Shader compilation, pipeline
+	// creation and scene setup overlap adapter, device and swap chain
+	// creation. The window and swap chain stay on this thread, DXGI talks
+	// to the window on the thread that created it.
+	HWND windowHandle = nullptr;
+	ComPtr<IDXGIAdapter4> dxgiAdapter4;
+	for(int i = 0; i < 3; i++){
+		mPassPipelineStates[i] = kInvalidPipelineState;
+		mPassPipelines[i] = kUnregisteredPipeline;
+	}
+
+	StartupGraph graph;
+	StartupGraph::Stage factory = graph.Add("Factory", [&]{
+		EnableDebugLayer();
+		mFactory = CreateFactory();
+		mTearingSupported = CheckTearingSupport();
+	});
+	StartupGraph::Stage window = graph.AddMainThread("Window", [&]{
+		windowHandle = createWindow();
+	});
+	StartupGraph::Stage vertexShaderStage = graph.Add("VertexShader", [&]{
+		mVertexShader = CompileShader("VSMain", "vs_5_1");
+	});
+	StartupGraph::Stage pixelShaderStage = graph.Add("PixelShader", [&]{
+		mPixelShader = CompileShader("PSMain", "ps_5_1");
+	});
+	StartupGraph::Stage scene = graph.Add("Scene", [&]{
+		CreateScene();
+	});
+
+	// Gets adapter for device creation, then creates the device and queue
+	StartupGraph::Stage adapter = graph.Add("Adapter", [&]{
+		dxgiAdapter4 = GetAdapter(mUseWarp);
+	}, { factory });
+	StartupGraph::Stage device = graph.Add("Device", [&]{
+		mDevice = CreateDevice(dxgiAdapter4);
+	}, { adapter });
+	StartupGraph::Stage queue = graph.Add("CommandQueue", [&]{
+		mCommandQueue = CreateCommandQueue(mDevice, D3D12_COMMAND_LIST_TYPE_DIRECT);
+	}, { device });
+
+	// Creates Swap Chain and the RTV descriptor heap for its back buffers
+	StartupGraph::Stage swapChain = graph.AddMainThread("SwapChain", [&]{
+		mSwapChain = CreateSwapChain(windowHandle, mCommandQueue, windowRect.x, windowRect.y, mNumFrames);
+		mRTVDescriptorHeap = CreateDescriptorHeap(mDevice, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, mNumFrames);
+		UpdateRenderTargetViews(mDevice, mSwapChain, mRTVDescriptorHeap);
+	}, { window, queue });
+
+	// Creates the depth buffer matching the back buffers
+	StartupGraph::Stage depthBuffer = graph.Add("DepthBuffer", [&]{
+		mDepthBuffer.Init(mDevice, windowRect.x, windowRect.y);
+	}, { device });
+
+	StartupGraph::Stage rootSignature = graph.Add("RootSignature", [&]{
+		CreateRootSignature();
+	}, { device });
+	StartupGraph::Stage pipelineDesc = graph.Add("PipelineDesc", [&]{
+		mInputElementDescs = GetInputLayout(mVertexFormat);
+		mPipelineDesc = GetPipelineDesc(mVertexShader.Get(), mPixelShader.Get(), mInputElementDescs);
+	}, { rootSignature, vertexShaderStage, pixelShaderStage });
+
+	// Pass pipelines compile on the job system from here on, frames draw
+	// without them until they are ready. The default pass is always needed,
+	// the pre-pass variants on first use or when the last run drew with them.
+	StartupGraph::Stage pipelines = graph.Add("Pipelines", [&]{
+		mPipelineCache.Init(mDevice, kPipelineWarmUpPath);
+		RequestPassPipeline(GeometryPass::DepthAndColor);
+		mPipelineCache.WarmUp([this](const std::string& name, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, PipelineStateHandle& fallback){
+			return DescribePassPipeline(name, desc, fallback);
+		});
+	}, { pipelineDesc });
+
+	StartupGraph::Stage commandList = graph.Add("CommandList", [&]{
+		CreateCommandList();
+	}, { device });
+	StartupGraph::Stage vertexBuffer = graph.Add("VertexBuffer", [&]{
+		CreateVertexBuffer();
+	}, { device });
+	StartupGraph::Stage constantRing = graph.Add("ConstantRing", [&]{
+		mConstantRing.Init(mDevice, kConstantRingSize);
+	}, { device });
+	StartupGraph::Stage drawResources = graph.Add("DrawResources", [&]{
+		RegisterDrawResources();
+	}, { vertexBuffer, constantRing });
+
+	StartupGraph::Stage gpuDriven = graph.Add("GpuDrivenRenderer", [&]{
+		if(!mUseGpuDrivenPath){
+			return;
+		}
+		std::vector<GpuObjectBounds> bounds;
+		std::vector<GpuDrawArguments> drawArgs;
+		GatherRenderObjects(mScene, bounds, drawArgs);
+
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = mPipelineDesc;
+		ApplyGeometryPass(desc, GeometryPass::DepthAndColor, DepthBuffer::Format);
+		mGpuDrivenRenderer.Init(mDevice, desc, bounds, drawArgs);
+		if(mUseOcclusionCulling){
+			mGpuDrivenRenderer.EnableOcclusionCulling(mDepthBuffer);
+		}
+	}, { pipelineDesc, scene, depthBuffer });
+
+	StartupGraph::Stage streamedTexture = graph.Add("StreamedTexture", [&]{
+		CreateStreamedTexture();
+	}, { queue });
+	StartupGraph::Stage statisticsQueries = graph.Add("StatisticsQueries", [&]{
+		CreateStatisticsQueries();
+	}, { device });
+
+	// Create synchronization objects and wait until assets have been uploaded to the GPU.
+	graph.Add("Fence", [&]{
+		mFence.Init(mDevice, mCommandQueue);
+		mReleaseQueue.SetFenceValue(mFence.GetNextValue());
+
+		// Wait for setup to complete before the first frame.
+		WaitForGpu();
+		mframeIndex = mSwapChain->GetCurrentBackBufferIndex();
+	}, { swapChain, commandList, drawResources, pipelines, gpuDriven, streamedTexture, statisticsQueries });
+
+	// The report shows which stage failed and what was skipped after it.
+	try{
+		graph.Run();
+	} catch(...){
+		graph.PrintReport();
+		throw;
+	}
+	graph.PrintReport();
+	/*						Init has finished								*/
+	mIsInitialized = true;
+}
+
+void DirectXAPI::BuildSnapshot(RenderSnapshot& snapshot){
+	// Positions are already in clip space, the camera is identity and clip
+	// space z is the view depth, already in [0, 1].
+	snapshot.view = Float4x4::Identity();
+	snapshot.projection = Float4x4::Identity();
+	snapshot.nearZ = 0.0f;
+	snapshot.farZ = 1.0f;
+	snapshot.depthPrePass = mUseDepthPrePass;
+	UpdateDemoMesh();
+
+	// The GPU-driven path reads the scene it was given at init.
+	if(mUseGpuDrivenPath){
+		return;
+	}
+
+	// Only subtrees with a changed local transform are recomputed.
+	mTransforms.Update();
+	if(mTransforms.GetLastUpdatedCount() > 0){
+		CopyHierarchyTransforms(mScene, mTransforms);
+	}
+
+	// Culled and keyed here, the render thread sorts the packets of each
+	// pass by these keys, grouping state and going front to back.
+	const Float4x4 viewProjection = Multiply(snapshot.view, snapshot.projection);
+	if(mUseOcclusionCulling){
+		mOcclusion.BeginFrame(viewProjection);
+		GatherOccluders(mScene, mOcclusion);
+		mOcclusion.RasterizeOccluders();
+	}
+	GatherDrawList(mScene, snapshot.view, Frustum::FromViewProjection(&viewProjection.m[0][0]), snapshot.nearZ, snapshot.farZ, mDrawGatherScratch,
+		snapshot.draws, snapshot.worlds, snapshot.drawList, mUseOcclusionCulling ? &mOcclusion : nullptr);
+
+	// Every draw is the demo triangle, the placeholder stands in until the
+	// streamed one is in place.
+	if(mDemoMeshResident){
+		for(RenderableComponent& draw : snapshot.draws){
+			draw.startVertex = kDemoMeshStartVertex;
+		}
+	}
+}
+
+void DirectXAPI::UpdateDemoMesh(){
+	if(mDemoMeshResident){
+		return;
+	}
+	std::shared_ptr<const std::vector<uint8_t>> vertices = AssetStreamer::GetInstance()->Get<std::vector<uint8_t>>(mDemoMesh);
+	if(!vertices){
+		return;
+	}
+
+	// Not drawn yet, so the GPU does not read this part of the buffer. The
+	// copy in the vertex buffer is all that is needed from now on.
+	StreamCopy(mVertexData + kDemoMeshStartVertex * mVertexFormat.stride, vertices->data(), vertices->size());
+	mDemoMeshResident = true;
+	AssetStreamer::GetInstance()->Release(mDemoMesh);
+	mDemoMesh = kInvalidAsset;
+}
+
+void DirectXAPI::Render(const RenderSnapshot& snapshot){
+	// The game thread saw the window change size, nothing of the last
+	// size may still be in flight when its buffers are replaced.
+	if(snapshot.width != 0 && snapshot.height != 0 && (snapshot.width != mBackBufferWidth || snapshot.height != mBackBufferHeight)){
+		Resize(snapshot.width, snapshot.height);
+	}
+
+	// Free what the GPU has finished with since last frame.
+	mReleaseQueue.Retire(mFence.GetCompletedValue());
+
+	// Populate command list
+	PopulateCommandList(snapshot);
+
+	// Execute the command list.
+	ID3D12CommandList* ppCommandLists[] = { mCommandList.Get() };
+	mCommandQueue->ExecuteCommandLists(_countof(ppCommandLists), ppCommandLists);
+
+	// Present the frame.
+	ThrowIfFailed(mSwapChain->Present(1, 0));
+	// Up to mNumFrames frames stay in flight
+	MoveToNextFrame();
+}
+
+void DirectXAPI::Resize(uint32_t width, uint32_t height){
+	if(!mIsInitialized){
+		return;
+	}
+
+	// A minimized window reports zero, swap chain buffers can't be empty.
+	width = std::max(width, 1u);
+	height = std::max(height, 1u);
+
+	// The back buffers and the depth buffer can only be replaced once the
+	// GPU no longer references them.
+	WaitForGpu();
+	for(int i = 0; i < mNumFrames; i++){
+		mRenderTargets[i].Reset();
+	}
+
+	DXGI_SWAP_CHAIN_DESC swapChainDesc = {};
+	ThrowIfFailed(mSwapChain->GetDesc(&swapChainDesc));
+	ThrowIfFailed(mSwapChain->ResizeBuffers(mNumFrames, width, height, swapChainDesc.BufferDesc.Format, swapChainDesc.Flags));
+	mframeIndex = mSwapChain->GetCurrentBackBufferIndex();
+
+	UpdateRenderTargetViews(mDevice, mSwapChain, mRTVDescriptorHeap);
+	mDepthBuffer.Resize(width, height);
+	if(mGpuDrivenRenderer.IsOcclusionCullingEnabled()){
+		mGpuDrivenRenderer.EnableOcclusionCulling(mDepthBuffer);
+	}
+
+	mBackBufferWidth = width;
+	mBackBufferHeight = height;
+	mAspectRatio = static_cast<float>(width) / static_cast<float>(height);
+	m_viewport = { 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height), 0.0f, 1.0f };
+	m_scissorRect.right = static_cast<LONG>(width);
+	m_scissorRect.bottom = static_cast<LONG>(height);
+}
+
+void DirectXAPI::MoveToNextFrame(){
+	// Signal the frame just submitted.
+	mFrameFenceValues[mframeIndex] = mFence.Signal();
+	mReleaseQueue.SetFenceValue(mFence.GetNextValue());
+
+	// The next back buffer and its allocator were last used mNumFrames frames
+	// ago, only that frame has to be finished. Never used ones wait on 0.
+	mframeIndex = mSwapChain->GetCurrentBackBufferIndex();
+	mFence.CpuWait(mFrameFenceValues[mframeIndex]);
+}
+
+void DirectXAPI::WaitForGpu(){
+	const uint64_t fence = mFence.Signal();
+	mReleaseQueue.SetFenceValue(mFence.GetNextValue());
+	mFence.CpuWait(fence);
+}
+
+void DirectXAPI::Destroy(){
+	// Only once, and only what Init got to create.
+	if(!mIsInitialized){
+		return;
+	}
+	mIsInitialized = false;
+	if(mDemoMesh != kInvalidAsset){
+		AssetStreamer::GetInstance()->Release(mDemoMesh);
+		mDemoMesh = kInvalidAsset;
+	}
+
+	// Wait for the GPU to be done with all resources.
+	WaitForGpu();
+	mReleaseQueue.Flush();
+
+	// Remembers the pipelines drawn with for the next startup.
+	mPipelineCache.Shutdown();
+	PipelineCacheStats pipelineStats = mPipelineCache.GetStats();
+	std::cout << "Pipelines: " << pipelineStats.ready << " of " << pipelineStats.requested << " compiled, " << pipelineStats.warmedUp
+		<< " warmed up, " << pipelineStats.misses << " binds without, " << pipelineStats.maxCompileMilliseconds << " ms slowest" << std::endl;
+
+	TimelineFenceStats stats = mFence.GetStats();
+	std::cout << "Frame fence: " << stats.waits << " waits, " << stats.spinHits << " ended while spinning, "
+		<< stats.totalWaitMilliseconds << " ms total, " << stats.maxWaitMilliseconds << " ms max" << std::endl;
+
+	// Pixels shaded per screen pixel is the overdraw, compare the two.
+	for(int prePass = 0; prePass < 2; prePass++){
+		const PixelShadingStats& shading = mPixelShading[prePass];
+		if(shading.frames == 0){
+			continue;
+		}
+		std::cout << "Pixel shading " << (prePass ? "with" : "without") << " depth pre-pass: " << shading.invocations / shading.frames
+			<< " per frame, " << static_cast<double>(shading.invocations) / static_cast<double>(shading.screenPixels)
+			<< " per screen pixel over " << shading.frames << " frames" << std::endl;
+	}
+}
+
+ComPtr<ID3DBlob> DirectXAPI::CompileShader(const char* entryPoint, const char* target){
+	return CompileShaderFromFile(L"shader.hlsl", entryPoint, target);
+}
+
+void DirectXAPI::CreateRootSignature(){
+	// Per object and per frame constants, both root CBVs into mConstantRing.
+	CD3DX12_ROOT_PARAMETER rootParameters[RootParameterCount];
+	rootParameters[ObjectConstantsSlot].InitAsConstantBufferView(1, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	rootParameters[FrameConstantsSlot].InitAsConstantBufferView(2, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(RootParameterCount, rootParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	mRootSignature = CreateRootSignatureFromDesc(mDevice.Get(), rootSignatureDesc);
+}
+
+D3D12_GRAPHICS_PIPELINE_STATE_DESC DirectXAPI::GetPipelineDesc(ID3DBlob* vertexShader, ID3DBlob* pixelShader,
+	const std::vector<D3D12_INPUT_ELEMENT_DESC>& inputElementDescs){
+	// Describe the graphics pipeline state object (PSO), without a pass.
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC psoDesc = {0};
+	psoDesc.InputLayout = { inputElementDescs.data(), static_cast<UINT>(inputElementDescs.size()) };
+	psoDesc.pRootSignature = mRootSignature.Get();
+	psoDesc.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
+	psoDesc.PS = { reinterpret_cast<UINT8*>(pixelShader->GetBufferPointer()), pixelShader->GetBufferSize() };
+	psoDesc.RasterizerState = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	psoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
+	psoDesc.BlendState = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	psoDesc.SampleMask = UINT_MAX;
+	psoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+	psoDesc.NumRenderTargets = 1;
+	psoDesc.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+	psoDesc.SampleDesc.Count = 1;
+	return psoDesc;
+}
+
+bool DirectXAPI::DescribePassPipeline(const std::string& name, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, PipelineStateHandle& fallback){
+	for(int pass = 0; pass < 3; pass++){
+		if(name == kPassPipelineNames[pass]){
+			// One pipeline per geometry pass, the pre-pass can then be toggled per frame.
+			desc = mPipelineDesc;
+			ApplyGeometryPass(desc, static_cast<GeometryPass>(pass), DepthBuffer::Format);
+			// The pre-pass pipelines only work as a pair, PopulateCommandList
+			// falls back to the single pass for the whole frame instead.
+			fallback = kInvalidPipelineState;
+			return true;
+		}
+	}
+	return false;
+}
+
+void DirectXAPI::RequestPassPipeline(GeometryPass pass){
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+	PipelineStateHandle fallback;
+	DescribePassPipeline(kPassPipelineNames[static_cast<int>(pass)], desc, fallback);
+	mPassPipelineStates[static_cast<int>(pass)] = mPipelineCache.Request(kPassPipelineNames[static_cast<int>(pass)], desc, fallback);
+}
+
+void DirectXAPI::ResolvePassPipelines(bool depthPrePass){
+	DrawPipelineLayout layout = DrawPipelineLayout::None();
+	layout.drawConstants = ObjectConstantsSlot;
+	layout.frameConstants = FrameConstantsSlot;
+
+	for(int pass = 0; pass < 3; pass++){
+		if(mPassPipelines[pass] != kUnregisteredPipeline){
+			continue;
+		}
+
+		// Warmed up pipelines were requested by name at startup.
+		if(mPassPipelineStates[pass] == kInvalidPipelineState){
+			mPassPipelineStates[pass] = mPipelineCache.Find(kPassPipelineNames[pass]);
+		}
+		if(mPassPipelineStates[pass] == kInvalidPipelineState){
+			if(!depthPrePass){
+				continue;
+			}
+			RequestPassPipeline(static_cast<GeometryPass>(pass));
+		}
+
+		// Handles the CPU path draw packets refer to.
+		if(mPipelineCache.IsReady(mPassPipelineStates[pass])){
+			mPassPipelines[pass] = mPacketTranslator.RegisterPipeline(mPipelineCache.GetPipelineState(mPassPipelineStates[pass]), mRootSignature.Get(),
+				D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST, layout);
+		}
+	}
+}
+
+void DirectXAPI::CreateCommandList(){
+	// Create a command allocator per back buffer
+	for(int i = 0; i < mNumFrames; i++){
+		ThrowIfFailed(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&mCommandAllocators[i])));
+	}
+
+	// Create the command list.
+	ThrowIfFailed(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, mCommandAllocators[0].Get(), nullptr, IID_PPV_ARGS(&mCommandList)));
+
+	// Command lists are created in the recording state, but there is nothing
+	// to record yet. The main loop expects it to be closed, so close it now.
+	ThrowIfFailed(mCommandList->Close());
+}
+
+void DirectXAPI::CreateVertexBuffer(){
+	// Room for the placeholder and the streamed triangle behind it.
+	const std::vector<uint8_t> placeholder = EncodeTriangle(mAspectRatio, mVertexFormat, true);
+	const UINT vertexBufferSize = (kDemoMeshStartVertex + kDemoMeshVertexCount) * mVertexFormat.stride;
+
+	// Note: using upload heaps to transfer static data like vert buffers is not 
+	// recommended. Every time the GPU needs it, the upload heap will be marshalled 
+	// over. Please read up on Default Heap usage. An upload heap is used here for 
+	// code simplicity and because there are very few verts to actually transfer.
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&m_vertexBuffer)));
+
+	// Copy the placeholder to the vertex buffer. It stays mapped, the
+	// streamed triangle is copied in once it arrives.
+	CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+	ThrowIfFailed(m_vertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mVertexData)));
+	StreamCopy(mVertexData, placeholder.data(), placeholder.size());
+
+	// Loaded on an I/O thread. Encoding stands in for reading a cooked mesh
+	// file, the demo ships none.
+	const float aspectRatio = mAspectRatio;
+	const VertexFormat format = mVertexFormat;
+	mDemoMesh = AssetStreamer::GetInstance()->Request(kDemoMeshPath, 1.0f,
+		[aspectRatio, format](const std::string&, std::shared_ptr<const void>& data, size_t& size){
+			std::shared_ptr<const std::vector<uint8_t>> vertices = std::make_shared<const std::vector<uint8_t>>(EncodeTriangle(aspectRatio, format, false));
+			size = vertices->size();
+			data = vertices;
+			return true;
+		});
+
+	// Initialize the vertex buffer view.
+	m_vertexBufferView.BufferLocation = m_vertexBuffer->GetGPUVirtualAddress();
+	m_vertexBufferView.StrideInBytes = mVertexFormat.stride;
+	m_vertexBufferView.SizeInBytes = vertexBufferSize;
+}
+
+void DirectXAPI::RegisterDrawResources(){
+	// Handles the CPU path draw packets refer to, pipelines follow in
+	// ResolvePassPipelines as they finish compiling.
+	mVertexBufferHandle = mPacketTranslator.RegisterVertexBuffer(m_vertexBufferView);
+	mConstantBufferHandle = mPacketTranslator.RegisterConstantBuffer(mConstantRing.GetGpuAddress());
+}
+
+void DirectXAPI::CreateScene(){
+	// Lay out copies of the triangle on a grid that spills past the screen
+	// edges, so the GPU culling pass has something to reject. Each row is a
+	// node under the grid and each triangle a node under its row, moving a
+	// row or the grid moves everything below it.
+	const int gridSize = 16;
+	const float spacing = 0.5f;
+	const float radius = sqrtf(0.25f * 0.25f + (0.25f * mAspectRatio) * (0.25f * mAspectRatio));
+
+	// Every triangle also occludes what lies behind it on the CPU path.
+	GetTrianglePositions(mAspectRatio, mOccluderPositions);
+	const OccluderComponent occluder = { mOccluderPositions, 3, mOccluderIndices, 3, false };
+	mOcclusion.Resize(kOcclusionWidth, kOcclusionHeight);
+
+	const TransformHierarchy::Handle grid = mTransforms.Create();
+	for(int y = 0; y < gridSize; y++){
+		const TransformHierarchy::Handle row = mTransforms.Create(grid);
+		mTransforms.SetLocal(row, Float4x4::Translation(0.0f, (y - gridSize / 2) * spacing, 0.0f));
+		// Placed relative to the row, then attached under it.
+		for(int x = 0; x < gridSize; x++){
+			const Entity entity = mScene.CreateEntity(TransformComponent{ Float4x4::Translation((x - gridSize / 2) * spacing, 0.0f, 0.0f) },
+				BoundsComponent{ { 0.0f, 0.0f, 0.0f }, radius }, RenderableComponent{ 0, 0, 3, 0, 0, 0, DrawPass::Opaque });
+			if(mUseOcclusionCulling){
+				mScene.AddComponent(entity, occluder);
+			}
+		}
+		AttachToHierarchy(mScene, mTransforms, row);
+	}
+
+	// World matrices for the GPU-driven path, which reads them once at init.
+	mTransforms.Update();
+	CopyHierarchyTransforms(mScene, mTransforms);
+}
+
+void DirectXAPI::PopulateCommandList(const RenderSnapshot& snapshot)
+{
+	// Command list allocators can only be reset when the associated 
+	// command lists have finished execution on the GPU. MoveToNextFrame
+	// waited for the frame that last used this back buffer's allocator.
+	ID3D12CommandAllocator* commandAllocator = mCommandAllocators[mframeIndex].Get();
+	ThrowIfFailed(commandAllocator->Reset());
+
+	// However, when ExecuteCommandList() is called on a particular command 
+	// list, that command list can then be reset at any time and must be before 
+	// re-recording.
+	ThrowIfFailed(mCommandList->Reset(commandAllocator, nullptr));
+	UpdateStreamedTexture();
+
+	// The frame that last used this back buffer is done, so are its
+	// statistics. Shaded pixels go to the pre-pass setting they were drawn with.
+	if(mStatisticsPending[mframeIndex]){
+		const D3D12_RANGE readRange = { mframeIndex * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS), (mframeIndex + 1) * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS) };
+		void* data;
+		ThrowIfFailed(mStatisticsReadback->Map(0, &readRange, &data));
+		const D3D12_QUERY_DATA_PIPELINE_STATISTICS* statistics = reinterpret_cast<const D3D12_QUERY_DATA_PIPELINE_STATISTICS*>(static_cast<const UINT8*>(data) + readRange.Begin);
+		PixelShadingStats& shading = mPixelShading[mStatisticsPrePass[mframeIndex] ? 1 : 0];
+		shading.frames++;
+		shading.invocations += statistics->PSInvocations;
+		shading.screenPixels += mStatisticsScreenPixels[mframeIndex];
+		const D3D12_RANGE writeRange = { 0, 0 };
+		mStatisticsReadback->Unmap(0, &writeRange);
+		mStatisticsPending[mframeIndex] = false;
+	}
+
+	// Build this frame's indirect arguments before any drawing state is set.
+	if(mUseGpuDrivenPath){
+		Float4x4 viewProjection = Multiply(snapshot.view, snapshot.projection);
+		mGpuDrivenRenderer.Cull(mCommandList.Get(), Frustum::FromViewProjection(&viewProjection.m[0][0]), &viewProjection.m[0][0]);
+	}else{
+		// Picks up pass pipelines that finished compiling since last frame.
+		ResolvePassPipelines(snapshot.depthPrePass);
+		mConstantRing.BeginFrame(mFence.GetCompletedValue());
+		mPacketTranslator.Begin();
+		mSkipDraws = !WriteConstants(snapshot);
+	}
+
+	// Set necessary state.
+	mCommandList->SetGraphicsRootSignature(mRootSignature.Get());
+	mCommandList->RSSetViewports(1, &m_viewport);
+	mCommandList->RSSetScissorRects(1, &m_scissorRect);
+
+	// Indicate that the back buffer will be used as a render target.
+	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mframeIndex].Get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE rtvHandle(mRTVDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), mframeIndex, mRTVDescriptorSize);
+	D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = mDepthBuffer.GetDsv();
+
+	// Record commands.
+	const float clearColor[] = { 0.8f, 0.2f, 0.4f, 1.0f };
+	mCommandList->ClearRenderTargetView(rtvHandle, clearColor, 0, nullptr);
+	mDepthBuffer.Clear(mCommandList.Get());
+	mCommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	mCommandList->IASetVertexBuffers(0, 1, &m_vertexBufferView);
+
+	// Until both pre-pass pipelines are compiled the frame goes without it.
+	// GpuDrivenRenderer creates its own pass pipelines at init.
+	const bool depthPrePass = snapshot.depthPrePass && (mUseGpuDrivenPath ||
+		(mPassPipelines[static_cast<int>(GeometryPass::DepthOnly)] != kUnregisteredPipeline &&
+		mPassPipelines[static_cast<int>(GeometryPass::ColorAfterDepth)] != kUnregisteredPipeline));
+	// Pixel shader invocations of both passes, the overdraw the pre-pass saves.
+	mCommandList->BeginQuery(mStatisticsQueries.Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS, mframeIndex);
+	if(depthPrePass){
+		// Depth only, nothing to shade so no color target either.
+		mCommandList->OMSetRenderTargets(0, nullptr, FALSE, &dsvHandle);
+		DrawGeometry(GeometryPass::DepthOnly, snapshot);
+		mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+		DrawGeometry(GeometryPass::ColorAfterDepth, snapshot);
+	}else{
+		if(snapshot.depthPrePass && !mUseGpuDrivenPath){
+			// Counts the frame as a miss of whichever pre-pass pipeline is not ready.
+			mPipelineCache.Get(mPassPipelineStates[static_cast<int>(GeometryPass::DepthOnly)]);
+			mPipelineCache.Get(mPassPipelineStates[static_cast<int>(GeometryPass::ColorAfterDepth)]);
+		}
+		mCommandList->OMSetRenderTargets(1, &rtvHandle, FALSE, &dsvHandle);
+		DrawGeometry(GeometryPass::DepthAndColor, snapshot);
+	}
+	mCommandList->EndQuery(mStatisticsQueries.Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS, mframeIndex);
+
+	// Indicate that the back buffer will now be used to present.
+	mCommandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mRenderTargets[mframeIndex].Get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+
+	mCommandList->ResolveQueryData(mStatisticsQueries.Get(), D3D12_QUERY_TYPE_PIPELINE_STATISTICS, mframeIndex, 1,
+		mStatisticsReadback.Get(), mframeIndex * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS));
+	mStatisticsPending[mframeIndex] = true;
+	mStatisticsPrePass[mframeIndex] = depthPrePass;
+	mStatisticsScreenPixels[mframeIndex] = static_cast<uint64_t>(mBackBufferWidth) * mBackBufferHeight;
+
+	ThrowIfFailed(mCommandList->Close());
+
+	// MoveToNextFrame signals the next fence value once this frame is submitted.
+	if(!mUseGpuDrivenPath){
+		mConstantRing.EndFrame(mFence.GetNextValue());
+	}
+}
+
+bool DirectXAPI::WriteConstants(const RenderSnapshot& snapshot){
+	const uint32_t drawCount = static_cast<uint32_t>(snapshot.draws.size());
+	if(drawCount == 0){
+		return true;
+	}
+
+	ConstantAllocation frame;
+	ConstantAllocation objects;
+	if(!mConstantRing.Allocate(sizeof(FrameConstants), 1, frame) || !mConstantRing.Allocate(sizeof(ObjectConstants), drawCount, objects)){
+		// The GPU still holds the ring, skip the draws rather than overwrite it.
+		std::cout << "Constant ring full, dropping " << drawCount << " draws" << std::endl;
+		return false;
+	}
+
+	FrameConstants frameConstants;
+	frameConstants.viewProjection = Multiply(snapshot.view, snapshot.projection);
+	StreamCopyNoFence(frame.cpuAddress, &frameConstants, sizeof(frameConstants));
+	mPacketTranslator.SetFrameConstants(frame.gpuAddress);
+
+	// Every matrix in one batch, then one streamed line per slot. The slots
+	// are written in draw index order, packets look theirs up by index.
+	mModelViewProjections.resize(drawCount);
+	ComputeModelViewProjection(snapshot.worlds.data(), snapshot.view, snapshot.projection,
+		mModelViewProjections.data(), drawCount);
+	for(uint32_t i = 0; i < drawCount; i++){
+		StreamCopyNoFence(objects.cpuAddress + i * objects.stride, &mModelViewProjections[i], sizeof(ObjectConstants));
+	}
+	StreamFence();
+	mObjectConstantsOffset = objects.offset;
+	mObjectConstantsStride = objects.stride;
+	return true;
+}
+
+void DirectXAPI::CreateStatisticsQueries(){
+	D3D12_QUERY_HEAP_DESC queryHeapDesc = {};
+	queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_PIPELINE_STATISTICS;
+	queryHeapDesc.Count = mNumFrames;
+	ThrowIfFailed(mDevice->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&mStatisticsQueries)));
+
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_READBACK),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(mNumFrames * sizeof(D3D12_QUERY_DATA_PIPELINE_STATISTICS)),
+		D3D12_RESOURCE_STATE_COPY_DEST,
+		nullptr,
+		IID_PPV_ARGS(&mStatisticsReadback)));
+}
+
+void DirectXAPI::CreateStreamedTexture(){
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(mDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	if(options.TiledResourcesTier == D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED){
+		std::cout << "No tiled resources, texture streaming is off" << std::endl;
+		return;
+	}
+
+	mStreamedTexture.Init(mDevice, mCommandQueue, &mReleaseQueue, kStreamedTextureSize, kStreamedTextureSize, kStreamedTextureMips, DXGI_FORMAT_R8G8B8A8_UNORM);
+	StreamedTextureDesc desc = { kStreamedTextureSize, kStreamedTextureSize, kStreamedTextureMips, 1, 4, mStreamedTexture.GetPackedMipStart() };
+	mTextureResidency.Init(kStreamedTextureBudget);
+	mStreamedTextureId = mTextureResidency.Register(desc);
+}
+
+void DirectXAPI::UpdateStreamedTexture(){
+	if(mStreamedTextureId == kInvalidStreamedTexture){
+		return;
+	}
+
+	if(!mPackedMipsCleared){
+		for(UINT mip = mStreamedTexture.GetPackedMipStart(); mip < kStreamedTextureMips; mip++){
+			mStreamedTexture.ClearMip(mCommandList.Get(), mip, GetMipGray(mip));
+		}
+		mPackedMipsCleared = true;
+	}
+
+	// Stands in for sampler feedback until materials sample textures: the
+	// texture spans the triangle's bounds, a quarter of the viewport across.
+	const float mip = TextureResidency::ComputeMipFromFootprint(kStreamedTextureSize, kStreamedTextureSize,
+		m_viewport.Width * 0.25f, m_viewport.Height * 0.25f * mAspectRatio);
+	mTextureResidency.ReportSampledMip(mStreamedTextureId, mip);
+
+	mMipTransitions.clear();
+	mTextureResidency.Update(mMipTransitions);
+	for(const MipTransition& transition : mMipTransitions){
+		if(transition.load){
+			mStreamedTexture.MapMip(transition.mip);
+			mStreamedTexture.ClearMip(mCommandList.Get(), transition.mip, GetMipGray(transition.mip));
+			// Loaded once the frame recording the copy has completed.
+			mReleaseQueue.Defer([this, transition]{
+				mTextureResidency.OnMipLoaded(transition.texture, transition.mip);
+			});
+		}else{
+			mStreamedTexture.UnmapMip(transition.mip);
+		}
+	}
+}
+
+void DirectXAPI::DrawGeometry(GeometryPass pass, const RenderSnapshot& snapshot){
+	if(mUseGpuDrivenPath){
+		mGpuDrivenRenderer.Draw(mCommandList.Get(), pass, 0);
+		if(mGpuDrivenRenderer.IsOcclusionCullingEnabled()){
+			// Depth of what was visible last frame is down now, re-test the
+			// rest against it. The color pass after a pre-pass reuses both lists.
+			if(pass != GeometryPass::ColorAfterDepth){
+				mGpuDrivenRenderer.CullDisoccluded(mCommandList.Get(), mDepthBuffer.GetResource());
+			}
+			mGpuDrivenRenderer.Draw(mCommandList.Get(), pass, 1);
+		}
+		return;
+	}
+
+	// Packets are emitted in gather order with their keys, then sorted.
+	// Nothing is drawn until the pass pipeline has compiled. Get marks it
+	// used for the warm-up list and counts the frames spent without it.
+	mDrawPackets.Clear();
+	if(mSkipDraws || mPipelineCache.Get(mPassPipelineStates[static_cast<int>(pass)]) == nullptr ||
+		mPassPipelines[static_cast<int>(pass)] == kUnregisteredPipeline){
+		return;
+	}
+	// Gather adds draw i with key i, so keys line up with snapshot.draws.
+	const DrawList& drawList = snapshot.drawList;
+	const uint64_t* keys = drawList.GetKeys();
+	for(uint32_t i = 0; i < drawList.GetCount(); i++){
+		const RenderableComponent& draw = snapshot.draws[i];
+		// Blended draws leave depth alone.
+		if(pass == GeometryPass::DepthOnly && draw.pass == DrawPass::Transparent){
+			continue;
+		}
+		DrawPacket& packet = mDrawPackets.Emit(keys[i]);
+		packet.pipeline = mPassPipelines[static_cast<int>(pass)];
+		packet.vertexBuffer = mVertexBufferHandle;
+		packet.constantBuffer = mConstantBufferHandle;
+		packet.constantOffset = mObjectConstantsOffset + i * mObjectConstantsStride;
+		packet.count = draw.vertexCount;
+		packet.first = draw.startVertex;
+	}
+	SortDrawPackets(&mDrawPackets, 1, mPacketOrder, mSortedPackets);
+	mPacketTranslator.Translate(mCommandList.Get(), mSortedPackets);
+}
@@ -1,102 +1,255 @@
-#pragma once
-#define WIN32_LEAN_AND_MEAN
-
-// DirectX 12 specific headers.
-#include <d3d12.h>
-#include <dxgi1_6.h>
-#include <d3dcompiler.h>
-#include <DirectXMath.h>
-
-#pragma comment (lib, "d3dcompiler.lib")
-
-
-
-// Windows Runtime Library. Needed for Microsoft::WRL::ComPtr<> template class.
-#include <wrl.h>
-
-#include "Rect.h"
-
-class DirectXAPI{
-public:
-	static DirectXAPI* GetInstance();
-
-	void Init(HWND windowhandle, Rect windowRect);
-	void Render();
-	void Resize(uint32_t width, uint32_t height);
-	void Destroy();
-private:
-	// For init DirectX
-	void EnableDebugLayer();
-	Microsoft::WRL::ComPtr<IDXGIAdapter4> GetAdapter(bool useWarp);
-	Microsoft::WRL::ComPtr<ID3D12Device2> CreateDevice(Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter);
-	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CreateCommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
-	bool CheckTearingSupport();
-	Microsoft::WRL::ComPtr<IDXGISwapChain4> CreateSwapChain(HWND hWnd, Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount);
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors);
-	void UpdateRenderTargetViews(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGISwapChain4> swapChain, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap);
-
-	// Waiting for frame
-	void WaitForPreviousFrame();
-
-	// Temp here so I can load the triangle
-	void LoadAssets();
-
-	// Pre commands 
-	void PopulateCommandList();
-private:
-	static DirectXAPI* instance;
-	
-	// Set to true once the DX12 objects have been initialized.
-	bool mIsInitialized = false;
-	// By default, enable V-Sync.
-	bool mVSync = true;
-	bool mTearingSupported = false;
-	// By default, use windowed mode.
-	bool mFullscreen = false;
-	// Use WARP adapter - software rasterizer (Windows Advanced Rasterization Platform - WARP) 
-	bool mUseWarp = false;
-	// The number of back buffers for the swap chain.
-	static const uint8_t mNumFrames = 4;
-	D3D12_VIEWPORT m_viewport;
-	D3D12_RECT m_scissorRect;
-
-	// Pipline objects
-	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
-	Microsoft::WRL::ComPtr<ID3D12CommandQueue>  mCommandQueue;
-	// IDXGISwapChain4 interface defines swap chain - Responsible for resenting the rendered image to window
-	// Created with a number of back buffers resources
-	Microsoft::WRL::ComPtr<IDXGISwapChain4> mSwapChain;
-	// all back buffers &  textures  are referenced by ID3D12Resource
-	Microsoft::WRL::ComPtr<ID3D12Resource> mRenderTargets[mNumFrames];
-	// Used to store descriptor heap that contains render target views for swap chain back buffers
-	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mRTVDescriptorHeap;
-	// Serves as backing memory for recording Gpu commands into command list cannot be reused unless all 
-	//commands that have been recorded are finished executing on gpu
-	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mCommandAllocator;
-	Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
-	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPipelineState;
-	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> mCommandList;
-	UINT mRTVDescriptorSize;
-
-	// Synchronization objects
-	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
-	// handle to OS event object used to receive the notification that fence has reached value
-	HANDLE mFenceEvent;
-	// the next fence value to signal is stored below
-	uint64_t mFenceValue;
-	UINT mframeIndex;
-
-private:
-	struct Vertex
-	{
-		DirectX::XMFLOAT4 position;
-		DirectX::XMFLOAT4 color;
-	};
-
-	float mAspectRatio;
-
-	// App resources.
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexBuffer;
-	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
-};
-
+#pragma once
+#define WIN32_LEAN_AND_MEAN
+
+// DirectX 12 specific headers.
+#include <d3d12.h>
+#include <dxgi1_6.h>
+#include <d3dcompiler.h>
+#include <DirectXMath.h>
+
+#pragma comment (lib, "d3dcompiler.lib")
+
+
+
+// Windows Runtime Library. Needed for Microsoft::WRL::ComPtr<> template class.
+#include <wrl.h>
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "Rect.h"
+#include "AssetStreamer.h"
+#include "ConstantBufferRing.h"
+#include "DeferredReleaseQueue.h"
+#include "DepthBuffer.h"
+#include "DrawPacketTranslator.h"
+#include "GpuDrivenRenderer.h"
+#include "MathBatch.h"
+#include "PipelineCache.h"
+#include "RenderComponents.h"
+#include "RenderSnapshot.h"
+#include "ReservedTexture.h"
+#include "TextureResidency.h"
+#include "TimelineFence.h"
+#include "VertexFormat.h"
+
+// Pixel shading cost of the frames drawn one way, from pipeline statistics.
+struct PixelShadingStats {
+	uint64_t frames = 0;
+	uint64_t invocations = 0;
+	// Sum of the back buffer sizes, invocations per pixel is the overdraw
+	uint64_t screenPixels = 0;
+};
+
+class DirectXAPI{
+public:
+	static DirectXAPI* GetInstance();
+
+	// Runs the startup graph and prints its timing report. createWindow is
+	// called on this thread while the device is being created. Rethrows the
+	// first stage failure, the API is then left uninitialized.
+	void Init(const std::function<HWND()>& createWindow, Rect windowRect);
+	// Game thread, captures the scene and camera for one frame.
+	void BuildSnapshot(RenderSnapshot& snapshot);
+	// Render thread, records, submits and presents a captured frame.
+	void Render(const RenderSnapshot& snapshot);
+	void Destroy();
+
+	// Game thread. Draw depth first and shade only the visible fragments
+	// afterwards, from the next snapshot on. Toggle it to compare overdraw,
+	// Destroy prints the pixel shading cost of frames with and without.
+	inline void SetDepthPrePass(bool enabled) { mUseDepthPrePass = enabled; }
+	inline bool IsDepthPrePassEnabled() const { return mUseDepthPrePass; }
+
+	// Frees GPU objects from any thread without waiting on the GPU.
+	inline DeferredReleaseQueue& GetReleaseQueue() { return mReleaseQueue; }
+private:
+	// For init DirectX
+	void EnableDebugLayer();
+	Microsoft::WRL::ComPtr<IDXGIFactory4> CreateFactory();
+	// These three use mFactory.
+	Microsoft::WRL::ComPtr<IDXGIAdapter4> GetAdapter(bool useWarp);
+	Microsoft::WRL::ComPtr<ID3D12Device2> CreateDevice(Microsoft::WRL::ComPtr<IDXGIAdapter4> adapter);
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> CreateCommandQueue(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_COMMAND_LIST_TYPE type);
+	bool CheckTearingSupport();
+	Microsoft::WRL::ComPtr<IDXGISwapChain4> CreateSwapChain(HWND hWnd, Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue, uint32_t width, uint32_t height, uint32_t bufferCount);
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(Microsoft::WRL::ComPtr<ID3D12Device2> device, D3D12_DESCRIPTOR_HEAP_TYPE type, uint32_t numDescriptors);
+	void UpdateRenderTargetViews(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<IDXGISwapChain4> swapChain, Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> descriptorHeap);
+
+	// Signals the frame just submitted and moves to the next back buffer,
+	// waiting only until the frame that last recorded into it is done.
+	void MoveToNextFrame();
+	// Waits for everything submitted so far, before resources are replaced.
+	void WaitForGpu();
+	// Render thread, between frames. Recreates the back buffers and the
+	// depth buffer at the new size.
+	void Resize(uint32_t width, uint32_t height);
+
+	// Startup stages, scheduled by Init
+	Microsoft::WRL::ComPtr<ID3DBlob> CompileShader(const char* entryPoint, const char* target);
+	void CreateRootSignature();
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC GetPipelineDesc(ID3DBlob* vertexShader, ID3DBlob* pixelShader,
+		const std::vector<D3D12_INPUT_ELEMENT_DESC>& inputElementDescs);
+	// Pass pipelines by PipelineCache name, for requests and the warm-up list.
+	bool DescribePassPipeline(const std::string& name, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, PipelineStateHandle& fallback);
+	void RequestPassPipeline(GeometryPass pass);
+	// Registers pass pipelines with mPacketTranslator once they are ready.
+	// Missing pre-pass pipelines are only requested when depthPrePass is set.
+	void ResolvePassPipelines(bool depthPrePass);
+	void CreateCommandList();
+	// Temp here so I can load the triangle
+	void CreateVertexBuffer();
+	// Game thread. Copies the streamed demo triangle into the vertex buffer
+	// once AssetStreamer has it.
+	void UpdateDemoMesh();
+	void RegisterDrawResources();
+	void CreateScene();
+	// Left out when the device has no tiled resources.
+	void CreateStreamedTexture();
+	void CreateStatisticsQueries();
+
+	// Pre commands 
+	void PopulateCommandList(const RenderSnapshot& snapshot);
+	// Fills this frame's constants for the CPU path draws in mConstantRing.
+	// Returns false when the ring is full and the draws have to be skipped.
+	bool WriteConstants(const RenderSnapshot& snapshot);
+	// Reports this frame's footprint to mTextureResidency and records the
+	// mip loads and drops it asks for.
+	void UpdateStreamedTexture();
+	void DrawGeometry(GeometryPass pass, const RenderSnapshot& snapshot);
+private:
+	static DirectXAPI* instance;
+	
+	// Set to true once the DX12 objects have been initialized.
+	bool mIsInitialized = false;
+	// By default, enable V-Sync.
+	bool mVSync = true;
+	bool mTearingSupported = false;
+	// By default, use windowed mode.
+	bool mFullscreen = false;
+	// Use WARP adapter - software rasterizer (Windows Advanced Rasterization Platform - WARP) 
+	bool mUseWarp = false;
+	// Cull and draw the scene objects on the GPU with ExecuteIndirect
+	bool mUseGpuDrivenPath = false;
+	// Lay down depth in a separate pass before shading. Game thread, the
+	// render thread reads the copy in each snapshot.
+	bool mUseDepthPrePass = false;
+	// Reject objects hidden behind others: the Hi-Z pyramid on the GPU-driven
+	// path, CPU rasterized occluders on the CPU path. Off while the demo has
+	// no camera, under the identity projection every box crosses the near
+	// plane and nothing can be rejected.
+	bool mUseOcclusionCulling = false;
+	// The number of back buffers for the swap chain.
+	static const uint8_t mNumFrames = 4;
+	D3D12_VIEWPORT m_viewport;
+	D3D12_RECT m_scissorRect;
+	// Size of the back buffers, render thread
+	uint32_t mBackBufferWidth = 0;
+	uint32_t mBackBufferHeight = 0;
+
+	// Pipline objects
+	// Shared by adapter selection, the tearing check and the swap chain
+	Microsoft::WRL::ComPtr<IDXGIFactory4> mFactory;
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>  mCommandQueue;
+	// IDXGISwapChain4 interface defines swap chain - Responsible for resenting the rendered image to window
+	// Created with a number of back buffers resources
+	Microsoft::WRL::ComPtr<IDXGISwapChain4> mSwapChain;
+	// all back buffers &  textures  are referenced by ID3D12Resource
+	Microsoft::WRL::ComPtr<ID3D12Resource> mRenderTargets[mNumFrames];
+	// Used to store descriptor heap that contains render target views for swap chain back buffers
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mRTVDescriptorHeap;
+	// Shared by every back buffer, resized with them
+	DepthBuffer mDepthBuffer;
+	// Serves as backing memory for recording Gpu commands into command list cannot be reused unless all 
+	//commands that have been recorded are finished executing on gpu, so one per back buffer
+	Microsoft::WRL::ComPtr<ID3D12CommandAllocator> mCommandAllocators[mNumFrames];
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
+	// One pipeline per GeometryPass, compiled in the background
+	PipelineCache mPipelineCache;
+	PipelineStateHandle mPassPipelineStates[3];
+	// What the pass pipelines are built from, they must outlive every request
+	Microsoft::WRL::ComPtr<ID3DBlob> mVertexShader;
+	Microsoft::WRL::ComPtr<ID3DBlob> mPixelShader;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> mInputElementDescs;
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC mPipelineDesc;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList2> mCommandList;
+	UINT mRTVDescriptorSize;
+
+	// Synchronization objects
+	// Signaled once per frame on mCommandQueue, waits spin before they block
+	TimelineFence mFence;
+	// Releases objects once mFence passes the frame they were dropped in
+	DeferredReleaseQueue mReleaseQueue;
+	UINT mframeIndex;
+	// mFence value signaled after the last frame recorded into each back buffer
+	uint64_t mFrameFenceValues[mNumFrames];
+
+	// One pipeline statistics query per back buffer around the geometry
+	// passes, resolved into mStatisticsReadback and read when the back
+	// buffer comes around again.
+	Microsoft::WRL::ComPtr<ID3D12QueryHeap> mStatisticsQueries;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mStatisticsReadback;
+	bool mStatisticsPending[mNumFrames] = {};
+	bool mStatisticsPrePass[mNumFrames] = {};
+	uint64_t mStatisticsScreenPixels[mNumFrames] = {};
+	// Index 0 without the depth pre-pass, 1 with it
+	PixelShadingStats mPixelShading[2];
+
+private:
+	// Half positions and 8 bit colors, 12 bytes per vertex.
+	VertexFormat mVertexFormat;
+
+	float mAspectRatio;
+
+	// App resources.
+	Microsoft::WRL::ComPtr<ID3D12Resource> m_vertexBuffer;
+	D3D12_VERTEX_BUFFER_VIEW m_vertexBufferView;
+	// m_vertexBuffer, persistently mapped
+	UINT8* mVertexData = nullptr;
+	// Held until the streamed triangle is copied into m_vertexBuffer
+	AssetHandle mDemoMesh = kInvalidAsset;
+	bool mDemoMeshResident = false;
+
+	// Draws copies of the triangle when mUseGpuDrivenPath is set
+	GpuDrivenRenderer mGpuDrivenRenderer;
+	// Renderable entities, drawn by mGpuDrivenRenderer or the CPU path below.
+	// Only the game thread touches it after Init, through BuildSnapshot.
+	EntityWorld mScene;
+	// Owns the world matrices of mScene, copied into its TransformComponents.
+	TransformHierarchy mTransforms;
+	DrawGatherScratch mDrawGatherScratch;
+	// Occluders of the CPU path, rasterized before the draw list is gathered
+	SoftwareOcclusion mOcclusion;
+	// Triangle mesh the occluder entities point at
+	Float3 mOccluderPositions[3];
+	uint32_t mOccluderIndices[3] = { 0, 1, 2 };
+	// Model view projection of every CPU path draw in the snapshot
+	std::vector<Float4x4> mModelViewProjections;
+	// Set when this frame's constants did not fit, the CPU path draws nothing
+	bool mSkipDraws = false;
+	// Per frame constants of the CPU path, persistently mapped
+	ConstantBufferRing mConstantRing;
+	// Slot of draw i is at mObjectConstantsOffset + i * mObjectConstantsStride
+	uint32_t mObjectConstantsOffset;
+	uint32_t mObjectConstantsStride;
+	// CPU path draws go through packets, sorted into mSortedPackets and
+	// recorded by mPacketTranslator. mPacketOrder is the sort's scratch.
+	DrawPacketStream mDrawPackets;
+	DrawPacketStream mSortedPackets;
+	DrawList mPacketOrder;
+	DrawPacketTranslator mPacketTranslator;
+	PipelineHandle mPassPipelines[3];
+	BufferHandle mVertexBufferHandle;
+	BufferHandle mConstantBufferHandle;
+
+	// Streamed over the triangle, its mips are made resident by mTextureResidency
+	ReservedTexture mStreamedTexture;
+	TextureResidency mTextureResidency;
+	StreamedTextureId mStreamedTextureId = kInvalidStreamedTexture;
+	std::vector<MipTransition> mMipTransitions;
+	// The packed tail is mapped at creation and cleared with the first frame
+	bool mPackedMipsCleared = false;
+};
+
@@ -0,0 +1,50 @@
+#include "DrawPacket.h"
+
+#include <cassert>
+
+namespace {
+	// Draw indices in the merged order carry their stream in the top bits.
+	const uint32_t kStreamShift = 24;
+	const uint32_t kPacketMask = (1u << kStreamShift) - 1;
+}
+
+void SortDrawPackets(const DrawPacketStream* streams, uint32_t streamCount, DrawList& order, DrawPacketStream& sorted){
+	assert(streamCount <= (1u << (32 - kStreamShift)));
+
+	uint32_t total = 0;
+	for(uint32_t stream = 0; stream < streamCount; stream++){
+		total += streams[stream].GetCount();
+	}
+
+	order.Clear();
+	order.Reserve(total);
+	for(uint32_t stream = 0; stream < streamCount; stream++){
+		const uint64_t* keys = streams[stream].GetKeys();
+		assert(streams[stream].GetCount() <= kPacketMask + 1);
+		for(uint32_t i = 0; i < streams[stream].GetCount(); i++){
+			order.Add(keys[i], (stream << kStreamShift) | i);
+		}
+	}
+	order.Sort();
+
+	// Copy the packets out in order so translation walks memory linearly.
+	sorted.mPackets.resize(total);
+	sorted.mKeys.resize(total);
+	const uint64_t* keys = order.GetKeys();
+	const uint32_t* draws = order.GetDraws();
+	for(uint32_t i = 0; i < total; i++){
+		const DrawPacketStream& stream = streams[draws[i] >> kStreamShift];
+		sorted.mPackets[i] = stream.mPackets[draws[i] & kPacketMask];
+		sorted.mKeys[i] = keys[i];
+	}
+}
+
+void DrawPacketState::Invalidate(){
+	pipeline = kUnknown;
+	rootSignature = kUnknown;
+	vertexBuffer = kUnknown;
+	indexBuffer = kUnknown;
+	constantBuffer = kUnknown;
+	constantOffset = 0;
+	rootConstantCount = kUnknown;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "DrawSortKey.h"
+
+// Render code describes draws as small plain packets instead of calling the
+// command list directly. Pipelines and buffers are referred to by handles
+// registered up front, the translator resolves them in one tight loop and
+// only records the state that actually changes between packets.
+
+typedef uint16_t PipelineHandle;
+typedef uint16_t BufferHandle;
+
+static const BufferHandle kNoBuffer = 0xFFFF;
+static const uint32_t kDrawPacketMaxRootConstants = 7;
+
+struct DrawPacket {
+	PipelineHandle pipeline;
+	BufferHandle vertexBuffer;
+	// kNoBuffer for a non indexed draw.
+	BufferHandle indexBuffer;
+	// Per draw constants, bound as a root CBV at constantOffset bytes into
+	// the buffer. kNoBuffer when the draw has none.
+	BufferHandle constantBuffer;
+	uint32_t constantOffset;
+	// Vertices, or indices when indexed, per instance.
+	uint32_t count;
+	uint32_t instanceCount;
+	// First vertex, or first index when indexed.
+	uint32_t first;
+	int32_t baseVertex;
+	uint32_t firstInstance;
+	uint32_t rootConstantCount;
+	uint32_t rootConstants[kDrawPacketMaxRootConstants];
+};
+
+static_assert(std::is_trivially_copyable<DrawPacket>::value, "Draw packets are copied around with memcpy");
+static_assert(sizeof(DrawPacket) == 64, "Draw packets should stay one cache line");
+
+// Linear packet buffer, one per recording thread. Capacity is kept between
+// frames, so emitting packets does not allocate once it has warmed up.
+class DrawPacketStream {
+public:
+	inline void Clear() { mPackets.clear(); mKeys.clear(); }
+	inline void Reserve(uint32_t count) { mPackets.reserve(count); mKeys.reserve(count); }
+
+	// Appends a zeroed packet for one instance and returns it to fill in.
+	inline DrawPacket& Emit(uint64_t key){
+		mKeys.push_back(key);
+		mPackets.emplace_back();
+		DrawPacket& packet = mPackets.back();
+		packet.indexBuffer = kNoBuffer;
+		packet.constantBuffer = kNoBuffer;
+		packet.instanceCount = 1;
+		return packet;
+	}
+
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(mPackets.size()); }
+	inline const DrawPacket* GetPackets() const { return mPackets.data(); }
+	inline const uint64_t* GetKeys() const { return mKeys.data(); }
+
+private:
+	friend void SortDrawPackets(const DrawPacketStream*, uint32_t, DrawList&, DrawPacketStream&);
+
+	std::vector<DrawPacket> mPackets;
+	std::vector<uint64_t> mKeys;
+};
+
+// Merges the streams into sorted in key order. order is scratch, reusing it
+// keeps the sort from allocating. At most 256 streams.
+void SortDrawPackets(const DrawPacketStream* streams, uint32_t streamCount, DrawList& order, DrawPacketStream& sorted);
+
+// What the command list has bound, as handles. Root signatures are whatever
+// id the sink hands out for them.
+struct DrawPacketState {
+	static const uint32_t kUnknown = 0xFFFFFFFF;
+
+	uint32_t pipeline;
+	uint32_t rootSignature;
+	uint32_t vertexBuffer;
+	uint32_t indexBuffer;
+	uint32_t constantBuffer;
+	uint32_t constantOffset;
+	uint32_t rootConstantCount;
+	uint32_t rootConstants[kDrawPacketMaxRootConstants];
+
+	// Forget everything, the next packet sets all of its state.
+	void Invalidate();
+};
+
+struct DrawPacketStats {
+	uint32_t packets;
+	uint32_t pipelineChanges;
+	uint32_t rootSignatureChanges;
+	uint32_t vertexBufferChanges;
+	uint32_t indexBufferChanges;
+	uint32_t constantBufferChanges;
+	uint32_t rootConstantChanges;
+};
+
+// The translation loop, shared by the D3D12 translator and anything that
+// wants to count state changes without a device. Sink provides
+//
+//   uint32_t GetRootSignature(PipelineHandle)
+//   void SetRootSignature(uint32_t)
+//   void SetPipeline(PipelineHandle)
+//   void SetVertexBuffer(BufferHandle)
+//   void SetIndexBuffer(BufferHandle)
+//   void SetConstantBuffer(PipelineHandle, BufferHandle, uint32_t offset)
+//   void SetRootConstants(PipelineHandle, uint32_t count, const uint32_t* values)
+//   void Draw(const DrawPacket&)
+//   void DrawIndexed(const DrawPacket&)
+template<typename Sink>
+void TranslateDrawPackets(const DrawPacket* packets, uint32_t count, DrawPacketState& state, DrawPacketStats& stats, Sink& sink){
+	for(uint32_t i = 0; i < count; i++){
+		const DrawPacket& packet = packets[i];
+
+		if(packet.pipeline != state.pipeline){
+			uint32_t rootSignature = sink.GetRootSignature(packet.pipeline);
+			if(rootSignature != state.rootSignature){
+				// Root arguments do not survive a root signature change.
+				sink.SetRootSignature(rootSignature);
+				state.rootSignature = rootSignature;
+				state.constantBuffer = DrawPacketState::kUnknown;
+				state.rootConstantCount = DrawPacketState::kUnknown;
+				stats.rootSignatureChanges++;
+			}
+			sink.SetPipeline(packet.pipeline);
+			state.pipeline = packet.pipeline;
+			stats.pipelineChanges++;
+		}
+
+		if(packet.vertexBuffer != state.vertexBuffer && packet.vertexBuffer != kNoBuffer){
+			sink.SetVertexBuffer(packet.vertexBuffer);
+			state.vertexBuffer = packet.vertexBuffer;
+			stats.vertexBufferChanges++;
+		}
+
+		if(packet.indexBuffer != state.indexBuffer && packet.indexBuffer != kNoBuffer){
+			sink.SetIndexBuffer(packet.indexBuffer);
+			state.indexBuffer = packet.indexBuffer;
+			stats.indexBufferChanges++;
+		}
+
+		if(packet.constantBuffer != kNoBuffer && (packet.constantBuffer != state.constantBuffer || packet.constantOffset != state.constantOffset)){
+			sink.SetConstantBuffer(packet.pipeline, packet.constantBuffer, packet.constantOffset);
+			state.constantBuffer = packet.constantBuffer;
+			state.constantOffset = packet.constantOffset;
+			stats.constantBufferChanges++;
+		}
+
+		if(packet.rootConstantCount > 0 && (packet.rootConstantCount != state.rootConstantCount ||
+			memcmp(packet.rootConstants, state.rootConstants, packet.rootConstantCount * sizeof(uint32_t)) != 0)){
+			sink.SetRootConstants(packet.pipeline, packet.rootConstantCount, packet.rootConstants);
+			state.rootConstantCount = packet.rootConstantCount;
+			memcpy(state.rootConstants, packet.rootConstants, packet.rootConstantCount * sizeof(uint32_t));
+			stats.rootConstantChanges++;
+		}
+
+		if(packet.indexBuffer != kNoBuffer){
+			sink.DrawIndexed(packet);
+		}else{
+			sink.Draw(packet);
+		}
+	}
+	stats.packets += count;
+}
@@ -0,0 +1,130 @@
+#include "DrawPacketTranslator.h"
+
+#include <cassert>
+
+class DrawPacketTranslator::Recorder {
+public:
+	Recorder(DrawPacketTranslator& translator, ID3D12GraphicsCommandList* commandList)
+		: mTranslator(translator), mCommandList(commandList) {
+	}
+
+	inline uint32_t GetRootSignature(PipelineHandle pipeline) const {
+		return mTranslator.mPipelines[pipeline].rootSignature;
+	}
+
+	inline void SetRootSignature(uint32_t rootSignature){
+		mCommandList->SetGraphicsRootSignature(mTranslator.mRootSignatures[rootSignature].Get());
+		mTranslator.mFrameConstantsBound = false;
+	}
+
+	inline void SetPipeline(PipelineHandle handle){
+		const Pipeline& pipeline = mTranslator.mPipelines[handle];
+		mCommandList->SetPipelineState(pipeline.pipelineState.Get());
+		if(pipeline.topology != mTranslator.mTopology){
+			mCommandList->IASetPrimitiveTopology(pipeline.topology);
+			mTranslator.mTopology = pipeline.topology;
+		}
+		if(!mTranslator.mFrameConstantsBound && pipeline.layout.frameConstants != DrawPipelineLayout::kNoParameter){
+			mCommandList->SetGraphicsRootConstantBufferView(pipeline.layout.frameConstants, mTranslator.mFrameConstants);
+			mTranslator.mFrameConstantsBound = true;
+		}
+	}
+
+	inline void SetVertexBuffer(BufferHandle buffer){
+		mCommandList->IASetVertexBuffers(0, 1, &mTranslator.mVertexBuffers[buffer]);
+	}
+
+	inline void SetIndexBuffer(BufferHandle buffer){
+		mCommandList->IASetIndexBuffer(&mTranslator.mIndexBuffers[buffer]);
+	}
+
+	inline void SetConstantBuffer(PipelineHandle pipeline, BufferHandle buffer, uint32_t offset){
+		uint32_t parameter = mTranslator.mPipelines[pipeline].layout.drawConstants;
+		assert(parameter != DrawPipelineLayout::kNoParameter);
+		mCommandList->SetGraphicsRootConstantBufferView(parameter, mTranslator.mConstantBuffers[buffer] + offset);
+	}
+
+	inline void SetRootConstants(PipelineHandle pipeline, uint32_t count, const uint32_t* values){
+		uint32_t parameter = mTranslator.mPipelines[pipeline].layout.rootConstants;
+		assert(parameter != DrawPipelineLayout::kNoParameter);
+		mCommandList->SetGraphicsRoot32BitConstants(parameter, count, values, 0);
+	}
+
+	inline void Draw(const DrawPacket& packet){
+		mCommandList->DrawInstanced(packet.count, packet.instanceCount, packet.first, packet.firstInstance);
+	}
+
+	inline void DrawIndexed(const DrawPacket& packet){
+		mCommandList->DrawIndexedInstanced(packet.count, packet.instanceCount, packet.first, packet.baseVertex, packet.firstInstance);
+	}
+
+private:
+	DrawPacketTranslator& mTranslator;
+	ID3D12GraphicsCommandList* mCommandList;
+};
+
+DrawPacketTranslator::DrawPacketTranslator() : mTopology(D3D_PRIMITIVE_TOPOLOGY_UNDEFINED), mFrameConstants(0), mFrameConstantsBound(false),
+	mStats() {
+	mState.Invalidate();
+}
+
+DrawPacketTranslator::~DrawPacketTranslator(){
+}
+
+PipelineHandle DrawPacketTranslator::RegisterPipeline(ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature,
+	D3D_PRIMITIVE_TOPOLOGY topology, const DrawPipelineLayout& layout){
+	assert(mPipelines.size() < 0xFFFF);
+
+	// Pipelines sharing a root signature share its id, so switching between
+	// them keeps the root arguments.
+	uint32_t rootSignatureIndex = 0;
+	while(rootSignatureIndex < mRootSignatures.size() && mRootSignatures[rootSignatureIndex].Get() != rootSignature){
+		rootSignatureIndex++;
+	}
+	if(rootSignatureIndex == mRootSignatures.size()){
+		mRootSignatures.push_back(rootSignature);
+	}
+
+	Pipeline pipeline;
+	pipeline.pipelineState = pipelineState;
+	pipeline.rootSignature = rootSignatureIndex;
+	pipeline.topology = topology;
+	pipeline.layout = layout;
+	mPipelines.push_back(pipeline);
+	return static_cast<PipelineHandle>(mPipelines.size() - 1);
+}
+
+BufferHandle DrawPacketTranslator::RegisterVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view){
+	assert(mVertexBuffers.size() < kNoBuffer);
+	mVertexBuffers.push_back(view);
+	return static_cast<BufferHandle>(mVertexBuffers.size() - 1);
+}
+
+BufferHandle DrawPacketTranslator::RegisterIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view){
+	assert(mIndexBuffers.size() < kNoBuffer);
+	mIndexBuffers.push_back(view);
+	return static_cast<BufferHandle>(mIndexBuffers.size() - 1);
+}
+
+BufferHandle DrawPacketTranslator::RegisterConstantBuffer(D3D12_GPU_VIRTUAL_ADDRESS baseAddress){
+	assert(mConstantBuffers.size() < kNoBuffer);
+	mConstantBuffers.push_back(baseAddress);
+	return static_cast<BufferHandle>(mConstantBuffers.size() - 1);
+}
+
+void DrawPacketTranslator::Begin(){
+	mState.Invalidate();
+	mTopology = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+	mFrameConstantsBound = false;
+	mStats = DrawPacketStats();
+}
+
+void DrawPacketTranslator::SetFrameConstants(D3D12_GPU_VIRTUAL_ADDRESS address){
+	mFrameConstants = address;
+	mFrameConstantsBound = false;
+}
+
+void DrawPacketTranslator::Translate(ID3D12GraphicsCommandList* commandList, const DrawPacketStream& stream){
+	Recorder recorder(*this, commandList);
+	TranslateDrawPackets(stream.GetPackets(), stream.GetCount(), mState, mStats, recorder);
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <vector>
+
+#include "DrawPacket.h"
+
+// Root parameters of a pipeline's root signature that packet data goes to,
+// kNoParameter for the ones it does not have.
+struct DrawPipelineLayout {
+	static const uint32_t kNoParameter = 0xFFFFFFFF;
+
+	uint32_t rootConstants;
+	// Root CBV for the packet's constantBuffer and constantOffset.
+	uint32_t drawConstants;
+	// Root CBV for SetFrameConstants' address.
+	uint32_t frameConstants;
+
+	static DrawPipelineLayout None() { return { kNoParameter, kNoParameter, kNoParameter }; }
+};
+
+// Turns DrawPacket streams into D3D12 commands. Pipelines and buffers are
+// registered once and referred to by handle afterwards. State the command
+// list already has is not set again.
+class DrawPacketTranslator {
+public:
+	DrawPacketTranslator();
+	~DrawPacketTranslator();
+
+	PipelineHandle RegisterPipeline(ID3D12PipelineState* pipelineState, ID3D12RootSignature* rootSignature,
+		D3D_PRIMITIVE_TOPOLOGY topology, const DrawPipelineLayout& layout = DrawPipelineLayout::None());
+	BufferHandle RegisterVertexBuffer(const D3D12_VERTEX_BUFFER_VIEW& view);
+	BufferHandle RegisterIndexBuffer(const D3D12_INDEX_BUFFER_VIEW& view);
+	// Packet constant offsets are relative to baseAddress.
+	BufferHandle RegisterConstantBuffer(D3D12_GPU_VIRTUAL_ADDRESS baseAddress);
+
+	// Forgets the tracked state and the stats. Call after the command list
+	// is reset, and whenever other code has set state on it in between.
+	void Begin();
+	// Constants shared by every draw until the next Begin, bound to each
+	// pipeline that has a frameConstants parameter. Set it right after Begin.
+	void SetFrameConstants(D3D12_GPU_VIRTUAL_ADDRESS address);
+	void Translate(ID3D12GraphicsCommandList* commandList, const DrawPacketStream& stream);
+
+	// Counts since the last Begin.
+	inline const DrawPacketStats& GetStats() const { return mStats; }
+
+private:
+	struct Pipeline {
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+		// Index into mRootSignatures.
+		uint32_t rootSignature;
+		D3D_PRIMITIVE_TOPOLOGY topology;
+		DrawPipelineLayout layout;
+	};
+
+	// Sink of TranslateDrawPackets, see DrawPacket.h.
+	class Recorder;
+
+	std::vector<Pipeline> mPipelines;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12RootSignature>> mRootSignatures;
+	std::vector<D3D12_VERTEX_BUFFER_VIEW> mVertexBuffers;
+	std::vector<D3D12_INDEX_BUFFER_VIEW> mIndexBuffers;
+	std::vector<D3D12_GPU_VIRTUAL_ADDRESS> mConstantBuffers;
+
+	DrawPacketState mState;
+	// Topology is part of the pipeline entry but command list state of its own.
+	D3D_PRIMITIVE_TOPOLOGY mTopology;
+	D3D12_GPU_VIRTUAL_ADDRESS mFrameConstants;
+	// Cleared with every root signature change.
+	bool mFrameConstantsBound;
+	DrawPacketStats mStats;
+};
@@ -0,0 +1,101 @@
+#include "DrawSortKey.h"
+
+#include <cassert>
+#include <chrono>
+
+#include "RadixSort.h"
+
+namespace {
+	const uint32_t kLayerShift = 60;
+	const uint32_t kPassShift = 58;
+	// Opaque layout.
+	const uint32_t kPipelineShift = 48;
+	const uint32_t kMaterialShift = 32;
+	const uint32_t kMeshShift = 16;
+	const uint32_t kDepthShift = 0;
+	// Transparent layout, depth first.
+	const uint32_t kTransparentDepthShift = 42;
+	const uint32_t kTransparentPipelineShift = 32;
+	const uint32_t kTransparentMaterialShift = 16;
+	const uint32_t kTransparentMeshShift = 0;
+
+	inline uint32_t Field(uint64_t key, uint32_t shift, uint32_t max){
+		return static_cast<uint32_t>(key >> shift) & max;
+	}
+}
+
+uint64_t EncodeDrawKey(const DrawKeyFields& fields){
+	assert(fields.layer <= kDrawKeyMaxLayer);
+	assert(fields.pipeline <= kDrawKeyMaxPipeline);
+	assert(fields.material <= kDrawKeyMaxMaterial);
+	assert(fields.mesh <= kDrawKeyMaxMesh);
+	assert(fields.depth <= kDrawKeyMaxDepth);
+
+	uint64_t key = static_cast<uint64_t>(fields.layer & kDrawKeyMaxLayer) << kLayerShift;
+	key |= static_cast<uint64_t>(static_cast<uint32_t>(fields.pass) & 3) << kPassShift;
+	if(fields.pass == DrawPass::Transparent){
+		key |= static_cast<uint64_t>(kDrawKeyMaxDepth - (fields.depth & kDrawKeyMaxDepth)) << kTransparentDepthShift;
+		key |= static_cast<uint64_t>(fields.pipeline & kDrawKeyMaxPipeline) << kTransparentPipelineShift;
+		key |= static_cast<uint64_t>(fields.material & kDrawKeyMaxMaterial) << kTransparentMaterialShift;
+		key |= static_cast<uint64_t>(fields.mesh & kDrawKeyMaxMesh) << kTransparentMeshShift;
+	}else{
+		key |= static_cast<uint64_t>(fields.pipeline & kDrawKeyMaxPipeline) << kPipelineShift;
+		key |= static_cast<uint64_t>(fields.material & kDrawKeyMaxMaterial) << kMaterialShift;
+		key |= static_cast<uint64_t>(fields.mesh & kDrawKeyMaxMesh) << kMeshShift;
+		key |= static_cast<uint64_t>(fields.depth & kDrawKeyMaxDepth) << kDepthShift;
+	}
+	return key;
+}
+
+DrawKeyFields DecodeDrawKey(uint64_t key){
+	DrawKeyFields fields;
+	fields.layer = Field(key, kLayerShift, kDrawKeyMaxLayer);
+	fields.pass = static_cast<DrawPass>(Field(key, kPassShift, 3));
+	if(fields.pass == DrawPass::Transparent){
+		fields.depth = kDrawKeyMaxDepth - Field(key, kTransparentDepthShift, kDrawKeyMaxDepth);
+		fields.pipeline = Field(key, kTransparentPipelineShift, kDrawKeyMaxPipeline);
+		fields.material = Field(key, kTransparentMaterialShift, kDrawKeyMaxMaterial);
+		fields.mesh = Field(key, kTransparentMeshShift, kDrawKeyMaxMesh);
+	}else{
+		fields.pipeline = Field(key, kPipelineShift, kDrawKeyMaxPipeline);
+		fields.material = Field(key, kMaterialShift, kDrawKeyMaxMaterial);
+		fields.mesh = Field(key, kMeshShift, kDrawKeyMaxMesh);
+		fields.depth = Field(key, kDepthShift, kDrawKeyMaxDepth);
+	}
+	return fields;
+}
+
+uint32_t QuantizeDepth(float viewDepth, float nearZ, float farZ){
+	float t = (viewDepth - nearZ) / (farZ - nearZ);
+	// Written so NaN lands on the far end too.
+	if(!(t < 1.0f)){
+		return kDrawKeyMaxDepth;
+	}
+	if(t <= 0.0f){
+		return 0;
+	}
+	return static_cast<uint32_t>(t * static_cast<float>(kDrawKeyMaxDepth) + 0.5f);
+}
+
+DrawList::DrawList() : mSortMilliseconds(0.0) {
+}
+
+void DrawList::Clear(){
+	mKeys.clear();
+	mDraws.clear();
+}
+
+void DrawList::Reserve(uint32_t count){
+	mKeys.reserve(count);
+	mDraws.reserve(count);
+}
+
+void DrawList::Sort(){
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	mScratchKeys.resize(mKeys.size());
+	mScratchDraws.resize(mDraws.size());
+	RadixSortPairs(mKeys.data(), mDraws.data(), mScratchKeys.data(), mScratchDraws.data(), GetCount());
+
+	mSortMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Every draw is described by a 64 bit key, and draws are recorded in key
+// order. From the top bit down an opaque key is
+//
+//   layer:4 pass:2 pipeline:10 material:16 mesh:16 depth:16
+//
+// so pipeline and material changes are grouped and each group goes front to
+// back for early Z. Transparent draws have to blend back to front, their
+// depth moves up under the pass and is inverted:
+//
+//   layer:4 pass:2 ~depth:16 pipeline:10 material:16 mesh:16
+
+enum class DrawPass : uint8_t { Opaque = 0, AlphaTested = 1, Transparent = 2 };
+
+struct DrawKeyFields {
+	uint32_t layer;
+	DrawPass pass;
+	uint32_t pipeline;
+	uint32_t material;
+	uint32_t mesh;
+	// QuantizeDepth's result, 0 is nearest.
+	uint32_t depth;
+};
+
+static const uint32_t kDrawKeyMaxLayer = (1u << 4) - 1;
+static const uint32_t kDrawKeyMaxPipeline = (1u << 10) - 1;
+static const uint32_t kDrawKeyMaxMaterial = (1u << 16) - 1;
+static const uint32_t kDrawKeyMaxMesh = (1u << 16) - 1;
+static const uint32_t kDrawKeyMaxDepth = (1u << 16) - 1;
+
+uint64_t EncodeDrawKey(const DrawKeyFields& fields);
+DrawKeyFields DecodeDrawKey(uint64_t key);
+
+// Maps view space depth linearly from [nearZ, farZ] to [0, kDrawKeyMaxDepth],
+// clamping outside the range.
+uint32_t QuantizeDepth(float viewDepth, float nearZ, float farZ);
+
+// Keys and the draw each one stands for, sorted once per frame.
+class DrawList {
+public:
+	DrawList();
+
+	void Clear();
+	void Reserve(uint32_t count);
+	inline void Add(uint64_t key, uint32_t draw) { mKeys.push_back(key); mDraws.push_back(draw); }
+
+	// Radix sorts by key. Draws with equal keys keep the order they were added in.
+	void Sort();
+
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(mKeys.size()); }
+	inline const uint64_t* GetKeys() const { return mKeys.data(); }
+	inline const uint32_t* GetDraws() const { return mDraws.data(); }
+	inline double GetSortMilliseconds() const { return mSortMilliseconds; }
+
+private:
+	std::vector<uint64_t> mKeys;
+	std::vector<uint32_t> mDraws;
+	// Kept between frames so sorting does not allocate.
+	std::vector<uint64_t> mScratchKeys;
+	std::vector<uint32_t> mScratchDraws;
+	double mSortMilliseconds;
+};
@@ -0,0 +1,338 @@
+#include "EntityWorld.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+namespace {
+	// Component types register the first time any thread asks for their id,
+	// which can be on several threads at once. Registering takes the lock,
+	// lookups don't: a slot is written before the count that publishes it
+	// and never moves afterwards.
+	struct ComponentRegistry {
+		std::mutex mutex;
+		std::atomic<uint32_t> count;
+		ComponentInfo infos[kMaxComponents];
+	};
+
+	ComponentRegistry& GetRegistry(){
+		static ComponentRegistry registry;
+		return registry;
+	}
+
+	uint32_t AlignUp(uint32_t value, uint32_t alignment){
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Chunks are cache line aligned so the first element of every column is too.
+	const uint32_t kChunkAlignment = 64;
+
+	uint8_t* AllocateChunk(){
+		#if defined(_MSC_VER)
+		return static_cast<uint8_t*>(_aligned_malloc(EntityWorld::kChunkSize, kChunkAlignment));
+		#else
+		return static_cast<uint8_t*>(aligned_alloc(kChunkAlignment, EntityWorld::kChunkSize));
+		#endif
+	}
+
+	void FreeChunk(uint8_t* data){
+		#if defined(_MSC_VER)
+		_aligned_free(data);
+		#else
+		free(data);
+		#endif
+	}
+
+	// Byte layout of a chunk holding capacity entities, returns the total size.
+	uint32_t LayoutColumns(const std::vector<ComponentId>& components, uint32_t capacity, std::vector<uint32_t>& offsets){
+		uint32_t offset = capacity * sizeof(Entity);
+		offsets.resize(components.size());
+		for(size_t i = 0; i < components.size(); i++){
+			const ComponentInfo& info = EcsDetail::GetComponentInfo(components[i]);
+			offset = AlignUp(offset, info.alignment);
+			offsets[i] = offset;
+			offset += info.size * capacity;
+		}
+		return offset;
+	}
+}
+
+ComponentId EcsDetail::RegisterComponent(uint32_t size, uint32_t alignment){
+	ComponentRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	const uint32_t id = registry.count.load(std::memory_order_relaxed);
+	assert(id < kMaxComponents && "Too many component types for a 64 bit mask");
+	registry.infos[id] = { size, alignment };
+	registry.count.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+const ComponentInfo& EcsDetail::GetComponentInfo(ComponentId id){
+	ComponentRegistry& registry = GetRegistry();
+	assert(id < registry.count.load(std::memory_order_acquire));
+	return registry.infos[id];
+}
+
+EntityWorld::EntityWorld() :mEmptyArchetype(nullptr), mAliveCount(0), mIterating(0) {
+	mEmptyArchetype = GetOrCreateArchetype(0);
+}
+
+EntityWorld::~EntityWorld(){
+	for(Archetype* archetype : mArchetypeList){
+		for(ArchetypeChunk& chunk : archetype->chunks){
+			FreeChunk(chunk.data);
+		}
+	}
+}
+
+Archetype* EntityWorld::GetOrCreateArchetype(ComponentMask mask){
+	auto found = mArchetypes.find(mask);
+	if(found != mArchetypes.end()){
+		return found->second.get();
+	}
+
+	std::unique_ptr<Archetype> archetype(new Archetype());
+	archetype->mask = mask;
+	archetype->entityCount = 0;
+	std::fill(std::begin(archetype->columnOf), std::end(archetype->columnOf), static_cast<int8_t>(-1));
+	std::fill(std::begin(archetype->addEdge), std::end(archetype->addEdge), nullptr);
+	std::fill(std::begin(archetype->removeEdge), std::end(archetype->removeEdge), nullptr);
+
+	for(ComponentId id = 0; id < kMaxComponents; id++){
+		if(mask & (ComponentMask(1) << id)){
+			archetype->columnOf[id] = static_cast<int8_t>(archetype->components.size());
+			archetype->components.push_back(id);
+		}
+	}
+
+	// Fit as many entities as the chunk holds once columns are aligned.
+	uint32_t bytesPerEntity = sizeof(Entity);
+	for(ComponentId id : archetype->components){
+		bytesPerEntity += EcsDetail::GetComponentInfo(id).size;
+	}
+	uint32_t capacity = kChunkSize / bytesPerEntity;
+	while(capacity > 1 && LayoutColumns(archetype->components, capacity, archetype->columnOffsets) > kChunkSize){
+		capacity--;
+	}
+	assert(LayoutColumns(archetype->components, capacity, archetype->columnOffsets) <= kChunkSize && "Components too large for one chunk");
+	archetype->capacity = capacity;
+
+	Archetype* result = archetype.get();
+	mArchetypes.emplace(mask, std::move(archetype));
+	mArchetypeList.push_back(result);
+	return result;
+}
+
+Entity EntityWorld::ReserveEntity(){
+	uint32_t index;
+	if(!mFreeIndices.empty()){
+		index = mFreeIndices.back();
+		mFreeIndices.pop_back();
+	}else{
+		index = static_cast<uint32_t>(mRecords.size());
+		mRecords.push_back({ nullptr, 0, 0, 0 });
+	}
+
+	mAliveCount++;
+	EntityRecord& record = mRecords[index];
+	record.archetype = nullptr;
+	return { index, record.generation };
+}
+
+void EntityWorld::PlaceReservedEntity(Entity entity){
+	assert(mIterating == 0);
+	if(IsAlive(entity) && mRecords[entity.index].archetype == nullptr){
+		AllocateRow(mEmptyArchetype, entity);
+	}
+}
+
+Entity EntityWorld::CreateEntity(){
+	assert(mIterating == 0);
+	Entity entity = ReserveEntity();
+	AllocateRow(mEmptyArchetype, entity);
+	return entity;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+	return entity.index < mRecords.size() && mRecords[entity.index].generation == entity.generation;
+}
+
+void EntityWorld::DestroyEntity(Entity entity){
+	assert(mIterating == 0);
+	if(!IsAlive(entity)){
+		return;
+	}
+
+	EntityRecord& record = mRecords[entity.index];
+	if(record.archetype){
+		FreeRow(record.archetype, record.chunk, record.row);
+	}
+
+	// Bumping the generation invalidates every copy of this handle.
+	record.archetype = nullptr;
+	record.generation++;
+	mFreeIndices.push_back(entity.index);
+	mAliveCount--;
+}
+
+void EntityWorld::AllocateRow(Archetype* archetype, Entity entity){
+	if(archetype->chunks.empty() || archetype->chunks.back().count == archetype->capacity){
+		archetype->chunks.push_back({ AllocateChunk(), 0 });
+	}
+
+	ArchetypeChunk& chunk = archetype->chunks.back();
+	uint32_t row = chunk.count++;
+	archetype->GetEntities(chunk)[row] = entity;
+	archetype->entityCount++;
+
+	EntityRecord& record = mRecords[entity.index];
+	record.archetype = archetype;
+	record.chunk = static_cast<uint32_t>(archetype->chunks.size() - 1);
+	record.row = row;
+}
+
+void EntityWorld::FreeRow(Archetype* archetype, uint32_t chunkIndex, uint32_t row){
+	ArchetypeChunk& last = archetype->chunks.back();
+	uint32_t lastChunkIndex = static_cast<uint32_t>(archetype->chunks.size() - 1);
+	uint32_t lastRow = last.count - 1;
+
+	// Swap the last entity into the hole to keep the chunks packed.
+	if(chunkIndex != lastChunkIndex || row != lastRow){
+		ArchetypeChunk& chunk = archetype->chunks[chunkIndex];
+		Entity moved = archetype->GetEntities(last)[lastRow];
+		archetype->GetEntities(chunk)[row] = moved;
+		for(size_t column = 0; column < archetype->components.size(); column++){
+			uint32_t size = EcsDetail::GetComponentInfo(archetype->components[column]).size;
+			memcpy(archetype->GetComponent(chunkIndex, row, static_cast<int>(column)),
+				archetype->GetComponent(lastChunkIndex, lastRow, static_cast<int>(column)), size);
+		}
+		mRecords[moved.index].chunk = chunkIndex;
+		mRecords[moved.index].row = row;
+	}
+
+	last.count--;
+	archetype->entityCount--;
+	if(last.count == 0){
+		FreeChunk(last.data);
+		archetype->chunks.pop_back();
+	}
+}
+
+void EntityWorld::MoveEntity(Entity entity, Archetype* target){
+	EntityRecord record = mRecords[entity.index];
+	Archetype* source = record.archetype;
+
+	AllocateRow(target, entity);
+	const EntityRecord& placed = mRecords[entity.index];
+
+	// Copy the components both archetypes share.
+	for(size_t column = 0; column < source->components.size(); column++){
+		ComponentId id = source->components[column];
+		int targetColumn = target->columnOf[id];
+		if(targetColumn >= 0){
+			memcpy(target->GetComponent(placed.chunk, placed.row, targetColumn),
+				source->GetComponent(record.chunk, record.row, static_cast<int>(column)),
+				EcsDetail::GetComponentInfo(id).size);
+		}
+	}
+
+	FreeRow(source, record.chunk, record.row);
+}
+
+void EntityWorld::AddComponentRaw(Entity entity, ComponentId component, const void* data){
+	assert(mIterating == 0);
+	if(!IsAlive(entity)){
+		return;
+	}
+
+	if(mRecords[entity.index].archetype == nullptr){
+		AllocateRow(mEmptyArchetype, entity);
+	}
+
+	Archetype* source = mRecords[entity.index].archetype;
+	if(source->columnOf[component] < 0){
+		Archetype* target = source->addEdge[component];
+		if(target == nullptr){
+			target = GetOrCreateArchetype(source->mask | (ComponentMask(1) << component));
+			source->addEdge[component] = target;
+		}
+		MoveEntity(entity, target);
+	}
+
+	const EntityRecord& record = mRecords[entity.index];
+	memcpy(record.archetype->GetComponent(record.chunk, record.row, record.archetype->columnOf[component]),
+		data, EcsDetail::GetComponentInfo(component).size);
+}
+
+void EntityWorld::RemoveComponentRaw(Entity entity, ComponentId component){
+	assert(mIterating == 0);
+	if(!IsAlive(entity) || mRecords[entity.index].archetype == nullptr){
+		return;
+	}
+
+	Archetype* source = mRecords[entity.index].archetype;
+	if(source->columnOf[component] < 0){
+		return;
+	}
+
+	Archetype* target = source->removeEdge[component];
+	if(target == nullptr){
+		target = GetOrCreateArchetype(source->mask & ~(ComponentMask(1) << component));
+		source->removeEdge[component] = target;
+	}
+	MoveEntity(entity, target);
+}
+
+void* EntityWorld::GetComponentRaw(Entity entity, ComponentId component){
+	if(!IsAlive(entity) || mRecords[entity.index].archetype == nullptr){
+		return nullptr;
+	}
+
+	const EntityRecord& record = mRecords[entity.index];
+	int column = record.archetype->columnOf[component];
+	if(column < 0){
+		return nullptr;
+	}
+	return record.archetype->GetComponent(record.chunk, record.row, column);
+}
+
+EntityCommandBuffer::EntityCommandBuffer(EntityWorld& world) :mWorld(world) {
+
+}
+
+EntityCommandBuffer::~EntityCommandBuffer(){
+	assert(mCommands.empty() && "EntityCommandBuffer destroyed without Playback");
+}
+
+Entity EntityCommandBuffer::CreateEntity(){
+	Entity entity = mWorld.ReserveEntity();
+	mCommands.push_back({ CommandType::Create, 0, entity, 0 });
+	return entity;
+}
+
+void EntityCommandBuffer::DestroyEntity(Entity entity){
+	mCommands.push_back({ CommandType::Destroy, 0, entity, 0 });
+}
+
+void EntityCommandBuffer::Playback(){
+	for(const Command& command : mCommands){
+		switch(command.type){
+			case CommandType::Create:
+				mWorld.PlaceReservedEntity(command.entity);
+				break;
+			case CommandType::Destroy:
+				mWorld.DestroyEntity(command.entity);
+				break;
+			case CommandType::Add:
+				mWorld.AddComponentRaw(command.entity, command.component, mData.data() + command.dataOffset);
+				break;
+			case CommandType::Remove:
+				mWorld.RemoveComponentRaw(command.entity, command.component);
+				break;
+		}
+	}
+
+	mCommands.clear();
+	mData.clear();
+}
@@ -0,0 +1,272 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Archetype based entity storage. Every distinct set of component types is an
+// archetype, and its entities live in fixed size chunks that hold one tightly
+// packed array per component. Queries walk those arrays linearly.
+
+typedef uint32_t ComponentId;
+typedef uint64_t ComponentMask;
+static const uint32_t kMaxComponents = 64;
+
+struct Entity {
+	uint32_t index;
+	uint32_t generation;
+
+	inline bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	inline bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+static const Entity kNullEntity = { 0xFFFFFFFF, 0 };
+
+struct ComponentInfo {
+	uint32_t size;
+	uint32_t alignment;
+};
+
+namespace EcsDetail {
+	ComponentId RegisterComponent(uint32_t size, uint32_t alignment);
+	const ComponentInfo& GetComponentInfo(ComponentId id);
+}
+
+// Components are plain data, the storage moves them around with memcpy.
+// Ids are handed out on first use and can be asked for from any thread.
+template<typename T>
+ComponentId GetComponentId(){
+	static_assert(std::is_trivially_copyable<T>::value, "Components must be trivially copyable");
+	static const ComponentId id = EcsDetail::RegisterComponent(sizeof(T), alignof(T));
+	return id;
+}
+
+template<typename... Ts>
+ComponentMask MakeComponentMask(){
+	return (ComponentMask(0) | ... | (ComponentMask(1) << GetComponentId<Ts>()));
+}
+
+struct ArchetypeChunk {
+	uint8_t* data;
+	uint32_t count;
+};
+
+struct Archetype {
+	ComponentMask mask;
+	// Component ids in ascending order, one column per component.
+	std::vector<ComponentId> components;
+	// Byte offset of each column inside a chunk, the entity ids come first.
+	std::vector<uint32_t> columnOffsets;
+	// Column of each component id, -1 when the archetype does not have it.
+	int8_t columnOf[kMaxComponents];
+	// Entities per chunk.
+	uint32_t capacity;
+	// Every chunk is full except the last one.
+	std::vector<ArchetypeChunk> chunks;
+	uint32_t entityCount;
+
+	// Cached archetype reached by adding or removing one component.
+	Archetype* addEdge[kMaxComponents];
+	Archetype* removeEdge[kMaxComponents];
+
+	inline Entity* GetEntities(const ArchetypeChunk& chunk) const { return reinterpret_cast<Entity*>(chunk.data); }
+	inline void* GetColumn(const ArchetypeChunk& chunk, int column) const { return chunk.data + columnOffsets[column]; }
+	inline void* GetComponent(uint32_t chunk, uint32_t row, int column) const {
+		return chunks[chunk].data + columnOffsets[column] + row * EcsDetail::GetComponentInfo(components[column]).size;
+	}
+};
+
+class EntityWorld {
+public:
+	// Size of one chunk of component storage.
+	static const uint32_t kChunkSize = 16 * 1024;
+
+	EntityWorld();
+	~EntityWorld();
+
+	Entity CreateEntity();
+	template<typename... Ts>
+	Entity CreateEntity(const Ts&... components);
+	void DestroyEntity(Entity entity);
+	bool IsAlive(Entity entity) const;
+
+	// Adding or removing a component moves the entity to another archetype.
+	template<typename T>
+	void AddComponent(Entity entity, const T& component){ AddComponentRaw(entity, GetComponentId<T>(), &component); }
+	template<typename T>
+	void RemoveComponent(Entity entity){ RemoveComponentRaw(entity, GetComponentId<T>()); }
+	template<typename T>
+	T* GetComponent(Entity entity){ return static_cast<T*>(GetComponentRaw(entity, GetComponentId<T>())); }
+	template<typename T>
+	bool HasComponent(Entity entity) const;
+
+	// Calls func(Entity, Ts&...) for every entity that has all of Ts.
+	// Structural changes are not allowed inside, record them in an
+	// EntityCommandBuffer instead.
+	template<typename... Ts, typename Func>
+	void ForEach(Func&& func);
+	// Calls func(count, const Entity*, Ts*...) once per chunk, for loops that
+	// want the raw arrays.
+	template<typename... Ts, typename Func>
+	void ForEachChunk(Func&& func);
+
+	inline uint32_t GetEntityCount() const { return mAliveCount; }
+	inline uint32_t GetArchetypeCount() const { return static_cast<uint32_t>(mArchetypeList.size()); }
+
+	// Used by EntityCommandBuffer. A reserved entity is alive but has no
+	// storage until a command places it.
+	Entity ReserveEntity();
+	void PlaceReservedEntity(Entity entity);
+	void AddComponentRaw(Entity entity, ComponentId component, const void* data);
+	void RemoveComponentRaw(Entity entity, ComponentId component);
+	void* GetComponentRaw(Entity entity, ComponentId component);
+
+private:
+	struct EntityRecord {
+		Archetype* archetype;
+		uint32_t chunk;
+		uint32_t row;
+		uint32_t generation;
+	};
+
+	Archetype* GetOrCreateArchetype(ComponentMask mask);
+	// Puts the entity in a new row at the end of archetype.
+	void AllocateRow(Archetype* archetype, Entity entity);
+	// Fills the hole left at (chunk, row) with the archetype's last entity.
+	void FreeRow(Archetype* archetype, uint32_t chunk, uint32_t row);
+	void MoveEntity(Entity entity, Archetype* target);
+
+	template<typename... Ts, typename Func, size_t... I>
+	void RunChunk(Archetype& archetype, const ArchetypeChunk& chunk, const int* columns, Func& func, std::index_sequence<I...>);
+
+private:
+	std::unordered_map<ComponentMask, std::unique_ptr<Archetype>> mArchetypes;
+	std::vector<Archetype*> mArchetypeList;
+	Archetype* mEmptyArchetype;
+
+	std::vector<EntityRecord> mRecords;
+	std::vector<uint32_t> mFreeIndices;
+	uint32_t mAliveCount;
+	// Non zero while a query runs, guards against structural changes.
+	uint32_t mIterating;
+
+	EntityWorld(const EntityWorld&) = delete;
+	EntityWorld& operator=(const EntityWorld&) = delete;
+};
+
+// Records structural changes while queries are running and applies them
+// later, in the order they were recorded.
+class EntityCommandBuffer {
+public:
+	explicit EntityCommandBuffer(EntityWorld& world);
+	~EntityCommandBuffer();
+
+	// The returned entity is usable in later commands right away.
+	Entity CreateEntity();
+	void DestroyEntity(Entity entity);
+	template<typename T>
+	void AddComponent(Entity entity, const T& component);
+	template<typename T>
+	void RemoveComponent(Entity entity);
+
+	void Playback();
+	inline bool IsEmpty() const { return mCommands.empty(); }
+
+private:
+	enum class CommandType : uint8_t { Create, Destroy, Add, Remove };
+
+	struct Command {
+		CommandType type;
+		ComponentId component;
+		Entity entity;
+		// Where the component value starts in mData for Add.
+		uint32_t dataOffset;
+	};
+
+	EntityWorld& mWorld;
+	std::vector<Command> mCommands;
+	std::vector<uint8_t> mData;
+};
+
+template<typename... Ts>
+Entity EntityWorld::CreateEntity(const Ts&... components){
+	assert(mIterating == 0);
+	Entity entity = ReserveEntity();
+	Archetype* archetype = GetOrCreateArchetype(MakeComponentMask<Ts...>());
+	AllocateRow(archetype, entity);
+
+	const EntityRecord& record = mRecords[entity.index];
+	(memcpy(archetype->GetComponent(record.chunk, record.row, archetype->columnOf[GetComponentId<Ts>()]), &components, sizeof(Ts)), ...);
+	return entity;
+}
+
+template<typename T>
+bool EntityWorld::HasComponent(Entity entity) const {
+	if(!IsAlive(entity) || mRecords[entity.index].archetype == nullptr){
+		return false;
+	}
+	return (mRecords[entity.index].archetype->mask & (ComponentMask(1) << GetComponentId<T>())) != 0;
+}
+
+template<typename... Ts, typename Func, size_t... I>
+void EntityWorld::RunChunk(Archetype& archetype, const ArchetypeChunk& chunk, const int* columns, Func& func, std::index_sequence<I...>){
+	std::tuple<Ts*...> arrays(static_cast<Ts*>(archetype.GetColumn(chunk, columns[I]))...);
+	const Entity* entities = archetype.GetEntities(chunk);
+	for(uint32_t row = 0; row < chunk.count; row++){
+		func(entities[row], std::get<I>(arrays)[row]...);
+	}
+}
+
+template<typename... Ts, typename Func>
+void EntityWorld::ForEach(Func&& func){
+	const ComponentMask required = MakeComponentMask<Ts...>();
+	mIterating++;
+	for(Archetype* archetype : mArchetypeList){
+		if((archetype->mask & required) != required || archetype->entityCount == 0){
+			continue;
+		}
+
+		const int columns[] = { archetype->columnOf[GetComponentId<Ts>()]..., 0 };
+		for(const ArchetypeChunk& chunk : archetype->chunks){
+			RunChunk<Ts...>(*archetype, chunk, columns, func, std::index_sequence_for<Ts...>{});
+		}
+	}
+	mIterating--;
+}
+
+template<typename... Ts, typename Func>
+void EntityWorld::ForEachChunk(Func&& func){
+	const ComponentMask required = MakeComponentMask<Ts...>();
+	mIterating++;
+	for(Archetype* archetype : mArchetypeList){
+		if((archetype->mask & required) != required || archetype->entityCount == 0){
+			continue;
+		}
+
+		for(const ArchetypeChunk& chunk : archetype->chunks){
+			func(chunk.count, static_cast<const Entity*>(archetype->GetEntities(chunk)),
+				static_cast<Ts*>(archetype->GetColumn(chunk, archetype->columnOf[GetComponentId<Ts>()]))...);
+		}
+	}
+	mIterating--;
+}
+
+template<typename T>
+void EntityCommandBuffer::AddComponent(Entity entity, const T& component){
+	Command command = { CommandType::Add, GetComponentId<T>(), entity, static_cast<uint32_t>(mData.size()) };
+	mData.resize(mData.size() + sizeof(T));
+	memcpy(mData.data() + command.dataOffset, &component, sizeof(T));
+	mCommands.push_back(command);
+}
+
+template<typename T>
+void EntityCommandBuffer::RemoveComponent(Entity entity){
+	Command command = { CommandType::Remove, GetComponentId<T>(), entity, 0 };
+	mCommands.push_back(command);
+}
@@ -0,0 +1,62 @@
+#include "Frustum.h"
+
+#include <cmath>
+
+namespace {
+	void SetPlane(float* plane, float a, float b, float c, float d){
+		float length = std::sqrt(a * a + b * b + c * c);
+		float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+		plane[0] = a * invLength;
+		plane[1] = b * invLength;
+		plane[2] = c * invLength;
+		plane[3] = d * invLength;
+	}
+}
+
+Frustum Frustum::FromViewProjection(const float* m){
+	// Column c of the matrix produces clip component c.
+	auto col = [m](int r, int c){ return m[r * 4 + c]; };
+
+	Frustum frustum;
+	SetPlane(frustum.planes[Left],   col(0, 3) + col(0, 0), col(1, 3) + col(1, 0), col(2, 3) + col(2, 0), col(3, 3) + col(3, 0));
+	SetPlane(frustum.planes[Right],  col(0, 3) - col(0, 0), col(1, 3) - col(1, 0), col(2, 3) - col(2, 0), col(3, 3) - col(3, 0));
+	SetPlane(frustum.planes[Bottom], col(0, 3) + col(0, 1), col(1, 3) + col(1, 1), col(2, 3) + col(2, 1), col(3, 3) + col(3, 1));
+	SetPlane(frustum.planes[Top],    col(0, 3) - col(0, 1), col(1, 3) - col(1, 1), col(2, 3) - col(2, 1), col(3, 3) - col(3, 1));
+	SetPlane(frustum.planes[Near],   col(0, 2), col(1, 2), col(2, 2), col(3, 2));
+	SetPlane(frustum.planes[Far],    col(0, 3) - col(0, 2), col(1, 3) - col(1, 2), col(2, 3) - col(2, 2), col(3, 3) - col(3, 2));
+	return frustum;
+}
+
+Frustum Frustum::Identity(){
+	const float identity[16] = {
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f
+	};
+	return FromViewProjection(identity);
+}
+
+bool Frustum::IntersectsSphere(const float center[3], float radius) const {
+	for(int i = 0; i < Count; i++){
+		const float* p = planes[i];
+		if(p[0] * center[0] + p[1] * center[1] + p[2] * center[2] + p[3] < -radius){
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::IntersectsAABB(const float boxMin[3], const float boxMax[3]) const {
+	for(int i = 0; i < Count; i++){
+		const float* p = planes[i];
+		// Test the corner furthest along the plane normal.
+		float x = p[0] >= 0.0f ? boxMax[0] : boxMin[0];
+		float y = p[1] >= 0.0f ? boxMax[1] : boxMin[1];
+		float z = p[2] >= 0.0f ? boxMax[2] : boxMin[2];
+		if(p[0] * x + p[1] * y + p[2] * z + p[3] < 0.0f){
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+
+// Six clip planes stored as (a, b, c, d) with the normal pointing inward.
+// A point p is inside a plane when a*p.x + b*p.y + c*p.z + d >= 0.
+struct Frustum {
+	enum Plane { Left = 0, Right, Bottom, Top, Near, Far, Count };
+
+	float planes[Count][4];
+
+	// Extracts the planes from a row-major view-projection matrix using the
+	// DirectXMath row-vector convention (clip = v * M) and D3D depth [0, 1].
+	static Frustum FromViewProjection(const float* m);
+
+	// Clip space itself, handy when positions are already projected.
+	static Frustum Identity();
+
+	bool IntersectsSphere(const float center[3], float radius) const;
+	bool IntersectsAABB(const float boxMin[3], const float boxMax[3]) const;
+};
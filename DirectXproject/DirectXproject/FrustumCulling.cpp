@@ -0,0 +1,286 @@
+#include "FrustumCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// Below this many objects threading costs more than it saves.
+	const uint32_t kParallelThreshold = 16 * 1024;
+	// Multiple of 8 so every chunk but the last runs full SIMD batches.
+	const uint32_t kChunkSize = 8 * 1024;
+
+	// Source arrays for one kernel call. Spheres leave the extents null and
+	// use the radius instead, boxes do the opposite.
+	struct BoundsView {
+		const float* x;
+		const float* y;
+		const float* z;
+		const float* radius;
+		const float* extentX;
+		const float* extentY;
+		const float* extentZ;
+	};
+
+	// Kernels cull [begin, end) and write visible indices to out, returning the count.
+	typedef uint32_t(*CullKernel)(const Frustum&, const BoundsView&, uint32_t, uint32_t, uint32_t*);
+
+	inline float Distance(const float* plane, float x, float y, float z){
+		return ((plane[0] * x + plane[1] * y) + plane[2] * z) + plane[3];
+	}
+
+	// Projected half size of the box on the plane normal.
+	inline float Reach(const float* plane, const BoundsView& bounds, uint32_t i){
+		if(bounds.radius){
+			return bounds.radius[i];
+		}
+		return (std::fabs(plane[0]) * bounds.extentX[i] + std::fabs(plane[1]) * bounds.extentY[i]) + std::fabs(plane[2]) * bounds.extentZ[i];
+	}
+
+	uint32_t CullScalar(const Frustum& frustum, const BoundsView& bounds, uint32_t begin, uint32_t end, uint32_t* out){
+		uint32_t count = 0;
+		for(uint32_t i = begin; i < end; i++){
+			bool inside = true;
+			for(int p = 0; p < Frustum::Count && inside; p++){
+				const float* plane = frustum.planes[p];
+				inside = Distance(plane, bounds.x[i], bounds.y[i], bounds.z[i]) >= -Reach(plane, bounds, i);
+			}
+			if(inside){
+				out[count++] = i;
+			}
+		}
+		return count;
+	}
+
+	#if defined(CPU_X86)
+	// Appends base + bit for every set bit of mask.
+	inline uint32_t WriteIndices(unsigned int mask, uint32_t base, uint32_t* out){
+		uint32_t count = 0;
+		while(mask){
+			#if defined(_MSC_VER)
+			unsigned long bit;
+			_BitScanForward(&bit, mask);
+			#else
+			unsigned int bit = static_cast<unsigned int>(__builtin_ctz(mask));
+			#endif
+			out[count++] = base + bit;
+			mask &= mask - 1;
+		}
+		return count;
+	}
+
+	SIMD_TARGET_SSE41 uint32_t CullSSE(const Frustum& frustum, const BoundsView& bounds, uint32_t begin, uint32_t end, uint32_t* out){
+		const __m128 signMask = _mm_set1_ps(-0.0f);
+		__m128 planes[Frustum::Count][4];
+		__m128 absNormals[Frustum::Count][3];
+		for(int p = 0; p < Frustum::Count; p++){
+			for(int c = 0; c < 4; c++){
+				planes[p][c] = _mm_set1_ps(frustum.planes[p][c]);
+			}
+			for(int c = 0; c < 3; c++){
+				absNormals[p][c] = _mm_andnot_ps(signMask, planes[p][c]);
+			}
+		}
+
+		uint32_t count = 0;
+		uint32_t i = begin;
+		for(; i + 4 <= end; i += 4){
+			__m128 x = _mm_loadu_ps(bounds.x + i);
+			__m128 y = _mm_loadu_ps(bounds.y + i);
+			__m128 z = _mm_loadu_ps(bounds.z + i);
+			__m128 radius = bounds.radius ? _mm_loadu_ps(bounds.radius + i) : _mm_setzero_ps();
+			__m128 ex, ey, ez;
+			if(!bounds.radius){
+				ex = _mm_loadu_ps(bounds.extentX + i);
+				ey = _mm_loadu_ps(bounds.extentY + i);
+				ez = _mm_loadu_ps(bounds.extentZ + i);
+			}
+
+			__m128 outside = _mm_setzero_ps();
+			for(int p = 0; p < Frustum::Count; p++){
+				__m128 distance = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(planes[p][0], x), _mm_mul_ps(planes[p][1], y)), _mm_mul_ps(planes[p][2], z)), planes[p][3]);
+				__m128 reach = radius;
+				if(!bounds.radius){
+					reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(absNormals[p][0], ex), _mm_mul_ps(absNormals[p][1], ey)), _mm_mul_ps(absNormals[p][2], ez));
+				}
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_xor_ps(reach, signMask)));
+			}
+
+			unsigned int visibleMask = ~static_cast<unsigned int>(_mm_movemask_ps(outside)) & 0xF;
+			count += WriteIndices(visibleMask, i, out + count);
+		}
+
+		return count + CullScalar(frustum, bounds, i, end, out + count);
+	}
+
+	SIMD_TARGET_AVX2 uint32_t CullAVX2(const Frustum& frustum, const BoundsView& bounds, uint32_t begin, uint32_t end, uint32_t* out){
+		const __m256 signMask = _mm256_set1_ps(-0.0f);
+		__m256 planes[Frustum::Count][4];
+		__m256 absNormals[Frustum::Count][3];
+		for(int p = 0; p < Frustum::Count; p++){
+			for(int c = 0; c < 4; c++){
+				planes[p][c] = _mm256_set1_ps(frustum.planes[p][c]);
+			}
+			for(int c = 0; c < 3; c++){
+				absNormals[p][c] = _mm256_andnot_ps(signMask, planes[p][c]);
+			}
+		}
+
+		uint32_t count = 0;
+		uint32_t i = begin;
+		for(; i + 8 <= end; i += 8){
+			__m256 x = _mm256_loadu_ps(bounds.x + i);
+			__m256 y = _mm256_loadu_ps(bounds.y + i);
+			__m256 z = _mm256_loadu_ps(bounds.z + i);
+			__m256 radius = bounds.radius ? _mm256_loadu_ps(bounds.radius + i) : _mm256_setzero_ps();
+			__m256 ex, ey, ez;
+			if(!bounds.radius){
+				ex = _mm256_loadu_ps(bounds.extentX + i);
+				ey = _mm256_loadu_ps(bounds.extentY + i);
+				ez = _mm256_loadu_ps(bounds.extentZ + i);
+			}
+
+			// Separate multiplies and adds rather than FMA, so results match
+			// the scalar path exactly on every object.
+			__m256 outside = _mm256_setzero_ps();
+			for(int p = 0; p < Frustum::Count; p++){
+				__m256 distance = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(planes[p][0], x), _mm256_mul_ps(planes[p][1], y)), _mm256_mul_ps(planes[p][2], z)), planes[p][3]);
+				__m256 reach = radius;
+				if(!bounds.radius){
+					reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(absNormals[p][0], ex), _mm256_mul_ps(absNormals[p][1], ey)), _mm256_mul_ps(absNormals[p][2], ez));
+				}
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_xor_ps(reach, signMask), _CMP_LT_OQ));
+			}
+
+			unsigned int visibleMask = ~static_cast<unsigned int>(_mm256_movemask_ps(outside)) & 0xFF;
+			count += WriteIndices(visibleMask, i, out + count);
+		}
+
+		return count + CullScalar(frustum, bounds, i, end, out + count);
+	}
+	#endif
+
+	CullKernel SelectKernel(CullPath path){
+		if(path == CullPath::Auto){
+			path = GetBestCullPath();
+		}
+
+		#if defined(CPU_X86)
+		const CpuFeatures& features = CpuFeatures::Get();
+		if(path == CullPath::AVX2 && features.avx2){
+			return CullAVX2;
+		}
+		if(path == CullPath::SSE && features.sse41){
+			return CullSSE;
+		}
+		#endif
+		return CullScalar;
+	}
+
+	void Cull(const Frustum& frustum, const BoundsView& bounds, uint32_t count, std::vector<uint32_t>& visible, CullPath path){
+		CullKernel kernel = SelectKernel(path);
+		visible.resize(count);
+
+		if(count < kParallelThreshold){
+			visible.resize(kernel(frustum, bounds, 0, count, visible.data()));
+			return;
+		}
+
+		// Each chunk writes into its own slice of visible, the slices are then
+		// packed together in order so the output stays sorted.
+		const uint32_t chunkCount = (count + kChunkSize - 1) / kChunkSize;
+		std::vector<uint32_t> chunkVisible(chunkCount);
+		JobSystem::GetInstance()->ParallelFor(chunkCount, 1, [&](uint32_t first, uint32_t last){
+			for(uint32_t chunk = first; chunk < last; chunk++){
+				uint32_t begin = chunk * kChunkSize;
+				uint32_t end = std::min(count, begin + kChunkSize);
+				chunkVisible[chunk] = kernel(frustum, bounds, begin, end, visible.data() + begin);
+			}
+		});
+
+		uint32_t total = chunkVisible[0];
+		for(uint32_t chunk = 1; chunk < chunkCount; chunk++){
+			memmove(visible.data() + total, visible.data() + chunk * kChunkSize, chunkVisible[chunk] * sizeof(uint32_t));
+			total += chunkVisible[chunk];
+		}
+		visible.resize(total);
+	}
+}
+
+uint32_t SphereBoundsSoA::Add(const float center[3], float r){
+	centerX.push_back(center[0]);
+	centerY.push_back(center[1]);
+	centerZ.push_back(center[2]);
+	radius.push_back(r);
+	return Size() - 1;
+}
+
+void SphereBoundsSoA::Reserve(size_t count){
+	centerX.reserve(count);
+	centerY.reserve(count);
+	centerZ.reserve(count);
+	radius.reserve(count);
+}
+
+void SphereBoundsSoA::Clear(){
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	radius.clear();
+}
+
+uint32_t AabbBoundsSoA::Add(const float boxMin[3], const float boxMax[3]){
+	centerX.push_back((boxMin[0] + boxMax[0]) * 0.5f);
+	centerY.push_back((boxMin[1] + boxMax[1]) * 0.5f);
+	centerZ.push_back((boxMin[2] + boxMax[2]) * 0.5f);
+	extentX.push_back((boxMax[0] - boxMin[0]) * 0.5f);
+	extentY.push_back((boxMax[1] - boxMin[1]) * 0.5f);
+	extentZ.push_back((boxMax[2] - boxMin[2]) * 0.5f);
+	return Size() - 1;
+}
+
+void AabbBoundsSoA::Reserve(size_t count){
+	centerX.reserve(count);
+	centerY.reserve(count);
+	centerZ.reserve(count);
+	extentX.reserve(count);
+	extentY.reserve(count);
+	extentZ.reserve(count);
+}
+
+void AabbBoundsSoA::Clear(){
+	centerX.clear();
+	centerY.clear();
+	centerZ.clear();
+	extentX.clear();
+	extentY.clear();
+	extentZ.clear();
+}
+
+CullPath GetBestCullPath(){
+	const CpuFeatures& features = CpuFeatures::Get();
+	if(features.avx2){
+		return CullPath::AVX2;
+	}
+	if(features.sse41){
+		return CullPath::SSE;
+	}
+	return CullPath::Scalar;
+}
+
+void CullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, std::vector<uint32_t>& visible, CullPath path){
+	BoundsView view = { bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(), bounds.radius.data(), nullptr, nullptr, nullptr };
+	Cull(frustum, view, bounds.Size(), visible, path);
+}
+
+void CullAabbs(const Frustum& frustum, const AabbBoundsSoA& bounds, std::vector<uint32_t>& visible, CullPath path){
+	BoundsView view = { bounds.centerX.data(), bounds.centerY.data(), bounds.centerZ.data(), nullptr, bounds.extentX.data(), bounds.extentY.data(), bounds.extentZ.data() };
+	Cull(frustum, view, bounds.Size(), visible, path);
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Frustum.h"
+
+// Bounding spheres in structure-of-arrays form, one array per component, so
+// the culling kernels can load 4 or 8 objects with a single instruction.
+struct SphereBoundsSoA {
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> radius;
+
+	uint32_t Add(const float center[3], float r);
+	void Reserve(size_t count);
+	void Clear();
+	inline uint32_t Size() const { return static_cast<uint32_t>(radius.size()); }
+};
+
+// Axis aligned boxes stored as center and half extents, which turns the
+// box-plane test into the same multiply-add chain as the sphere test.
+struct AabbBoundsSoA {
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> extentX;
+	std::vector<float> extentY;
+	std::vector<float> extentZ;
+
+	uint32_t Add(const float boxMin[3], const float boxMax[3]);
+	void Reserve(size_t count);
+	void Clear();
+	inline uint32_t Size() const { return static_cast<uint32_t>(centerX.size()); }
+};
+
+// Which kernel runs the plane tests. Auto picks the widest one the CPU has.
+enum class CullPath { Auto, Scalar, SSE, AVX2 };
+
+// Writes the indices of the bounds that touch the frustum to visible, in
+// ascending order. Large inputs are split across the JobSystem workers.
+void CullSpheres(const Frustum& frustum, const SphereBoundsSoA& bounds, std::vector<uint32_t>& visible, CullPath path = CullPath::Auto);
+void CullAabbs(const Frustum& frustum, const AabbBoundsSoA& bounds, std::vector<uint32_t>& visible, CullPath path = CullPath::Auto);
+
+// The kernel Auto resolves to on this machine.
+CullPath GetBestCullPath();
@@ -1,56 +1,95 @@
-#include "GameManager.h"
-#include "RenderEngine.h"
-
-GameManager::GameManager() {
-	timer = nullptr;
-	isRunning = false;
-}
-
-GameManager::~GameManager() {
-	
-}
-
-bool GameManager::Initialize() {
-	timer = new Timer();
-	if(timer == nullptr) {
-		return false;
-	}
-	
-	isRunning = true;
-	return true;
-}
-
-void GameManager::Destroy() {
-	if(timer != nullptr) {
-		delete timer;
-		timer = nullptr;
-	}
-}
-
-void GameManager::Update() {
-	timer->UpdateFrameTicks();
-}
-
-void GameManager::HandleEvent() {
-	while(SDL_PollEvent(&event)) {
-		if(event.type == SDL_QUIT) {
-			isRunning = false;
-		}
-	}
-}
-
-void GameManager::Run() {
-	timer->Start();
-	while(isRunning) {
-		HandleEvent();
-
-		Update();
-		
-		RenderEngine::GetInstance()->Render();
-
-		//Keep the event loop running at 60 fps
-		SDL_Delay(timer->GetSleepTime(60));
-	}
-
-	Destroy();
+#include "GameManager.h"
+#include "RenderEngine.h"
+#include "AssetStreamer.h"
+#include "DirectXAPI.h"
+#include <chrono>
+#include <iostream>
+
+GameManager::GameManager() {
+	timer = nullptr;
+	isRunning = false;
+}
+
+GameManager::~GameManager() {
+	
+}
+
+bool GameManager::Initialize() {
+	const auto start = std::chrono::steady_clock::now();
+	timer = new Timer();
+	if(timer == nullptr) {
+		return false;
+	}
+	
+	// Two I/O threads and a 256 MB resident budget for streamed assets.
+	if(!AssetStreamer::GetInstance()->Init(2, 256ull * 1024 * 1024)) {
+		return false;
+	}
+
+	// Window and renderer startup, DirectXAPI prints the per stage report.
+	// Without them there is nothing to run.
+	if(!RenderEngine::GetInstance()->IsInitialized()) {
+		Destroy();
+		return false;
+	}
+
+	std::cout << "Engine startup: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+		<< " ms" << std::endl;
+	isRunning = true;
+	return true;
+}
+
+void GameManager::Destroy() {
+	// The last frame may still use streamed assets. The API waits for the
+	// GPU, releases what is still deferred and writes its warm-up list.
+	RenderEngine::GetInstance()->StopRenderThread();
+	DirectXAPI::GetInstance()->Destroy();
+	AssetStreamer::GetInstance()->Shutdown();
+
+	if(timer != nullptr) {
+		delete timer;
+		timer = nullptr;
+	}
+}
+
+void GameManager::Update() {
+	timer->UpdateFrameTicks();
+	AssetStreamer::GetInstance()->Update();
+}
+
+void GameManager::HandleEvent() {
+	while(SDL_PollEvent(&event)) {
+		if(event.type == SDL_QUIT) {
+			isRunning = false;
+		} else if(event.type == SDL_WINDOWEVENT && event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) {
+			RenderEngine::GetInstance()->Resize(event.window.data1, event.window.data2);
+		} else if(event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_p && event.key.repeat == 0) {
+			// Switches the depth pre-pass, the shutdown report compares the
+			// pixel shading cost of both.
+			DirectXAPI* api = DirectXAPI::GetInstance();
+			api->SetDepthPrePass(!api->IsDepthPrePassEnabled());
+			std::cout << "Depth pre-pass " << (api->IsDepthPrePassEnabled() ? "on" : "off") << std::endl;
+		}
+	}
+}
+
+void GameManager::Run() {
+	timer->Start();
+	while(isRunning) {
+		HandleEvent();
+
+		Update();
+		
+		// Hands the frame to the render thread, which records and presents
+		// it while the next Update runs.
+		RenderEngine::GetInstance()->Render();
+		if(!RenderEngine::GetInstance()->IsRendering()) {
+			isRunning = false;
+		}
+
+		//Keep the event loop running at 60 fps
+		SDL_Delay(timer->GetSleepTime(60));
+	}
+
+	Destroy();
 }
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include "GpuCulling.h"
+
+#include <cstring>
+
+GpuCullConstants MakeCullConstants(const Frustum& frustum, uint32_t objectCount){
+	GpuCullConstants constants;
+	memcpy(constants.planes, frustum.planes, sizeof(constants.planes));
+	constants.objectCount = objectCount;
+	return constants;
+}
+
+uint32_t CullAndCompactReference(const GpuCullConstants& constants,
+	const GpuObjectBounds* bounds, const GpuDrawArguments* drawArgs,
+	GpuIndirectCommand* outCommands){
+	uint32_t visibleCount = 0;
+
+	// Same math as CSMain, one loop iteration per GPU thread.
+	for(uint32_t i = 0; i < constants.objectCount; i++){
+		const GpuObjectBounds& sphere = bounds[i];
+
+		bool visible = true;
+		for(int p = 0; p < Frustum::Count; p++){
+			const float* plane = constants.planes[p];
+			float distance = plane[0] * sphere.center[0] + plane[1] * sphere.center[1] + plane[2] * sphere.center[2] + plane[3];
+			if(distance < -sphere.radius){
+				visible = false;
+				break;
+			}
+		}
+
+		if(visible){
+			GpuIndirectCommand& command = outCommands[visibleCount++];
+			command.objectIndex = i;
+			command.draw = drawArgs[i];
+		}
+	}
+
+	return visibleCount;
+}
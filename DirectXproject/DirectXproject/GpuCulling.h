@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "Frustum.h"
+
+// These structs mirror the ones declared in cull.hlsl, keep them in sync.
+
+// Bounding sphere for one object.
+struct GpuObjectBounds {
+	float center[3];
+	float radius;
+};
+
+// Same layout as D3D12_DRAW_ARGUMENTS.
+struct GpuDrawArguments {
+	uint32_t vertexCountPerInstance;
+	uint32_t instanceCount;
+	uint32_t startVertexLocation;
+	uint32_t startInstanceLocation;
+};
+
+// One entry of the indirect argument buffer: a root constant holding the
+// object index followed by the draw itself.
+struct GpuIndirectCommand {
+	uint32_t objectIndex;
+	GpuDrawArguments draw;
+};
+
+static_assert(sizeof(GpuObjectBounds) == 16, "GpuObjectBounds must match cull.hlsl");
+static_assert(sizeof(GpuDrawArguments) == 16, "GpuDrawArguments must match D3D12_DRAW_ARGUMENTS");
+static_assert(sizeof(GpuIndirectCommand) == 20, "GpuIndirectCommand must match the command signature");
+
+// Root constants consumed by CSMain in cull.hlsl.
+struct GpuCullConstants {
+	float planes[Frustum::Count][4];
+	uint32_t objectCount;
+};
+
+static const uint32_t kCullThreadGroupSize = 64;
+
+GpuCullConstants MakeCullConstants(const Frustum& frustum, uint32_t objectCount);
+
+// CPU reference of the culling kernel. Writes the visible commands to
+// outCommands in object order and returns how many were written. The GPU
+// appends in whatever order its threads finish, so compare results as sets.
+uint32_t CullAndCompactReference(const GpuCullConstants& constants,
+	const GpuObjectBounds* bounds, const GpuDrawArguments* drawArgs,
+	GpuIndirectCommand* outCommands);
+
+inline std::vector<GpuIndirectCommand> CullAndCompactReference(const GpuCullConstants& constants,
+	const std::vector<GpuObjectBounds>& bounds, const std::vector<GpuDrawArguments>& drawArgs){
+	std::vector<GpuIndirectCommand> commands(constants.objectCount);
+	commands.resize(CullAndCompactReference(constants, bounds.data(), drawArgs.data(), commands.data()));
+	return commands;
+}
@@ -0,0 +1,262 @@
+#include "GpuDrivenRenderer.h"
+
+#include "d3dx12.h"
+
+#include <cstring>
+#include <iostream>
+
+#include "Helpers.h"
+
+using namespace Microsoft::WRL;
+
+namespace {
+	// Root parameter slots, shared by the shaders and the command signature.
+	enum CullRootParameters { CullConstantsSlot = 0, CullBoundsSlot, CullDrawArgsSlot, CullCommandsSlot,
+		CullOcclusionConstantsSlot, CullVisibilitySlot, CullHiZSlot, CullRootParameterCount };
+	enum DrawRootParameters { DrawObjectIndexSlot = 0, DrawObjectsSlot, DrawRootParameterCount };
+	// mDescriptorHeap layout.
+	enum Descriptors { CommandsUav = 0, DisoccludedCommandsUav, HiZDescriptors, DescriptorCount = HiZDescriptors + HiZBuffer::DescriptorCount };
+
+	// The UAV counter must start on a 4K boundary.
+	UINT64 AlignForUavCounter(UINT64 bufferSize){
+		const UINT64 alignment = D3D12_UAV_COUNTER_PLACEMENT_ALIGNMENT;
+		return (bufferSize + (alignment - 1)) & ~(alignment - 1);
+	}
+}
+
+GpuDrivenRenderer::GpuDrivenRenderer() :mObjectCount(0), mCounterOffset(0), mOcclusionCulling(false), mFrustum(Frustum::Identity()), mDescriptorSize(0) {
+	mCommandBufferStates[0] = D3D12_RESOURCE_STATE_COPY_DEST;
+	mCommandBufferStates[1] = D3D12_RESOURCE_STATE_COPY_DEST;
+	memset(mViewProjection, 0, sizeof(mViewProjection));
+	memset(mHiZViewProjection, 0, sizeof(mHiZViewProjection));
+}
+
+GpuDrivenRenderer::~GpuDrivenRenderer() {
+
+}
+
+void GpuDrivenRenderer::Init(ComPtr<ID3D12Device2> device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& basePsoDesc,
+	const std::vector<GpuObjectBounds>& bounds, const std::vector<GpuDrawArguments>& drawArgs){
+	if(bounds.empty() || bounds.size() != drawArgs.size()){
+		std::cout << "GpuDrivenRenderer needs one draw per bounding volume" << std::endl;
+		throw std::exception();
+	}
+
+	mDevice = device;
+	CreateRootSignatures(device.Get());
+	CreatePipelineStates(device.Get(), basePsoDesc);
+	CreateBuffers(device.Get(), bounds, drawArgs);
+
+	mObjectCount = static_cast<uint32_t>(bounds.size());
+}
+
+void GpuDrivenRenderer::CreateRootSignatures(ID3D12Device2* device){
+	// Cull pass: frustum constants, bounds, draw arguments and the append buffer.
+	// The append counter needs a descriptor, a root UAV cannot carry one.
+	// The occlusion variant adds its constants, the visibility flags and the pyramid.
+	CD3DX12_DESCRIPTOR_RANGE uavRange;
+	uavRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+	CD3DX12_DESCRIPTOR_RANGE hiZRange;
+	hiZRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 2);
+
+	CD3DX12_ROOT_PARAMETER cullParameters[CullRootParameterCount];
+	cullParameters[CullConstantsSlot].InitAsConstants(sizeof(GpuCullConstants) / sizeof(uint32_t), 0);
+	cullParameters[CullBoundsSlot].InitAsShaderResourceView(0);
+	cullParameters[CullDrawArgsSlot].InitAsShaderResourceView(1);
+	cullParameters[CullCommandsSlot].InitAsDescriptorTable(1, &uavRange);
+	cullParameters[CullOcclusionConstantsSlot].InitAsConstants(sizeof(GpuOcclusionConstants) / sizeof(uint32_t), 1);
+	cullParameters[CullVisibilitySlot].InitAsUnorderedAccessView(1);
+	cullParameters[CullHiZSlot].InitAsDescriptorTable(1, &hiZRange);
+
+	CD3DX12_ROOT_SIGNATURE_DESC cullDesc;
+	cullDesc.Init(_countof(cullParameters), cullParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+	mCullRootSignature = CreateRootSignatureFromDesc(device, cullDesc);
+
+	// Draw pass: the object index written by ExecuteIndirect and the object data.
+	CD3DX12_ROOT_PARAMETER drawParameters[DrawRootParameterCount];
+	drawParameters[DrawObjectIndexSlot].InitAsConstants(1, 0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+	drawParameters[DrawObjectsSlot].InitAsShaderResourceView(0, 0, D3D12_SHADER_VISIBILITY_VERTEX);
+
+	CD3DX12_ROOT_SIGNATURE_DESC drawDesc;
+	drawDesc.Init(_countof(drawParameters), drawParameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+	mDrawRootSignature = CreateRootSignatureFromDesc(device, drawDesc);
+}
+
+void GpuDrivenRenderer::CreatePipelineStates(ID3D12Device2* device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& basePsoDesc){
+	ComPtr<ID3DBlob> cullShader = CompileShaderFromFile(L"cull.hlsl", "CSMain", "cs_5_1");
+	ComPtr<ID3DBlob> occlusionCullShader = CompileShaderFromFile(L"cull.hlsl", "CSCullOcclusion", "cs_5_1");
+	ComPtr<ID3DBlob> vertexShader = CompileShaderFromFile(L"shader.hlsl", "VSMainIndirect", "vs_5_1");
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC cullDesc = {};
+	cullDesc.pRootSignature = mCullRootSignature.Get();
+	cullDesc.CS = { reinterpret_cast<UINT8*>(cullShader->GetBufferPointer()), cullShader->GetBufferSize() };
+	ThrowIfFailed(device->CreateComputePipelineState(&cullDesc, IID_PPV_ARGS(&mCullPipelineState)));
+	cullDesc.CS = { reinterpret_cast<UINT8*>(occlusionCullShader->GetBufferPointer()), occlusionCullShader->GetBufferSize() };
+	ThrowIfFailed(device->CreateComputePipelineState(&cullDesc, IID_PPV_ARGS(&mOcclusionCullPipelineState)));
+
+	const GeometryPass passes[] = { GeometryPass::DepthAndColor, GeometryPass::DepthOnly, GeometryPass::ColorAfterDepth };
+	for(GeometryPass pass : passes){
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC drawDesc = basePsoDesc;
+		drawDesc.pRootSignature = mDrawRootSignature.Get();
+		drawDesc.VS = { reinterpret_cast<UINT8*>(vertexShader->GetBufferPointer()), vertexShader->GetBufferSize() };
+		ApplyGeometryPass(drawDesc, pass, basePsoDesc.DSVFormat);
+		ThrowIfFailed(device->CreateGraphicsPipelineState(&drawDesc, IID_PPV_ARGS(&mDrawPipelineStates[static_cast<int>(pass)])));
+	}
+
+	// Each command sets the object index root constant and then draws.
+	D3D12_INDIRECT_ARGUMENT_DESC arguments[2] = {};
+	arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+	arguments[0].Constant.RootParameterIndex = DrawObjectIndexSlot;
+	arguments[0].Constant.DestOffsetIn32BitValues = 0;
+	arguments[0].Constant.Num32BitValuesToSet = 1;
+	arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW;
+
+	D3D12_COMMAND_SIGNATURE_DESC signatureDesc = {};
+	signatureDesc.pArgumentDescs = arguments;
+	signatureDesc.NumArgumentDescs = _countof(arguments);
+	signatureDesc.ByteStride = sizeof(GpuIndirectCommand);
+	ThrowIfFailed(device->CreateCommandSignature(&signatureDesc, mDrawRootSignature.Get(), IID_PPV_ARGS(&mCommandSignature)));
+}
+
+void GpuDrivenRenderer::CreateBuffers(ID3D12Device2* device, const std::vector<GpuObjectBounds>& bounds, const std::vector<GpuDrawArguments>& drawArgs){
+	const UINT objectCount = static_cast<UINT>(bounds.size());
+
+	// Note: the object data is static, it lives in upload heaps for the same
+	// reason the triangle vertex buffer does.
+	mBoundsBuffer = CreateUploadBuffer(device, bounds.data(), bounds.size() * sizeof(GpuObjectBounds));
+	mDrawArgsBuffer = CreateUploadBuffer(device, drawArgs.data(), drawArgs.size() * sizeof(GpuDrawArguments));
+
+	const UINT zero = 0;
+	mCounterResetBuffer = CreateUploadBuffer(device, &zero, sizeof(zero));
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+	heapDesc.NumDescriptors = DescriptorCount;
+	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+	ThrowIfFailed(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(&mDescriptorHeap)));
+	mDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	// Room for every object being visible, the counter goes after it.
+	mCounterOffset = AlignForUavCounter(objectCount * sizeof(GpuIndirectCommand));
+	CD3DX12_HEAP_PROPERTIES defaultHeap(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC commandBufferDesc = CD3DX12_RESOURCE_DESC::Buffer(mCounterOffset + sizeof(UINT), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	for(uint32_t phase = 0; phase < 2; phase++){
+		ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &commandBufferDesc,
+			D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mCommandBuffers[phase])));
+		mCommandBufferStates[phase] = D3D12_RESOURCE_STATE_COPY_DEST;
+
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = DXGI_FORMAT_UNKNOWN;
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+		uavDesc.Buffer.FirstElement = 0;
+		uavDesc.Buffer.NumElements = objectCount;
+		uavDesc.Buffer.StructureByteStride = sizeof(GpuIndirectCommand);
+		uavDesc.Buffer.CounterOffsetInBytes = mCounterOffset;
+		uavDesc.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_NONE;
+		CD3DX12_CPU_DESCRIPTOR_HANDLE handle(mDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), CommandsUav + phase, mDescriptorSize);
+		device->CreateUnorderedAccessView(mCommandBuffers[phase].Get(), mCommandBuffers[phase].Get(), &uavDesc, handle);
+	}
+
+	CD3DX12_RESOURCE_DESC visibilityDesc = CD3DX12_RESOURCE_DESC::Buffer(objectCount * sizeof(uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	ThrowIfFailed(device->CreateCommittedResource(&defaultHeap, D3D12_HEAP_FLAG_NONE, &visibilityDesc,
+		D3D12_RESOURCE_STATE_UNORDERED_ACCESS, nullptr, IID_PPV_ARGS(&mVisibilityBuffer)));
+}
+
+void GpuDrivenRenderer::EnableOcclusionCulling(const DepthBuffer& depthBuffer){
+	if(!mOcclusionCulling){
+		mHiZ.Init(mDevice);
+		mOcclusionCulling = true;
+	}
+
+	// A new pyramid starts empty, the next phase 0 lets everything through.
+	mHiZ.Resize(depthBuffer.GetResource(), mDescriptorHeap.Get(), HiZDescriptors);
+}
+
+void GpuDrivenRenderer::TransitionCommandBuffer(ID3D12GraphicsCommandList2* commandList, uint32_t phase, D3D12_RESOURCE_STATES state){
+	if(mCommandBufferStates[phase] == state){
+		return;
+	}
+
+	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(mCommandBuffers[phase].Get(), mCommandBufferStates[phase], state);
+	commandList->ResourceBarrier(1, &barrier);
+	mCommandBufferStates[phase] = state;
+}
+
+void GpuDrivenRenderer::ResetCommandCounter(ID3D12GraphicsCommandList2* commandList, uint32_t phase){
+	TransitionCommandBuffer(commandList, phase, D3D12_RESOURCE_STATE_COPY_DEST);
+	commandList->CopyBufferRegion(mCommandBuffers[phase].Get(), mCounterOffset, mCounterResetBuffer.Get(), 0, sizeof(UINT));
+	TransitionCommandBuffer(commandList, phase, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+}
+
+void GpuDrivenRenderer::Cull(ID3D12GraphicsCommandList2* commandList, const Frustum& frustum, const float viewProjection[16]){
+	mFrustum = frustum;
+	memcpy(mViewProjection, viewProjection, sizeof(mViewProjection));
+
+	// Reset the append counters.
+	ResetCommandCounter(commandList, 0);
+	if(mOcclusionCulling){
+		ResetCommandCounter(commandList, 1);
+	}
+
+	GpuCullConstants constants = MakeCullConstants(frustum, mObjectCount);
+
+	ID3D12DescriptorHeap* heaps[] = { mDescriptorHeap.Get() };
+	commandList->SetDescriptorHeaps(_countof(heaps), heaps);
+	commandList->SetComputeRootSignature(mCullRootSignature.Get());
+	commandList->SetComputeRoot32BitConstants(CullConstantsSlot, sizeof(constants) / sizeof(uint32_t), &constants, 0);
+	commandList->SetComputeRootShaderResourceView(CullBoundsSlot, mBoundsBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootShaderResourceView(CullDrawArgsSlot, mDrawArgsBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootDescriptorTable(CullCommandsSlot, CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), CommandsUav, mDescriptorSize));
+
+	if(mOcclusionCulling){
+		// Reproject through the matrix the pyramid was built with.
+		GpuOcclusionConstants occlusionConstants = MakeOcclusionConstants(mHiZViewProjection, mHiZ.GetWidth(), mHiZ.GetHeight(),
+			mHiZ.IsBuilt() ? mHiZ.GetMipCount() : 0, 0);
+		commandList->SetPipelineState(mOcclusionCullPipelineState.Get());
+		commandList->SetComputeRoot32BitConstants(CullOcclusionConstantsSlot, sizeof(occlusionConstants) / sizeof(uint32_t), &occlusionConstants, 0);
+		commandList->SetComputeRootUnorderedAccessView(CullVisibilitySlot, mVisibilityBuffer->GetGPUVirtualAddress());
+		commandList->SetComputeRootDescriptorTable(CullHiZSlot, mHiZ.GetSrv());
+	}else{
+		commandList->SetPipelineState(mCullPipelineState.Get());
+	}
+	commandList->Dispatch((mObjectCount + kCullThreadGroupSize - 1) / kCullThreadGroupSize, 1, 1);
+
+	TransitionCommandBuffer(commandList, 0, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+void GpuDrivenRenderer::CullDisoccluded(ID3D12GraphicsCommandList2* commandList, ID3D12Resource* depthBuffer){
+	// The pyramid only holds what phase 0 drew. Anything phase 1 adds is
+	// missing from it next frame, which culls less but never wrongly.
+	mHiZ.Build(commandList, depthBuffer);
+	memcpy(mHiZViewProjection, mViewProjection, sizeof(mHiZViewProjection));
+
+	// Phase 0 wrote the visibility flags this dispatch reads.
+	CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(mVisibilityBuffer.Get());
+	commandList->ResourceBarrier(1, &barrier);
+
+	GpuCullConstants constants = MakeCullConstants(mFrustum, mObjectCount);
+	GpuOcclusionConstants occlusionConstants = MakeOcclusionConstants(mViewProjection, mHiZ.GetWidth(), mHiZ.GetHeight(), mHiZ.GetMipCount(), 1);
+
+	commandList->SetComputeRootSignature(mCullRootSignature.Get());
+	commandList->SetPipelineState(mOcclusionCullPipelineState.Get());
+	commandList->SetComputeRoot32BitConstants(CullConstantsSlot, sizeof(constants) / sizeof(uint32_t), &constants, 0);
+	commandList->SetComputeRootShaderResourceView(CullBoundsSlot, mBoundsBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootShaderResourceView(CullDrawArgsSlot, mDrawArgsBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootDescriptorTable(CullCommandsSlot, CD3DX12_GPU_DESCRIPTOR_HANDLE(mDescriptorHeap->GetGPUDescriptorHandleForHeapStart(), DisoccludedCommandsUav, mDescriptorSize));
+	commandList->SetComputeRoot32BitConstants(CullOcclusionConstantsSlot, sizeof(occlusionConstants) / sizeof(uint32_t), &occlusionConstants, 0);
+	commandList->SetComputeRootUnorderedAccessView(CullVisibilitySlot, mVisibilityBuffer->GetGPUVirtualAddress());
+	commandList->SetComputeRootDescriptorTable(CullHiZSlot, mHiZ.GetSrv());
+	commandList->Dispatch((mObjectCount + kCullThreadGroupSize - 1) / kCullThreadGroupSize, 1, 1);
+
+	TransitionCommandBuffer(commandList, 1, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT);
+}
+
+void GpuDrivenRenderer::Draw(ID3D12GraphicsCommandList2* commandList, GeometryPass pass, uint32_t phase){
+	commandList->SetPipelineState(mDrawPipelineStates[static_cast<int>(pass)].Get());
+	commandList->SetGraphicsRootSignature(mDrawRootSignature.Get());
+	commandList->SetGraphicsRootShaderResourceView(DrawObjectsSlot, mBoundsBuffer->GetGPUVirtualAddress());
+
+	// The append counter caps the number of commands actually executed.
+	ID3D12Resource* commandBuffer = mCommandBuffers[phase].Get();
+	commandList->ExecuteIndirect(mCommandSignature.Get(), mObjectCount, commandBuffer, 0, commandBuffer, mCounterOffset);
+}
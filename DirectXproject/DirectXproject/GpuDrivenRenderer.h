@@ -0,0 +1,91 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <vector>
+
+#include "DepthBuffer.h"
+#include "GpuCulling.h"
+#include "HiZBuffer.h"
+
+// Keeps object bounds and draw arguments in GPU buffers, culls them with a
+// compute pass and issues every visible draw with a single ExecuteIndirect.
+// CPU cost per frame does not depend on how many objects are in the buffers.
+class GpuDrivenRenderer {
+public:
+	GpuDrivenRenderer();
+	~GpuDrivenRenderer();
+
+	// basePsoDesc is the classic pipeline, its root signature and vertex shader
+	// are replaced by the indirect ones and a variant is built for every
+	// GeometryPass. bounds and drawArgs are indexed by object.
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& basePsoDesc,
+		const std::vector<GpuObjectBounds>& bounds, const std::vector<GpuDrawArguments>& drawArgs);
+
+	// Adds Hi-Z occlusion culling against depthBuffer, see HiZCulling.h.
+	// Call again whenever the depth buffer is recreated.
+	void EnableOcclusionCulling(const DepthBuffer& depthBuffer);
+
+	// Records the culling dispatch. Call before the render targets are bound.
+	// With occlusion culling this is the first phase, tested against the
+	// pyramid of the previous frame. viewProjection is this frame's.
+	void Cull(ID3D12GraphicsCommandList2* commandList, const Frustum& frustum, const float viewProjection[16]);
+	// Occlusion culling only, after phase 0 has been drawn to depthBuffer.
+	// Rebuilds the pyramid from it and re-tests what phase 0 rejected.
+	void CullDisoccluded(ID3D12GraphicsCommandList2* commandList, ID3D12Resource* depthBuffer);
+	// Records the ExecuteIndirect of one culling phase. Vertex buffers,
+	// targets and viewport must already be set. The culled commands can be
+	// drawn once per pass after a single Cull.
+	void Draw(ID3D12GraphicsCommandList2* commandList, GeometryPass pass = GeometryPass::DepthAndColor, uint32_t phase = 0);
+
+	inline bool IsInitialized() const { return mObjectCount > 0; }
+	inline uint32_t GetObjectCount() const { return mObjectCount; }
+	inline bool IsOcclusionCullingEnabled() const { return mOcclusionCulling; }
+
+private:
+	void CreateRootSignatures(ID3D12Device2* device);
+	void CreatePipelineStates(ID3D12Device2* device, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& basePsoDesc);
+	void CreateBuffers(ID3D12Device2* device, const std::vector<GpuObjectBounds>& bounds, const std::vector<GpuDrawArguments>& drawArgs);
+	void TransitionCommandBuffer(ID3D12GraphicsCommandList2* commandList, uint32_t phase, D3D12_RESOURCE_STATES state);
+	void ResetCommandCounter(ID3D12GraphicsCommandList2* commandList, uint32_t phase);
+
+private:
+	uint32_t mObjectCount;
+	// Byte offset of the append counter inside each command buffer.
+	UINT64 mCounterOffset;
+	D3D12_RESOURCE_STATES mCommandBufferStates[2];
+
+	bool mOcclusionCulling;
+	// Frustum and matrix of the current frame, phase 1 tests with them.
+	Frustum mFrustum;
+	float mViewProjection[16];
+	// Matrix the pyramid in mHiZ was built with, phase 0 reprojects through it.
+	float mHiZViewProjection[16];
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mCullRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mDrawRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mCullPipelineState;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mOcclusionCullPipelineState;
+	// Indexed by GeometryPass.
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mDrawPipelineStates[3];
+	Microsoft::WRL::ComPtr<ID3D12CommandSignature> mCommandSignature;
+
+	// Per object data read by both the cull pass and the vertex shader.
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBoundsBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mDrawArgsBuffer;
+	// Compacted GpuIndirectCommand list followed by its append counter, one
+	// per occlusion culling phase. Without occlusion culling only the first is used.
+	Microsoft::WRL::ComPtr<ID3D12Resource> mCommandBuffers[2];
+	// Holds a single zero used to reset the append counter every frame.
+	Microsoft::WRL::ComPtr<ID3D12Resource> mCounterResetBuffer;
+	// One uint per object, set when it passed phase 0.
+	Microsoft::WRL::ComPtr<ID3D12Resource> mVisibilityBuffer;
+	// Shader visible heap holding the UAVs of mCommandBuffers followed by the descriptors of mHiZ.
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mDescriptorHeap;
+	UINT mDescriptorSize;
+
+	HiZBuffer mHiZ;
+};
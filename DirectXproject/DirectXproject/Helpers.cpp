@@ -0,0 +1,56 @@
+#include "Helpers.h"
+
+#include "d3dx12.h"
+#include <d3dcompiler.h>
+
+#include "StreamingCopy.h"
+
+using namespace Microsoft::WRL;
+
+ComPtr<ID3DBlob> CompileShaderFromFile(const wchar_t* file, const char* entryPoint, const char* target){
+	UINT compileFlags = 0;
+	#if defined(_DEBUG)
+	// Enable better shader debugging with the graphics debugging tools.
+	compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
+	#endif
+
+	ComPtr<ID3DBlob> shader;
+	ComPtr<ID3DBlob> errorBlob;
+	HRESULT hr = D3DCompileFromFile(file, nullptr, 0, entryPoint, target, compileFlags, 0, &shader, &errorBlob);
+	if(errorBlob){
+		std::cout << ((char*)errorBlob->GetBufferPointer()) << std::endl;
+	}
+	ThrowIfFailed(hr);
+
+	return shader;
+}
+
+ComPtr<ID3D12RootSignature> CreateRootSignatureFromDesc(ID3D12Device2* device, const D3D12_ROOT_SIGNATURE_DESC& desc){
+	ComPtr<ID3DBlob> signature;
+	ComPtr<ID3DBlob> error;
+	HRESULT hr = D3D12SerializeRootSignature(&desc, D3D_ROOT_SIGNATURE_VERSION_1, &signature, &error);
+	if(error){
+		std::cout << ((char*)error->GetBufferPointer()) << std::endl;
+	}
+	ThrowIfFailed(hr);
+
+	ComPtr<ID3D12RootSignature> rootSignature;
+	ThrowIfFailed(device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&rootSignature)));
+	return rootSignature;
+}
+
+ComPtr<ID3D12Resource> CreateUploadBuffer(ID3D12Device2* device, const void* data, UINT64 size){
+	ComPtr<ID3D12Resource> buffer;
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	ThrowIfFailed(device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&buffer)));
+
+	UINT8* mapped;
+	CD3DX12_RANGE readRange(0, 0);        // We do not intend to read from this resource on the CPU.
+	ThrowIfFailed(buffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+	StreamCopy(mapped, data, static_cast<size_t>(size));
+	buffer->Unmap(0, nullptr);
+
+	return buffer;
+}
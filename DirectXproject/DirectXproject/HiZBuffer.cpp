@@ -0,0 +1,154 @@
+#include "HiZBuffer.h"
+
+#include "d3dx12.h"
+
+#include <algorithm>
+
+#include "DepthBuffer.h"
+#include "Helpers.h"
+
+using namespace Microsoft::WRL;
+
+namespace {
+	enum RootParameters { ConstantsSlot = 0, DepthSlot, SourceSlot, DestinationSlot, RootParameterCount };
+
+	// Mirrors DownsampleConstants in hiz.hlsl.
+	struct DownsampleConstants {
+		uint32_t sourceSize[2];
+		uint32_t destinationSize[2];
+	};
+}
+
+HiZBuffer::HiZBuffer() :mDepthWidth(0), mDepthHeight(0), mWidth(0), mHeight(0), mMipCount(0), mBuilt(false), mFirstDescriptor(0), mDescriptorSize(0) {
+
+}
+
+HiZBuffer::~HiZBuffer() {
+
+}
+
+void HiZBuffer::Init(ComPtr<ID3D12Device2> device){
+	mDevice = device;
+	mDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	CD3DX12_DESCRIPTOR_RANGE depthRange;
+	depthRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
+	CD3DX12_DESCRIPTOR_RANGE sourceRange;
+	sourceRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 0);
+	CD3DX12_DESCRIPTOR_RANGE destinationRange;
+	destinationRange.Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, 1, 1);
+
+	CD3DX12_ROOT_PARAMETER parameters[RootParameterCount];
+	parameters[ConstantsSlot].InitAsConstants(sizeof(DownsampleConstants) / sizeof(uint32_t), 0);
+	parameters[DepthSlot].InitAsDescriptorTable(1, &depthRange);
+	parameters[SourceSlot].InitAsDescriptorTable(1, &sourceRange);
+	parameters[DestinationSlot].InitAsDescriptorTable(1, &destinationRange);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(parameters), parameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	mRootSignature = CreateRootSignatureFromDesc(mDevice.Get(), rootSignatureDesc);
+
+	ComPtr<ID3DBlob> downsampleDepthShader = CompileShaderFromFile(L"hiz.hlsl", "CSDownsampleDepth", "cs_5_1");
+	ComPtr<ID3DBlob> downsampleShader = CompileShaderFromFile(L"hiz.hlsl", "CSDownsample", "cs_5_1");
+
+	D3D12_COMPUTE_PIPELINE_STATE_DESC pipelineDesc = {};
+	pipelineDesc.pRootSignature = mRootSignature.Get();
+	pipelineDesc.CS = { reinterpret_cast<UINT8*>(downsampleDepthShader->GetBufferPointer()), downsampleDepthShader->GetBufferSize() };
+	ThrowIfFailed(mDevice->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&mDownsampleDepthPipelineState)));
+	pipelineDesc.CS = { reinterpret_cast<UINT8*>(downsampleShader->GetBufferPointer()), downsampleShader->GetBufferSize() };
+	ThrowIfFailed(mDevice->CreateComputePipelineState(&pipelineDesc, IID_PPV_ARGS(&mDownsamplePipelineState)));
+}
+
+void HiZBuffer::Resize(ID3D12Resource* depthBuffer, ID3D12DescriptorHeap* heap, UINT firstDescriptor){
+	const D3D12_RESOURCE_DESC depthDesc = depthBuffer->GetDesc();
+	mDepthWidth = static_cast<uint32_t>(depthDesc.Width);
+	mDepthHeight = depthDesc.Height;
+	const HiZLayout layout = GetHiZLayout(mDepthWidth, mDepthHeight);
+	mWidth = layout.width;
+	mHeight = layout.height;
+	mMipCount = layout.mipCount;
+
+	mHeap = heap;
+	mFirstDescriptor = firstDescriptor;
+	mBuilt = false;
+
+	mPyramid.Reset();
+	CD3DX12_HEAP_PROPERTIES heapProperties(D3D12_HEAP_TYPE_DEFAULT);
+	CD3DX12_RESOURCE_DESC pyramidDesc = CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R32_FLOAT, layout.textureWidth, layout.textureHeight, 1, static_cast<UINT16>(mMipCount),
+		1, 0, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	ThrowIfFailed(mDevice->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &pyramidDesc,
+		D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, nullptr, IID_PPV_ARGS(&mPyramid)));
+
+	CD3DX12_CPU_DESCRIPTOR_HANDLE handle(heap->GetCPUDescriptorHandleForHeapStart(), firstDescriptor, mDescriptorSize);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC depthSrvDesc = {};
+	depthSrvDesc.Format = DepthBuffer::SrvFormat;
+	depthSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	depthSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	depthSrvDesc.Texture2D.MipLevels = 1;
+	mDevice->CreateShaderResourceView(depthBuffer, &depthSrvDesc, handle);
+	handle.Offset(1, mDescriptorSize);
+
+	D3D12_SHADER_RESOURCE_VIEW_DESC pyramidSrvDesc = {};
+	pyramidSrvDesc.Format = DXGI_FORMAT_R32_FLOAT;
+	pyramidSrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	pyramidSrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	pyramidSrvDesc.Texture2D.MipLevels = mMipCount;
+	mDevice->CreateShaderResourceView(mPyramid.Get(), &pyramidSrvDesc, handle);
+	handle.Offset(1, mDescriptorSize);
+
+	for(uint32_t mip = 0; mip < mMipCount; mip++){
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.Format = DXGI_FORMAT_R32_FLOAT;
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+		uavDesc.Texture2D.MipSlice = mip;
+		mDevice->CreateUnorderedAccessView(mPyramid.Get(), nullptr, &uavDesc, handle);
+		handle.Offset(1, mDescriptorSize);
+	}
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE HiZBuffer::GetGpuDescriptor(UINT index) const{
+	return CD3DX12_GPU_DESCRIPTOR_HANDLE(mHeap->GetGPUDescriptorHandleForHeapStart(), mFirstDescriptor + index, mDescriptorSize);
+}
+
+void HiZBuffer::Build(ID3D12GraphicsCommandList* commandList, ID3D12Resource* depthBuffer){
+	CD3DX12_RESOURCE_BARRIER toCompute[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(depthBuffer, D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		CD3DX12_RESOURCE_BARRIER::Transition(mPyramid.Get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+	};
+	commandList->ResourceBarrier(_countof(toCompute), toCompute);
+
+	commandList->SetComputeRootSignature(mRootSignature.Get());
+	commandList->SetComputeRootDescriptorTable(DepthSlot, GetGpuDescriptor(DepthSrv));
+
+	uint32_t sourceWidth = mDepthWidth;
+	uint32_t sourceHeight = mDepthHeight;
+	for(uint32_t mip = 0; mip < mMipCount; mip++){
+		const uint32_t width = std::max(1u, (mWidth + (1u << mip) - 1) >> mip);
+		const uint32_t height = std::max(1u, (mHeight + (1u << mip) - 1) >> mip);
+		DownsampleConstants constants = { { sourceWidth, sourceHeight }, { width, height } };
+
+		commandList->SetPipelineState(mip == 0 ? mDownsampleDepthPipelineState.Get() : mDownsamplePipelineState.Get());
+		commandList->SetComputeRoot32BitConstants(ConstantsSlot, sizeof(constants) / sizeof(uint32_t), &constants, 0);
+		// Level 0 ignores the source UAV, bind its own to keep the table valid.
+		commandList->SetComputeRootDescriptorTable(SourceSlot, GetGpuDescriptor(FirstMipUav + (mip == 0 ? 0 : mip - 1)));
+		commandList->SetComputeRootDescriptorTable(DestinationSlot, GetGpuDescriptor(FirstMipUav + mip));
+		commandList->Dispatch((width + kHiZThreadGroupSize - 1) / kHiZThreadGroupSize, (height + kHiZThreadGroupSize - 1) / kHiZThreadGroupSize, 1);
+
+		// The next level reads this one.
+		CD3DX12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::UAV(mPyramid.Get());
+		commandList->ResourceBarrier(1, &barrier);
+
+		sourceWidth = width;
+		sourceHeight = height;
+	}
+
+	CD3DX12_RESOURCE_BARRIER toRead[] = {
+		CD3DX12_RESOURCE_BARRIER::Transition(depthBuffer, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_DEPTH_WRITE),
+		CD3DX12_RESOURCE_BARRIER::Transition(mPyramid.Get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE)
+	};
+	commandList->ResourceBarrier(_countof(toRead), toRead);
+
+	mBuilt = true;
+}
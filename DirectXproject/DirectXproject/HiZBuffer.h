@@ -0,0 +1,60 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <cstdint>
+
+#include "HiZCulling.h"
+
+// GPU side of the Hi-Z pyramid: an R32_FLOAT texture half the size of the
+// depth buffer with a full mip chain, rebuilt by the compute shaders in
+// hiz.hlsl. Its descriptors live in a shader visible heap owned by the
+// caller so the culling pass can bind them next to its own.
+class HiZBuffer {
+public:
+	// Depth SRV, pyramid SRV, then one UAV per mip.
+	static const UINT DescriptorCount = 2 + kHiZMaxMips;
+
+	HiZBuffer();
+	~HiZBuffer();
+
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device);
+	// (Re)creates the pyramid for depthBuffer and writes the descriptors
+	// starting at firstDescriptor. The GPU must be done with the old one.
+	void Resize(ID3D12Resource* depthBuffer, ID3D12DescriptorHeap* heap, UINT firstDescriptor);
+
+	// depthBuffer must be in DEPTH_WRITE, it is returned to it. The heap
+	// passed to Resize must be bound.
+	void Build(ID3D12GraphicsCommandList* commandList, ID3D12Resource* depthBuffer);
+
+	// Whole pyramid, valid once Build has run.
+	inline D3D12_GPU_DESCRIPTOR_HANDLE GetSrv() const { return GetGpuDescriptor(PyramidSrv); }
+	inline bool IsBuilt() const { return mBuilt; }
+	inline uint32_t GetWidth() const { return mWidth; }
+	inline uint32_t GetHeight() const { return mHeight; }
+	inline uint32_t GetMipCount() const { return mMipCount; }
+
+private:
+	enum Descriptors { DepthSrv = 0, PyramidSrv, FirstMipUav };
+
+	D3D12_GPU_DESCRIPTOR_HANDLE GetGpuDescriptor(UINT index) const;
+
+private:
+	uint32_t mDepthWidth;
+	uint32_t mDepthHeight;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mMipCount;
+	bool mBuilt;
+
+	UINT mFirstDescriptor;
+	UINT mDescriptorSize;
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> mHeap;
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mDownsampleDepthPipelineState;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mDownsamplePipelineState;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mPyramid;
+};
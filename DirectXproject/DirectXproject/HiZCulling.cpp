@@ -0,0 +1,170 @@
+#include "HiZCulling.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+HiZLayout GetHiZLayout(uint32_t depthWidth, uint32_t depthHeight){
+	HiZLayout layout;
+	layout.width = std::max(1u, (depthWidth + 1) / 2);
+	layout.height = std::max(1u, (depthHeight + 1) / 2);
+	layout.textureWidth = 1;
+	layout.textureHeight = 1;
+	while(layout.textureWidth < layout.width){
+		layout.textureWidth *= 2;
+	}
+	while(layout.textureHeight < layout.height){
+		layout.textureHeight *= 2;
+	}
+
+	layout.mipCount = 1;
+	while(layout.mipCount < kHiZMaxMips && (1u << (layout.mipCount - 1)) < std::max(layout.textureWidth, layout.textureHeight)){
+		layout.mipCount++;
+	}
+	return layout;
+}
+
+void BuildHiZPyramid(HiZPyramid& pyramid, const float* depth, uint32_t width, uint32_t height){
+	const HiZLayout layout = GetHiZLayout(width, height);
+	pyramid.width = layout.width;
+	pyramid.height = layout.height;
+	pyramid.levels.clear();
+
+	const float* source = depth;
+	uint32_t sourceWidth = width;
+	uint32_t sourceHeight = height;
+	for(uint32_t mip = 0; ; mip++){
+		const uint32_t mipWidth = pyramid.GetMipWidth(mip);
+		const uint32_t mipHeight = pyramid.GetMipHeight(mip);
+		pyramid.levels.emplace_back(mipWidth * mipHeight);
+		std::vector<float>& level = pyramid.levels.back();
+
+		// Same footprint as CSDownsample, the odd edge repeats its last texel.
+		for(uint32_t y = 0; y < mipHeight; y++){
+			const uint32_t y0 = std::min(y * 2, sourceHeight - 1);
+			const uint32_t y1 = std::min(y * 2 + 1, sourceHeight - 1);
+			for(uint32_t x = 0; x < mipWidth; x++){
+				const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+				const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+				level[y * mipWidth + x] = std::max(std::max(source[y0 * sourceWidth + x0], source[y0 * sourceWidth + x1]),
+					std::max(source[y1 * sourceWidth + x0], source[y1 * sourceWidth + x1]));
+			}
+		}
+
+		if(mipWidth == 1 && mipHeight == 1){
+			break;
+		}
+		source = level.data();
+		sourceWidth = mipWidth;
+		sourceHeight = mipHeight;
+	}
+}
+
+GpuOcclusionConstants MakeOcclusionConstants(const float viewProjection[16], uint32_t hiZWidth, uint32_t hiZHeight, uint32_t mipCount, uint32_t phase){
+	GpuOcclusionConstants constants;
+	memcpy(constants.viewProjection, viewProjection, sizeof(constants.viewProjection));
+	constants.hiZWidth = static_cast<float>(hiZWidth);
+	constants.hiZHeight = static_cast<float>(hiZHeight);
+	constants.hiZMipCount = mipCount;
+	constants.phase = phase;
+	return constants;
+}
+
+bool IsSphereOccluded(const HiZPyramid& pyramid, const float viewProjection[16], const float center[3], float radius){
+	if(pyramid.levels.empty()){
+		return false;
+	}
+
+	// Project the corners of the box around the sphere.
+	float minX = 1.0f, minY = 1.0f, maxX = -1.0f, maxY = -1.0f, minZ = 1.0f;
+	for(int corner = 0; corner < 8; corner++){
+		const float p[3] = {
+			center[0] + ((corner & 1) ? radius : -radius),
+			center[1] + ((corner & 2) ? radius : -radius),
+			center[2] + ((corner & 4) ? radius : -radius)
+		};
+		const float* m = viewProjection;
+		const float clipX = p[0] * m[0] + p[1] * m[4] + p[2] * m[8] + m[12];
+		const float clipY = p[0] * m[1] + p[1] * m[5] + p[2] * m[9] + m[13];
+		const float clipZ = p[0] * m[2] + p[1] * m[6] + p[2] * m[10] + m[14];
+		const float clipW = p[0] * m[3] + p[1] * m[7] + p[2] * m[11] + m[15];
+		if(clipW <= 1e-5f){
+			return false;
+		}
+
+		const float x = clipX / clipW;
+		const float y = clipY / clipW;
+		minX = corner == 0 ? x : std::min(minX, x);
+		maxX = corner == 0 ? x : std::max(maxX, x);
+		minY = corner == 0 ? y : std::min(minY, y);
+		maxY = corner == 0 ? y : std::max(maxY, y);
+		minZ = corner == 0 ? clipZ / clipW : std::min(minZ, clipZ / clipW);
+	}
+	if(minZ <= 0.0f || maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f){
+		return false;
+	}
+
+	// Screen rectangle in level 0 texels, y grows downwards.
+	const float width = static_cast<float>(pyramid.width);
+	const float height = static_cast<float>(pyramid.height);
+	const float left = std::min(std::max((minX * 0.5f + 0.5f) * width, 0.0f), width - 1.0f);
+	const float right = std::min(std::max((maxX * 0.5f + 0.5f) * width, 0.0f), width - 1.0f);
+	const float top = std::min(std::max((0.5f - maxY * 0.5f) * height, 0.0f), height - 1.0f);
+	const float bottom = std::min(std::max((0.5f - minY * 0.5f) * height, 0.0f), height - 1.0f);
+
+	// The level where the rectangle spans at most 2x2 texels.
+	const float extent = std::max(std::max(right - left, bottom - top), 1.0f);
+	const uint32_t mip = std::min(static_cast<uint32_t>(std::ceil(std::log2(extent))), pyramid.GetMipCount() - 1);
+
+	const uint32_t x0 = static_cast<uint32_t>(left) >> mip;
+	const uint32_t x1 = static_cast<uint32_t>(right) >> mip;
+	const uint32_t y0 = static_cast<uint32_t>(top) >> mip;
+	const uint32_t y1 = static_cast<uint32_t>(bottom) >> mip;
+
+	float farthest = 0.0f;
+	for(uint32_t y = y0; y <= y1; y++){
+		for(uint32_t x = x0; x <= x1; x++){
+			farthest = std::max(farthest, pyramid.Load(mip, x, y));
+		}
+	}
+
+	return minZ > farthest;
+}
+
+uint32_t CullOcclusionReference(const GpuCullConstants& constants, const HiZPyramid& pyramid, const float viewProjection[16], uint32_t phase,
+	const GpuObjectBounds* bounds, const GpuDrawArguments* drawArgs, uint32_t* visibility, GpuIndirectCommand* outCommands){
+	uint32_t visibleCount = 0;
+
+	// Same math as CSCullOcclusion, one loop iteration per GPU thread.
+	for(uint32_t i = 0; i < constants.objectCount; i++){
+		if(phase == 1 && visibility[i] != 0){
+			continue;
+		}
+
+		const GpuObjectBounds& sphere = bounds[i];
+		bool inFrustum = true;
+		for(int p = 0; p < Frustum::Count; p++){
+			const float* plane = constants.planes[p];
+			float distance = plane[0] * sphere.center[0] + plane[1] * sphere.center[1] + plane[2] * sphere.center[2] + plane[3];
+			if(distance < -sphere.radius){
+				inFrustum = false;
+				break;
+			}
+		}
+		if(!inFrustum){
+			// Outside the frustum there is nothing to re-test in phase 1.
+			visibility[i] = 1;
+			continue;
+		}
+
+		const bool occluded = IsSphereOccluded(pyramid, viewProjection, sphere.center, sphere.radius);
+		visibility[i] = occluded ? 0 : 1;
+		if(!occluded){
+			GpuIndirectCommand& command = outCommands[visibleCount++];
+			command.objectIndex = i;
+			command.draw = drawArgs[i];
+		}
+	}
+
+	return visibleCount;
+}
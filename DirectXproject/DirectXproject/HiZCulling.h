@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GpuCulling.h"
+
+// Hierarchical-Z occlusion culling. Each level of the pyramid stores the
+// farthest depth of the texels below it, so a bounding sphere whose nearest
+// depth is farther than every texel under its screen rectangle is hidden.
+// Depth follows the D3D convention, 0 near and 1 far.
+//
+// Culling runs in two phases per frame. The first tests objects against the
+// pyramid of the previous frame, reprojected with the view-projection that
+// produced it. The survivors are drawn, the pyramid is rebuilt from their
+// depth and the second phase re-tests only the objects the first rejected,
+// so anything that became visible this frame is drawn this frame.
+
+// Largest pyramid the GPU path allocates descriptors for (32K texels).
+static const uint32_t kHiZMaxMips = 16;
+static const uint32_t kHiZThreadGroupSize = 8;
+
+struct HiZPyramid {
+	// Level 0 size, each following level halves it rounding up.
+	uint32_t width;
+	uint32_t height;
+	std::vector<std::vector<float>> levels;
+
+	inline uint32_t GetMipCount() const { return static_cast<uint32_t>(levels.size()); }
+	inline uint32_t GetMipWidth(uint32_t mip) const { uint32_t w = (width + (1u << mip) - 1) >> mip; return w > 0 ? w : 1; }
+	inline uint32_t GetMipHeight(uint32_t mip) const { uint32_t h = (height + (1u << mip) - 1) >> mip; return h > 0 ? h : 1; }
+	inline float Load(uint32_t mip, uint32_t x, uint32_t y) const { return levels[mip][y * GetMipWidth(mip) + x]; }
+};
+
+// Size of the pyramid for a depth buffer. Levels round up when halving, D3D
+// mips round down, so the GPU texture is padded to a power of two to make
+// every rounded up level fit its mip. Only the top left width x height of
+// level 0 is ever written or read.
+struct HiZLayout {
+	uint32_t width;
+	uint32_t height;
+	uint32_t textureWidth;
+	uint32_t textureHeight;
+	// Down to 1x1, capped at kHiZMaxMips.
+	uint32_t mipCount;
+};
+
+HiZLayout GetHiZLayout(uint32_t depthWidth, uint32_t depthHeight);
+
+// Builds the full chain down to 1x1. Level 0 is the max of every 2x2 block
+// of depth, like the GPU path, so it is half the depth buffer size.
+void BuildHiZPyramid(HiZPyramid& pyramid, const float* depth, uint32_t width, uint32_t height);
+
+// Root constants of the occlusion test in cull.hlsl, mirror them there.
+struct GpuOcclusionConstants {
+	// Row vector view-projection the pyramid was built with.
+	float viewProjection[16];
+	float hiZWidth;
+	float hiZHeight;
+	// Zero when there is no pyramid yet, nothing is occluded then.
+	uint32_t hiZMipCount;
+	uint32_t phase;
+};
+
+static_assert(sizeof(GpuOcclusionConstants) == 80, "GpuOcclusionConstants must match cull.hlsl");
+
+GpuOcclusionConstants MakeOcclusionConstants(const float viewProjection[16], uint32_t hiZWidth, uint32_t hiZHeight, uint32_t mipCount, uint32_t phase);
+
+// CPU reference of the occlusion test in cull.hlsl. Conservative: spheres
+// crossing the near plane or leaving the screen count as visible.
+bool IsSphereOccluded(const HiZPyramid& pyramid, const float viewProjection[16], const float center[3], float radius);
+
+// CPU reference of one culling phase. Phase 0 tests every object in the
+// frustum and records in visibility whether it passed the occlusion test.
+// Phase 1 only tests the objects phase 0 rejected and marks the ones that
+// pass. Returns the number of commands written to outCommands.
+uint32_t CullOcclusionReference(const GpuCullConstants& constants, const HiZPyramid& pyramid, const float viewProjection[16], uint32_t phase,
+	const GpuObjectBounds* bounds, const GpuDrawArguments* drawArgs, uint32_t* visibility, GpuIndirectCommand* outCommands);
@@ -0,0 +1,111 @@
+#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem* JobSystem::instance = nullptr;
+
+JobSystem* JobSystem::GetInstance(){
+	if(instance == nullptr){
+		instance = new JobSystem();
+	}
+
+	return instance;
+}
+
+JobSystem::JobSystem() :mShuttingDown(false) {
+	// Leave one hardware thread for the caller.
+	unsigned int hardwareThreads = std::thread::hardware_concurrency();
+	unsigned int workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+
+	for(unsigned int i = 0; i < workerCount; i++){
+		mWorkers.emplace_back(&JobSystem::WorkerLoop, this);
+	}
+}
+
+JobSystem::~JobSystem(){
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mShuttingDown = true;
+	}
+	mJobAvailable.notify_all();
+
+	for(std::thread& worker : mWorkers){
+		worker.join();
+	}
+}
+
+void JobSystem::WorkerLoop(){
+	while(true){
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mJobAvailable.wait(lock, [this]{ return mShuttingDown || !mJobs.empty(); });
+			if(mShuttingDown && mJobs.empty()){
+				return;
+			}
+			job = std::move(mJobs.front());
+			mJobs.pop_front();
+		}
+		job();
+	}
+}
+
+bool JobSystem::RunOneJob(){
+	std::function<void()> job;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		if(mJobs.empty()){
+			return false;
+		}
+		job = std::move(mJobs.front());
+		mJobs.pop_front();
+	}
+	job();
+	return true;
+}
+
+void JobSystem::Submit(std::function<void()> job){
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		mJobs.push_back(std::move(job));
+	}
+	mJobAvailable.notify_one();
+}
+
+void JobSystem::ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func){
+	if(count == 0){
+		return;
+	}
+
+	// A few batches per thread keeps everyone busy when batches are uneven.
+	const uint32_t threadCount = GetWorkerCount() + 1;
+	uint32_t batchSize = std::max<uint32_t>(std::max<uint32_t>(minBatchSize, 1), (count + threadCount * 4 - 1) / (threadCount * 4));
+	uint32_t batchCount = (count + batchSize - 1) / batchSize;
+
+	if(batchCount == 1){
+		func(0, count);
+		return;
+	}
+
+	std::atomic<uint32_t> remaining(batchCount - 1);
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for(uint32_t batch = 1; batch < batchCount; batch++){
+			uint32_t begin = batch * batchSize;
+			uint32_t end = std::min(count, begin + batchSize);
+			mJobs.push_back([&func, &remaining, begin, end]{
+				func(begin, end);
+				remaining.fetch_sub(1, std::memory_order_release);
+			});
+		}
+	}
+	mJobAvailable.notify_all();
+
+	// The caller takes the first batch, then helps with whatever is queued.
+	func(0, std::min(count, batchSize));
+	while(remaining.load(std::memory_order_acquire) > 0){
+		if(!RunOneJob()){
+			std::this_thread::yield();
+		}
+	}
+}
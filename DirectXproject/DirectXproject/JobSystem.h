@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Small pool of worker threads for data parallel CPU work (culling,
+// transform updates, asset cooking). The calling thread helps out while it
+// waits, so nesting a ParallelFor inside a job does not deadlock.
+class JobSystem {
+public:
+	static JobSystem* GetInstance();
+
+	// Calls func(begin, end) over [0, count) split into ranges of at least
+	// minBatchSize items and blocks until every range has run.
+	void ParallelFor(uint32_t count, uint32_t minBatchSize, const std::function<void(uint32_t, uint32_t)>& func);
+
+	// Runs a job on a worker without waiting for it.
+	void Submit(std::function<void()> job);
+
+	inline uint32_t GetWorkerCount() const { return static_cast<uint32_t>(mWorkers.size()); }
+
+private:
+	JobSystem();
+	~JobSystem();
+
+	void WorkerLoop();
+	bool RunOneJob();
+
+	static JobSystem* instance;
+
+	std::vector<std::thread> mWorkers;
+	std::deque<std::function<void()>> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mJobAvailable;
+	bool mShuttingDown;
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem(JobSystem&&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+	JobSystem& operator=(JobSystem&&) = delete;
+};
@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile(){
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+	*this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+	if(this != &other){
+		Close();
+		std::swap(mData, other.mData);
+		std::swap(mSize, other.mSize);
+		std::swap(mFile, other.mFile);
+	#if defined(_WIN32)
+		std::swap(mMapping, other.mMapping);
+	#endif
+	}
+	return *this;
+}
+
+#if defined(_WIN32)
+bool MappedFile::Open(const char* path){
+	Close();
+
+	HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if(file == INVALID_HANDLE_VALUE){
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if(!GetFileSizeEx(file, &size) || size.QuadPart == 0){
+		CloseHandle(file);
+		return false;
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if(mapping == nullptr){
+		CloseHandle(file);
+		return false;
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if(view == nullptr){
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	mFile = file;
+	mMapping = mapping;
+	mData = static_cast<const uint8_t*>(view);
+	mSize = static_cast<size_t>(size.QuadPart);
+	return true;
+}
+
+void MappedFile::Close(){
+	if(mData){
+		UnmapViewOfFile(mData);
+	}
+	if(mMapping){
+		CloseHandle(mMapping);
+	}
+	if(mFile){
+		CloseHandle(mFile);
+	}
+	mData = nullptr;
+	mSize = 0;
+	mMapping = nullptr;
+	mFile = nullptr;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+	if(!mData || offset >= mSize){
+		return;
+	}
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<uint8_t*>(mData) + offset;
+	range.NumberOfBytes = (size < mSize - offset) ? size : (mSize - offset);
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+#else
+bool MappedFile::Open(const char* path){
+	Close();
+
+	int file = open(path, O_RDONLY);
+	if(file < 0){
+		return false;
+	}
+
+	struct stat info;
+	if(fstat(file, &info) != 0 || info.st_size == 0){
+		close(file);
+		return false;
+	}
+
+	void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	if(view == MAP_FAILED){
+		close(file);
+		return false;
+	}
+
+	mFile = file;
+	mData = static_cast<const uint8_t*>(view);
+	mSize = static_cast<size_t>(info.st_size);
+	return true;
+}
+
+void MappedFile::Close(){
+	if(mData){
+		munmap(const_cast<uint8_t*>(mData), mSize);
+	}
+	if(mFile >= 0){
+		close(mFile);
+	}
+	mData = nullptr;
+	mSize = 0;
+	mFile = -1;
+}
+
+void MappedFile::Prefetch(size_t offset, size_t size) const {
+	if(!mData || offset >= mSize){
+		return;
+	}
+	// madvise wants a page aligned start.
+	size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	size_t start = offset & ~(pageSize - 1);
+	size_t end = (size < mSize - offset) ? offset + size : mSize;
+	madvise(const_cast<uint8_t*>(mData) + start, end - start, MADV_WILLNEED);
+}
+#endif
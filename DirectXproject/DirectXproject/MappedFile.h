@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only view of a whole file, mapped straight into the address space.
+// Pages are faulted in on first touch, nothing is copied up front.
+class MappedFile {
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const char* path);
+	void Close();
+
+	// Asks the OS to start reading the range in ahead of use.
+	void Prefetch(size_t offset, size_t size) const;
+
+	const uint8_t* Data() const { return mData; }
+	size_t Size() const { return mSize; }
+	bool IsOpen() const { return mData != nullptr; }
+
+private:
+	const uint8_t* mData = nullptr;
+	size_t mSize = 0;
+#if defined(_WIN32)
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#else
+	int mFile = -1;
+#endif
+};
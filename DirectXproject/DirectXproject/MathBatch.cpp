@@ -0,0 +1,278 @@
+// Bit exact results across paths need every multiply and add rounded on its
+// own, even though the project builds with /fp:fast.
+#if defined(_MSC_VER)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "MathBatch.h"
+
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#elif defined(CPU_ARM)
+#include <arm_neon.h>
+#endif
+
+namespace {
+	// b advances by bStride matrices per item, 0 multiplies everything by one matrix.
+	typedef void(*MultiplyKernel)(const Float4x4*, const Float4x4*, Float4x4*, size_t, size_t);
+	typedef void(*TransformKernel)(const Float4x4&, const Float3*, Float4*, size_t);
+
+	void MultiplyScalar(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, size_t bStride){
+		for(size_t n = 0; n < count; n++, b += bStride){
+			Float4x4 result;
+			for(int i = 0; i < 4; i++){
+				for(int j = 0; j < 4; j++){
+					result.m[i][j] = ((a[n].m[i][0] * b->m[0][j] + a[n].m[i][1] * b->m[1][j]) + a[n].m[i][2] * b->m[2][j]) + a[n].m[i][3] * b->m[3][j];
+				}
+			}
+			out[n] = result;
+		}
+	}
+
+	void TransformScalar(const Float4x4& m, const Float3* points, Float4* out, size_t count){
+		for(size_t n = 0; n < count; n++){
+			const Float3 p = points[n];
+			float result[4];
+			for(int j = 0; j < 4; j++){
+				result[j] = ((p.x * m.m[0][j] + p.y * m.m[1][j]) + p.z * m.m[2][j]) + m.m[3][j];
+			}
+			out[n] = { result[0], result[1], result[2], result[3] };
+		}
+	}
+
+	#if defined(CPU_X86)
+	SIMD_TARGET_SSE41 void MultiplySSE4(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, size_t bStride){
+		for(size_t n = 0; n < count; n++, b += bStride){
+			__m128 b0 = _mm_loadu_ps(b->m[0]);
+			__m128 b1 = _mm_loadu_ps(b->m[1]);
+			__m128 b2 = _mm_loadu_ps(b->m[2]);
+			__m128 b3 = _mm_loadu_ps(b->m[3]);
+
+			__m128 rows[4];
+			for(int i = 0; i < 4; i++){
+				__m128 row = _mm_mul_ps(_mm_set1_ps(a[n].m[i][0]), b0);
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[n].m[i][1]), b1));
+				row = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[n].m[i][2]), b2));
+				rows[i] = _mm_add_ps(row, _mm_mul_ps(_mm_set1_ps(a[n].m[i][3]), b3));
+			}
+
+			// Stores go last so out can alias a or b.
+			for(int i = 0; i < 4; i++){
+				_mm_storeu_ps(out[n].m[i], rows[i]);
+			}
+		}
+	}
+
+	SIMD_TARGET_SSE41 void TransformSSE4(const Float4x4& m, const Float3* points, Float4* out, size_t count){
+		__m128 m0 = _mm_loadu_ps(m.m[0]);
+		__m128 m1 = _mm_loadu_ps(m.m[1]);
+		__m128 m2 = _mm_loadu_ps(m.m[2]);
+		__m128 m3 = _mm_loadu_ps(m.m[3]);
+
+		for(size_t n = 0; n < count; n++){
+			__m128 result = _mm_mul_ps(_mm_set1_ps(points[n].x), m0);
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(points[n].y), m1));
+			result = _mm_add_ps(result, _mm_mul_ps(_mm_set1_ps(points[n].z), m2));
+			result = _mm_add_ps(result, m3);
+			_mm_storeu_ps(&out[n].x, result);
+		}
+	}
+
+	// Two rows (or two points) per register, one in each 128 bit lane.
+	SIMD_TARGET_AVX2 inline __m256 SplatLanes(const float* lane0, const float* lane1){
+		return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_set1_ps(*lane0)), _mm_set1_ps(*lane1), 1);
+	}
+
+	SIMD_TARGET_AVX2 void MultiplyAVX2(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, size_t bStride){
+		for(size_t n = 0; n < count; n++, b += bStride){
+			__m256 b0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b->m[0]));
+			__m256 b1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b->m[1]));
+			__m256 b2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b->m[2]));
+			__m256 b3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(b->m[3]));
+
+			// Rows 0-1 and 2-3 of a, each lane holds one row.
+			__m256 a01 = _mm256_loadu_ps(a[n].m[0]);
+			__m256 a23 = _mm256_loadu_ps(a[n].m[2]);
+
+			__m256 r01 = _mm256_mul_ps(_mm256_permute_ps(a01, 0x00), b0);
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0x55), b1));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xAA), b2));
+			r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_permute_ps(a01, 0xFF), b3));
+
+			__m256 r23 = _mm256_mul_ps(_mm256_permute_ps(a23, 0x00), b0);
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0x55), b1));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xAA), b2));
+			r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_permute_ps(a23, 0xFF), b3));
+
+			_mm256_storeu_ps(out[n].m[0], r01);
+			_mm256_storeu_ps(out[n].m[2], r23);
+		}
+	}
+
+	SIMD_TARGET_AVX2 void TransformAVX2(const Float4x4& m, const Float3* points, Float4* out, size_t count){
+		__m256 m0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[0]));
+		__m256 m1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[1]));
+		__m256 m2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[2]));
+		__m256 m3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m.m[3]));
+
+		size_t n = 0;
+		for(; n + 2 <= count; n += 2){
+			__m256 result = _mm256_mul_ps(SplatLanes(&points[n].x, &points[n + 1].x), m0);
+			result = _mm256_add_ps(result, _mm256_mul_ps(SplatLanes(&points[n].y, &points[n + 1].y), m1));
+			result = _mm256_add_ps(result, _mm256_mul_ps(SplatLanes(&points[n].z, &points[n + 1].z), m2));
+			result = _mm256_add_ps(result, m3);
+			_mm256_storeu_ps(&out[n].x, result);
+		}
+
+		TransformSSE4(m, points + n, out + n, count - n);
+	}
+	#endif
+
+	#if defined(CPU_ARM)
+	void MultiplyNEON(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, size_t bStride){
+		for(size_t n = 0; n < count; n++, b += bStride){
+			float32x4_t b0 = vld1q_f32(b->m[0]);
+			float32x4_t b1 = vld1q_f32(b->m[1]);
+			float32x4_t b2 = vld1q_f32(b->m[2]);
+			float32x4_t b3 = vld1q_f32(b->m[3]);
+
+			// vmlaq may fuse on AArch64, separate multiplies keep the rounding.
+			float32x4_t rows[4];
+			for(int i = 0; i < 4; i++){
+				float32x4_t row = vmulq_f32(vdupq_n_f32(a[n].m[i][0]), b0);
+				row = vaddq_f32(row, vmulq_f32(vdupq_n_f32(a[n].m[i][1]), b1));
+				row = vaddq_f32(row, vmulq_f32(vdupq_n_f32(a[n].m[i][2]), b2));
+				rows[i] = vaddq_f32(row, vmulq_f32(vdupq_n_f32(a[n].m[i][3]), b3));
+			}
+
+			for(int i = 0; i < 4; i++){
+				vst1q_f32(out[n].m[i], rows[i]);
+			}
+		}
+	}
+
+	void TransformNEON(const Float4x4& m, const Float3* points, Float4* out, size_t count){
+		float32x4_t m0 = vld1q_f32(m.m[0]);
+		float32x4_t m1 = vld1q_f32(m.m[1]);
+		float32x4_t m2 = vld1q_f32(m.m[2]);
+		float32x4_t m3 = vld1q_f32(m.m[3]);
+
+		for(size_t n = 0; n < count; n++){
+			float32x4_t result = vmulq_f32(vdupq_n_f32(points[n].x), m0);
+			result = vaddq_f32(result, vmulq_f32(vdupq_n_f32(points[n].y), m1));
+			result = vaddq_f32(result, vmulq_f32(vdupq_n_f32(points[n].z), m2));
+			result = vaddq_f32(result, m3);
+			vst1q_f32(&out[n].x, result);
+		}
+	}
+	#endif
+
+	MultiplyKernel SelectMultiply(MathPath path){
+		if(path == MathPath::Auto){
+			path = GetBestMathPath();
+		}
+		if(!IsMathPathSupported(path)){
+			return MultiplyScalar;
+		}
+
+		switch(path){
+			#if defined(CPU_X86)
+			case MathPath::AVX2: return MultiplyAVX2;
+			case MathPath::SSE4: return MultiplySSE4;
+			#elif defined(CPU_ARM)
+			case MathPath::NEON: return MultiplyNEON;
+			#endif
+			default: return MultiplyScalar;
+		}
+	}
+
+	TransformKernel SelectTransform(MathPath path){
+		if(path == MathPath::Auto){
+			path = GetBestMathPath();
+		}
+		if(!IsMathPathSupported(path)){
+			return TransformScalar;
+		}
+
+		switch(path){
+			#if defined(CPU_X86)
+			case MathPath::AVX2: return TransformAVX2;
+			case MathPath::SSE4: return TransformSSE4;
+			#elif defined(CPU_ARM)
+			case MathPath::NEON: return TransformNEON;
+			#endif
+			default: return TransformScalar;
+		}
+	}
+}
+
+Float4x4 Float4x4::Identity(){
+	Float4x4 identity = { {
+		{ 1.0f, 0.0f, 0.0f, 0.0f },
+		{ 0.0f, 1.0f, 0.0f, 0.0f },
+		{ 0.0f, 0.0f, 1.0f, 0.0f },
+		{ 0.0f, 0.0f, 0.0f, 1.0f }
+	} };
+	return identity;
+}
+
+Float4x4 Float4x4::Translation(float x, float y, float z){
+	Float4x4 translation = Identity();
+	translation.m[3][0] = x;
+	translation.m[3][1] = y;
+	translation.m[3][2] = z;
+	return translation;
+}
+
+bool IsMathPathSupported(MathPath path){
+	const CpuFeatures& features = CpuFeatures::Get();
+	switch(path){
+		case MathPath::Auto:
+		case MathPath::Scalar: return true;
+		case MathPath::SSE4: return features.sse41;
+		case MathPath::AVX2: return features.avx2;
+		case MathPath::NEON: return features.neon;
+	}
+	return false;
+}
+
+MathPath GetBestMathPath(){
+	const CpuFeatures& features = CpuFeatures::Get();
+	if(features.avx2){
+		return MathPath::AVX2;
+	}
+	if(features.sse41){
+		return MathPath::SSE4;
+	}
+	if(features.neon){
+		return MathPath::NEON;
+	}
+	return MathPath::Scalar;
+}
+
+void MultiplyMatrices(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, MathPath path){
+	SelectMultiply(path)(a, b, out, count, 1);
+}
+
+void TransformPoints(const Float4x4& m, const Float3* points, Float4* out, size_t count, MathPath path){
+	SelectTransform(path)(m, points, out, count);
+}
+
+void ComputeModelViewProjection(const Float4x4* models, const Float4x4& view, const Float4x4& projection, Float4x4* out,
+	size_t count, MathPath path){
+	const Float4x4 viewProjection = Multiply(view, projection);
+	SelectMultiply(path)(models, &viewProjection, out, count, 0);
+}
+
+Float4x4 Multiply(const Float4x4& a, const Float4x4& b){
+	Float4x4 result;
+	MultiplyScalar(&a, &b, &result, 1, 0);
+	return result;
+}
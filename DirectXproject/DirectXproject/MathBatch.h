@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+
+// Portable matrix types for CPU-side batch work. Float4x4 is row-major with
+// the row-vector convention (v * M), the same memory layout as
+// DirectX::XMFLOAT4X4, so arrays of either can be reinterpreted.
+struct Float3 {
+	float x, y, z;
+};
+
+struct Float4 {
+	float x, y, z, w;
+};
+
+struct Float4x4 {
+	float m[4][4];
+
+	static Float4x4 Identity();
+	// Translation in the last row, for row vectors.
+	static Float4x4 Translation(float x, float y, float z);
+};
+
+// Which kernels run the batch. Auto picks the widest the CPU supports.
+// Every path gives bit-identical results to Scalar: no FMA, and the
+// multiplies and adds happen in the same order.
+enum class MathPath { Auto, Scalar, SSE4, AVX2, NEON };
+
+// out[i] = a[i] * b[i]. out may alias a or b.
+void MultiplyMatrices(const Float4x4* a, const Float4x4* b, Float4x4* out, size_t count, MathPath path = MathPath::Auto);
+
+// out[i] = float4(points[i], 1) * m.
+void TransformPoints(const Float4x4& m, const Float3* points, Float4* out, size_t count, MathPath path = MathPath::Auto);
+
+// out[i] = models[i] * view * projection, view * projection computed once.
+void ComputeModelViewProjection(const Float4x4* models, const Float4x4& view, const Float4x4& projection, Float4x4* out,
+	size_t count, MathPath path = MathPath::Auto);
+
+// Single matrix product through the scalar reference.
+Float4x4 Multiply(const Float4x4& a, const Float4x4& b);
+
+// The path Auto resolves to, and whether a given path can run here.
+MathPath GetBestMathPath();
+bool IsMathPathSupported(MathPath path);
@@ -0,0 +1,225 @@
+#include "MeshFile.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace {
+	uint64_t AlignUp(uint64_t value, uint64_t alignment){
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	bool WritePadded(FILE* file, const void* data, size_t size, uint64_t& offset, uint64_t target){
+		static const uint8_t zeros[kMeshFileAlignment] = {};
+		if(target > offset && fwrite(zeros, 1, static_cast<size_t>(target - offset), file) != target - offset){
+			return false;
+		}
+		offset = target;
+		if(size && fwrite(data, 1, size, file) != size){
+			return false;
+		}
+		offset += size;
+		return true;
+	}
+
+	VertexFormat FormatFromHeader(const MeshFileHeader& header){
+		VertexFormat format;
+		format.position = static_cast<PositionEncoding>(header.positionEncoding);
+		format.normal = static_cast<NormalEncoding>(header.normalEncoding);
+		format.tangent = static_cast<NormalEncoding>(header.tangentEncoding);
+		format.color = static_cast<ColorEncoding>(header.colorEncoding);
+		format.uv = static_cast<UvEncoding>(header.uvEncoding);
+		format.ComputeLayout();
+		return format;
+	}
+
+	const float* PositionAt(const MeshFileDesc& desc, uint32_t index){
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(desc.positions) + size_t(index) * desc.positionStride);
+	}
+
+	// Bounding sphere around the box center. Not minimal, but cheap and stable.
+	void ComputeSphere(const MeshFileDesc& desc, const uint32_t* indices, uint32_t indexCount, float center[3], float& radius){
+		float boxMin[3] = { 0.0f, 0.0f, 0.0f };
+		float boxMax[3] = { 0.0f, 0.0f, 0.0f };
+		for(uint32_t i = 0; i < indexCount; i++){
+			const float* p = PositionAt(desc, indices[i]);
+			for(int k = 0; k < 3; k++){
+				boxMin[k] = i ? std::min(boxMin[k], p[k]) : p[k];
+				boxMax[k] = i ? std::max(boxMax[k], p[k]) : p[k];
+			}
+		}
+		for(int k = 0; k < 3; k++){
+			center[k] = (boxMin[k] + boxMax[k]) * 0.5f;
+		}
+
+		float radiusSquared = 0.0f;
+		for(uint32_t i = 0; i < indexCount; i++){
+			const float* p = PositionAt(desc, indices[i]);
+			float dx = p[0] - center[0];
+			float dy = p[1] - center[1];
+			float dz = p[2] - center[2];
+			radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+		}
+		radius = sqrtf(radiusSquared);
+	}
+}
+
+bool WriteMeshFile(const char* path, const MeshFileDesc& desc){
+	if(!desc.vertices || !desc.positions || desc.vertexCount == 0 || desc.format.stride == 0){
+		return false;
+	}
+	if(desc.indexCount && !desc.indices){
+		return false;
+	}
+	for(uint32_t i = 0; i < desc.indexCount; i++){
+		if(desc.indices[i] >= desc.vertexCount){
+			return false;
+		}
+	}
+
+	std::vector<MeshFileSubmesh> submeshes = desc.submeshes;
+	if(submeshes.empty()){
+		submeshes.push_back({ 0, desc.indexCount, 0, 0, { 0.0f, 0.0f, 0.0f }, 0.0f });
+	}
+	for(MeshFileSubmesh& submesh : submeshes){
+		if(uint64_t(submesh.indexStart) + submesh.indexCount > desc.indexCount){
+			return false;
+		}
+		ComputeSphere(desc, desc.indices + submesh.indexStart, submesh.indexCount, submesh.center, submesh.radius);
+	}
+
+	IndexFormat indexFormat = ChooseIndexFormat(desc.vertexCount);
+	std::vector<uint8_t> indexData = PackIndices(desc.indices, desc.indexCount, indexFormat);
+
+	MeshFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kMeshFileMagic;
+	header.version = kMeshFileVersion;
+	header.headerSize = sizeof(MeshFileHeader);
+	header.vertexCount = desc.vertexCount;
+	header.vertexStride = desc.format.stride;
+	header.indexCount = desc.indexCount;
+	header.indexFormat = static_cast<uint32_t>(indexFormat);
+	header.submeshCount = static_cast<uint32_t>(submeshes.size());
+	header.positionEncoding = static_cast<uint8_t>(desc.format.position);
+	header.normalEncoding = static_cast<uint8_t>(desc.format.normal);
+	header.tangentEncoding = static_cast<uint8_t>(desc.format.tangent);
+	header.colorEncoding = static_cast<uint8_t>(desc.format.color);
+	header.uvEncoding = static_cast<uint8_t>(desc.format.uv);
+	header.quantization = desc.quantization;
+
+	for(uint32_t i = 0; i < desc.vertexCount; i++){
+		const float* p = PositionAt(desc, i);
+		for(int k = 0; k < 3; k++){
+			header.aabbMin[k] = i ? std::min(header.aabbMin[k], p[k]) : p[k];
+			header.aabbMax[k] = i ? std::max(header.aabbMax[k], p[k]) : p[k];
+		}
+	}
+	std::vector<uint32_t> allVertices(desc.vertexCount);
+	for(uint32_t i = 0; i < desc.vertexCount; i++){
+		allVertices[i] = i;
+	}
+	ComputeSphere(desc, allVertices.data(), desc.vertexCount, header.sphereCenter, header.sphereRadius);
+
+	const uint64_t submeshSize = sizeof(MeshFileSubmesh) * submeshes.size();
+	header.submeshOffset = AlignUp(sizeof(MeshFileHeader), kMeshFileAlignment);
+	header.vertexOffset = AlignUp(header.submeshOffset + submeshSize, kMeshFileAlignment);
+	header.vertexSize = uint64_t(desc.vertexCount) * desc.format.stride;
+	header.indexOffset = AlignUp(header.vertexOffset + header.vertexSize, kMeshFileAlignment);
+	header.indexSize = indexData.size();
+	header.fileSize = header.indexOffset + header.indexSize;
+
+	FILE* file = fopen(path, "wb");
+	if(!file){
+		return false;
+	}
+
+	uint64_t offset = 0;
+	bool written = WritePadded(file, &header, sizeof(header), offset, 0)
+		&& WritePadded(file, submeshes.data(), static_cast<size_t>(submeshSize), offset, header.submeshOffset)
+		&& WritePadded(file, desc.vertices, static_cast<size_t>(header.vertexSize), offset, header.vertexOffset)
+		&& WritePadded(file, indexData.data(), indexData.size(), offset, header.indexOffset);
+
+	if(fclose(file) != 0){
+		written = false;
+	}
+	if(!written){
+		remove(path);
+	}
+	return written;
+}
+
+bool MeshFile::Open(const char* path){
+	Close();
+	if(!mFile.Open(path)){
+		return false;
+	}
+
+	const size_t size = mFile.Size();
+	if(size < sizeof(MeshFileHeader)){
+		Close();
+		return false;
+	}
+
+	const MeshFileHeader* header = reinterpret_cast<const MeshFileHeader*>(mFile.Data());
+	// Everything below is untrusted, check every range against the mapping.
+	auto inside = [size](uint64_t offset, uint64_t bytes){
+		return offset % kMeshFileAlignment == 0 && offset <= size && bytes <= size - offset;
+	};
+	const uint64_t indexSize = header->indexFormat == static_cast<uint32_t>(IndexFormat::UInt16) ? 2 : 4;
+	bool valid = header->magic == kMeshFileMagic
+		&& header->version == kMeshFileVersion
+		&& header->headerSize == sizeof(MeshFileHeader)
+		&& header->fileSize == size
+		&& header->indexFormat <= static_cast<uint32_t>(IndexFormat::UInt32)
+		&& header->vertexSize == uint64_t(header->vertexCount) * header->vertexStride
+		&& header->indexSize == uint64_t(header->indexCount) * indexSize
+		&& inside(header->submeshOffset, uint64_t(header->submeshCount) * sizeof(MeshFileSubmesh))
+		&& inside(header->vertexOffset, header->vertexSize)
+		&& inside(header->indexOffset, header->indexSize);
+
+	if(valid){
+		valid = header->positionEncoding <= static_cast<uint8_t>(PositionEncoding::Unorm16)
+			&& header->normalEncoding <= static_cast<uint8_t>(NormalEncoding::Oct8)
+			&& header->tangentEncoding <= static_cast<uint8_t>(NormalEncoding::Oct8)
+			&& header->colorEncoding <= static_cast<uint8_t>(ColorEncoding::Unorm8)
+			&& header->uvEncoding <= static_cast<uint8_t>(UvEncoding::Unorm16)
+			&& FormatFromHeader(*header).stride == header->vertexStride;
+	}
+
+	if(valid){
+		const MeshFileSubmesh* submeshes = reinterpret_cast<const MeshFileSubmesh*>(mFile.Data() + header->submeshOffset);
+		for(uint32_t i = 0; i < header->submeshCount && valid; i++){
+			valid = uint64_t(submeshes[i].indexStart) + submeshes[i].indexCount <= header->indexCount;
+		}
+	}
+
+	if(!valid){
+		Close();
+		return false;
+	}
+
+	mHeader = header;
+	return true;
+}
+
+void MeshFile::Close(){
+	mHeader = nullptr;
+	mFile.Close();
+}
+
+VertexFormat MeshFile::GetVertexFormat() const {
+	return FormatFromHeader(*mHeader);
+}
+
+const MeshFileSubmesh* MeshFile::GetSubmeshes() const {
+	return reinterpret_cast<const MeshFileSubmesh*>(mFile.Data() + mHeader->submeshOffset);
+}
+
+void MeshFile::Prefetch() const {
+	if(!mHeader){
+		return;
+	}
+	mFile.Prefetch(static_cast<size_t>(mHeader->vertexOffset), static_cast<size_t>(mHeader->indexOffset + mHeader->indexSize - mHeader->vertexOffset));
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "VertexFormat.h"
+
+// Binary mesh container laid out to be used in place: a fixed header,
+// then the submesh table and the vertex and index streams, each starting
+// on a kMeshFileAlignment boundary. Loading is a map plus a header check,
+// the streams can be copied straight into an upload buffer.
+//
+// All values are little endian.
+
+static constexpr uint32_t kMeshFileMagic = 0x4853454D; // "MESH"
+static constexpr uint16_t kMeshFileVersion = 1;
+static constexpr uint32_t kMeshFileAlignment = 256;
+
+struct MeshFileSubmesh {
+	uint32_t indexStart;
+	uint32_t indexCount;
+	uint32_t baseVertex;
+	uint32_t material;
+	// Bounding sphere in mesh space.
+	float center[3];
+	float radius;
+};
+
+struct MeshFileHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t headerSize;
+	uint64_t fileSize;
+
+	uint32_t vertexCount;
+	uint32_t vertexStride;
+	uint32_t indexCount;
+	// IndexFormat.
+	uint32_t indexFormat;
+	uint32_t submeshCount;
+
+	// VertexFormat encodings, one byte each.
+	uint8_t positionEncoding;
+	uint8_t normalEncoding;
+	uint8_t tangentEncoding;
+	uint8_t colorEncoding;
+	uint8_t uvEncoding;
+	uint8_t reserved[3];
+
+	QuantizationBounds quantization;
+
+	// Whole mesh bounds.
+	float aabbMin[3];
+	float aabbMax[3];
+	float sphereCenter[3];
+	float sphereRadius;
+	uint32_t padding;
+
+	uint64_t submeshOffset;
+	uint64_t vertexOffset;
+	uint64_t vertexSize;
+	uint64_t indexOffset;
+	uint64_t indexSize;
+};
+
+static_assert(sizeof(MeshFileHeader) == 168, "MeshFileHeader layout is part of the file format");
+
+// Everything needed to write a mesh file. Indices are stored in the
+// smallest format that fits vertexCount.
+struct MeshFileDesc {
+	const uint8_t* vertices = nullptr;
+	uint32_t vertexCount = 0;
+	VertexFormat format;
+	QuantizationBounds quantization = {};
+	const uint32_t* indices = nullptr;
+	uint32_t indexCount = 0;
+	// Empty means one submesh covering every index.
+	std::vector<MeshFileSubmesh> submeshes;
+	// Decoded positions for the bounds, vertexCount of them.
+	const float* positions = nullptr;
+	uint32_t positionStride = sizeof(float) * 3;
+};
+
+bool WriteMeshFile(const char* path, const MeshFileDesc& desc);
+
+class MeshFile {
+public:
+	// Maps the file and validates the header. Nothing else is read.
+	bool Open(const char* path);
+	void Close();
+
+	const MeshFileHeader& GetHeader() const { return *mHeader; }
+	VertexFormat GetVertexFormat() const;
+	IndexFormat GetIndexFormat() const { return static_cast<IndexFormat>(mHeader->indexFormat); }
+
+	// Pointers into the mapping, valid until Close.
+	const uint8_t* GetVertexData() const { return mFile.Data() + mHeader->vertexOffset; }
+	size_t GetVertexDataSize() const { return static_cast<size_t>(mHeader->vertexSize); }
+	const uint8_t* GetIndexData() const { return mFile.Data() + mHeader->indexOffset; }
+	size_t GetIndexDataSize() const { return static_cast<size_t>(mHeader->indexSize); }
+	const MeshFileSubmesh* GetSubmeshes() const;
+	uint32_t GetSubmeshCount() const { return mHeader->submeshCount; }
+
+	// Starts reading the streams in ahead of the upload copy.
+	void Prefetch() const;
+
+	bool IsOpen() const { return mHeader != nullptr; }
+
+private:
+	MappedFile mFile;
+	const MeshFileHeader* mHeader = nullptr;
+};
@@ -0,0 +1,483 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	// Tuning from Tom Forsyth's "Linear-Speed Vertex Cache Optimisation".
+	const int kCacheSize = 32;
+	const float kCacheDecayPower = 1.5f;
+	const float kLastTriangleScore = 0.75f;
+	const float kValenceBoostScale = 2.0f;
+	const float kValenceBoostPower = 0.5f;
+
+	// Resolution of each AnalyzeOverdraw view.
+	const int kOverdrawGridSize = 256;
+
+	float VertexScore(int cachePosition, uint32_t remainingTriangles){
+		if(remainingTriangles == 0){
+			return -1.0f;
+		}
+
+		float score = 0.0f;
+		if(cachePosition >= 0){
+			if(cachePosition < 3){
+				// The last triangle's vertices get a fixed score so the next
+				// triangle does not simply reuse its edge.
+				score = kLastTriangleScore;
+			}else{
+				float scaler = 1.0f / (kCacheSize - 3);
+				score = powf(1.0f - (cachePosition - 3) * scaler, kCacheDecayPower);
+			}
+		}
+
+		// Finish off vertices with few triangles left so they leave the cache.
+		score += kValenceBoostScale * powf(static_cast<float>(remainingTriangles), -kValenceBoostPower);
+		return score;
+	}
+
+	struct Adjacency {
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> counts;
+		std::vector<uint32_t> triangles;
+	};
+
+	void BuildAdjacency(Adjacency& adjacency, const uint32_t* indices, size_t indexCount, size_t vertexCount){
+		adjacency.counts.assign(vertexCount, 0);
+		for(size_t i = 0; i < indexCount; i++){
+			assert(indices[i] < vertexCount);
+			adjacency.counts[indices[i]]++;
+		}
+
+		adjacency.offsets.resize(vertexCount);
+		uint32_t offset = 0;
+		for(size_t v = 0; v < vertexCount; v++){
+			adjacency.offsets[v] = offset;
+			offset += adjacency.counts[v];
+		}
+
+		adjacency.triangles.resize(indexCount);
+		std::vector<uint32_t> fill(adjacency.offsets);
+		for(size_t i = 0; i < indexCount; i++){
+			adjacency.triangles[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+
+	const float* GetPosition(const float* positions, size_t stride, uint32_t vertex){
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + vertex * stride);
+	}
+}
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize){
+	VertexCacheStats stats = {};
+
+	// FIFO cache: a vertex is resident while fewer than cacheSize misses
+	// happened since it was loaded.
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	std::vector<uint8_t> used(vertexCount, 0);
+	uint32_t misses = 0;
+	for(size_t i = 0; i < indexCount; i++){
+		uint32_t v = indices[i];
+		if(!used[v] || misses - loadedAt[v] >= cacheSize){
+			loadedAt[v] = misses;
+			misses++;
+		}
+		used[v] = 1;
+	}
+
+	size_t usedVertices = 0;
+	for(uint8_t u : used){
+		usedVertices += u;
+	}
+
+	stats.vertexTransforms = misses;
+	stats.acmr = indexCount ? static_cast<float>(misses) / (indexCount / 3) : 0.0f;
+	stats.atvr = usedVertices ? static_cast<float>(misses) / usedVertices : 0.0f;
+	return stats;
+}
+
+OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride){
+	assert(indexCount % 3 == 0);
+	OverdrawStats stats = {};
+	if(indexCount == 0 || vertexCount == 0){
+		return stats;
+	}
+
+	// One square pixel size for every view, from the largest box side.
+	float boxMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float boxMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for(size_t v = 0; v < vertexCount; v++){
+		const float* p = GetPosition(positions, positionStride, static_cast<uint32_t>(v));
+		for(int k = 0; k < 3; k++){
+			boxMin[k] = std::min(boxMin[k], p[k]);
+			boxMax[k] = std::max(boxMax[k], p[k]);
+		}
+	}
+	const float extent = std::max(boxMax[0] - boxMin[0], std::max(boxMax[1] - boxMin[1], boxMax[2] - boxMin[2]));
+	if(extent <= 0.0f){
+		return stats;
+	}
+	const float scale = kOverdrawGridSize / extent;
+
+	std::vector<float> depth(kOverdrawGridSize * kOverdrawGridSize);
+	for(int axis = 0; axis < 3; axis++){
+		for(int side = 0; side < 2; side++){
+			// The viewer sits on the sign side of the axis, looking back.
+			const float sign = side == 0 ? 1.0f : -1.0f;
+			const int uAxis = (axis + 1) % 3;
+			const int vAxis = (axis + 2) % 3;
+			std::fill(depth.begin(), depth.end(), FLT_MAX);
+
+			for(size_t i = 0; i < indexCount; i += 3){
+				float u[3], v[3], z[3];
+				for(int k = 0; k < 3; k++){
+					const float* p = GetPosition(positions, positionStride, indices[i + k]);
+					u[k] = (p[uAxis] - boxMin[uAxis]) * scale;
+					v[k] = (p[vAxis] - boxMin[vAxis]) * scale;
+					z[k] = -sign * p[axis];
+				}
+
+				// Twice the projected area, the normal's component along the axis.
+				const float area = (u[1] - u[0]) * (v[2] - v[0]) - (u[2] - u[0]) * (v[1] - v[0]);
+				if(area * sign <= 0.0f){
+					continue;
+				}
+				const float invArea = 1.0f / area;
+
+				const int x0 = std::max(0, static_cast<int>(floorf(std::min(u[0], std::min(u[1], u[2])))));
+				const int x1 = std::min(kOverdrawGridSize - 1, static_cast<int>(std::max(u[0], std::max(u[1], u[2]))));
+				const int y0 = std::max(0, static_cast<int>(floorf(std::min(v[0], std::min(v[1], v[2])))));
+				const int y1 = std::min(kOverdrawGridSize - 1, static_cast<int>(std::max(v[0], std::max(v[1], v[2]))));
+				for(int y = y0; y <= y1; y++){
+					const float cy = y + 0.5f;
+					for(int x = x0; x <= x1; x++){
+						const float cx = x + 0.5f;
+						// Barycentrics, each vertex's weight from the edge opposite it.
+						const float w0 = ((u[2] - u[1]) * (cy - v[1]) - (v[2] - v[1]) * (cx - u[1])) * invArea;
+						const float w1 = ((u[0] - u[2]) * (cy - v[2]) - (v[0] - v[2]) * (cx - u[2])) * invArea;
+						const float w2 = ((u[1] - u[0]) * (cy - v[0]) - (v[1] - v[0]) * (cx - u[0])) * invArea;
+						if(w0 < 0.0f || w1 < 0.0f || w2 < 0.0f){
+							continue;
+						}
+
+						float& stored = depth[y * kOverdrawGridSize + x];
+						const float d = w0 * z[0] + w1 * z[1] + w2 * z[2];
+						if(d < stored){
+							stored = d;
+							stats.pixelsShaded++;
+						}
+					}
+				}
+			}
+
+			for(float d : depth){
+				stats.pixelsCovered += d != FLT_MAX;
+			}
+		}
+	}
+
+	stats.overdraw = stats.pixelsCovered > 0 ? static_cast<float>(stats.pixelsShaded) / stats.pixelsCovered : 0.0f;
+	return stats;
+}
+
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount){
+	assert(indexCount % 3 == 0);
+	const size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0){
+		return;
+	}
+
+	// Work from a copy so destination may alias indices.
+	std::vector<uint32_t> source(indices, indices + indexCount);
+
+	Adjacency adjacency;
+	BuildAdjacency(adjacency, source.data(), indexCount, vertexCount);
+
+	std::vector<uint32_t> remaining(adjacency.counts);
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	for(size_t v = 0; v < vertexCount; v++){
+		vertexScore[v] = VertexScore(-1, remaining[v]);
+	}
+
+	std::vector<float> triangleScore(triangleCount);
+	std::vector<uint8_t> emitted(triangleCount, 0);
+	for(size_t t = 0; t < triangleCount; t++){
+		triangleScore[t] = vertexScore[source[t * 3]] + vertexScore[source[t * 3 + 1]] + vertexScore[source[t * 3 + 2]];
+	}
+
+	// Room for the cache plus the three vertices of the triangle being added.
+	uint32_t cache[kCacheSize + 3];
+	int cacheCount = 0;
+	size_t nextUnemitted = 0;
+	size_t written = 0;
+
+	int64_t bestTriangle = 0;
+	float bestScore = triangleScore[0];
+	for(size_t t = 1; t < triangleCount; t++){
+		if(triangleScore[t] > bestScore){
+			bestScore = triangleScore[t];
+			bestTriangle = static_cast<int64_t>(t);
+		}
+	}
+
+	while(bestTriangle >= 0){
+		const uint32_t* tri = &source[bestTriangle * 3];
+		destination[written++] = tri[0];
+		destination[written++] = tri[1];
+		destination[written++] = tri[2];
+		emitted[bestTriangle] = 1;
+
+		// Drop the triangle from its vertices' remaining lists.
+		for(int k = 0; k < 3; k++){
+			uint32_t v = tri[k];
+			uint32_t* list = &adjacency.triangles[adjacency.offsets[v]];
+			uint32_t count = remaining[v];
+			for(uint32_t i = 0; i < count; i++){
+				if(list[i] == bestTriangle){
+					list[i] = list[count - 1];
+					break;
+				}
+			}
+			remaining[v]--;
+		}
+
+		// New cache: the triangle's vertices first, then the old entries.
+		uint32_t newCache[kCacheSize + 3];
+		int newCount = 0;
+		for(int k = 0; k < 3; k++){
+			newCache[newCount++] = tri[k];
+		}
+		for(int i = 0; i < cacheCount; i++){
+			uint32_t v = cache[i];
+			if(v != tri[0] && v != tri[1] && v != tri[2]){
+				newCache[newCount++] = v;
+			}
+		}
+
+		// Rescore everything that was or is in the cache. Anything past the
+		// cache size has been evicted.
+		for(int i = 0; i < newCount; i++){
+			uint32_t v = newCache[i];
+			cachePosition[v] = i < kCacheSize ? i : -1;
+			vertexScore[v] = VertexScore(cachePosition[v], remaining[v]);
+		}
+
+		bestTriangle = -1;
+		bestScore = -1.0f;
+		for(int i = 0; i < newCount; i++){
+			uint32_t v = newCache[i];
+			const uint32_t* list = &adjacency.triangles[adjacency.offsets[v]];
+			for(uint32_t j = 0; j < remaining[v]; j++){
+				uint32_t t = list[j];
+				const uint32_t* other = &source[t * 3];
+				float score = vertexScore[other[0]] + vertexScore[other[1]] + vertexScore[other[2]];
+				triangleScore[t] = score;
+				if(score > bestScore){
+					bestScore = score;
+					bestTriangle = t;
+				}
+			}
+		}
+
+		cacheCount = std::min(newCount, kCacheSize);
+		memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+		// Nothing in the cache has work left, continue with the next
+		// triangle in input order.
+		if(bestTriangle < 0){
+			while(nextUnemitted < triangleCount && emitted[nextUnemitted]){
+				nextUnemitted++;
+			}
+			if(nextUnemitted < triangleCount){
+				bestTriangle = static_cast<int64_t>(nextUnemitted);
+			}
+		}
+	}
+
+	assert(written == indexCount);
+}
+
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, float threshold){
+	assert(indexCount % 3 == 0);
+	const size_t triangleCount = indexCount / 3;
+	std::vector<uint32_t> source(indices, indices + indexCount);
+	if(triangleCount < 2){
+		memmove(destination, source.data(), indexCount * sizeof(uint32_t));
+		return;
+	}
+
+	// Cluster boundaries: triangles whose three vertices all miss the cache.
+	// Moving whole clusters around leaves the cache behaviour nearly intact.
+	const uint32_t cacheSize = 16;
+	std::vector<uint32_t> loadedAt(vertexCount, 0);
+	std::vector<uint8_t> used(vertexCount, 0);
+	std::vector<size_t> clusterStart;
+	uint32_t misses = 0;
+	for(size_t t = 0; t < triangleCount; t++){
+		int triangleMisses = 0;
+		for(int k = 0; k < 3; k++){
+			uint32_t v = source[t * 3 + k];
+			if(!used[v] || misses - loadedAt[v] >= cacheSize){
+				loadedAt[v] = misses;
+				misses++;
+				triangleMisses++;
+			}
+			used[v] = 1;
+		}
+		if(t == 0 || triangleMisses == 3){
+			clusterStart.push_back(t);
+		}
+	}
+	clusterStart.push_back(triangleCount);
+
+	// Area weighted mesh centroid.
+	double meshCenter[3] = { 0.0, 0.0, 0.0 };
+	double meshArea = 0.0;
+	struct Cluster { size_t begin, end; float sortKey; };
+	std::vector<Cluster> clusters;
+	std::vector<float> triangleData(triangleCount * 4);
+	for(size_t t = 0; t < triangleCount; t++){
+		const float* a = GetPosition(positions, positionStride, source[t * 3]);
+		const float* b = GetPosition(positions, positionStride, source[t * 3 + 1]);
+		const float* c = GetPosition(positions, positionStride, source[t * 3 + 2]);
+		float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]) * 0.5f;
+		for(int k = 0; k < 3; k++){
+			meshCenter[k] += (a[k] + b[k] + c[k]) / 3.0 * area;
+		}
+		meshArea += area;
+		// Keep the unnormalized normal, its length weights by area.
+		triangleData[t * 4 + 0] = n[0];
+		triangleData[t * 4 + 1] = n[1];
+		triangleData[t * 4 + 2] = n[2];
+		triangleData[t * 4 + 3] = area;
+	}
+	if(meshArea > 0.0){
+		for(int k = 0; k < 3; k++){
+			meshCenter[k] /= meshArea;
+		}
+	}
+
+	// Sort key: how far the cluster sits out along its own facing direction.
+	// Clusters on the outside of the mesh occlude the ones further in.
+	for(size_t i = 0; i + 1 < clusterStart.size(); i++){
+		double center[3] = { 0.0, 0.0, 0.0 };
+		double normal[3] = { 0.0, 0.0, 0.0 };
+		double area = 0.0;
+		for(size_t t = clusterStart[i]; t < clusterStart[i + 1]; t++){
+			const float* a = GetPosition(positions, positionStride, source[t * 3]);
+			const float* b = GetPosition(positions, positionStride, source[t * 3 + 1]);
+			const float* c = GetPosition(positions, positionStride, source[t * 3 + 2]);
+			float triangleArea = triangleData[t * 4 + 3];
+			for(int k = 0; k < 3; k++){
+				center[k] += (a[k] + b[k] + c[k]) / 3.0 * triangleArea;
+				normal[k] += triangleData[t * 4 + k];
+			}
+			area += triangleArea;
+		}
+
+		double normalLength = sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float key = 0.0f;
+		if(area > 0.0 && normalLength > 0.0){
+			for(int k = 0; k < 3; k++){
+				key += static_cast<float>((center[k] / area - meshCenter[k]) * normal[k] / normalLength);
+			}
+		}
+		clusters.push_back({ clusterStart[i], clusterStart[i + 1], key });
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b){ return a.sortKey > b.sortKey; });
+
+	std::vector<uint32_t> reordered;
+	reordered.reserve(indexCount);
+	for(const Cluster& cluster : clusters){
+		reordered.insert(reordered.end(), source.begin() + cluster.begin * 3, source.begin() + cluster.end * 3);
+	}
+
+	// Only keep the new order if the cache did not pay too much for it.
+	float before = AnalyzeVertexCache(source.data(), indexCount, vertexCount).acmr;
+	float after = AnalyzeVertexCache(reordered.data(), indexCount, vertexCount).acmr;
+	const std::vector<uint32_t>& result = after <= before * threshold ? reordered : source;
+	memcpy(destination, result.data(), indexCount * sizeof(uint32_t));
+}
+
+size_t BuildVertexFetchRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount){
+	remap.assign(vertexCount, ~0u);
+	uint32_t next = 0;
+	for(size_t i = 0; i < indexCount; i++){
+		uint32_t& target = remap[indices[i]];
+		if(target == ~0u){
+			target = next++;
+		}
+	}
+	return next;
+}
+
+size_t OptimizeVertexFetch(void* destinationVertices, uint32_t* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize){
+	std::vector<uint32_t> remap;
+	size_t usedCount = BuildVertexFetchRemap(remap, indices, indexCount, vertexCount);
+
+	// Copy through a scratch buffer so the destination may be the source.
+	std::vector<uint8_t> scratch(usedCount * vertexSize);
+	const uint8_t* source = static_cast<const uint8_t*>(vertices);
+	for(size_t v = 0; v < vertexCount; v++){
+		if(remap[v] != ~0u){
+			memcpy(scratch.data() + remap[v] * vertexSize, source + v * vertexSize, vertexSize);
+		}
+	}
+	if(!scratch.empty()){
+		memcpy(destinationVertices, scratch.data(), scratch.size());
+	}
+
+	for(size_t i = 0; i < indexCount; i++){
+		indices[i] = remap[indices[i]];
+	}
+	return usedCount;
+}
+
+IndexFormat ChooseIndexFormat(size_t vertexCount){
+	return vertexCount < 0x10000 ? IndexFormat::UInt16 : IndexFormat::UInt32;
+}
+
+std::vector<uint8_t> PackIndices(const uint32_t* indices, size_t indexCount, IndexFormat format){
+	std::vector<uint8_t> packed(indexCount * GetIndexSize(format));
+	if(format == IndexFormat::UInt32){
+		memcpy(packed.data(), indices, packed.size());
+		return packed;
+	}
+
+	uint16_t* narrow = reinterpret_cast<uint16_t*>(packed.data());
+	for(size_t i = 0; i < indexCount; i++){
+		assert(indices[i] <= 0xFFFF);
+		narrow[i] = static_cast<uint16_t>(indices[i]);
+	}
+	return packed;
+}
+
+MeshOptimizationReport OptimizeMesh(std::vector<uint8_t>& vertices, size_t vertexSize, size_t positionOffset,
+	std::vector<uint32_t>& indices, float overdrawThreshold){
+	MeshOptimizationReport report = {};
+	const size_t vertexCount = vertices.size() / vertexSize;
+	report.vertexCountBefore = vertexCount;
+	report.before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+
+	OptimizeVertexCache(indices.data(), indices.data(), indices.size(), vertexCount);
+	const float* positions = reinterpret_cast<const float*>(vertices.data() + positionOffset);
+	OptimizeOverdraw(indices.data(), indices.data(), indices.size(), positions, vertexCount, vertexSize, overdrawThreshold);
+
+	size_t usedCount = OptimizeVertexFetch(vertices.data(), indices.data(), indices.size(), vertices.data(), vertexCount, vertexSize);
+	vertices.resize(usedCount * vertexSize);
+
+	report.vertexCountAfter = usedCount;
+	report.after = AnalyzeVertexCache(indices.data(), indices.size(), usedCount);
+	report.indexFormat = ChooseIndexFormat(usedCount);
+	return report;
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Index and vertex reordering for real meshes, usable offline in the asset
+// pipeline or at load time. Indices are always 32 bit while optimizing and
+// packed down with PackIndices once the vertex count is known.
+
+// Post-transform cache behaviour of an index buffer, simulated with a FIFO.
+struct VertexCacheStats {
+	// Average cache misses per triangle, 0.5 is ideal on large meshes, 3 is worst.
+	float acmr;
+	// Average transforms per vertex, 1 is ideal.
+	float atvr;
+	uint32_t vertexTransforms;
+};
+
+VertexCacheStats AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize = 16);
+
+// Pixel shading cost of an index order, from rasterizing the mesh along the
+// six axis directions with a depth test.
+struct OverdrawStats {
+	// Shaded pixels per covered pixel, 1 is ideal.
+	float overdraw;
+	uint32_t pixelsCovered;
+	uint32_t pixelsShaded;
+};
+
+// Triangles face along (b - a) x (c - a), the same convention
+// OptimizeOverdraw sorts by, and are culled when facing away. Too slow for
+// load time, meant for tools and tests.
+OverdrawStats AnalyzeOverdraw(const uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+// Reorders triangles for vertex cache locality (Forsyth's linear-speed
+// algorithm). destination may equal indices.
+void OptimizeVertexCache(uint32_t* destination, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders clusters of the cache optimized triangles so outward facing
+// surfaces are drawn first, cutting overdraw. Clusters break where the cache
+// restarts anyway. The new order is kept only if its ACMR stays within
+// threshold times the input's. positions points at float3s spaced positionStride bytes apart.
+void OptimizeOverdraw(uint32_t* destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, float threshold = 1.05f);
+
+// Builds remap[old] = new so vertices appear in the order indices first use
+// them. Unused vertices map to ~0u. Returns the number of used vertices.
+size_t BuildVertexFetchRemap(std::vector<uint32_t>& remap, const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+// Applies a remap to the vertex data (vertexSize bytes each) and the indices
+// in place. Returns the new vertex count.
+size_t OptimizeVertexFetch(void* destinationVertices, uint32_t* indices, size_t indexCount,
+	const void* vertices, size_t vertexCount, size_t vertexSize);
+
+enum class IndexFormat { UInt16, UInt32 };
+
+// 16 bit indices whenever every vertex fits in them.
+IndexFormat ChooseIndexFormat(size_t vertexCount);
+inline size_t GetIndexSize(IndexFormat format){ return format == IndexFormat::UInt16 ? 2 : 4; }
+std::vector<uint8_t> PackIndices(const uint32_t* indices, size_t indexCount, IndexFormat format);
+
+struct MeshOptimizationReport {
+	VertexCacheStats before;
+	VertexCacheStats after;
+	size_t vertexCountBefore;
+	size_t vertexCountAfter;
+	IndexFormat indexFormat;
+};
+
+// Full pipeline: vertex cache, overdraw, then vertex fetch. The position is
+// a float3 at positionOffset inside each vertex. vertices and indices are
+// rewritten and unused vertices dropped.
+MeshOptimizationReport OptimizeMesh(std::vector<uint8_t>& vertices, size_t vertexSize, size_t positionOffset,
+	std::vector<uint32_t>& indices, float overdrawThreshold = 1.05f);
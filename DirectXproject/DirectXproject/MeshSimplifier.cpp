@@ -0,0 +1,458 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+
+#include "JobSystem.h"
+#include "MeshOptimizer.h"
+
+namespace {
+	// Symmetric 4x4 quadric stored as its 10 unique terms, plus the weight
+	// it was built with so the error reads as a squared distance.
+	struct Quadric {
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double weight;
+
+		void AddPlane(const double n[3], double d, double w){
+			a00 += w * n[0] * n[0]; a01 += w * n[0] * n[1]; a02 += w * n[0] * n[2];
+			a11 += w * n[1] * n[1]; a12 += w * n[1] * n[2]; a22 += w * n[2] * n[2];
+			b0 += w * n[0] * d; b1 += w * n[1] * d; b2 += w * n[2] * d;
+			c += w * d * d;
+			weight += w;
+		}
+
+		void Add(const Quadric& other){
+			a00 += other.a00; a01 += other.a01; a02 += other.a02;
+			a11 += other.a11; a12 += other.a12; a22 += other.a22;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		double Evaluate(const float* p) const {
+			double x = p[0], y = p[1], z = p[2];
+			double result = a00 * x * x + a11 * y * y + a22 * z * z
+				+ 2.0 * (a01 * x * y + a02 * x * z + a12 * y * z)
+				+ 2.0 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0.0 ? std::max(result, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct Collapse {
+		double cost;
+		uint32_t from;
+		uint32_t to;
+		uint32_t fromVersion;
+		uint32_t toVersion;
+
+		bool operator<(const Collapse& other) const { return cost > other.cost; }
+	};
+
+	struct PositionKey {
+		uint32_t bits[3];
+		bool operator==(const PositionKey& other) const { return memcmp(bits, other.bits, sizeof(bits)) == 0; }
+	};
+
+	struct PositionHash {
+		size_t operator()(const PositionKey& key) const {
+			return (key.bits[0] * 73856093u) ^ (key.bits[1] * 19349663u) ^ (key.bits[2] * 83492791u);
+		}
+	};
+
+	void TriangleNormal(const float* a, const float* b, const float* c, double n[3]){
+		double e1[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+		double e2[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+		n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+		n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+		n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	}
+
+	double Dot(const double a[3], const double b[3]){
+		return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+	}
+
+	// Squared distance from p to triangle abc, through the closest point
+	// found by Voronoi region (Real-Time Collision Detection, 5.1.5).
+	double PointTriangleDistanceSquared(const float* p, const float* a, const float* b, const float* c){
+		const double ab[3] = { double(b[0]) - a[0], double(b[1]) - a[1], double(b[2]) - a[2] };
+		const double ac[3] = { double(c[0]) - a[0], double(c[1]) - a[1], double(c[2]) - a[2] };
+		const double ap[3] = { double(p[0]) - a[0], double(p[1]) - a[1], double(p[2]) - a[2] };
+		const double bp[3] = { double(p[0]) - b[0], double(p[1]) - b[1], double(p[2]) - b[2] };
+		const double cp[3] = { double(p[0]) - c[0], double(p[1]) - c[1], double(p[2]) - c[2] };
+
+		// Closest point as a + v * ab + w * ac.
+		double v = 0.0, w = 0.0;
+		const double d1 = Dot(ab, ap), d2 = Dot(ac, ap);
+		const double d3 = Dot(ab, bp), d4 = Dot(ac, bp);
+		const double d5 = Dot(ab, cp), d6 = Dot(ac, cp);
+		const double vc = d1 * d4 - d3 * d2;
+		const double vb = d5 * d2 - d1 * d6;
+		const double va = d3 * d6 - d5 * d4;
+		if(d1 <= 0.0 && d2 <= 0.0){
+			// Vertex a.
+		}else if(d3 >= 0.0 && d4 <= d3){
+			v = 1.0;
+		}else if(d6 >= 0.0 && d5 <= d6){
+			w = 1.0;
+		}else if(vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0){
+			v = d1 / (d1 - d3);
+		}else if(vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0){
+			w = d2 / (d2 - d6);
+		}else if(va <= 0.0 && d4 - d3 >= 0.0 && d5 - d6 >= 0.0){
+			w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			v = 1.0 - w;
+		}else if(va + vb + vc > 0.0){
+			const double denominator = 1.0 / (va + vb + vc);
+			v = vb * denominator;
+			w = vc * denominator;
+		}
+
+		double distance = 0.0;
+		for(int k = 0; k < 3; k++){
+			const double offset = ap[k] - v * ab[k] - w * ac[k];
+			distance += offset * offset;
+		}
+		return distance;
+	}
+
+	uint64_t EdgeKey(uint32_t a, uint32_t b){
+		return (uint64_t(std::min(a, b)) << 32) | std::max(a, b);
+	}
+}
+
+float SimplifyMesh(std::vector<uint32_t>& destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float maxError){
+	auto position = [positions, positionStride](uint32_t v){
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+	};
+
+	const size_t triangleCount = indexCount / 3;
+	std::vector<uint32_t> triangles(indices, indices + triangleCount * 3);
+	std::vector<bool> triangleAlive(triangleCount, true);
+	size_t aliveCount = triangleCount;
+
+	// Locked vertices: on an edge used by one triangle (open border or
+	// attribute seam), on a non-manifold edge, or sharing a position.
+	std::vector<bool> locked(vertexCount, false);
+	{
+		std::unordered_map<uint64_t, uint32_t> edgeUse;
+		edgeUse.reserve(triangleCount * 3);
+		for(size_t t = 0; t < triangleCount; t++){
+			for(int k = 0; k < 3; k++){
+				edgeUse[EdgeKey(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3])]++;
+			}
+		}
+		for(const auto& edge : edgeUse){
+			if(edge.second != 2){
+				locked[edge.first >> 32] = true;
+				locked[edge.first & 0xFFFFFFFF] = true;
+			}
+		}
+
+		std::unordered_map<PositionKey, uint32_t, PositionHash> firstAtPosition;
+		firstAtPosition.reserve(vertexCount);
+		for(uint32_t v = 0; v < vertexCount; v++){
+			PositionKey key;
+			memcpy(key.bits, position(v), sizeof(key.bits));
+			auto inserted = firstAtPosition.emplace(key, v);
+			if(!inserted.second){
+				locked[v] = true;
+				locked[inserted.first->second] = true;
+			}
+		}
+	}
+
+	// Area weighted plane quadrics of the surrounding triangles.
+	std::vector<Quadric> quadrics(vertexCount);
+	memset(quadrics.data(), 0, sizeof(Quadric) * vertexCount);
+	std::vector<std::vector<uint32_t>> vertexTriangles(vertexCount);
+	for(size_t t = 0; t < triangleCount; t++){
+		const uint32_t* tri = &triangles[t * 3];
+		double n[3];
+		TriangleNormal(position(tri[0]), position(tri[1]), position(tri[2]), n);
+		double length = sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if(length > 0.0){
+			for(int k = 0; k < 3; k++){
+				n[k] /= length;
+			}
+			const float* p = position(tri[0]);
+			double d = -(n[0] * p[0] + n[1] * p[1] + n[2] * p[2]);
+			for(int k = 0; k < 3; k++){
+				quadrics[tri[k]].AddPlane(n, d, length * 0.5);
+			}
+		}
+		for(int k = 0; k < 3; k++){
+			vertexTriangles[tri[k]].push_back(static_cast<uint32_t>(t));
+		}
+	}
+
+	std::vector<uint32_t> versions(vertexCount, 0);
+	std::priority_queue<Collapse> queue;
+	auto pushCollapse = [&](uint32_t from, uint32_t to){
+		if(locked[from] || from == to){
+			return;
+		}
+		Quadric combined = quadrics[from];
+		combined.Add(quadrics[to]);
+		queue.push({ combined.Evaluate(position(to)), from, to, versions[from], versions[to] });
+	};
+
+	for(size_t t = 0; t < triangleCount; t++){
+		for(int k = 0; k < 3; k++){
+			pushCollapse(triangles[t * 3 + k], triangles[t * 3 + (k + 1) % 3]);
+			pushCollapse(triangles[t * 3 + (k + 1) % 3], triangles[t * 3 + k]);
+		}
+	}
+
+	const size_t targetTriangles = targetIndexCount / 3;
+	const double maxCost = double(maxError) * maxError;
+	double reachedCost = 0.0;
+	double reachedDistance = 0.0;
+
+	// Input vertices collapsed away so far, by the vertex they sit on now.
+	std::vector<std::vector<uint32_t>> removed(vertexCount);
+	std::vector<uint32_t> ring;
+	// Squared distance from p to the triangles around host as they would be
+	// with from moved onto to. The fan of to takes over the one of from.
+	auto fanDistanceSquared = [&](const float* p, uint32_t host, uint32_t from, uint32_t to){
+		double best = std::numeric_limits<double>::max();
+		for(int list = 0; list < (host == to ? 2 : 1); list++){
+			for(uint32_t t : vertexTriangles[list == 0 ? host : from]){
+				const uint32_t* tri = &triangles[t * 3];
+				const bool hasFrom = tri[0] == from || tri[1] == from || tri[2] == from;
+				const bool hasTo = tri[0] == to || tri[1] == to || tri[2] == to;
+				if(!triangleAlive[t] || (hasFrom && hasTo)){
+					continue;
+				}
+				const float* corners[3];
+				for(int k = 0; k < 3; k++){
+					corners[k] = position(tri[k] == from ? to : tri[k]);
+				}
+				best = std::min(best, PointTriangleDistanceSquared(p, corners[0], corners[1], corners[2]));
+			}
+		}
+		return best;
+	};
+
+	while(aliveCount > targetTriangles && !queue.empty()){
+		Collapse collapse = queue.top();
+		queue.pop();
+		if(collapse.fromVersion != versions[collapse.from] || collapse.toVersion != versions[collapse.to]){
+			continue;
+		}
+		if(collapse.cost > maxCost){
+			break;
+		}
+
+		const uint32_t from = collapse.from;
+		const uint32_t to = collapse.to;
+
+		// Still an edge, and moving from onto to flips no triangle.
+		bool adjacent = false;
+		bool flips = false;
+		for(uint32_t t : vertexTriangles[from]){
+			if(!triangleAlive[t]){
+				continue;
+			}
+			const uint32_t* tri = &triangles[t * 3];
+			if(tri[0] == to || tri[1] == to || tri[2] == to){
+				adjacent = true;
+				continue;
+			}
+			const float* corners[3] = { position(tri[0]), position(tri[1]), position(tri[2]) };
+			double before[3], after[3];
+			TriangleNormal(corners[0], corners[1], corners[2], before);
+			for(int k = 0; k < 3; k++){
+				if(tri[k] == from){
+					corners[k] = position(to);
+				}
+			}
+			TriangleNormal(corners[0], corners[1], corners[2], after);
+			double dot = before[0] * after[0] + before[1] * after[1] + before[2] * after[2];
+			double afterLength = sqrt(after[0] * after[0] + after[1] * after[1] + after[2] * after[2]);
+			double beforeLength = sqrt(before[0] * before[0] + before[1] * before[1] + before[2] * before[2]);
+			// Flipped, or folded to nearly perpendicular.
+			if(dot <= 0.25 * beforeLength * afterLength){
+				flips = true;
+				break;
+			}
+		}
+		if(!adjacent || flips){
+			continue;
+		}
+
+		// The quadric cost is a weighted mean over planes and can sit well
+		// under the real distance. Every removed vertex is measured against
+		// the fan it lies on, again whenever this collapse changes that fan:
+		// the fans of to and of every vertex around it.
+		ring.clear();
+		for(int list = 0; list < 2; list++){
+			for(uint32_t t : vertexTriangles[list == 0 ? to : from]){
+				if(!triangleAlive[t]){
+					continue;
+				}
+				for(int k = 0; k < 3; k++){
+					uint32_t v = triangles[t * 3 + k];
+					if(v != from && v != to && std::find(ring.begin(), ring.end(), v) == ring.end()){
+						ring.push_back(v);
+					}
+				}
+			}
+		}
+		double distance = fanDistanceSquared(position(from), to, from, to);
+		for(int list = 0; list < 2; list++){
+			for(uint32_t v : removed[list == 0 ? to : from]){
+				distance = std::max(distance, fanDistanceSquared(position(v), to, from, to));
+			}
+		}
+		for(size_t i = 0; i < ring.size() && distance <= maxCost; i++){
+			for(uint32_t v : removed[ring[i]]){
+				distance = std::max(distance, fanDistanceSquared(position(v), ring[i], from, to));
+			}
+		}
+		if(distance > maxCost){
+			continue;
+		}
+		reachedDistance = std::max(reachedDistance, distance);
+		removed[to].push_back(from);
+		removed[to].insert(removed[to].end(), removed[from].begin(), removed[from].end());
+		removed[from].clear();
+
+		for(uint32_t t : vertexTriangles[from]){
+			if(!triangleAlive[t]){
+				continue;
+			}
+			uint32_t* tri = &triangles[t * 3];
+			if(tri[0] == to || tri[1] == to || tri[2] == to){
+				triangleAlive[t] = false;
+				aliveCount--;
+				continue;
+			}
+			for(int k = 0; k < 3; k++){
+				if(tri[k] == from){
+					tri[k] = to;
+				}
+			}
+			vertexTriangles[to].push_back(t);
+		}
+		vertexTriangles[from].clear();
+		quadrics[to].Add(quadrics[from]);
+		versions[from]++;
+		versions[to]++;
+		reachedCost = std::max(reachedCost, collapse.cost);
+
+		// Costs of the edges at to changed with its quadric. Bumping its
+		// version dropped the old entries, queue them again.
+		std::vector<uint32_t>& around = vertexTriangles[to];
+		size_t kept = 0;
+		for(size_t i = 0; i < around.size(); i++){
+			if(triangleAlive[around[i]]){
+				around[kept++] = around[i];
+			}
+		}
+		around.resize(kept);
+		for(uint32_t t : around){
+			for(int k = 0; k < 3; k++){
+				uint32_t neighbour = triangles[t * 3 + k];
+				if(neighbour != to){
+					pushCollapse(to, neighbour);
+					pushCollapse(neighbour, to);
+				}
+			}
+		}
+	}
+
+	destination.clear();
+	destination.reserve(aliveCount * 3);
+	for(size_t t = 0; t < triangleCount; t++){
+		if(triangleAlive[t]){
+			destination.insert(destination.end(), &triangles[t * 3], &triangles[t * 3] + 3);
+		}
+	}
+	return static_cast<float>(sqrt(std::max(reachedCost, reachedDistance)));
+}
+
+void BuildLodChain(std::vector<MeshLod>& lods, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, const LodChainSettings& settings){
+	lods.clear();
+	lods.push_back({ std::vector<uint32_t>(indices, indices + indexCount), 0.0f });
+
+	// Mesh radius, to turn the relative error budget into units.
+	float boxMin[3] = { 0.0f, 0.0f, 0.0f };
+	float boxMax[3] = { 0.0f, 0.0f, 0.0f };
+	for(size_t v = 0; v < vertexCount; v++){
+		const float* p = reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + v * positionStride);
+		for(int k = 0; k < 3; k++){
+			boxMin[k] = v ? std::min(boxMin[k], p[k]) : p[k];
+			boxMax[k] = v ? std::max(boxMax[k], p[k]) : p[k];
+		}
+	}
+	float dx = boxMax[0] - boxMin[0], dy = boxMax[1] - boxMin[1], dz = boxMax[2] - boxMin[2];
+	const float maxError = 0.5f * sqrtf(dx * dx + dy * dy + dz * dz) * settings.maxRelativeError;
+
+	while(lods.size() < settings.maxLods){
+		const MeshLod& previous = lods.back();
+		size_t target = static_cast<size_t>(previous.indices.size() / 3 * settings.reduction) * 3;
+		// Errors add up along the chain, so each level gets what is left.
+		float remaining = maxError - previous.error;
+		if(target == 0 || remaining <= 0.0f){
+			break;
+		}
+
+		MeshLod lod;
+		float error = SimplifyMesh(lod.indices, previous.indices.data(), previous.indices.size(), positions, vertexCount, positionStride, target, remaining);
+		if(lod.indices.size() > previous.indices.size() * (1.0f - settings.minSaving)){
+			break;
+		}
+		lod.error = previous.error + error;
+		OptimizeVertexCache(lod.indices.data(), lod.indices.data(), lod.indices.size(), vertexCount);
+		lods.push_back(std::move(lod));
+	}
+}
+
+void BuildLodChains(std::vector<std::vector<MeshLod>>& chains, const std::vector<LodSourceMesh>& meshes, const LodChainSettings& settings){
+	chains.clear();
+	chains.resize(meshes.size());
+	JobSystem::GetInstance()->ParallelFor(static_cast<uint32_t>(meshes.size()), 1, [&](uint32_t begin, uint32_t end){
+		for(uint32_t i = begin; i < end; i++){
+			const LodSourceMesh& mesh = meshes[i];
+			BuildLodChain(chains[i], mesh.indices, mesh.indexCount, mesh.positions, mesh.vertexCount, mesh.positionStride, settings);
+		}
+	});
+}
+
+float ComputeProjectionScale(float screenHeight, float fovY){
+	return screenHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+uint32_t SelectLod(const MeshLod* lods, uint32_t lodCount, float distance, float projectionScale,
+	float pixelThreshold, uint32_t currentLod, float hysteresis){
+	if(lodCount == 0){
+		return 0;
+	}
+	currentLod = std::min(currentLod, lodCount - 1);
+	const float pixelsPerUnit = projectionScale / std::max(distance, 1e-4f);
+
+	// The current level is too coarse: the coarsest one that fits, at once.
+	if(lods[currentLod].error * pixelsPerUnit > pixelThreshold){
+		uint32_t lod = currentLod;
+		while(lod > 0 && lods[lod].error * pixelsPerUnit > pixelThreshold){
+			lod--;
+		}
+		return lod;
+	}
+
+	// Coarser only with some margin.
+	uint32_t lod = currentLod;
+	const float coarserThreshold = pixelThreshold * (1.0f - hysteresis);
+	while(lod + 1 < lodCount && lods[lod + 1].error * pixelsPerUnit <= coarserThreshold){
+		lod++;
+	}
+	return lod;
+}
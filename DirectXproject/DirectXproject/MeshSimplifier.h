@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Quadric error metric simplification by edge collapse. Vertices only ever
+// collapse onto existing vertices, so every LOD indexes the original vertex
+// buffer and only the index buffer changes per level. Vertices on open
+// borders and attribute seams (several vertices at one position) are
+// locked, which keeps UV and normal seams intact.
+
+// Collapses edges until the triangle count reaches targetIndexCount / 3 or
+// no collapse is left that keeps the surface within maxError (object space
+// units). positions are float3 at positionStride byte steps. Returns the
+// error reached, as a distance: every input vertex lies at most that far
+// from the output triangles.
+float SimplifyMesh(std::vector<uint32_t>& destination, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, size_t targetIndexCount, float maxError);
+
+struct MeshLod {
+	std::vector<uint32_t> indices;
+	// Largest deviation from LOD 0, object space units.
+	float error;
+};
+
+struct LodChainSettings {
+	uint32_t maxLods = 5;
+	// Each level aims for this fraction of the previous one's triangles.
+	float reduction = 0.5f;
+	// Stop once a level would deviate more than this fraction of the mesh radius.
+	float maxRelativeError = 0.05f;
+	// Stop when a level saves less than this fraction of triangles.
+	float minSaving = 0.1f;
+};
+
+// LOD 0 is the input. Each level is simplified from the one before and
+// reordered for the vertex cache.
+void BuildLodChain(std::vector<MeshLod>& lods, const uint32_t* indices, size_t indexCount,
+	const float* positions, size_t vertexCount, size_t positionStride, const LodChainSettings& settings = LodChainSettings());
+
+struct LodSourceMesh {
+	const uint32_t* indices;
+	size_t indexCount;
+	const float* positions;
+	size_t vertexCount;
+	size_t positionStride;
+};
+
+// One chain per mesh, meshes spread across the JobSystem workers.
+void BuildLodChains(std::vector<std::vector<MeshLod>>& chains, const std::vector<LodSourceMesh>& meshes, const LodChainSettings& settings = LodChainSettings());
+
+// Pixels per object space unit at distance 1, screenHeight / (2 tan(fovY / 2)).
+float ComputeProjectionScale(float screenHeight, float fovY);
+
+// Picks the coarsest LOD whose error projects to at most pixelThreshold
+// pixels. Going coarser needs the error under pixelThreshold * (1 - hysteresis),
+// so an object sitting at the boundary does not flip every frame.
+uint32_t SelectLod(const MeshLod* lods, uint32_t lodCount, float distance, float projectionScale,
+	float pixelThreshold, uint32_t currentLod, float hysteresis = 0.2f);
@@ -0,0 +1,258 @@
+#include "MeshletBuilder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+	const float* PositionAt(const float* positions, size_t stride, uint32_t index){
+		return reinterpret_cast<const float*>(reinterpret_cast<const uint8_t*>(positions) + index * stride);
+	}
+
+	// Triangles around each vertex, as offsets into one flat list.
+	struct Adjacency {
+		std::vector<uint32_t> offsets;
+		std::vector<uint32_t> triangles;
+	};
+
+	void BuildAdjacency(size_t vertexCount, const uint32_t* indices, size_t indexCount, Adjacency& adjacency){
+		adjacency.offsets.assign(vertexCount + 1, 0);
+		for(size_t i = 0; i < indexCount; i++){
+			adjacency.offsets[indices[i] + 1]++;
+		}
+		for(size_t v = 0; v < vertexCount; v++){
+			adjacency.offsets[v + 1] += adjacency.offsets[v];
+		}
+
+		adjacency.triangles.resize(indexCount);
+		std::vector<uint32_t> cursor(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for(size_t i = 0; i < indexCount; i++){
+			adjacency.triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+		}
+	}
+}
+
+void BuildMeshlets(const float* positions, size_t vertexCount, size_t positionStride,
+	const uint32_t* indices, size_t indexCount, MeshletMesh& out){
+	out.meshlets.clear();
+	out.bounds.clear();
+	out.vertices.clear();
+	out.triangles.clear();
+
+	const size_t triangleCount = indexCount / 3;
+	if(triangleCount == 0){
+		return;
+	}
+
+	Adjacency adjacency;
+	BuildAdjacency(vertexCount, indices, triangleCount * 3, adjacency);
+
+	std::vector<float> centroids(triangleCount * 3);
+	for(size_t t = 0; t < triangleCount; t++){
+		for(int k = 0; k < 3; k++){
+			centroids[t * 3 + k] = (PositionAt(positions, positionStride, indices[t * 3 + 0])[k]
+				+ PositionAt(positions, positionStride, indices[t * 3 + 1])[k]
+				+ PositionAt(positions, positionStride, indices[t * 3 + 2])[k]) / 3.0f;
+		}
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	// Meshlet local index of each mesh vertex, 0xFF when not in the current meshlet.
+	std::vector<uint8_t> localIndex(vertexCount, 0xFF);
+	std::vector<uint32_t> candidates;
+	size_t nextSeed = 0;
+
+	Meshlet meshlet = { 0, 0, 0, 0 };
+	float centerSum[3] = { 0.0f, 0.0f, 0.0f };
+
+	auto finishMeshlet = [&](){
+		for(uint32_t v = 0; v < meshlet.vertexCount; v++){
+			localIndex[out.vertices[meshlet.vertexOffset + v]] = 0xFF;
+		}
+		out.meshlets.push_back(meshlet);
+		meshlet.vertexOffset = static_cast<uint32_t>(out.vertices.size());
+		meshlet.triangleOffset = static_cast<uint32_t>(out.triangles.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleCount = 0;
+		centerSum[0] = centerSum[1] = centerSum[2] = 0.0f;
+		candidates.clear();
+	};
+
+	for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++){
+		// Best neighbour of the current meshlet, or a fresh seed.
+		size_t best = triangleCount;
+		int bestNewVertices = 4;
+		float bestDistance = std::numeric_limits<float>::max();
+		if(meshlet.triangleCount > 0){
+			float center[3];
+			for(int k = 0; k < 3; k++){
+				center[k] = centerSum[k] / meshlet.triangleCount;
+			}
+
+			size_t kept = 0;
+			for(size_t c = 0; c < candidates.size(); c++){
+				uint32_t triangle = candidates[c];
+				if(emitted[triangle]){
+					continue;
+				}
+				candidates[kept++] = triangle;
+
+				int newVertices = 0;
+				for(int k = 0; k < 3; k++){
+					newVertices += localIndex[indices[triangle * 3 + k]] == 0xFF ? 1 : 0;
+				}
+				float dx = centroids[triangle * 3 + 0] - center[0];
+				float dy = centroids[triangle * 3 + 1] - center[1];
+				float dz = centroids[triangle * 3 + 2] - center[2];
+				float distance = dx * dx + dy * dy + dz * dz;
+				if(newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance)){
+					best = triangle;
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+				}
+			}
+			candidates.resize(kept);
+		}
+
+		if(best == triangleCount){
+			while(emitted[nextSeed]){
+				nextSeed++;
+			}
+			best = nextSeed;
+			bestNewVertices = 0;
+			for(int k = 0; k < 3; k++){
+				bestNewVertices += localIndex[indices[best * 3 + k]] == 0xFF ? 1 : 0;
+			}
+		}
+
+		// Full: the triangle that did not fit seeds the next meshlet, which
+		// keeps neighbouring meshlets next to each other.
+		if(meshlet.vertexCount + bestNewVertices > kMeshletMaxVertices || meshlet.triangleCount + 1 > kMeshletMaxTriangles){
+			finishMeshlet();
+		}
+
+		uint32_t packed = 0;
+		for(int k = 0; k < 3; k++){
+			uint32_t vertex = indices[best * 3 + k];
+			if(localIndex[vertex] == 0xFF){
+				localIndex[vertex] = static_cast<uint8_t>(meshlet.vertexCount++);
+				out.vertices.push_back(vertex);
+				for(uint32_t a = adjacency.offsets[vertex]; a < adjacency.offsets[vertex + 1]; a++){
+					if(!emitted[adjacency.triangles[a]]){
+						candidates.push_back(adjacency.triangles[a]);
+					}
+				}
+			}
+			packed |= static_cast<uint32_t>(localIndex[vertex]) << (k * 8);
+		}
+		out.triangles.push_back(packed);
+		meshlet.triangleCount++;
+		emitted[best] = true;
+		for(int k = 0; k < 3; k++){
+			centerSum[k] += centroids[best * 3 + k];
+		}
+	}
+
+	if(meshlet.triangleCount > 0){
+		finishMeshlet();
+	}
+
+	out.bounds.reserve(out.meshlets.size());
+	for(const Meshlet& m : out.meshlets){
+		out.bounds.push_back(ComputeMeshletBounds(out, m, positions, positionStride));
+	}
+}
+
+MeshletBounds ComputeMeshletBounds(const MeshletMesh& mesh, const Meshlet& meshlet, const float* positions, size_t positionStride){
+	MeshletBounds bounds = {};
+
+	// Sphere around the box center.
+	const float largest = std::numeric_limits<float>::max();
+	float boxMin[3] = { largest, largest, largest };
+	float boxMax[3] = { -largest, -largest, -largest };
+	for(uint32_t v = 0; v < meshlet.vertexCount; v++){
+		const float* p = PositionAt(positions, positionStride, mesh.vertices[meshlet.vertexOffset + v]);
+		for(int k = 0; k < 3; k++){
+			boxMin[k] = std::min(boxMin[k], p[k]);
+			boxMax[k] = std::max(boxMax[k], p[k]);
+		}
+	}
+	for(int k = 0; k < 3; k++){
+		bounds.center[k] = (boxMin[k] + boxMax[k]) * 0.5f;
+	}
+	float radiusSquared = 0.0f;
+	for(uint32_t v = 0; v < meshlet.vertexCount; v++){
+		const float* p = PositionAt(positions, positionStride, mesh.vertices[meshlet.vertexOffset + v]);
+		float dx = p[0] - bounds.center[0];
+		float dy = p[1] - bounds.center[1];
+		float dz = p[2] - bounds.center[2];
+		radiusSquared = std::max(radiusSquared, dx * dx + dy * dy + dz * dz);
+	}
+	bounds.radius = sqrtf(radiusSquared);
+
+	// Normal cone: axis is the mean triangle normal, the spread is the
+	// largest angle any normal makes with it. Normals are cross(b - a, c - a),
+	// which points out of the front face for the clockwise winding D3D uses.
+	std::vector<float> normals;
+	normals.reserve(meshlet.triangleCount * 3);
+	float axis[3] = { 0.0f, 0.0f, 0.0f };
+	for(uint32_t t = 0; t < meshlet.triangleCount; t++){
+		uint32_t packed = mesh.triangles[meshlet.triangleOffset + t];
+		const float* a = PositionAt(positions, positionStride, mesh.vertices[meshlet.vertexOffset + (packed & 0xFF)]);
+		const float* b = PositionAt(positions, positionStride, mesh.vertices[meshlet.vertexOffset + ((packed >> 8) & 0xFF)]);
+		const float* c = PositionAt(positions, positionStride, mesh.vertices[meshlet.vertexOffset + ((packed >> 16) & 0xFF)]);
+		float e1[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		float e2[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+		float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if(length == 0.0f){
+			continue;
+		}
+		for(int k = 0; k < 3; k++){
+			normals.push_back(n[k] / length);
+			axis[k] += n[k] / length;
+		}
+	}
+
+	float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]);
+	float minDot = 1.0f;
+	if(axisLength > 0.0f){
+		for(int k = 0; k < 3; k++){
+			axis[k] /= axisLength;
+		}
+		for(size_t n = 0; n < normals.size(); n += 3){
+			minDot = std::min(minDot, normals[n] * axis[0] + normals[n + 1] * axis[1] + normals[n + 2] * axis[2]);
+		}
+	}
+
+	if(axisLength == 0.0f || minDot <= 0.0f){
+		// Normals span a hemisphere or more, the cone never culls.
+		bounds.coneCutoff = 1.0f;
+	}else{
+		for(int k = 0; k < 3; k++){
+			bounds.coneAxis[k] = axis[k];
+		}
+		bounds.coneCutoff = sqrtf(1.0f - minDot * minDot);
+	}
+	return bounds;
+}
+
+bool IsMeshletVisible(const MeshletBounds& bounds, const Frustum& frustum, const float cameraPosition[3]){
+	if(!frustum.IntersectsSphere(bounds.center, bounds.radius)){
+		return false;
+	}
+
+	float view[3] = { bounds.center[0] - cameraPosition[0], bounds.center[1] - cameraPosition[1], bounds.center[2] - cameraPosition[2] };
+	float distance = sqrtf(view[0] * view[0] + view[1] * view[1] + view[2] * view[2]);
+	float facing = view[0] * bounds.coneAxis[0] + view[1] * bounds.coneAxis[1] + view[2] * bounds.coneAxis[2];
+	return facing < bounds.coneCutoff * distance + bounds.radius;
+}
+
+void CullMeshletsReference(const MeshletMesh& mesh, const Frustum& frustum, const float cameraPosition[3], std::vector<uint32_t>& visible){
+	visible.clear();
+	for(uint32_t i = 0; i < mesh.bounds.size(); i++){
+		if(IsMeshletVisible(mesh.bounds[i], frustum, cameraPosition)){
+			visible.push_back(i);
+		}
+	}
+}
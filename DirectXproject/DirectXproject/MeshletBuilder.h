@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Frustum.h"
+
+// Splits an indexed triangle list into small clusters for the mesh shader
+// path in meshlet.hlsl, with the bounds the amplification shader culls by.
+// The structs mirror the ones declared there, keep them in sync.
+
+static constexpr uint32_t kMeshletMaxVertices = 64;
+static constexpr uint32_t kMeshletMaxTriangles = 124;
+
+struct Meshlet {
+	// Into MeshletMesh::vertices and MeshletMesh::triangles.
+	uint32_t vertexOffset;
+	uint32_t triangleOffset;
+	uint32_t vertexCount;
+	uint32_t triangleCount;
+};
+
+struct MeshletBounds {
+	float center[3];
+	float radius;
+	// Backface cone: the meshlet faces away from a camera at p when
+	// dot(center - p, coneAxis) >= coneCutoff * length(center - p) + radius.
+	// A zero axis with cutoff 1 never passes.
+	float coneAxis[3];
+	float coneCutoff;
+};
+
+static_assert(sizeof(Meshlet) == 16, "Meshlet must match meshlet.hlsl");
+static_assert(sizeof(MeshletBounds) == 32, "MeshletBounds must match meshlet.hlsl");
+
+struct MeshletMesh {
+	std::vector<Meshlet> meshlets;
+	std::vector<MeshletBounds> bounds;
+	// Mesh vertex index of every meshlet vertex.
+	std::vector<uint32_t> vertices;
+	// One uint per triangle, three meshlet local 8 bit indices.
+	std::vector<uint32_t> triangles;
+};
+
+// Grows each meshlet from a seed triangle, always taking the neighbouring
+// triangle that adds the fewest new vertices, nearest the meshlet center
+// on ties. positions are float3 at positionStride byte steps.
+void BuildMeshlets(const float* positions, size_t vertexCount, size_t positionStride,
+	const uint32_t* indices, size_t indexCount, MeshletMesh& out);
+
+MeshletBounds ComputeMeshletBounds(const MeshletMesh& mesh, const Meshlet& meshlet, const float* positions, size_t positionStride);
+
+// CPU reference of the amplification shader test, in mesh space.
+bool IsMeshletVisible(const MeshletBounds& bounds, const Frustum& frustum, const float cameraPosition[3]);
+// Indices of the meshlets the amplification shader keeps, in order.
+void CullMeshletsReference(const MeshletMesh& mesh, const Frustum& frustum, const float cameraPosition[3], std::vector<uint32_t>& visible);
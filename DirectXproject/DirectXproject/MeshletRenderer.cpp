@@ -0,0 +1,158 @@
+#include "MeshletRenderer.h"
+
+#include "d3dx12.h"
+#include <d3dcompiler.h>
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "Helpers.h"
+
+using namespace Microsoft::WRL;
+
+MeshletRenderer::MeshletRenderer() :mMeshletCount(0) {
+
+}
+
+MeshletRenderer::~MeshletRenderer() {
+
+}
+
+#if defined(MESHLET_RENDERER_SUPPORTED)
+namespace {
+	enum MeshletRootParameters { ConstantsSlot = 0, PositionsSlot, MeshletsSlot, VertexIndicesSlot, TrianglesSlot, BoundsSlot, RootParameterCount };
+
+	ComPtr<ID3DBlob> LoadShader(const wchar_t* directory, const wchar_t* name){
+		std::wstring path = std::wstring(directory) + L"/" + name;
+		ComPtr<ID3DBlob> blob;
+		if(FAILED(D3DReadFileToBlob(path.c_str(), &blob))){
+			std::wcout << L"Missing compiled shader " << path << std::endl;
+			return nullptr;
+		}
+		return blob;
+	}
+
+	// One subobject of a pipeline state stream, aligned the way the runtime walks it.
+	template<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE Type, typename T>
+	struct alignas(void*) StreamSubobject {
+		D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type = Type;
+		T desc;
+	};
+
+	struct MeshletPipelineStream {
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, ID3D12RootSignature*> rootSignature;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, D3D12_SHADER_BYTECODE> amplificationShader;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, D3D12_SHADER_BYTECODE> meshShader;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, D3D12_SHADER_BYTECODE> pixelShader;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, D3D12_RASTERIZER_DESC> rasterizer;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, D3D12_BLEND_DESC> blend;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, D3D12_DEPTH_STENCIL_DESC> depthStencil;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, DXGI_FORMAT> depthFormat;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, UINT> sampleMask;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, D3D12_RT_FORMAT_ARRAY> renderTargets;
+		StreamSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, DXGI_SAMPLE_DESC> sampleDesc;
+	};
+}
+
+bool MeshletRenderer::Init(ComPtr<ID3D12Device2> device, DXGI_FORMAT renderTargetFormat, DXGI_FORMAT depthFormat, const wchar_t* shaderDirectory,
+	const MeshletMesh& mesh, const float* positions, size_t vertexCount){
+	if(mesh.meshlets.empty() || vertexCount == 0){
+		return false;
+	}
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS7 options = {};
+	if(FAILED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options, sizeof(options)))
+		|| options.MeshShaderTier == D3D12_MESH_SHADER_TIER_NOT_SUPPORTED){
+		return false;
+	}
+
+	ComPtr<ID3DBlob> amplificationShader = LoadShader(shaderDirectory, L"meshlet_as.cso");
+	ComPtr<ID3DBlob> meshShader = LoadShader(shaderDirectory, L"meshlet_ms.cso");
+	ComPtr<ID3DBlob> pixelShader = LoadShader(shaderDirectory, L"meshlet_ps.cso");
+	if(!amplificationShader || !meshShader || !pixelShader){
+		return false;
+	}
+
+	CD3DX12_ROOT_PARAMETER parameters[RootParameterCount];
+	parameters[ConstantsSlot].InitAsConstants(sizeof(MeshletConstants) / sizeof(uint32_t), 0);
+	parameters[PositionsSlot].InitAsShaderResourceView(0);
+	parameters[MeshletsSlot].InitAsShaderResourceView(1);
+	parameters[VertexIndicesSlot].InitAsShaderResourceView(2);
+	parameters[TrianglesSlot].InitAsShaderResourceView(3);
+	parameters[BoundsSlot].InitAsShaderResourceView(4);
+
+	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc;
+	rootSignatureDesc.Init(_countof(parameters), parameters, 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_NONE);
+
+	mRootSignature = CreateRootSignatureFromDesc(device, rootSignatureDesc);
+
+	MeshletPipelineStream stream;
+	stream.rootSignature.desc = mRootSignature.Get();
+	stream.amplificationShader.desc = { amplificationShader->GetBufferPointer(), amplificationShader->GetBufferSize() };
+	stream.meshShader.desc = { meshShader->GetBufferPointer(), meshShader->GetBufferSize() };
+	stream.pixelShader.desc = { pixelShader->GetBufferPointer(), pixelShader->GetBufferSize() };
+	stream.rasterizer.desc = CD3DX12_RASTERIZER_DESC(D3D12_DEFAULT);
+	stream.blend.desc = CD3DX12_BLEND_DESC(D3D12_DEFAULT);
+	stream.depthStencil.desc = CD3DX12_DEPTH_STENCIL_DESC(D3D12_DEFAULT);
+	stream.depthStencil.desc.StencilEnable = FALSE;
+	stream.depthFormat.desc = depthFormat;
+	stream.sampleMask.desc = UINT_MAX;
+	stream.renderTargets.desc = {};
+	stream.renderTargets.desc.NumRenderTargets = 1;
+	stream.renderTargets.desc.RTFormats[0] = renderTargetFormat;
+	stream.sampleDesc.desc = { 1, 0 };
+
+	D3D12_PIPELINE_STATE_STREAM_DESC streamDesc = { sizeof(stream), &stream };
+	ThrowIfFailed(device->CreatePipelineState(&streamDesc, IID_PPV_ARGS(&mPipelineState)));
+
+	ID3D12Device2* rawDevice = device.Get();
+	mPositionBuffer = CreateUploadBuffer(rawDevice, positions, vertexCount * sizeof(float) * 3);
+	mMeshletBuffer = CreateUploadBuffer(rawDevice, mesh.meshlets.data(), mesh.meshlets.size() * sizeof(Meshlet));
+	mVertexIndexBuffer = CreateUploadBuffer(rawDevice, mesh.vertices.data(), mesh.vertices.size() * sizeof(uint32_t));
+	mTriangleBuffer = CreateUploadBuffer(rawDevice, mesh.triangles.data(), mesh.triangles.size() * sizeof(uint32_t));
+	mBoundsBuffer = CreateUploadBuffer(rawDevice, mesh.bounds.data(), mesh.bounds.size() * sizeof(MeshletBounds));
+
+	mMeshletCount = static_cast<uint32_t>(mesh.meshlets.size());
+	return true;
+}
+
+void MeshletRenderer::Draw(ID3D12GraphicsCommandList* commandList, const float viewProjection[16], const float cameraPosition[3]){
+	if(mMeshletCount == 0){
+		return;
+	}
+
+	ComPtr<ID3D12GraphicsCommandList6> meshCommandList;
+	if(FAILED(commandList->QueryInterface(IID_PPV_ARGS(&meshCommandList)))){
+		return;
+	}
+
+	MeshletConstants constants;
+	memcpy(constants.viewProjection, viewProjection, sizeof(constants.viewProjection));
+	Frustum frustum = Frustum::FromViewProjection(viewProjection);
+	memcpy(constants.planes, frustum.planes, sizeof(constants.planes));
+	memcpy(constants.cameraPosition, cameraPosition, sizeof(constants.cameraPosition));
+	constants.meshletCount = mMeshletCount;
+
+	meshCommandList->SetGraphicsRootSignature(mRootSignature.Get());
+	meshCommandList->SetPipelineState(mPipelineState.Get());
+	meshCommandList->SetGraphicsRoot32BitConstants(ConstantsSlot, sizeof(MeshletConstants) / sizeof(uint32_t), &constants, 0);
+	meshCommandList->SetGraphicsRootShaderResourceView(PositionsSlot, mPositionBuffer->GetGPUVirtualAddress());
+	meshCommandList->SetGraphicsRootShaderResourceView(MeshletsSlot, mMeshletBuffer->GetGPUVirtualAddress());
+	meshCommandList->SetGraphicsRootShaderResourceView(VertexIndicesSlot, mVertexIndexBuffer->GetGPUVirtualAddress());
+	meshCommandList->SetGraphicsRootShaderResourceView(TrianglesSlot, mTriangleBuffer->GetGPUVirtualAddress());
+	meshCommandList->SetGraphicsRootShaderResourceView(BoundsSlot, mBoundsBuffer->GetGPUVirtualAddress());
+
+	// One amplification group per 32 meshlets, matching AS_GROUP_SIZE.
+	meshCommandList->DispatchMesh((mMeshletCount + 31) / 32, 1, 1);
+}
+#else
+bool MeshletRenderer::Init(ComPtr<ID3D12Device2>, DXGI_FORMAT, const wchar_t*, const MeshletMesh&, const float*, size_t){
+	// Built against an SDK without mesh shaders.
+	return false;
+}
+
+void MeshletRenderer::Draw(ID3D12GraphicsCommandList*, const float*, const float*){
+
+}
+#endif
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+
+#include "MeshletBuilder.h"
+
+// Draws a MeshletMesh through the amplification and mesh shaders in
+// meshlet.hlsl. Mesh shaders need a Windows SDK that declares
+// ID3D12GraphicsCommandList6 and a device reporting
+// D3D12_MESH_SHADER_TIER_1. Without either, Init returns false and the
+// caller keeps the input assembler path.
+#if defined(__ID3D12GraphicsCommandList6_INTERFACE_DEFINED__)
+#define MESHLET_RENDERER_SUPPORTED 1
+#endif
+
+// Root constants of meshlet.hlsl.
+struct MeshletConstants {
+	float viewProjection[16];
+	float planes[Frustum::Count][4];
+	float cameraPosition[3];
+	uint32_t meshletCount;
+};
+
+class MeshletRenderer {
+public:
+	MeshletRenderer();
+	~MeshletRenderer();
+
+	// shaderDirectory holds meshlet_as.cso, meshlet_ms.cso and meshlet_ps.cso.
+	// positions are float3 per mesh vertex.
+	bool Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, DXGI_FORMAT renderTargetFormat, DXGI_FORMAT depthFormat, const wchar_t* shaderDirectory,
+		const MeshletMesh& mesh, const float* positions, size_t vertexCount);
+
+	// viewProjection is row vector, like the rest of the renderer.
+	void Draw(ID3D12GraphicsCommandList* commandList, const float viewProjection[16], const float cameraPosition[3]);
+
+	inline bool IsInitialized() const { return mMeshletCount > 0; }
+
+private:
+	uint32_t mMeshletCount;
+
+	Microsoft::WRL::ComPtr<ID3D12RootSignature> mRootSignature;
+	Microsoft::WRL::ComPtr<ID3D12PipelineState> mPipelineState;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mPositionBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mMeshletBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mVertexIndexBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mTriangleBuffer;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBoundsBuffer;
+};
@@ -0,0 +1,208 @@
+#include "PipelineCache.h"
+
+#include "Helpers.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+
+using Microsoft::WRL::ComPtr;
+
+PipelineCache::PipelineCache() : mShuttingDown(false), mStats{} {
+
+}
+
+PipelineCache::~PipelineCache(){
+	Shutdown();
+}
+
+void PipelineCache::Init(ComPtr<ID3D12Device2> device, const std::string& warmUpPath){
+	mDevice = device;
+	mWarmUpPath = warmUpPath;
+
+	mWarmUpNames.clear();
+	std::ifstream file(warmUpPath);
+	std::string name;
+	while(std::getline(file, name)){
+		if(!name.empty()){
+			mWarmUpNames.push_back(name);
+		}
+	}
+
+	mShuttingDown = false;
+	mCompileThread = std::thread(&PipelineCache::CompileLoop, this);
+	// Frames and the job system come first, compiles soak up idle time.
+	SetThreadPriority(mCompileThread.native_handle(), THREAD_PRIORITY_BELOW_NORMAL);
+}
+
+void PipelineCache::Shutdown(){
+	if(mCompileThread.joinable()){
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mShuttingDown = true;
+		}
+		mCompileAvailable.notify_all();
+		mCompileThread.join();
+	}
+	if(mDevice){
+		SaveWarmUpList();
+		mDevice.Reset();
+	}
+}
+
+PipelineStateHandle PipelineCache::Request(const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, PipelineStateHandle fallback){
+	PipelineStateHandle handle;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		auto found = mHandles.find(name);
+		if(found != mHandles.end()){
+			return found->second;
+		}
+
+		Entry entry;
+		entry.name = name;
+		entry.desc = desc;
+		entry.fallback = fallback;
+		entry.status = PipelineStateStatus::Pending;
+		entry.used = false;
+		mEntries.push_back(entry);
+
+		handle = static_cast<PipelineStateHandle>(mEntries.size());
+		mHandles[name] = handle;
+		mCompileQueue.push_back(handle);
+		mStats.requested++;
+	}
+
+	mCompileAvailable.notify_one();
+	return handle;
+}
+
+uint32_t PipelineCache::WarmUp(const Describe& describe){
+	uint32_t warmedUp = 0;
+	for(const std::string& name : mWarmUpNames){
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc = {};
+		PipelineStateHandle fallback = kInvalidPipelineState;
+		if(Find(name) == kInvalidPipelineState && describe(name, desc, fallback)){
+			Request(name, desc, fallback);
+			warmedUp++;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	mStats.warmedUp += warmedUp;
+	return warmedUp;
+}
+
+void PipelineCache::CompileLoop(){
+	while(true){
+		PipelineStateHandle handle;
+		{
+			// Whatever is queued still gets compiled before leaving.
+			std::unique_lock<std::mutex> lock(mMutex);
+			mCompileAvailable.wait(lock, [this]{ return mShuttingDown || !mCompileQueue.empty(); });
+			if(mCompileQueue.empty()){
+				return;
+			}
+			handle = mCompileQueue.front();
+			mCompileQueue.pop_front();
+		}
+		Create(handle);
+	}
+}
+
+void PipelineCache::Create(PipelineStateHandle handle){
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		desc = GetEntry(handle).desc;
+	}
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+	ComPtr<ID3D12PipelineState> pipelineState;
+	HRESULT hr = mDevice->CreateGraphicsPipelineState(&desc, IID_PPV_ARGS(&pipelineState));
+	double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Entry& entry = GetEntry(handle);
+		if(SUCCEEDED(hr)){
+			entry.pipelineState = pipelineState;
+			entry.status = PipelineStateStatus::Ready;
+			mStats.ready++;
+		}else{
+			// Stays on its fallback for good.
+			CheckHResult(hr);
+			std::cout << "Pipeline " << entry.name << " failed to compile" << std::endl;
+			entry.status = PipelineStateStatus::Failed;
+			mStats.failed++;
+		}
+		mStats.totalCompileMilliseconds += milliseconds;
+		mStats.maxCompileMilliseconds = std::max(mStats.maxCompileMilliseconds, milliseconds);
+	}
+	mCompiled.notify_all();
+}
+
+PipelineStateHandle PipelineCache::Find(const std::string& name) const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	auto found = mHandles.find(name);
+	return found != mHandles.end() ? found->second : kInvalidPipelineState;
+}
+
+PipelineStateStatus PipelineCache::GetStatus(PipelineStateHandle handle) const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return IsValid(handle) ? GetEntry(handle).status : PipelineStateStatus::Failed;
+}
+
+ID3D12PipelineState* PipelineCache::Get(PipelineStateHandle handle){
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(!IsValid(handle)){
+		return nullptr;
+	}
+
+	Entry& entry = GetEntry(handle);
+	entry.used = true;
+	if(entry.status == PipelineStateStatus::Ready){
+		return entry.pipelineState.Get();
+	}
+
+	mStats.misses++;
+	if(IsValid(entry.fallback) && GetEntry(entry.fallback).status == PipelineStateStatus::Ready){
+		return GetEntry(entry.fallback).pipelineState.Get();
+	}
+	return nullptr;
+}
+
+ID3D12PipelineState* PipelineCache::GetPipelineState(PipelineStateHandle handle) const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	if(!IsValid(handle) || GetEntry(handle).status != PipelineStateStatus::Ready){
+		return nullptr;
+	}
+	return GetEntry(handle).pipelineState.Get();
+}
+
+void PipelineCache::Wait(PipelineStateHandle handle){
+	std::unique_lock<std::mutex> lock(mMutex);
+	if(!IsValid(handle)){
+		return;
+	}
+	mCompiled.wait(lock, [this, handle]{ return GetEntry(handle).status != PipelineStateStatus::Pending; });
+}
+
+void PipelineCache::SaveWarmUpList() const {
+	if(mWarmUpPath.empty()){
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	std::ofstream file(mWarmUpPath, std::ios::trunc);
+	for(const Entry& entry : mEntries){
+		if(entry.used && entry.status == PipelineStateStatus::Ready){
+			file << entry.name << "\n";
+		}
+	}
+}
+
+PipelineCacheStats PipelineCache::GetStats() const {
+	std::lock_guard<std::mutex> lock(mMutex);
+	return mStats;
+}
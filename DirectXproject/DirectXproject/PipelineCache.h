@@ -0,0 +1,116 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Creates graphics PSOs on a low priority thread of its own so that first
+// use never stalls a frame. Not on the JobSystem, a ParallelFor on the
+// render thread would help drain its queue and could pick up a compile.
+// Request returns a handle right away. Until the PSO is ready, Get returns
+// the request's fallback PSO, or null when there is none, and the caller
+// skips the draw.
+//
+// The names of the PSOs actually drawn with are written to a warm-up list
+// on shutdown. On the next run WarmUp requests them at startup, before
+// anything asks for them.
+
+using PipelineStateHandle = uint32_t;
+static constexpr PipelineStateHandle kInvalidPipelineState = 0;
+
+enum class PipelineStateStatus { Pending, Ready, Failed };
+
+struct PipelineCacheStats {
+	uint32_t requested;
+	uint32_t warmedUp;
+	uint32_t ready;
+	uint32_t failed;
+	// Get calls that had to fall back or skip, one per bind.
+	uint64_t misses;
+	double totalCompileMilliseconds;
+	double maxCompileMilliseconds;
+};
+
+class PipelineCache {
+public:
+	// Fills desc and fallback for a warm-up name, false for names it does not know.
+	using Describe = std::function<bool(const std::string& name, D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, PipelineStateHandle& fallback)>;
+
+	PipelineCache();
+	~PipelineCache();
+
+	// Reads the warm-up list at warmUpPath, a missing file is an empty list,
+	// and starts the compile thread.
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, const std::string& warmUpPath);
+	// Finishes the queued compiles, stops the thread and writes the warm-up
+	// list back. Safe to call more than once.
+	void Shutdown();
+
+	// Starts creating desc in the background. Requesting a name again
+	// returns the first handle. Whatever desc points at (shaders, input
+	// layout, root signature) has to stay alive until the PSO is ready.
+	PipelineStateHandle Request(const std::string& name, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc,
+		PipelineStateHandle fallback = kInvalidPipelineState);
+	// Requests every name on the warm-up list describe knows. Returns how many.
+	uint32_t WarmUp(const Describe& describe);
+
+	PipelineStateHandle Find(const std::string& name) const;
+	PipelineStateStatus GetStatus(PipelineStateHandle handle) const;
+	inline bool IsReady(PipelineStateHandle handle) const { return GetStatus(handle) == PipelineStateStatus::Ready; }
+
+	// Call where the PSO is bound, once per frame. Returns it once ready,
+	// otherwise the fallback's, otherwise null. Marks the handle as used for
+	// the warm-up list and counts a miss while it is not ready.
+	ID3D12PipelineState* Get(PipelineStateHandle handle);
+	// The PSO once ready, otherwise null, without touching the bookkeeping.
+	ID3D12PipelineState* GetPipelineState(PipelineStateHandle handle) const;
+	// Blocks until handle is no longer pending, for loading screens.
+	void Wait(PipelineStateHandle handle);
+
+	void SaveWarmUpList() const;
+	PipelineCacheStats GetStats() const;
+
+private:
+	struct Entry {
+		std::string name;
+		D3D12_GRAPHICS_PIPELINE_STATE_DESC desc;
+		PipelineStateHandle fallback;
+		PipelineStateStatus status;
+		bool used;
+		Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+	};
+
+	void CompileLoop();
+	// Runs on mCompileThread.
+	void Create(PipelineStateHandle handle);
+	// Called with mMutex held.
+	inline Entry& GetEntry(PipelineStateHandle handle) { return mEntries[handle - 1]; }
+	inline const Entry& GetEntry(PipelineStateHandle handle) const { return mEntries[handle - 1]; }
+	inline bool IsValid(PipelineStateHandle handle) const { return handle != kInvalidPipelineState && handle <= mEntries.size(); }
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+	std::string mWarmUpPath;
+	std::vector<std::string> mWarmUpNames;
+
+	mutable std::mutex mMutex;
+	std::condition_variable mCompiled;
+	// A deque so entries stay put while the compile thread fills them in.
+	std::deque<Entry> mEntries;
+	std::unordered_map<std::string, PipelineStateHandle> mHandles;
+
+	std::thread mCompileThread;
+	std::deque<PipelineStateHandle> mCompileQueue;
+	std::condition_variable mCompileAvailable;
+	bool mShuttingDown;
+	PipelineCacheStats mStats;
+};
@@ -0,0 +1,143 @@
+#include "RadixSort.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "JobSystem.h"
+
+namespace {
+	// Six passes of eleven bits, the last one only nine wide. The buckets
+	// still fit in L1 while saving two full passes over eight bit digits.
+	const uint32_t kDigitBits = 11;
+	const uint32_t kBuckets = 1 << kDigitBits;
+	const uint32_t kDigits = (64 + kDigitBits - 1) / kDigitBits;
+	// Below this many keys per block a worker costs more than it saves.
+	const uint32_t kMinBlockKeys = 32 * 1024;
+
+	inline uint32_t Digit(uint64_t key, uint32_t digit){
+		return static_cast<uint32_t>(key >> (digit * kDigitBits)) & (kBuckets - 1);
+	}
+
+	// Every block owns one contiguous range of the array. The ranges stay in
+	// order from pass to pass, which is what keeps the sort stable.
+	struct Blocks {
+		uint32_t count;
+		uint32_t size;
+		uint32_t total;
+
+		inline uint32_t Begin(uint32_t block) const { return block * size; }
+		inline uint32_t End(uint32_t block) const { return std::min(total, (block + 1) * size); }
+	};
+
+	// Runs func(block) for every block, inline when there is only one.
+	template<typename Func>
+	void ForEachBlock(const Blocks& blocks, const Func& func){
+		if(blocks.count == 1){
+			func(0);
+			return;
+		}
+		JobSystem::GetInstance()->ParallelFor(blocks.count, 1, [&](uint32_t first, uint32_t last){
+			for(uint32_t block = first; block < last; block++){
+				func(block);
+			}
+		});
+	}
+}
+
+void RadixSortPairs(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues, uint32_t count){
+	if(count < 2){
+		return;
+	}
+
+	Blocks blocks;
+	blocks.count = std::max(1u, std::min(JobSystem::GetInstance()->GetWorkerCount() + 1, count / kMinBlockKeys));
+	blocks.size = (count + blocks.count - 1) / blocks.count;
+	blocks.total = count;
+
+	// One read up front counts every digit at once. The totals decide which
+	// passes can be skipped, the per block counts also serve the first pass.
+	std::vector<uint32_t> blockCounts(blocks.count * kDigits * kBuckets, 0);
+	ForEachBlock(blocks, [&](uint32_t block){
+		uint32_t* histogram = blockCounts.data() + block * kDigits * kBuckets;
+		for(uint32_t i = blocks.Begin(block); i < blocks.End(block); i++){
+			uint64_t key = keys[i];
+			for(uint32_t digit = 0; digit < kDigits; digit++){
+				histogram[digit * kBuckets + Digit(key, digit)]++;
+			}
+		}
+	});
+
+	uint32_t totals[kDigits][kBuckets] = {};
+	for(uint32_t block = 0; block < blocks.count; block++){
+		const uint32_t* histogram = blockCounts.data() + block * kDigits * kBuckets;
+		for(uint32_t digit = 0; digit < kDigits; digit++){
+			for(uint32_t bucket = 0; bucket < kBuckets; bucket++){
+				totals[digit][bucket] += histogram[digit * kBuckets + bucket];
+			}
+		}
+	}
+
+	uint64_t* srcKeys = keys;
+	uint32_t* srcValues = values;
+	uint64_t* dstKeys = scratchKeys;
+	uint32_t* dstValues = scratchValues;
+	// Write cursor of every bucket in every block for the current pass.
+	std::vector<uint32_t> offsets(blocks.count * kBuckets);
+	bool firstPass = true;
+
+	for(uint32_t digit = 0; digit < kDigits; digit++){
+		if(std::find(totals[digit], totals[digit] + kBuckets, count) != totals[digit] + kBuckets){
+			continue;
+		}
+
+		// The blocks of the first pass were counted above, later passes
+		// have moved keys between blocks and count again. A single block
+		// always holds every key, its counts are the totals.
+		if(blocks.count == 1){
+			memcpy(offsets.data(), totals[digit], kBuckets * sizeof(uint32_t));
+		}else if(!firstPass){
+			ForEachBlock(blocks, [&](uint32_t block){
+				uint32_t* histogram = offsets.data() + block * kBuckets;
+				std::fill(histogram, histogram + kBuckets, 0u);
+				for(uint32_t i = blocks.Begin(block); i < blocks.End(block); i++){
+					histogram[Digit(srcKeys[i], digit)]++;
+				}
+			});
+		}else{
+			for(uint32_t block = 0; block < blocks.count; block++){
+				memcpy(offsets.data() + block * kBuckets, blockCounts.data() + (block * kDigits + digit) * kBuckets, kBuckets * sizeof(uint32_t));
+			}
+		}
+
+		// Bucket by bucket, block by block, so equal digits keep their order.
+		uint32_t next = 0;
+		for(uint32_t bucket = 0; bucket < kBuckets; bucket++){
+			for(uint32_t block = 0; block < blocks.count; block++){
+				uint32_t blockCount = offsets[block * kBuckets + bucket];
+				offsets[block * kBuckets + bucket] = next;
+				next += blockCount;
+			}
+		}
+
+		ForEachBlock(blocks, [&](uint32_t block){
+			uint32_t* cursor = offsets.data() + block * kBuckets;
+			for(uint32_t i = blocks.Begin(block); i < blocks.End(block); i++){
+				uint64_t key = srcKeys[i];
+				uint32_t position = cursor[Digit(key, digit)]++;
+				dstKeys[position] = key;
+				dstValues[position] = srcValues[i];
+			}
+		});
+
+		std::swap(srcKeys, dstKeys);
+		std::swap(srcValues, dstValues);
+		firstPass = false;
+	}
+
+	if(srcKeys != keys){
+		memcpy(keys, srcKeys, count * sizeof(uint64_t));
+		memcpy(values, srcValues, count * sizeof(uint32_t));
+	}
+}
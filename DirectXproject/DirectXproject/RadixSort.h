@@ -0,0 +1,12 @@
+#pragma once
+
+#include <cstdint>
+
+// Stable ascending LSD radix sort of 64 bit keys, eleven bits per pass, with
+// a 32 bit value carried along each key. Passes where every key has the same
+// digit are skipped, so keys that only use a few fields stay cheap. Large
+// inputs are histogrammed and scattered in blocks on the JobSystem.
+//
+// scratchKeys and scratchValues must hold count elements each. The sorted
+// result always ends up back in keys and values.
+void RadixSortPairs(uint64_t* keys, uint32_t* values, uint64_t* scratchKeys, uint32_t* scratchValues, uint32_t count);
@@ -1,8 +1,8 @@
-#pragma once
-
-struct Rect {
-	int x;
-	int y;
-
-	Rect(int x_, int y_):x(x_),y(y_){}
+#pragma once
+
+struct Rect {
+	int x;
+	int y;
+
+	Rect(int x_, int y_):x(x_),y(y_){}
 };
\ No newline at end of file
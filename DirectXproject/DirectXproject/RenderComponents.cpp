@@ -0,0 +1,166 @@
+#include "RenderComponents.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+	// Moves the local sphere into world space. The radius grows with the
+	// largest axis scale so the sphere stays conservative. World matrices
+	// are affine, w stays 1.
+	float GetMaxScale(const Float4x4& world){
+		const float (&m)[4][4] = world.m;
+		float scaleX = m[0][0] * m[0][0] + m[0][1] * m[0][1] + m[0][2] * m[0][2];
+		float scaleY = m[1][0] * m[1][0] + m[1][1] * m[1][1] + m[1][2] * m[1][2];
+		float scaleZ = m[2][0] * m[2][0] + m[2][1] * m[2][1] + m[2][2] * m[2][2];
+		return sqrtf(std::max(scaleX, std::max(scaleY, scaleZ)));
+	}
+
+	GpuObjectBounds ToWorld(const Float4x4& world, const BoundsComponent& local){
+		const float (&m)[4][4] = world.m;
+		GpuObjectBounds result;
+		for(int column = 0; column < 3; column++){
+			result.center[column] = local.center[0] * m[0][column] + local.center[1] * m[1][column] + local.center[2] * m[2][column] + m[3][column];
+		}
+		result.radius = local.radius * GetMaxScale(world);
+		return result;
+	}
+}
+
+void AttachToHierarchy(EntityWorld& world, TransformHierarchy& hierarchy, TransformHierarchy::Handle parent){
+	// Adding the component moves the entity to another archetype, which
+	// can't happen while the query walks the chunks.
+	EntityCommandBuffer commands(world);
+	world.ForEach<TransformComponent>([&](Entity entity, TransformComponent& transform){
+		if(world.HasComponent<HierarchyComponent>(entity)){
+			return;
+		}
+		const TransformHierarchy::Handle node = hierarchy.Create(parent);
+		hierarchy.SetLocal(node, transform.world);
+		commands.AddComponent(entity, HierarchyComponent{ node });
+	});
+	commands.Playback();
+}
+
+void CopyHierarchyTransforms(EntityWorld& world, const TransformHierarchy& hierarchy){
+	world.ForEachChunk<TransformComponent, HierarchyComponent>(
+		[&](uint32_t count, const Entity*, TransformComponent* transforms, HierarchyComponent* nodes){
+		for(uint32_t i = 0; i < count; i++){
+			transforms[i].world = hierarchy.GetWorld(nodes[i].node);
+		}
+	});
+}
+
+void GatherRenderObjects(EntityWorld& world, std::vector<GpuObjectBounds>& bounds, std::vector<GpuDrawArguments>& drawArgs,
+	std::vector<Entity>* entities){
+	bounds.clear();
+	drawArgs.clear();
+	if(entities){
+		entities->clear();
+	}
+
+	world.ForEachChunk<TransformComponent, BoundsComponent, RenderableComponent>(
+		[&](uint32_t count, const Entity* ids, TransformComponent* transforms, BoundsComponent* localBounds, RenderableComponent* renderables){
+		for(uint32_t i = 0; i < count; i++){
+			bounds.push_back(ToWorld(transforms[i].world, localBounds[i]));
+			drawArgs.push_back({ renderables[i].vertexCount, 1, renderables[i].startVertex, 0 });
+		}
+		if(entities){
+			entities->insert(entities->end(), ids, ids + count);
+		}
+	});
+}
+
+void GatherRenderBounds(EntityWorld& world, SphereBoundsSoA& bounds, std::vector<Entity>& entities){
+	bounds.Clear();
+	entities.clear();
+
+	world.ForEachChunk<TransformComponent, BoundsComponent, RenderableComponent>(
+		[&](uint32_t count, const Entity* ids, TransformComponent* transforms, BoundsComponent* localBounds, RenderableComponent*){
+		for(uint32_t i = 0; i < count; i++){
+			GpuObjectBounds sphere = ToWorld(transforms[i].world, localBounds[i]);
+			bounds.Add(sphere.center, sphere.radius);
+		}
+		entities.insert(entities.end(), ids, ids + count);
+	});
+}
+
+void GatherOccluders(EntityWorld& world, SoftwareOcclusion& occlusion){
+	world.ForEach<TransformComponent, OccluderComponent>([&](Entity, TransformComponent& transform, OccluderComponent& occluder){
+		OccluderMesh mesh = { occluder.positions, occluder.vertexCount, occluder.indices, occluder.indexCount, transform.world, occluder.twoSided };
+		occlusion.AddOccluder(mesh);
+	});
+}
+
+void GatherDrawList(EntityWorld& world, const Float4x4& view, const Frustum& frustum, float nearZ, float farZ, DrawGatherScratch& scratch,
+	std::vector<RenderableComponent>& draws, std::vector<Float4x4>& worlds, DrawList& drawList, SoftwareOcclusion* occlusion,
+	const LodSelection* lod){
+	draws.clear();
+	worlds.clear();
+	drawList.Clear();
+
+	GatherRenderBounds(world, scratch.bounds, scratch.entities);
+	CullSpheres(frustum, scratch.bounds, scratch.visible);
+	if(occlusion && !scratch.visible.empty()){
+		// Only the frustum survivors are tested. Box j belongs to visible[j],
+		// so the unoccluded boxes map straight back and stay ascending.
+		const SphereBoundsSoA& spheres = scratch.bounds;
+		scratch.boxes.Clear();
+		scratch.candidates.resize(scratch.visible.size());
+		for(size_t j = 0; j < scratch.visible.size(); j++){
+			const uint32_t object = scratch.visible[j];
+			const float radius = spheres.radius[object];
+			const float boxMin[3] = { spheres.centerX[object] - radius, spheres.centerY[object] - radius, spheres.centerZ[object] - radius };
+			const float boxMax[3] = { spheres.centerX[object] + radius, spheres.centerY[object] + radius, spheres.centerZ[object] + radius };
+			scratch.candidates[j] = scratch.boxes.Add(boxMin, boxMax);
+		}
+		occlusion->CullOccludees(scratch.boxes, scratch.candidates.data(), static_cast<uint32_t>(scratch.candidates.size()), scratch.unoccluded);
+		for(size_t j = 0; j < scratch.unoccluded.size(); j++){
+			scratch.visible[j] = scratch.visible[scratch.unoccluded[j]];
+		}
+		scratch.visible.resize(scratch.unoccluded.size());
+	}
+	if(scratch.visible.empty()){
+		return;
+	}
+
+	// Chunk order is the same as in GatherRenderBounds, object is the index
+	// into scratch.bounds and visible is ascending.
+	const SphereBoundsSoA& bounds = scratch.bounds;
+	const std::vector<uint32_t>& visible = scratch.visible;
+	uint32_t object = 0;
+	size_t next = 0;
+	world.ForEachChunk<TransformComponent, BoundsComponent, RenderableComponent>(
+		[&](uint32_t count, const Entity* ids, TransformComponent* transforms, BoundsComponent*, RenderableComponent* renderables){
+		for(uint32_t i = 0; i < count; i++, object++){
+			if(next == visible.size() || visible[next] != object){
+				continue;
+			}
+			next++;
+
+			float viewDepth = bounds.centerX[object] * view.m[0][2] + bounds.centerY[object] * view.m[1][2] + bounds.centerZ[object] * view.m[2][2] + view.m[3][2];
+
+			RenderableComponent renderable = renderables[i];
+			LodComponent* levels = lod ? world.GetComponent<LodComponent>(ids[i]) : nullptr;
+			if(levels && levels->lodCount > 0){
+				// Errors are in object space, scaling the object up is the
+				// same as seeing it from closer.
+				const float distance = viewDepth / GetMaxScale(transforms[i].world);
+				levels->currentLod = SelectLod(levels->lods, levels->lodCount, distance, lod->projectionScale,
+					lod->pixelThreshold, levels->currentLod, lod->hysteresis);
+				renderable.vertexCount = levels->ranges[levels->currentLod].vertexCount;
+				renderable.startVertex = levels->ranges[levels->currentLod].startVertex;
+			}
+			DrawKeyFields fields;
+			fields.layer = renderable.layer;
+			fields.pass = renderable.pass;
+			fields.pipeline = renderable.pipeline;
+			fields.material = renderable.material;
+			fields.mesh = renderable.mesh;
+			fields.depth = QuantizeDepth(viewDepth, nearZ, farZ);
+
+			drawList.Add(EncodeDrawKey(fields), static_cast<uint32_t>(draws.size()));
+			draws.push_back(renderable);
+			worlds.push_back(transforms[i].world);
+		}
+	});
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "DrawSortKey.h"
+#include "EntityWorld.h"
+#include "FrustumCulling.h"
+#include "GpuCulling.h"
+#include "MathBatch.h"
+#include "MeshSimplifier.h"
+#include "SoftwareOcclusion.h"
+#include "TransformHierarchy.h"
+
+// Components the renderer reads straight out of the EntityWorld chunks.
+
+struct TransformComponent {
+	Float4x4 world;
+};
+
+// Node in a TransformHierarchy that owns the entity's world matrix.
+struct HierarchyComponent {
+	TransformHierarchy::Handle node;
+};
+
+// Bounding sphere in the object's local space.
+struct BoundsComponent {
+	float center[3];
+	float radius;
+};
+
+// What to draw. Vertex ranges index the shared vertex buffer.
+struct RenderableComponent {
+	uint32_t mesh;
+	uint32_t material;
+	uint32_t vertexCount;
+	uint32_t startVertex;
+	// Sort key fields, see DrawSortKey.h.
+	uint32_t pipeline;
+	uint32_t layer;
+	DrawPass pass;
+};
+
+// Vertex range drawing one level of detail.
+struct LodRange {
+	uint32_t vertexCount;
+	uint32_t startVertex;
+};
+
+// Levels of detail of a renderable: the mesh's chain from BuildLodChain and
+// the range each level is drawn with, both shared and outliving the world.
+// GatherDrawList draws the picked level's range in place of the
+// RenderableComponent's and keeps the pick in currentLod for hysteresis.
+struct LodComponent {
+	const MeshLod* lods;
+	const LodRange* ranges;
+	uint32_t lodCount;
+	uint32_t currentLod;
+};
+
+// How GatherDrawList picks levels of detail, see SelectLod.
+struct LodSelection {
+	float projectionScale;
+	float pixelThreshold;
+	float hysteresis;
+};
+
+// Marks an entity as an occluder for SoftwareOcclusion, drawn with its
+// TransformComponent. The mesh data is shared and must outlive the world.
+struct OccluderComponent {
+	const Float3* positions;
+	uint32_t vertexCount;
+	const uint32_t* indices;
+	uint32_t indexCount;
+	bool twoSided;
+};
+
+// Gives every entity with a TransformComponent but no node yet a node under
+// parent, its current world matrix becoming the node's local transform.
+void AttachToHierarchy(EntityWorld& world, TransformHierarchy& hierarchy, TransformHierarchy::Handle parent);
+
+// Copies the hierarchy's world matrices into the TransformComponent of every
+// entity with a node, call after TransformHierarchy::Update.
+void CopyHierarchyTransforms(EntityWorld& world, const TransformHierarchy& hierarchy);
+
+// Fills the GpuDrivenRenderer inputs from every entity that has all three
+// components, with world space bounds. Entities are written in chunk order,
+// entities receives the entity behind each object index when not null.
+void GatherRenderObjects(EntityWorld& world, std::vector<GpuObjectBounds>& bounds, std::vector<GpuDrawArguments>& drawArgs,
+	std::vector<Entity>* entities = nullptr);
+
+// Same walk, producing world space spheres for the CPU culler.
+void GatherRenderBounds(EntityWorld& world, SphereBoundsSoA& bounds, std::vector<Entity>& entities);
+
+// Adds every entity with a TransformComponent and an OccluderComponent to
+// occlusion. Call between BeginFrame and RasterizeOccluders.
+void GatherOccluders(EntityWorld& world, SoftwareOcclusion& occlusion);
+
+// Working memory of GatherDrawList, kept between frames so it does not allocate.
+struct DrawGatherScratch {
+	SphereBoundsSoA bounds;
+	std::vector<Entity> entities;
+	std::vector<uint32_t> visible;
+	// Boxes around the spheres that survived the frustum, for the occlusion test.
+	AabbBoundsSoA boxes;
+	std::vector<uint32_t> candidates;
+	std::vector<uint32_t> unoccluded;
+};
+
+// Culls the world space spheres from GatherRenderBounds against frustum,
+// and against the occluders rasterized into occlusion when it is not null,
+// then walks again adding one sort key per visible entity to drawList. The
+// draw index of each key points into draws and worlds, which receive the
+// renderables and their world matrices. Depth is the bounds center along
+// the view direction, quantized over [nearZ, farZ]. Keys are added in draw
+// order, key i for draw i, and left for the caller to sort. With lod set,
+// entities with a LodComponent draw the level SelectLod picks at that depth.
+void GatherDrawList(EntityWorld& world, const Float4x4& view, const Frustum& frustum, float nearZ, float farZ, DrawGatherScratch& scratch,
+	std::vector<RenderableComponent>& draws, std::vector<Float4x4>& worlds, DrawList& drawList, SoftwareOcclusion* occlusion = nullptr,
+	const LodSelection* lod = nullptr);
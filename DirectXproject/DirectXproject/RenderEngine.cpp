@@ -1,53 +1,95 @@
-#include "RenderEngine.h"
-#include <SDL.h>
-#include "DirectXAPI.h"
-#include <iostream>
-#include "Rect.h"
-
-RenderEngine* RenderEngine::instance = nullptr;
-
-RenderEngine* RenderEngine::GetInstance(){
-	if(instance == nullptr){
-		instance = new RenderEngine();
-	}
-
-	return instance;
-}
-
-RenderEngine::RenderEngine(){
-	const int SCREEN_WIDTH = 1280;
-	const int SCREEN_HEIGHT = 720;
-	Rect windowRect = Rect(SCREEN_WIDTH, SCREEN_HEIGHT);
-	ptr = new Window(SCREEN_WIDTH, SCREEN_HEIGHT);
-	if( ptr->Initialize() == false) {
-		ptr->Destroy();
-		delete ptr;
-	}
-
-	try{
-		DirectXAPI::GetInstance()->Init(ptr->GetWHD(), windowRect);
-	} catch(std::exception e){
-		std::cout << "Error: " << e.what() << std::endl;
-	}
-
-}
-
-RenderEngine::~RenderEngine(){
-	DirectXAPI::GetInstance()->Destroy();
-	//Clean up window
-	if(ptr != nullptr) {
-		ptr->Destroy();
-		delete ptr;
-		ptr = nullptr;
-	}
-}
-
-void RenderEngine::Render(){
-	// DirectX 12 
-	DirectXAPI::GetInstance()->Render();
-	SDL_UpdateWindowSurface(ptr->GetSDL_Window());
-}
-
-void RenderEngine::UpdateAPI(){
-	
+#include "RenderEngine.h"
+#include <SDL.h>
+#include "DirectXAPI.h"
+#include <iostream>
+#include <stdexcept>
+#include "Rect.h"
+
+RenderEngine* RenderEngine::instance = nullptr;
+
+RenderEngine* RenderEngine::GetInstance(){
+	if(instance == nullptr){
+		instance = new RenderEngine();
+	}
+
+	return instance;
+}
+
+RenderEngine::RenderEngine(){
+	mInitialized = false;
+	const int SCREEN_WIDTH = 1280;
+	const int SCREEN_HEIGHT = 720;
+	Rect windowRect = Rect(SCREEN_WIDTH, SCREEN_HEIGHT);
+	mWidth = SCREEN_WIDTH;
+	mHeight = SCREEN_HEIGHT;
+	ptr = new Window(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+	try{
+		// The window is opened on this thread while DirectX creates the
+		// device and compiles shaders on the job system.
+		DirectXAPI::GetInstance()->Init([this](){
+			if(ptr->Initialize() == false) {
+				throw std::runtime_error("Window failed to initialize");
+			}
+			return ptr->GetWHD();
+		}, windowRect);
+	} catch(const std::exception& e){
+		// Nothing to render with, the window goes too.
+		std::cout << "Error: " << e.what() << std::endl;
+		ptr->Destroy();
+		delete ptr;
+		ptr = nullptr;
+		return;
+	}
+	mInitialized = true;
+
+	mRenderThread.Start([](const RenderSnapshot& snapshot){
+		DirectXAPI::GetInstance()->Render(snapshot);
+	});
+}
+
+RenderEngine::~RenderEngine(){
+	StopRenderThread();
+	DirectXAPI::GetInstance()->Destroy();
+	//Clean up window
+	if(ptr != nullptr) {
+		ptr->Destroy();
+		delete ptr;
+		ptr = nullptr;
+	}
+}
+
+void RenderEngine::Render(){
+	if(!mInitialized){
+		return;
+	}
+	// DirectX 12, the render thread picks the snapshot up from here
+	RenderSnapshot& snapshot = mRenderThread.GetSnapshot();
+	DirectXAPI::GetInstance()->BuildSnapshot(snapshot);
+	snapshot.width = static_cast<uint32_t>(mWidth);
+	snapshot.height = static_cast<uint32_t>(mHeight);
+	mRenderThread.Publish();
+	SDL_UpdateWindowSurface(ptr->GetSDL_Window());
+}
+
+void RenderEngine::Resize(int width, int height){
+	// Minimized, the swap chain keeps its size until the window is back.
+	if(width <= 0 || height <= 0){
+		return;
+	}
+	mWidth = width;
+	mHeight = height;
+}
+
+void RenderEngine::StopRenderThread(){
+	mRenderThread.Stop();
+
+	RenderThreadStats stats = mRenderThread.GetStats();
+	std::cout << "Render thread: " << stats.framesRendered << " of " << stats.framesPublished << " frames rendered, "
+		<< stats.framesDropped << " dropped, queue " << stats.averageQueueMilliseconds << " ms avg " << stats.maxQueueMilliseconds
+		<< " ms max, latency " << stats.averageLatencyMilliseconds << " ms avg " << stats.maxLatencyMilliseconds << " ms max" << std::endl;
+}
+
+void RenderEngine::UpdateAPI(){
+	
 }
\ No newline at end of file
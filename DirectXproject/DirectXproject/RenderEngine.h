@@ -1,28 +1,43 @@
-#pragma once
-
-#include "Window.h"
-
-class RenderEngine{
-public:
-	static RenderEngine* GetInstance();
-
-	void Render();
-	void UpdateAPI();
-	inline Window* GetWindow(){ return ptr; }
-
-	
-private:
-	RenderEngine();
-	~RenderEngine();
-
-	static RenderEngine* instance;
-
-	Window *ptr;
-	int mHeight, mWidth;
-
-	RenderEngine(const RenderEngine&) = delete;
-	RenderEngine(RenderEngine&&) = delete;
-	RenderEngine& operator=(const RenderEngine&) = delete;
-	RenderEngine& operator=(RenderEngine&&) = delete;
-};
-
+#pragma once
+
+#include "RenderThread.h"
+#include "Window.h"
+
+class RenderEngine{
+public:
+	static RenderEngine* GetInstance();
+
+	// Game thread. Captures this frame and hands it to the render thread.
+	void Render();
+	// Game thread, from the window's size change event. The render thread
+	// resizes the swap chain before the next snapshot it draws.
+	void Resize(int width, int height);
+	void UpdateAPI();
+	// Waits for the frame in flight, call before tearing the API down.
+	void StopRenderThread();
+	inline Window* GetWindow(){ return ptr; }
+	// False when startup failed, nothing is rendered then.
+	inline bool IsInitialized() const { return mInitialized; }
+	// False once the render thread stopped on an error.
+	inline bool IsRendering() const { return mRenderThread.IsRunning(); }
+	inline RenderThreadStats GetRenderThreadStats() const { return mRenderThread.GetStats(); }
+
+	
+private:
+	RenderEngine();
+	~RenderEngine();
+
+	static RenderEngine* instance;
+
+	Window *ptr;
+	int mHeight, mWidth;
+	bool mInitialized;
+	// Records and submits the frames DirectXAPI captures on the game thread
+	RenderThread mRenderThread;
+
+	RenderEngine(const RenderEngine&) = delete;
+	RenderEngine(RenderEngine&&) = delete;
+	RenderEngine& operator=(const RenderEngine&) = delete;
+	RenderEngine& operator=(RenderEngine&&) = delete;
+};
+
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+#include "DrawSortKey.h"
+#include "MathBatch.h"
+#include "RenderComponents.h"
+
+// Everything the render thread needs for one frame, captured by the game
+// thread at the end of its update. The render thread only reads it, the
+// scene can move on while the frame is being recorded.
+struct RenderSnapshot {
+	uint64_t frame = 0;
+
+	// Camera.
+	Float4x4 view;
+	Float4x4 projection;
+	float nearZ = 0.0f;
+	float farZ = 1.0f;
+
+	// Window client size. The render thread resizes the swap chain and the
+	// depth buffer when it differs from theirs, between two frames.
+	uint32_t width = 0;
+	uint32_t height = 0;
+
+	// Lay down depth in a separate pass before shading, chosen per scene.
+	bool depthPrePass = false;
+
+	// Objects to draw and their world matrices. drawList holds their sort
+	// keys, draw i with key i, and is sorted by whoever records the draws.
+	std::vector<RenderableComponent> draws;
+	std::vector<Float4x4> worlds;
+	DrawList drawList;
+
+	// Stamped on publish, the render thread measures its latency from here.
+	std::chrono::high_resolution_clock::time_point publishTime;
+};
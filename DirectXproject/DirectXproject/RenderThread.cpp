@@ -0,0 +1,117 @@
+#include "RenderThread.h"
+
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	uint64_t MicrosecondsSince(Clock::time_point start){
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+	}
+
+	// Only the render thread raises the maxima, a plain compare is enough.
+	void RaiseMax(std::atomic<uint64_t>& max, uint64_t value){
+		if(value > max.load(std::memory_order_relaxed)){
+			max.store(value, std::memory_order_relaxed);
+		}
+	}
+}
+
+RenderThread::RenderThread() : mRunning(false), mStopping(false), mNextFrame(0) {
+	ResetStats();
+}
+
+RenderThread::~RenderThread(){
+	Stop();
+}
+
+bool RenderThread::Start(std::function<void(const RenderSnapshot&)> render){
+	if(mThread.joinable() || !render){
+		return false;
+	}
+
+	mRender = std::move(render);
+	mStopping.store(false, std::memory_order_relaxed);
+	mRunning.store(true, std::memory_order_release);
+	mThread = std::thread(&RenderThread::RenderLoop, this);
+	return true;
+}
+
+void RenderThread::Stop(){
+	if(!mThread.joinable()){
+		return;
+	}
+
+	// Publishing wakes the render thread if it is waiting, it sees the flag
+	// and leaves without rendering whatever the slot holds.
+	mStopping.store(true, std::memory_order_release);
+	mSnapshots.Publish();
+	mThread.join();
+	mRunning.store(false, std::memory_order_release);
+}
+
+void RenderThread::Publish(){
+	RenderSnapshot& snapshot = mSnapshots.GetWriteSlot();
+	snapshot.frame = mNextFrame++;
+	snapshot.publishTime = Clock::now();
+
+	mFramesPublished.fetch_add(1, std::memory_order_relaxed);
+	if(mSnapshots.Publish()){
+		mFramesDropped.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+void RenderThread::RenderLoop(){
+	while(true){
+		mSnapshots.WaitForPublish();
+		if(mStopping.load(std::memory_order_acquire)){
+			break;
+		}
+		mSnapshots.Acquire();
+
+		const RenderSnapshot& snapshot = mSnapshots.GetReadSlot();
+		uint64_t queued = MicrosecondsSince(snapshot.publishTime);
+		mQueueMicroseconds.fetch_add(queued, std::memory_order_relaxed);
+		RaiseMax(mMaxQueueMicroseconds, queued);
+
+		try{
+			mRender(snapshot);
+		} catch(std::exception& e){
+			std::cout << "Error: " << e.what() << std::endl;
+			break;
+		}
+
+		uint64_t latency = MicrosecondsSince(snapshot.publishTime);
+		mLatencyMicroseconds.fetch_add(latency, std::memory_order_relaxed);
+		RaiseMax(mMaxLatencyMicroseconds, latency);
+		mFramesRendered.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	mRunning.store(false, std::memory_order_release);
+}
+
+RenderThreadStats RenderThread::GetStats() const {
+	RenderThreadStats stats;
+	stats.framesPublished = mFramesPublished.load(std::memory_order_relaxed);
+	stats.framesRendered = mFramesRendered.load(std::memory_order_relaxed);
+	stats.framesDropped = mFramesDropped.load(std::memory_order_relaxed);
+
+	double rendered = static_cast<double>(std::max<uint64_t>(stats.framesRendered, 1));
+	stats.averageQueueMilliseconds = mQueueMicroseconds.load(std::memory_order_relaxed) / rendered / 1000.0;
+	stats.maxQueueMilliseconds = mMaxQueueMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+	stats.averageLatencyMilliseconds = mLatencyMicroseconds.load(std::memory_order_relaxed) / rendered / 1000.0;
+	stats.maxLatencyMilliseconds = mMaxLatencyMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+	return stats;
+}
+
+void RenderThread::ResetStats(){
+	mFramesPublished.store(0, std::memory_order_relaxed);
+	mFramesDropped.store(0, std::memory_order_relaxed);
+	mFramesRendered.store(0, std::memory_order_relaxed);
+	mQueueMicroseconds.store(0, std::memory_order_relaxed);
+	mMaxQueueMicroseconds.store(0, std::memory_order_relaxed);
+	mLatencyMicroseconds.store(0, std::memory_order_relaxed);
+	mMaxLatencyMicroseconds.store(0, std::memory_order_relaxed);
+}
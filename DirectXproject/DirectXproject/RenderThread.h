@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "RenderSnapshot.h"
+#include "TripleBuffer.h"
+
+// Records and submits frames on a thread of its own. The game thread fills
+// a snapshot at the end of every update and publishes it, the render thread
+// renders the newest one while the game simulates the next frame. Snapshots
+// pass through a TripleBuffer, so neither thread blocks the other. When the
+// game runs ahead, snapshots the render thread never picked up are dropped.
+
+struct RenderThreadStats {
+	uint64_t framesPublished;
+	uint64_t framesRendered;
+	uint64_t framesDropped;
+	// Publish until the render thread picks the snapshot up.
+	double averageQueueMilliseconds;
+	double maxQueueMilliseconds;
+	// Publish until the frame has been rendered and presented.
+	double averageLatencyMilliseconds;
+	double maxLatencyMilliseconds;
+};
+
+class RenderThread {
+public:
+	RenderThread();
+	~RenderThread();
+
+	// render runs on the render thread once per picked up snapshot. Throwing
+	// from it stops the thread, IsRunning turns false.
+	bool Start(std::function<void(const RenderSnapshot&)> render);
+	// Finishes the frame in flight and joins the thread.
+	void Stop();
+
+	// Game thread only. Fill the snapshot, then publish it.
+	inline RenderSnapshot& GetSnapshot() { return mSnapshots.GetWriteSlot(); }
+	void Publish();
+
+	inline bool IsRunning() const { return mRunning.load(std::memory_order_acquire); }
+
+	RenderThreadStats GetStats() const;
+	void ResetStats();
+
+private:
+	void RenderLoop();
+
+	std::thread mThread;
+	std::function<void(const RenderSnapshot&)> mRender;
+	TripleBuffer<RenderSnapshot> mSnapshots;
+	std::atomic<bool> mRunning;
+	std::atomic<bool> mStopping;
+	uint64_t mNextFrame;
+
+	// Written by one thread each, read by anyone through GetStats.
+	std::atomic<uint64_t> mFramesPublished;
+	std::atomic<uint64_t> mFramesDropped;
+	std::atomic<uint64_t> mFramesRendered;
+	std::atomic<uint64_t> mQueueMicroseconds;
+	std::atomic<uint64_t> mMaxQueueMicroseconds;
+	std::atomic<uint64_t> mLatencyMicroseconds;
+	std::atomic<uint64_t> mMaxLatencyMicroseconds;
+
+	RenderThread(const RenderThread&) = delete;
+	RenderThread& operator=(const RenderThread&) = delete;
+};
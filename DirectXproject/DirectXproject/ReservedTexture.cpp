@@ -0,0 +1,169 @@
+#include "ReservedTexture.h"
+
+#include "d3dx12.h"
+#include "Helpers.h"
+#include "StreamingCopy.h"
+
+#include <cstring>
+
+using Microsoft::WRL::ComPtr;
+
+ReservedTexture::ReservedTexture() :mReleaseQueue(nullptr), mDesc{}, mPackedMipInfo{} {
+
+}
+
+ReservedTexture::~ReservedTexture(){
+
+}
+
+void ReservedTexture::Init(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandQueue> queue, DeferredReleaseQueue* releaseQueue,
+	UINT width, UINT height, UINT16 mipCount, DXGI_FORMAT format){
+	mDevice = device;
+	mQueue = queue;
+	mReleaseQueue = releaseQueue;
+
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	ThrowIfFailed(mDevice->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+	if(options.TiledResourcesTier == D3D12_TILED_RESOURCES_TIER_NOT_SUPPORTED){
+		ThrowIfFailed(E_NOTIMPL);
+	}
+
+	mDesc = CD3DX12_RESOURCE_DESC::Tex2D(format, width, height, 1, mipCount);
+	mDesc.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+	ThrowIfFailed(mDevice->CreateReservedResource(&mDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&mResource)));
+	mDesc = mResource->GetDesc();
+
+	UINT subresourceCount = mDesc.MipLevels;
+	mMipTilings.resize(subresourceCount);
+	UINT totalTiles = 0;
+	D3D12_TILE_SHAPE tileShape = {};
+	mDevice->GetResourceTiling(mResource.Get(), &totalTiles, &mPackedMipInfo, &tileShape, &subresourceCount, 0, mMipTilings.data());
+
+	mMipHeaps.resize(mDesc.MipLevels);
+	mMipStates.assign(mDesc.MipLevels, D3D12_RESOURCE_STATE_COPY_DEST);
+
+	// The packed tail cannot be split, map it once for good.
+	if(mPackedMipInfo.NumTilesForPackedMips > 0){
+		CD3DX12_HEAP_DESC heapDesc(UINT64(mPackedMipInfo.NumTilesForPackedMips) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+			D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+		ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&mPackedHeap)));
+		MapTiles(mPackedMipInfo.NumStandardMips, mPackedMipInfo.NumTilesForPackedMips, mPackedHeap.Get());
+	}
+}
+
+void ReservedTexture::MapTiles(UINT subresource, UINT tileCount, ID3D12Heap* heap){
+	D3D12_TILED_RESOURCE_COORDINATE coordinate = {};
+	coordinate.Subresource = subresource;
+
+	D3D12_TILE_REGION_SIZE region = {};
+	region.NumTiles = tileCount;
+	region.UseBox = FALSE;
+
+	// A null heap unmaps the region.
+	D3D12_TILE_RANGE_FLAGS rangeFlags = heap ? D3D12_TILE_RANGE_FLAG_NONE : D3D12_TILE_RANGE_FLAG_NULL;
+	UINT heapStart = 0;
+	mQueue->UpdateTileMappings(mResource.Get(), 1, &coordinate, &region, heap, 1, &rangeFlags,
+		heap ? &heapStart : nullptr, &tileCount, D3D12_TILE_MAPPING_FLAG_NONE);
+}
+
+void ReservedTexture::MapMip(UINT mip){
+	if(mip >= GetPackedMipStart() || mMipHeaps[mip]){
+		return;
+	}
+
+	const D3D12_SUBRESOURCE_TILING& tiling = mMipTilings[mip];
+	UINT tileCount = tiling.WidthInTiles * tiling.HeightInTiles * tiling.DepthInTiles;
+
+	CD3DX12_HEAP_DESC heapDesc(UINT64(tileCount) * D3D12_TILED_RESOURCE_TILE_SIZE_IN_BYTES,
+		D3D12_HEAP_TYPE_DEFAULT, 0, D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES);
+	ThrowIfFailed(mDevice->CreateHeap(&heapDesc, IID_PPV_ARGS(&mMipHeaps[mip])));
+	MapTiles(mip, tileCount, mMipHeaps[mip].Get());
+}
+
+void ReservedTexture::UnmapMip(UINT mip){
+	if(mip >= GetPackedMipStart() || !mMipHeaps[mip]){
+		return;
+	}
+
+	const D3D12_SUBRESOURCE_TILING& tiling = mMipTilings[mip];
+	MapTiles(mip, tiling.WidthInTiles * tiling.HeightInTiles * tiling.DepthInTiles, nullptr);
+
+	// Frames already submitted may still sample the tiles.
+	ComPtr<ID3D12Heap> heap = std::move(mMipHeaps[mip]);
+	mReleaseQueue->Defer([heap]{});
+}
+
+UINT8* ReservedTexture::BeginUpload(UINT mip, PendingUpload& pending){
+	mDevice->GetCopyableFootprints(&mDesc, mip, 1, 0, &pending.footprint, &pending.rowCount, &pending.rowSize, &pending.size);
+
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(pending.size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&pending.buffer)));
+
+	UINT8* mapped;
+	CD3DX12_RANGE readRange(0, 0);
+	ThrowIfFailed(pending.buffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped)));
+	return mapped + pending.footprint.Offset;
+}
+
+void ReservedTexture::EndUpload(ID3D12GraphicsCommandList* commandList, UINT mip, PendingUpload& pending){
+	pending.buffer->Unmap(0, nullptr);
+
+	if(mMipStates[mip] != D3D12_RESOURCE_STATE_COPY_DEST){
+		commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mResource.Get(), mMipStates[mip], D3D12_RESOURCE_STATE_COPY_DEST, mip));
+	}
+
+	CD3DX12_TEXTURE_COPY_LOCATION destination(mResource.Get(), mip);
+	CD3DX12_TEXTURE_COPY_LOCATION source(pending.buffer.Get(), pending.footprint);
+	commandList->CopyTextureRegion(&destination, 0, 0, 0, &source, nullptr);
+
+	commandList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(mResource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, mip));
+	mMipStates[mip] = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+	ComPtr<ID3D12Resource> upload = std::move(pending.buffer);
+	mReleaseQueue->Defer([upload]{});
+}
+
+void ReservedTexture::UploadMip(ID3D12GraphicsCommandList* commandList, UINT mip, const void* data, UINT rowPitch){
+	if(!IsMipMapped(mip)){
+		return;
+	}
+
+	PendingUpload pending;
+	UINT8* mapped = BeginUpload(mip, pending);
+	for(UINT row = 0; row < pending.rowCount; row++){
+		StreamCopyNoFence(mapped + UINT64(row) * pending.footprint.Footprint.RowPitch,
+			static_cast<const UINT8*>(data) + UINT64(row) * rowPitch, static_cast<size_t>(pending.rowSize));
+	}
+	StreamFence();
+	EndUpload(commandList, mip, pending);
+}
+
+void ReservedTexture::ClearMip(ID3D12GraphicsCommandList* commandList, UINT mip, UINT8 value){
+	if(!IsMipMapped(mip)){
+		return;
+	}
+
+	// Row padding included, one fill covers the whole footprint.
+	PendingUpload pending;
+	UINT8* mapped = BeginUpload(mip, pending);
+	StreamFill(mapped, value, static_cast<size_t>(pending.size - pending.footprint.Offset));
+	EndUpload(commandList, mip, pending);
+}
+
+void ReservedTexture::CreateShaderResourceView(D3D12_CPU_DESCRIPTOR_HANDLE descriptor, UINT residentMip){
+	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = mDesc.Format;
+	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	srvDesc.Texture2D.MostDetailedMip = 0;
+	srvDesc.Texture2D.MipLevels = mDesc.MipLevels;
+	// The clamp keeps the sampler off unmapped mips without recreating the
+	// resource as residency changes.
+	srvDesc.Texture2D.ResourceMinLODClamp = static_cast<float>(residentMip);
+	mDevice->CreateShaderResourceView(mResource.Get(), &srvDesc, descriptor);
+}
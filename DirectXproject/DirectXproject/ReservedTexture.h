@@ -0,0 +1,72 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+#include <vector>
+
+#include "DeferredReleaseQueue.h"
+
+// 2D texture created as a reserved resource with its full mip chain, where
+// only some mips are backed by memory. Each standard mip gets its own heap
+// so it can be mapped and released on its own. The packed mip tail is
+// mapped for the whole lifetime. Driven by the transitions from
+// TextureResidency.
+class ReservedTexture {
+public:
+	ReservedTexture();
+	~ReservedTexture();
+
+	// Needs D3D12_TILED_RESOURCES_TIER_1 or better. Memory the GPU may still
+	// use, unmapped mips and upload buffers, is handed to releaseQueue.
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue,
+		DeferredReleaseQueue* releaseQueue, UINT width, UINT height, UINT16 mipCount, DXGI_FORMAT format);
+
+	// Backs mip with memory. The contents are undefined until UploadMip.
+	void MapMip(UINT mip);
+	// Returns the memory of mip once the GPU is done sampling it.
+	void UnmapMip(UINT mip);
+	// Records a copy of data (rows of rowPitch bytes, block rows for BC
+	// formats) into a mapped mip. The upload buffer is released once the
+	// frame it was recorded in has completed.
+	void UploadMip(ID3D12GraphicsCommandList* commandList, UINT mip, const void* data, UINT rowPitch);
+	// Like UploadMip with every byte of the mip set to value, for mips that
+	// have no data of their own yet.
+	void ClearMip(ID3D12GraphicsCommandList* commandList, UINT mip, UINT8 value);
+
+	// SRV limited to the resident mips.
+	void CreateShaderResourceView(D3D12_CPU_DESCRIPTOR_HANDLE descriptor, UINT residentMip);
+
+	// First mip of the packed tail, the pinnedMip for TextureResidency.
+	inline UINT GetPackedMipStart() const { return mPackedMipInfo.NumStandardMips; }
+	inline bool IsMipMapped(UINT mip) const { return mip >= GetPackedMipStart() || mMipHeaps[mip] != nullptr; }
+	inline ID3D12Resource* GetResource() const { return mResource.Get(); }
+
+private:
+	// Upload buffer of one mip, mapped between BeginUpload and EndUpload.
+	struct PendingUpload {
+		Microsoft::WRL::ComPtr<ID3D12Resource> buffer;
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+		UINT rowCount;
+		UINT64 rowSize;
+		UINT64 size;
+	};
+
+	void MapTiles(UINT subresource, UINT tileCount, ID3D12Heap* heap);
+	// Returns where the mip's first row goes in the mapped upload buffer.
+	UINT8* BeginUpload(UINT mip, PendingUpload& pending);
+	// Unmaps and records the copy into mip, the buffer is released later.
+	void EndUpload(ID3D12GraphicsCommandList* commandList, UINT mip, PendingUpload& pending);
+
+	Microsoft::WRL::ComPtr<ID3D12Device2> mDevice;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	DeferredReleaseQueue* mReleaseQueue;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mResource;
+	D3D12_RESOURCE_DESC mDesc;
+
+	D3D12_PACKED_MIP_INFO mPackedMipInfo;
+	std::vector<D3D12_SUBRESOURCE_TILING> mMipTilings;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> mMipHeaps;
+	Microsoft::WRL::ComPtr<ID3D12Heap> mPackedHeap;
+	std::vector<D3D12_RESOURCE_STATES> mMipStates;
+};
@@ -0,0 +1,64 @@
+#include "RingAllocator.h"
+
+#include <cassert>
+
+RingAllocator::RingAllocator() : mSize(0), mHead(0), mTail(0), mAllocated(0), mFreed(0) {
+}
+
+void RingAllocator::Init(uint64_t size){
+	mSize = size;
+	mHead = 0;
+	mTail = 0;
+	mAllocated = 0;
+	mFreed = 0;
+	mFrames.clear();
+}
+
+void RingAllocator::Retire(uint64_t completedFenceValue){
+	while(!mFrames.empty() && mFrames.front().fenceValue <= completedFenceValue){
+		mTail = mFrames.front().head;
+		mFreed = mFrames.front().allocated;
+		mFrames.pop_front();
+	}
+}
+
+void RingAllocator::EndFrame(uint64_t fenceValue){
+	assert(mFrames.empty() || mFrames.back().fenceValue <= fenceValue);
+	mFrames.push_back({ fenceValue, mAllocated, mHead });
+}
+
+bool RingAllocator::Allocate(uint64_t size, uint64_t alignment, uint64_t& offset){
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+	if(GetUsed() == 0){
+		// Nothing in flight, start over at zero so the whole ring is free.
+		// Frames still pending are empty and end there too.
+		mHead = 0;
+		mTail = 0;
+		for(Frame& frame : mFrames){
+			frame.head = 0;
+		}
+	}
+
+	// Free space is [mHead, mSize) plus [0, mTail) while the part in use
+	// does not wrap, and only [mHead, mTail) once it does.
+	const bool wrapped = GetUsed() > 0 && mHead <= mTail;
+	uint64_t start = (mHead + alignment - 1) & ~(alignment - 1);
+	if(start + size > (wrapped ? mTail : mSize)){
+		if(wrapped || size > mTail){
+			return false;
+		}
+		// Skip the rest of the ring and start over at zero.
+		mAllocated += mSize - mHead;
+		mHead = 0;
+		start = 0;
+	}
+
+	mAllocated += start + size - mHead;
+	mHead = start + size;
+	if(mHead == mSize){
+		mHead = 0;
+	}
+	offset = start;
+	return true;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+// Offsets into a fixed size ring whose space is handed back per frame once
+// the GPU is done with it. Every allocation made between two EndFrame calls
+// is freed together, when the fence value given to EndFrame has completed.
+// Allocations never straddle the end, the tail is skipped instead.
+class RingAllocator {
+public:
+	RingAllocator();
+
+	void Init(uint64_t size);
+
+	// Frees the frames whose fence value is at most completedFenceValue.
+	void Retire(uint64_t completedFenceValue);
+	// Everything allocated since the last EndFrame stays in use until
+	// fenceValue completes.
+	void EndFrame(uint64_t fenceValue);
+
+	// Returns false when the ring has no room left for size contiguous bytes
+	// aligned to alignment, a power of two.
+	bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+
+	inline uint64_t GetSize() const { return mSize; }
+	inline uint64_t GetUsed() const { return mAllocated - mFreed; }
+
+private:
+	struct Frame {
+		uint64_t fenceValue;
+		// mAllocated and mHead when the frame ended.
+		uint64_t allocated;
+		uint64_t head;
+	};
+
+	uint64_t mSize;
+	// Next free byte, and the first byte still in use when something is.
+	uint64_t mHead;
+	uint64_t mTail;
+	// Running byte counts, skipped tails included. Their difference is what
+	// is in use, which tells a full ring from an empty one.
+	uint64_t mAllocated;
+	uint64_t mFreed;
+	std::deque<Frame> mFrames;
+};
@@ -0,0 +1,598 @@
+// Bit exact results across paths need every multiply and add rounded on its
+// own, even though the project builds with /fp:fast.
+#if defined(_MSC_VER)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "SoftwareOcclusion.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// Occluder triangles set up and binned per job.
+	const uint32_t kChunkTriangles = 1024;
+	// Occludees per job, below this many the test runs inline.
+	const uint32_t kOccludeeChunk = 2048;
+	// Clip space w below this counts as behind the camera.
+	const float kMinW = 1e-5f;
+	// Triangles are clipped to this many viewports around the screen, which
+	// keeps pixel coordinates small enough for float edge functions.
+	const float kGuardBand = 4.0f;
+	// The near plane plus the four guard band planes can add one vertex each.
+	const int kMaxClipVertices = 3 + 5;
+
+	typedef std::chrono::high_resolution_clock Clock;
+
+	double MillisecondsSince(Clock::time_point start){
+		return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+	}
+
+	// Signed distance to clip plane p, positive inside.
+	inline float ClipDistance(const Float4& v, int plane){
+		switch(plane){
+			case 0: return v.z;
+			case 1: return kGuardBand * v.w - v.x;
+			case 2: return kGuardBand * v.w + v.x;
+			case 3: return kGuardBand * v.w - v.y;
+			default: return kGuardBand * v.w + v.y;
+		}
+	}
+
+	// Sutherland-Hodgman against one plane, returns the new vertex count.
+	int ClipAgainstPlane(const Float4* in, int count, Float4* out, int plane){
+		int outCount = 0;
+		for(int i = 0; i < count; i++){
+			const Float4& a = in[i];
+			const Float4& b = in[(i + 1) % count];
+			const float da = ClipDistance(a, plane);
+			const float db = ClipDistance(b, plane);
+			if(da >= 0.0f){
+				out[outCount++] = a;
+			}
+			if((da >= 0.0f) != (db >= 0.0f)){
+				const float t = da / (da - db);
+				out[outCount++] = { a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t, a.w + (b.w - a.w) * t };
+			}
+		}
+		return outCount;
+	}
+
+	struct ScreenVertex {
+		float x;
+		float y;
+		float z;
+	};
+
+	// Returns false for triangles that cover no pixel center or face away.
+	bool SetupTriangle(ScreenVertex v0, ScreenVertex v1, ScreenVertex v2, bool twoSided, int width, int height, SoftwareOcclusion::Triangle& triangle){
+		// Clockwise on screen is positive with y pointing down.
+		double area = (static_cast<double>(v1.x) - v0.x) * (static_cast<double>(v2.y) - v0.y) - (static_cast<double>(v2.x) - v0.x) * (static_cast<double>(v1.y) - v0.y);
+		if(!(area != 0.0)){
+			return false;
+		}
+		if(area < 0.0){
+			if(!twoSided){
+				return false;
+			}
+			std::swap(v1, v2);
+			area = -area;
+		}
+
+		// Pixels whose center lies inside the bounds.
+		const float minX = std::min(std::min(v0.x, v1.x), v2.x);
+		const float maxX = std::max(std::max(v0.x, v1.x), v2.x);
+		const float minY = std::min(std::min(v0.y, v1.y), v2.y);
+		const float maxY = std::max(std::max(v0.y, v1.y), v2.y);
+		triangle.minX = std::max(0, static_cast<int>(std::ceil(minX - 0.5f)));
+		triangle.maxX = std::min(width - 1, static_cast<int>(std::floor(maxX - 0.5f)));
+		triangle.minY = std::max(0, static_cast<int>(std::ceil(minY - 0.5f)));
+		triangle.maxY = std::min(height - 1, static_cast<int>(std::floor(maxY - 0.5f)));
+		if(triangle.minX > triangle.maxX || triangle.minY > triangle.maxY){
+			return false;
+		}
+
+		const ScreenVertex vertices[3] = { v0, v1, v2 };
+		for(int e = 0; e < 3; e++){
+			const ScreenVertex& a = vertices[e];
+			const ScreenVertex& b = vertices[(e + 1) % 3];
+			const double edgeA = static_cast<double>(a.y) - b.y;
+			const double edgeB = static_cast<double>(b.x) - a.x;
+			triangle.edgeA[e] = static_cast<float>(edgeA);
+			triangle.edgeB[e] = static_cast<float>(edgeB);
+			triangle.edgeC[e] = static_cast<float>(-(edgeA * a.x + edgeB * a.y));
+		}
+
+		const double dx1 = static_cast<double>(v1.x) - v0.x, dy1 = static_cast<double>(v1.y) - v0.y, dz1 = static_cast<double>(v1.z) - v0.z;
+		const double dx2 = static_cast<double>(v2.x) - v0.x, dy2 = static_cast<double>(v2.y) - v0.y, dz2 = static_cast<double>(v2.z) - v0.z;
+		const double depthA = (dz1 * dy2 - dz2 * dy1) / area;
+		const double depthB = (dx1 * dz2 - dx2 * dz1) / area;
+		triangle.depthA = static_cast<float>(depthA);
+		triangle.depthB = static_cast<float>(depthB);
+		triangle.depthC = static_cast<float>(v0.z - depthA * v0.x - depthB * v0.y);
+		return true;
+	}
+
+	// Keeps the nearer depth on every pixel of [x0, x1] x [y0, y1] whose
+	// center is inside t. x0 and x1 + 1 are multiples of 8.
+	void RasterizeScalar(const SoftwareOcclusion::Triangle& t, float* depth, int width, int x0, int x1, int y0, int y1){
+		for(int y = y0; y <= y1; y++){
+			const float py = static_cast<float>(y) + 0.5f;
+			float* row = depth + y * width;
+			for(int x = x0; x <= x1; x++){
+				const float px = static_cast<float>(x) + 0.5f;
+				const float e0 = (t.edgeA[0] * px + t.edgeB[0] * py) + t.edgeC[0];
+				const float e1 = (t.edgeA[1] * px + t.edgeB[1] * py) + t.edgeC[1];
+				const float e2 = (t.edgeA[2] * px + t.edgeB[2] * py) + t.edgeC[2];
+				if(e0 >= 0.0f && e1 >= 0.0f && e2 >= 0.0f){
+					const float z = (t.depthA * px + t.depthB * py) + t.depthC;
+					row[x] = z < row[x] ? z : row[x];
+				}
+			}
+		}
+	}
+
+	bool IsRectVisibleScalar(const float* depth, int width, int minX, int minY, int maxX, int maxY, float nearestDepth){
+		for(int y = minY; y <= maxY; y++){
+			const float* row = depth + y * width;
+			for(int x = minX; x <= maxX; x++){
+				if(row[x] >= nearestDepth){
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	#if defined(CPU_X86)
+	SIMD_TARGET_AVX2 void RasterizeAVX2(const SoftwareOcclusion::Triangle& t, float* depth, int width, int x0, int x1, int y0, int y1){
+		const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+		const __m256 zero = _mm256_setzero_ps();
+		__m256 edgeA[3], edgeB[3], edgeC[3];
+		for(int e = 0; e < 3; e++){
+			edgeA[e] = _mm256_set1_ps(t.edgeA[e]);
+			edgeB[e] = _mm256_set1_ps(t.edgeB[e]);
+			edgeC[e] = _mm256_set1_ps(t.edgeC[e]);
+		}
+		const __m256 depthA = _mm256_set1_ps(t.depthA);
+		const __m256 depthB = _mm256_set1_ps(t.depthB);
+		const __m256 depthC = _mm256_set1_ps(t.depthC);
+
+		for(int y = y0; y <= y1; y++){
+			const __m256 py = _mm256_set1_ps(static_cast<float>(y) + 0.5f);
+			__m256 rowTerms[3];
+			for(int e = 0; e < 3; e++){
+				rowTerms[e] = _mm256_mul_ps(edgeB[e], py);
+			}
+			const __m256 depthRow = _mm256_mul_ps(depthB, py);
+
+			float* row = depth + y * width;
+			for(int x = x0; x <= x1; x += 8){
+				const __m256 px = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), laneOffsets);
+				__m256 inside = _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[0], px), rowTerms[0]), edgeC[0]), zero, _CMP_GE_OQ);
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[1], px), rowTerms[1]), edgeC[1]), zero, _CMP_GE_OQ));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(edgeA[2], px), rowTerms[2]), edgeC[2]), zero, _CMP_GE_OQ));
+				if(_mm256_movemask_ps(inside) == 0){
+					continue;
+				}
+
+				const __m256 z = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(depthA, px), depthRow), depthC);
+				const __m256 current = _mm256_loadu_ps(row + x);
+				_mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(z, current), inside));
+			}
+		}
+	}
+
+	SIMD_TARGET_AVX2 bool IsRectVisibleAVX2(const float* depth, int width, int minX, int minY, int maxX, int maxY, float nearestDepth){
+		const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+		const __m256i first = _mm256_set1_epi32(minX - 1);
+		const __m256i last = _mm256_set1_epi32(maxX + 1);
+		const __m256 nearest = _mm256_set1_ps(nearestDepth);
+		const int startX = minX & ~7;
+
+		for(int y = minY; y <= maxY; y++){
+			const float* row = depth + y * width;
+			for(int x = startX; x <= maxX; x += 8){
+				const __m256i columns = _mm256_add_epi32(_mm256_set1_epi32(x), laneIndices);
+				const __m256i inRect = _mm256_and_si256(_mm256_cmpgt_epi32(columns, first), _mm256_cmpgt_epi32(last, columns));
+				const __m256 farther = _mm256_cmp_ps(_mm256_loadu_ps(row + x), nearest, _CMP_GE_OQ);
+				if(_mm256_movemask_ps(_mm256_and_ps(farther, _mm256_castsi256_ps(inRect))) != 0){
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+	#endif
+}
+
+SoftwareOcclusion::SoftwareOcclusion() :mWidth(0), mHeight(0), mTilesX(0), mTilesY(0), mPath(OcclusionPath::Auto), mViewProjection(Float4x4::Identity()) {
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+SoftwareOcclusion::~SoftwareOcclusion() {
+
+}
+
+void SoftwareOcclusion::Resize(uint32_t width, uint32_t height){
+	mTilesX = std::max(1u, (width + TileWidth - 1) / TileWidth);
+	mTilesY = std::max(1u, (height + TileHeight - 1) / TileHeight);
+	mWidth = mTilesX * TileWidth;
+	mHeight = mTilesY * TileHeight;
+	mDepth.assign(mWidth * mHeight, 1.0f);
+}
+
+void SoftwareOcclusion::BeginFrame(const Float4x4& viewProjection){
+	mViewProjection = viewProjection;
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+	mOccluders.clear();
+	memset(&mStats, 0, sizeof(mStats));
+}
+
+void SoftwareOcclusion::AddOccluder(const OccluderMesh& mesh){
+	if(mesh.indexCount >= 3 && mesh.vertexCount > 0){
+		mOccluders.push_back(mesh);
+	}
+}
+
+OcclusionPath SoftwareOcclusion::ResolvePath() const{
+	OcclusionPath path = mPath == OcclusionPath::Auto ? GetBestOcclusionPath() : mPath;
+	if(path == OcclusionPath::AVX2 && !CpuFeatures::Get().avx2){
+		path = OcclusionPath::Scalar;
+	}
+	return path;
+}
+
+void SoftwareOcclusion::RasterizeOccluders(){
+	const Clock::time_point start = Clock::now();
+	const uint32_t occluderCount = static_cast<uint32_t>(mOccluders.size());
+
+	mVertexOffsets.resize(occluderCount);
+	mTriangleOffsets.resize(occluderCount + 1);
+	uint32_t vertexCount = 0;
+	mTriangleOffsets[0] = 0;
+	for(uint32_t i = 0; i < occluderCount; i++){
+		mVertexOffsets[i] = vertexCount;
+		vertexCount += mOccluders[i].vertexCount;
+		mTriangleOffsets[i + 1] = mTriangleOffsets[i] + mOccluders[i].indexCount / 3;
+	}
+	const uint32_t triangleCount = mTriangleOffsets[occluderCount];
+	mStats.occluderTriangles = triangleCount;
+
+	JobSystem* jobs = JobSystem::GetInstance();
+
+	// Vertices to clip space, once per occluder.
+	mClipVertices.resize(vertexCount);
+	jobs->ParallelFor(occluderCount, 1, [this](uint32_t begin, uint32_t end){
+		for(uint32_t i = begin; i < end; i++){
+			const OccluderMesh& mesh = mOccluders[i];
+			const Float4x4 worldViewProjection = Multiply(mesh.world, mViewProjection);
+			TransformPoints(worldViewProjection, mesh.positions, mClipVertices.data() + mVertexOffsets[i], mesh.vertexCount);
+		}
+	});
+
+	// Set up and bin each chunk of triangles on its own.
+	const uint32_t chunkCount = (triangleCount + kChunkTriangles - 1) / kChunkTriangles;
+	mChunks.resize(chunkCount);
+	jobs->ParallelFor(chunkCount, 1, [this](uint32_t begin, uint32_t end){
+		for(uint32_t chunk = begin; chunk < end; chunk++){
+			SetupChunk(chunk);
+			BinChunk(mChunks[chunk]);
+		}
+	});
+
+	for(uint32_t chunk = 0; chunk < chunkCount; chunk++){
+		mStats.rasterizedTriangles += static_cast<uint32_t>(mChunks[chunk].triangles.size());
+	}
+
+	// Every tile owns its pixels, so tiles need no synchronization.
+	if(chunkCount > 0){
+		const OcclusionPath path = ResolvePath();
+		jobs->ParallelFor(mTilesX * mTilesY, 1, [this, path](uint32_t begin, uint32_t end){
+			for(uint32_t tile = begin; tile < end; tile++){
+				RasterizeTile(tile, path);
+			}
+		});
+	}
+
+	mStats.rasterizeMilliseconds = MillisecondsSince(start);
+}
+
+void SoftwareOcclusion::SetupChunk(uint32_t chunkIndex){
+	Chunk& chunk = mChunks[chunkIndex];
+	chunk.triangles.clear();
+
+	const uint32_t first = chunkIndex * kChunkTriangles;
+	const uint32_t last = std::min(first + kChunkTriangles, mTriangleOffsets.back());
+	const int width = static_cast<int>(mWidth);
+	const int height = static_cast<int>(mHeight);
+	const float halfWidth = 0.5f * static_cast<float>(mWidth);
+	const float halfHeight = 0.5f * static_cast<float>(mHeight);
+
+	// Occluder owning the first triangle of the chunk.
+	uint32_t occluder = static_cast<uint32_t>(std::upper_bound(mTriangleOffsets.begin(), mTriangleOffsets.end(), first) - mTriangleOffsets.begin()) - 1;
+
+	for(uint32_t triangleIndex = first; triangleIndex < last; triangleIndex++){
+		while(triangleIndex >= mTriangleOffsets[occluder + 1]){
+			occluder++;
+		}
+		const OccluderMesh& mesh = mOccluders[occluder];
+		const Float4* clipVertices = mClipVertices.data() + mVertexOffsets[occluder];
+		const uint32_t* indices = mesh.indices + (triangleIndex - mTriangleOffsets[occluder]) * 3;
+		if(indices[0] >= mesh.vertexCount || indices[1] >= mesh.vertexCount || indices[2] >= mesh.vertexCount){
+			continue;
+		}
+
+		Float4 polygon[kMaxClipVertices];
+		Float4 scratch[kMaxClipVertices];
+		polygon[0] = clipVertices[indices[0]];
+		polygon[1] = clipVertices[indices[1]];
+		polygon[2] = clipVertices[indices[2]];
+		int count = 3;
+
+		// Entirely off one side of the viewport or behind the far plane.
+		bool rejected = false;
+		int outsideMask = 0;
+		for(int plane = 0; plane < 5; plane++){
+			int outsideCount = 0;
+			for(int v = 0; v < 3; v++){
+				outsideCount += ClipDistance(polygon[v], plane) < 0.0f ? 1 : 0;
+			}
+			rejected |= outsideCount == 3;
+			outsideMask |= outsideCount > 0 ? 1 << plane : 0;
+		}
+		if(rejected || (polygon[0].x > polygon[0].w && polygon[1].x > polygon[1].w && polygon[2].x > polygon[2].w)
+			|| (polygon[0].x < -polygon[0].w && polygon[1].x < -polygon[1].w && polygon[2].x < -polygon[2].w)
+			|| (polygon[0].y > polygon[0].w && polygon[1].y > polygon[1].w && polygon[2].y > polygon[2].w)
+			|| (polygon[0].y < -polygon[0].w && polygon[1].y < -polygon[1].w && polygon[2].y < -polygon[2].w)
+			|| (polygon[0].z > polygon[0].w && polygon[1].z > polygon[1].w && polygon[2].z > polygon[2].w)){
+			continue;
+		}
+
+		// Only the planes a vertex is actually outside of cost anything.
+		for(int plane = 0; plane < 5 && count >= 3; plane++){
+			if(outsideMask & (1 << plane)){
+				count = ClipAgainstPlane(polygon, count, scratch, plane);
+				memcpy(polygon, scratch, count * sizeof(Float4));
+			}
+		}
+		if(count < 3){
+			continue;
+		}
+
+		ScreenVertex screen[kMaxClipVertices];
+		bool valid = true;
+		for(int v = 0; v < count; v++){
+			if(polygon[v].w < kMinW){
+				valid = false;
+				break;
+			}
+			const float invW = 1.0f / polygon[v].w;
+			screen[v].x = (polygon[v].x * invW + 1.0f) * halfWidth;
+			screen[v].y = (1.0f - polygon[v].y * invW) * halfHeight;
+			screen[v].z = polygon[v].z * invW;
+		}
+		if(!valid){
+			continue;
+		}
+
+		// Clipping keeps the winding, so the fan does too.
+		for(int v = 1; v + 1 < count; v++){
+			Triangle triangle;
+			if(SetupTriangle(screen[0], screen[v], screen[v + 1], mesh.twoSided, width, height, triangle)){
+				chunk.triangles.push_back(triangle);
+			}
+		}
+	}
+}
+
+void SoftwareOcclusion::BinChunk(Chunk& chunk){
+	const uint32_t tileCount = mTilesX * mTilesY;
+	chunk.binOffsets.assign(tileCount + 1, 0);
+
+	// Count, prefix sum, then fill: two passes but no per tile allocations.
+	for(const Triangle& triangle : chunk.triangles){
+		for(int ty = triangle.minY / static_cast<int>(TileHeight); ty <= triangle.maxY / static_cast<int>(TileHeight); ty++){
+			for(int tx = triangle.minX / static_cast<int>(TileWidth); tx <= triangle.maxX / static_cast<int>(TileWidth); tx++){
+				chunk.binOffsets[ty * mTilesX + tx + 1]++;
+			}
+		}
+	}
+	for(uint32_t tile = 0; tile < tileCount; tile++){
+		chunk.binOffsets[tile + 1] += chunk.binOffsets[tile];
+	}
+
+	chunk.binTriangles.resize(chunk.binOffsets[tileCount]);
+	std::vector<uint32_t> cursor(chunk.binOffsets.begin(), chunk.binOffsets.end() - 1);
+	for(uint32_t i = 0; i < chunk.triangles.size(); i++){
+		const Triangle& triangle = chunk.triangles[i];
+		for(int ty = triangle.minY / static_cast<int>(TileHeight); ty <= triangle.maxY / static_cast<int>(TileHeight); ty++){
+			for(int tx = triangle.minX / static_cast<int>(TileWidth); tx <= triangle.maxX / static_cast<int>(TileWidth); tx++){
+				chunk.binTriangles[cursor[ty * mTilesX + tx]++] = i;
+			}
+		}
+	}
+}
+
+void SoftwareOcclusion::RasterizeTile(uint32_t tile, OcclusionPath path){
+	const int tileX = static_cast<int>((tile % mTilesX) * TileWidth);
+	const int tileY = static_cast<int>((tile / mTilesX) * TileHeight);
+	const int width = static_cast<int>(mWidth);
+
+	for(const Chunk& chunk : mChunks){
+		for(uint32_t bin = chunk.binOffsets[tile]; bin < chunk.binOffsets[tile + 1]; bin++){
+			const Triangle& triangle = chunk.triangles[chunk.binTriangles[bin]];
+			// Whole groups of 8 so both kernels cover the same pixels.
+			const int x0 = std::max(triangle.minX, tileX) & ~7;
+			const int x1 = std::min(triangle.maxX, tileX + static_cast<int>(TileWidth) - 1) | 7;
+			const int y0 = std::max(triangle.minY, tileY);
+			const int y1 = std::min(triangle.maxY, tileY + static_cast<int>(TileHeight) - 1);
+
+			#if defined(CPU_X86)
+			if(path == OcclusionPath::AVX2){
+				RasterizeAVX2(triangle, mDepth.data(), width, x0, x1, y0, y1);
+				continue;
+			}
+			#endif
+			RasterizeScalar(triangle, mDepth.data(), width, x0, x1, y0, y1);
+		}
+	}
+}
+
+bool SoftwareOcclusion::IsRectVisible(int minX, int minY, int maxX, int maxY, float nearestDepth, OcclusionPath path) const{
+	#if defined(CPU_X86)
+	if(path == OcclusionPath::AVX2){
+		return IsRectVisibleAVX2(mDepth.data(), static_cast<int>(mWidth), minX, minY, maxX, maxY, nearestDepth);
+	}
+	#endif
+	return IsRectVisibleScalar(mDepth.data(), static_cast<int>(mWidth), minX, minY, maxX, maxY, nearestDepth);
+}
+
+bool SoftwareOcclusion::IsAabbVisible(const float boxMin[3], const float boxMax[3]) const{
+	if(mDepth.empty()){
+		return true;
+	}
+
+	float minX = 0.0f, maxX = 0.0f, minY = 0.0f, maxY = 0.0f, nearest = 0.0f;
+	const float (*m)[4] = mViewProjection.m;
+	for(int corner = 0; corner < 8; corner++){
+		const float x = (corner & 1) ? boxMax[0] : boxMin[0];
+		const float y = (corner & 2) ? boxMax[1] : boxMin[1];
+		const float z = (corner & 4) ? boxMax[2] : boxMin[2];
+		const float clipX = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+		const float clipY = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+		const float clipZ = x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2];
+		const float clipW = x * m[0][3] + y * m[1][3] + z * m[2][3] + m[3][3];
+		if(clipW < kMinW){
+			return true;
+		}
+
+		const float invW = 1.0f / clipW;
+		const float screenX = (clipX * invW + 1.0f) * 0.5f * static_cast<float>(mWidth);
+		const float screenY = (1.0f - clipY * invW) * 0.5f * static_cast<float>(mHeight);
+		const float depth = clipZ * invW;
+		minX = corner == 0 ? screenX : std::min(minX, screenX);
+		maxX = corner == 0 ? screenX : std::max(maxX, screenX);
+		minY = corner == 0 ? screenY : std::min(minY, screenY);
+		maxY = corner == 0 ? screenY : std::max(maxY, screenY);
+		nearest = corner == 0 ? depth : std::min(nearest, depth);
+	}
+	if(nearest <= 0.0f){
+		return true;
+	}
+
+	// Every pixel the rectangle touches, not only those whose center it covers.
+	const int width = static_cast<int>(mWidth);
+	const int height = static_cast<int>(mHeight);
+	const int x0 = std::max(0, static_cast<int>(std::floor(minX)));
+	const int x1 = std::min(width - 1, static_cast<int>(std::floor(maxX)));
+	const int y0 = std::max(0, static_cast<int>(std::floor(minY)));
+	const int y1 = std::min(height - 1, static_cast<int>(std::floor(maxY)));
+	if(x0 > x1 || y0 > y1){
+		// Off screen, leave it to frustum culling.
+		return true;
+	}
+
+	return IsRectVisible(x0, y0, x1, y1, nearest, ResolvePath());
+}
+
+void SoftwareOcclusion::CullOccludees(const AabbBoundsSoA& bounds, const uint32_t* candidates, uint32_t count, std::vector<uint32_t>& visible){
+	const Clock::time_point start = Clock::now();
+	visible.resize(count);
+
+	auto testRange = [&](uint32_t begin, uint32_t end, uint32_t* out){
+		uint32_t visibleCount = 0;
+		for(uint32_t i = begin; i < end; i++){
+			const uint32_t index = candidates[i];
+			const float boxMin[3] = { bounds.centerX[index] - bounds.extentX[index], bounds.centerY[index] - bounds.extentY[index], bounds.centerZ[index] - bounds.extentZ[index] };
+			const float boxMax[3] = { bounds.centerX[index] + bounds.extentX[index], bounds.centerY[index] + bounds.extentY[index], bounds.centerZ[index] + bounds.extentZ[index] };
+			if(IsAabbVisible(boxMin, boxMax)){
+				out[visibleCount++] = index;
+			}
+		}
+		return visibleCount;
+	};
+
+	uint32_t total = 0;
+	if(count <= kOccludeeChunk){
+		total = testRange(0, count, visible.data());
+	}else{
+		// Same packing as frustum culling: each chunk fills its own slice,
+		// the slices are then moved together so the output keeps its order.
+		const uint32_t chunkCount = (count + kOccludeeChunk - 1) / kOccludeeChunk;
+		std::vector<uint32_t> chunkVisible(chunkCount);
+		JobSystem::GetInstance()->ParallelFor(chunkCount, 1, [&](uint32_t first, uint32_t last){
+			for(uint32_t chunk = first; chunk < last; chunk++){
+				const uint32_t begin = chunk * kOccludeeChunk;
+				chunkVisible[chunk] = testRange(begin, std::min(count, begin + kOccludeeChunk), visible.data() + begin);
+			}
+		});
+
+		total = chunkVisible[0];
+		for(uint32_t chunk = 1; chunk < chunkCount; chunk++){
+			memmove(visible.data() + total, visible.data() + chunk * kOccludeeChunk, chunkVisible[chunk] * sizeof(uint32_t));
+			total += chunkVisible[chunk];
+		}
+	}
+	visible.resize(total);
+
+	mStats.testedOccludees += count;
+	mStats.culledOccludees += count - total;
+	mStats.testMilliseconds += MillisecondsSince(start);
+}
+
+void SelectOccluders(const OccluderCandidate* candidates, uint32_t count, const float cameraPosition[3], float projectionScale,
+	float minScreenRadius, uint32_t triangleBudget, std::vector<uint32_t>& selected){
+	selected.clear();
+
+	std::vector<std::pair<float, uint32_t>> ranked;
+	uint32_t triangles = 0;
+	for(uint32_t i = 0; i < count; i++){
+		const OccluderCandidate& candidate = candidates[i];
+		if(candidate.marked){
+			selected.push_back(i);
+			triangles += candidate.triangleCount;
+			continue;
+		}
+
+		const float dx = candidate.center[0] - cameraPosition[0];
+		const float dy = candidate.center[1] - cameraPosition[1];
+		const float dz = candidate.center[2] - cameraPosition[2];
+		const float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+		// Inside the bounds it covers the screen.
+		const float screenRadius = distance > candidate.radius ? candidate.radius * projectionScale / distance : 1e30f;
+		if(screenRadius >= minScreenRadius){
+			ranked.push_back({ screenRadius, i });
+		}
+	}
+
+	std::sort(ranked.begin(), ranked.end(), [](const std::pair<float, uint32_t>& a, const std::pair<float, uint32_t>& b){
+		return a.first > b.first || (a.first == b.first && a.second < b.second);
+	});
+	for(const std::pair<float, uint32_t>& entry : ranked){
+		const uint32_t cost = candidates[entry.second].triangleCount;
+		if(triangles + cost > triangleBudget){
+			continue;
+		}
+		selected.push_back(entry.second);
+		triangles += cost;
+	}
+}
+
+OcclusionPath GetBestOcclusionPath(){
+	return CpuFeatures::Get().avx2 ? OcclusionPath::AVX2 : OcclusionPath::Scalar;
+}
@@ -0,0 +1,142 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "FrustumCulling.h"
+#include "MathBatch.h"
+
+// CPU occlusion culling for when GPU feedback arrives too late. A few large
+// occluder meshes are rasterized into a small depth buffer, then occludee
+// boxes are tested against it before their draws are emitted. Depth is the
+// D3D [0, 1] range, nearest wins.
+//
+// The screen is split into tiles. Triangles are set up and binned into the
+// tiles in parallel chunks, then every tile is rasterized by one job, eight
+// pixels at a time on AVX2. Every path writes bit-identical depth.
+
+// Which kernels rasterize and test. Auto picks the widest the CPU supports.
+enum class OcclusionPath { Auto, Scalar, AVX2 };
+
+// Indexed triangle list placed in the world. Winding is clockwise for front
+// faces like the D3D default, back faces are skipped unless twoSided is set.
+struct OccluderMesh {
+	const Float3* positions;
+	uint32_t vertexCount;
+	const uint32_t* indices;
+	uint32_t indexCount;
+	Float4x4 world;
+	bool twoSided;
+};
+
+// Input of SelectOccluders, one per object that could occlude.
+struct OccluderCandidate {
+	float center[3];
+	float radius;
+	uint32_t triangleCount;
+	// Artist marked occluders are always taken.
+	bool marked;
+};
+
+struct OcclusionStats {
+	uint32_t occluderTriangles;
+	// Triangles that reached the tiles after culling and clipping.
+	uint32_t rasterizedTriangles;
+	uint32_t testedOccludees;
+	uint32_t culledOccludees;
+	double rasterizeMilliseconds;
+	double testMilliseconds;
+};
+
+class SoftwareOcclusion {
+public:
+	static const uint32_t TileWidth = 32;
+	static const uint32_t TileHeight = 8;
+
+	SoftwareOcclusion();
+	~SoftwareOcclusion();
+
+	// Rounded up to whole tiles. The whole buffer maps to the viewport.
+	void Resize(uint32_t width, uint32_t height);
+	inline void SetPath(OcclusionPath path) { mPath = path; }
+
+	// Clears depth to far and drops the occluders of the last frame.
+	// viewProjection is row vector, like the rest of the renderer.
+	void BeginFrame(const Float4x4& viewProjection);
+	// The mesh data must stay alive until RasterizeOccluders returns.
+	void AddOccluder(const OccluderMesh& mesh);
+	// Transforms, clips, bins and rasterizes every occluder added this frame.
+	void RasterizeOccluders();
+
+	// True unless every pixel under the projected box is nearer than the
+	// box. Boxes crossing the near plane are always visible.
+	bool IsAabbVisible(const float boxMin[3], const float boxMax[3]) const;
+	// Writes the candidates whose box is visible to visible, in order.
+	// Large inputs are split across the JobSystem workers.
+	void CullOccludees(const AabbBoundsSoA& bounds, const uint32_t* candidates, uint32_t count, std::vector<uint32_t>& visible);
+
+	inline const float* GetDepth() const { return mDepth.data(); }
+	inline uint32_t GetWidth() const { return mWidth; }
+	inline uint32_t GetHeight() const { return mHeight; }
+	inline const OcclusionStats& GetStats() const { return mStats; }
+
+public:
+	// Screen space triangle ready for the tiles. Edge and depth values are
+	// plane equations a * x + b * y + c over pixel centers.
+	struct Triangle {
+		float edgeA[3];
+		float edgeB[3];
+		float edgeC[3];
+		float depthA;
+		float depthB;
+		float depthC;
+		// Inclusive pixel bounds, already clamped to the buffer.
+		int minX;
+		int minY;
+		int maxX;
+		int maxY;
+	};
+
+	// Set up triangles of one range of the occluder triangles, binned by tile.
+	struct Chunk {
+		std::vector<Triangle> triangles;
+		// Triangle indices of tile t are binTriangles[binOffsets[t], binOffsets[t + 1]).
+		std::vector<uint32_t> binOffsets;
+		std::vector<uint32_t> binTriangles;
+	};
+
+private:
+	void SetupChunk(uint32_t chunkIndex);
+	void BinChunk(Chunk& chunk);
+	void RasterizeTile(uint32_t tile, OcclusionPath path);
+	bool IsRectVisible(int minX, int minY, int maxX, int maxY, float nearestDepth, OcclusionPath path) const;
+	OcclusionPath ResolvePath() const;
+
+private:
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mTilesX;
+	uint32_t mTilesY;
+	OcclusionPath mPath;
+
+	Float4x4 mViewProjection;
+	std::vector<float> mDepth;
+
+	std::vector<OccluderMesh> mOccluders;
+	// Clip space vertices of every occluder, mVertexOffsets[i] is where occluder i starts.
+	std::vector<Float4> mClipVertices;
+	std::vector<uint32_t> mVertexOffsets;
+	// Running triangle count, occluder i owns [mTriangleOffsets[i], mTriangleOffsets[i + 1]).
+	std::vector<uint32_t> mTriangleOffsets;
+	std::vector<Chunk> mChunks;
+
+	OcclusionStats mStats;
+};
+
+// Artist marked candidates first, then the rest ranked by projected radius,
+// largest first, taking those of at least minScreenRadius pixels while the
+// triangle budget lasts. projectionScale is ComputeProjectionScale's.
+void SelectOccluders(const OccluderCandidate* candidates, uint32_t count, const float cameraPosition[3], float projectionScale,
+	float minScreenRadius, uint32_t triangleBudget, std::vector<uint32_t>& selected);
+
+OcclusionPath GetBestOcclusionPath();
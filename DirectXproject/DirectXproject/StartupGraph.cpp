@@ -0,0 +1,132 @@
+#include "StartupGraph.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "JobSystem.h"
+
+StartupGraph::StartupGraph() : mTotalMilliseconds(0.0), mFinished(0) {
+
+}
+
+StartupGraph::Stage StartupGraph::Add(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies){
+	return AddStage(name, std::move(func), dependencies, false);
+}
+
+StartupGraph::Stage StartupGraph::AddMainThread(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies){
+	return AddStage(name, std::move(func), dependencies, true);
+}
+
+StartupGraph::Stage StartupGraph::AddStage(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies, bool mainThread){
+	Stage stage = static_cast<Stage>(mStages.size());
+
+	StageInfo info;
+	info.name = name;
+	info.func = std::move(func);
+	info.mainThread = mainThread;
+	info.waitingOn = static_cast<uint32_t>(dependencies.size());
+	info.skipped = false;
+	info.failed = false;
+	info.startMilliseconds = 0.0;
+	info.endMilliseconds = 0.0;
+	mStages.push_back(std::move(info));
+
+	for(Stage dependency : dependencies){
+		mStages[dependency].dependents.push_back(stage);
+	}
+	return stage;
+}
+
+void StartupGraph::Schedule(Stage stage){
+	if(mStages[stage].mainThread){
+		mMainThreadReady.push_back(stage);
+		mChanged.notify_all();
+	}else{
+		JobSystem::GetInstance()->Submit([this, stage]{ Execute(stage); });
+	}
+}
+
+void StartupGraph::Execute(Stage stage){
+	StageInfo& info = mStages[stage];
+	bool skip;
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		skip = mError != nullptr;
+	}
+
+	info.startMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - mStart).count();
+	std::exception_ptr error;
+	if(!skip){
+		try{
+			info.func();
+		} catch(...){
+			error = std::current_exception();
+		}
+	}
+	info.endMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - mStart).count();
+
+	std::lock_guard<std::mutex> lock(mMutex);
+	info.skipped = skip;
+	info.failed = error != nullptr;
+	if(error && !mError){
+		mError = error;
+	}
+	for(Stage dependent : info.dependents){
+		if(--mStages[dependent].waitingOn == 0){
+			Schedule(dependent);
+		}
+	}
+	mFinished++;
+	mChanged.notify_all();
+}
+
+void StartupGraph::Run(){
+	mStart = Clock::now();
+	mFinished = 0;
+	mError = nullptr;
+	mMainThreadReady.clear();
+
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		for(Stage stage = 0; stage < mStages.size(); stage++){
+			if(mStages[stage].waitingOn == 0){
+				Schedule(stage);
+			}
+		}
+	}
+
+	// Run main thread stages as they become ready until everything is done.
+	while(true){
+		Stage stage;
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+			mChanged.wait(lock, [this]{ return !mMainThreadReady.empty() || mFinished == mStages.size(); });
+			if(mMainThreadReady.empty()){
+				break;
+			}
+			stage = mMainThreadReady.front();
+			mMainThreadReady.erase(mMainThreadReady.begin());
+		}
+		Execute(stage);
+	}
+
+	mTotalMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - mStart).count();
+	if(mError){
+		std::rethrow_exception(mError);
+	}
+}
+
+void StartupGraph::PrintReport() const {
+	std::vector<Stage> order(mStages.size());
+	for(Stage stage = 0; stage < order.size(); stage++){
+		order[stage] = stage;
+	}
+	std::sort(order.begin(), order.end(), [this](Stage a, Stage b){ return mStages[a].startMilliseconds < mStages[b].startMilliseconds; });
+
+	printf("Startup: %.2f ms\n", mTotalMilliseconds);
+	for(Stage stage : order){
+		const StageInfo& info = mStages[stage];
+		printf("  %-20s %8.2f -> %8.2f ms %8.2f ms%s%s%s\n", info.name.c_str(), info.startMilliseconds, info.endMilliseconds,
+			info.endMilliseconds - info.startMilliseconds, info.mainThread ? " main" : "", info.skipped ? " skipped" : "", info.failed ? " failed" : "");
+	}
+}
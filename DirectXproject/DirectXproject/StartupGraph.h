@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Startup work as a graph of named stages. A stage runs once all of its
+// dependencies have finished, on the JobSystem unless it is marked for the
+// main thread (window and swap chain creation), so independent work such as
+// shader compilation overlaps device creation. Every stage is timed for
+// the startup report.
+class StartupGraph {
+public:
+	typedef uint32_t Stage;
+
+	StartupGraph();
+
+	// Dependencies must have been added before.
+	Stage Add(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies = {});
+	Stage AddMainThread(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies = {});
+
+	// Runs every stage and returns once all have finished, main thread stages
+	// on the calling thread. When a stage throws, stages that have not
+	// started yet are skipped and the first exception is rethrown here,
+	// once everything already running has finished.
+	void Run();
+
+	// One line per stage: start and end since Run, its own time and whether
+	// it failed or was skipped. Also valid after Run threw.
+	void PrintReport() const;
+	inline double GetTotalMilliseconds() const { return mTotalMilliseconds; }
+
+private:
+	typedef std::chrono::high_resolution_clock Clock;
+
+	struct StageInfo {
+		std::string name;
+		std::function<void()> func;
+		bool mainThread;
+		std::vector<Stage> dependents;
+		uint32_t waitingOn;
+		bool skipped;
+		bool failed;
+		double startMilliseconds;
+		double endMilliseconds;
+	};
+
+	Stage AddStage(const char* name, std::function<void()> func, std::initializer_list<Stage> dependencies, bool mainThread);
+	// Called with mMutex held.
+	void Schedule(Stage stage);
+	void Execute(Stage stage);
+
+	std::vector<StageInfo> mStages;
+	Clock::time_point mStart;
+	double mTotalMilliseconds;
+
+	std::mutex mMutex;
+	std::condition_variable mChanged;
+	std::vector<Stage> mMainThreadReady;
+	uint32_t mFinished;
+	std::exception_ptr mError;
+};
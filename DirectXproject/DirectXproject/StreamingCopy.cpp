@@ -0,0 +1,293 @@
+#include "StreamingCopy.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "CpuFeatures.h"
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+#if defined(_DEBUG) && defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <Windows.h>
+#endif
+
+namespace {
+	// Below this streaming gains nothing over a plain copy, there is not
+	// even one full line to write.
+	const size_t kMinStreamSize = 64;
+	// Auto only takes the AVX2 kernels from here on. In StreamingCopyBenchmark
+	// AVX2 copies 256 B at 2.8 GB/s against 5.9 for SSE2, the two are even
+	// at 1 KB and AVX2 leads by about a fifth from 4 KB up.
+	const size_t kMinAVX2Size = 4096;
+
+	typedef void(*CopyKernel)(uint8_t*, const uint8_t*, size_t);
+	typedef void(*FillKernel)(uint8_t*, uint8_t, size_t);
+
+	void CopyScalar(uint8_t* destination, const uint8_t* source, size_t size){
+		memcpy(destination, source, size);
+	}
+
+	void FillScalar(uint8_t* destination, uint8_t value, size_t size){
+		memset(destination, value, size);
+	}
+
+	#if defined(CPU_X86)
+	// Bytes until destination reaches alignment, at most size.
+	inline size_t HeadSize(const uint8_t* destination, size_t alignment, size_t size){
+		size_t head = (alignment - (reinterpret_cast<uintptr_t>(destination) & (alignment - 1))) & (alignment - 1);
+		return std::min(head, size);
+	}
+
+	// SSE2 is part of every x64 CPU, no target attribute needed.
+	void CopySSE2(uint8_t* destination, const uint8_t* source, size_t size){
+		size_t head = HeadSize(destination, 16, size);
+		memcpy(destination, source, head);
+		destination += head;
+		source += head;
+		size -= head;
+
+		// One full line per iteration so every write combining buffer is
+		// flushed whole.
+		for(; size >= 64; size -= 64, destination += 64, source += 64){
+			__m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+			__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 16));
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 32));
+			__m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + 48));
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination), a);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 16), b);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 32), c);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 48), d);
+		}
+		for(; size >= 16; size -= 16, destination += 16, source += 16){
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination), _mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+		}
+		memcpy(destination, source, size);
+	}
+
+	void FillSSE2(uint8_t* destination, uint8_t value, size_t size){
+		size_t head = HeadSize(destination, 16, size);
+		memset(destination, value, head);
+		destination += head;
+		size -= head;
+
+		const __m128i pattern = _mm_set1_epi8(static_cast<char>(value));
+		for(; size >= 64; size -= 64, destination += 64){
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination), pattern);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 16), pattern);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 32), pattern);
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination + 48), pattern);
+		}
+		for(; size >= 16; size -= 16, destination += 16){
+			_mm_stream_si128(reinterpret_cast<__m128i*>(destination), pattern);
+		}
+		memset(destination, value, size);
+	}
+
+	SIMD_TARGET_AVX2 void CopyAVX2(uint8_t* destination, const uint8_t* source, size_t size){
+		size_t head = HeadSize(destination, 32, size);
+		memcpy(destination, source, head);
+		destination += head;
+		source += head;
+		size -= head;
+
+		// Two lines per iteration, the loads run ahead of the stores.
+		for(; size >= 128; size -= 128, destination += 128, source += 128){
+			__m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+			__m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 32));
+			__m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 64));
+			__m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source + 96));
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination), a);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 32), b);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 64), c);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 96), d);
+		}
+		for(; size >= 32; size -= 32, destination += 32, source += 32){
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source)));
+		}
+		memcpy(destination, source, size);
+	}
+
+	SIMD_TARGET_AVX2 void FillAVX2(uint8_t* destination, uint8_t value, size_t size){
+		size_t head = HeadSize(destination, 32, size);
+		memset(destination, value, head);
+		destination += head;
+		size -= head;
+
+		const __m256i pattern = _mm256_set1_epi8(static_cast<char>(value));
+		for(; size >= 128; size -= 128, destination += 128){
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination), pattern);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 32), pattern);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 64), pattern);
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination + 96), pattern);
+		}
+		for(; size >= 32; size -= 32, destination += 32){
+			_mm256_stream_si256(reinterpret_cast<__m256i*>(destination), pattern);
+		}
+		memset(destination, value, size);
+	}
+	#endif
+
+	CopyPath ResolvePath(CopyPath path, size_t size){
+		if(path == CopyPath::Auto){
+			path = GetBestCopyPath();
+			if(path == CopyPath::AVX2 && size < kMinAVX2Size){
+				path = CopyPath::SSE2;
+			}
+			return path;
+		}
+		#if defined(CPU_X86)
+		if(path == CopyPath::AVX2 && !CpuFeatures::Get().avx2){
+			return CopyPath::SSE2;
+		}
+		return path;
+		#else
+		return CopyPath::Scalar;
+		#endif
+	}
+
+	CopyKernel SelectCopy(CopyPath path, size_t size){
+		switch(ResolvePath(path, size)){
+			#if defined(CPU_X86)
+			case CopyPath::AVX2: return CopyAVX2;
+			case CopyPath::SSE2: return CopySSE2;
+			#endif
+			default: return CopyScalar;
+		}
+	}
+
+	FillKernel SelectFill(CopyPath path, size_t size){
+		switch(ResolvePath(path, size)){
+			#if defined(CPU_X86)
+			case CopyPath::AVX2: return FillAVX2;
+			case CopyPath::SSE2: return FillSSE2;
+			#endif
+			default: return FillScalar;
+		}
+	}
+
+	// Reading the source is the one place a copy could touch mapped GPU
+	// memory by mistake, a source that is itself an upload heap.
+	inline void CheckNotWriteCombined(const void* pointer){
+		#if defined(_DEBUG)
+		assert(!IsWriteCombined(pointer) && "Reading write combined memory");
+		#else
+		(void)pointer;
+		#endif
+	}
+
+	#if defined(_DEBUG)
+	struct WriteCombinedRange {
+		const uint8_t* begin;
+		const uint8_t* end;
+	};
+
+	std::mutex& RangeMutex(){
+		static std::mutex mutex;
+		return mutex;
+	}
+
+	std::vector<WriteCombinedRange>& Ranges(){
+		static std::vector<WriteCombinedRange> ranges;
+		return ranges;
+	}
+	#endif
+}
+
+void StreamCopy(void* destination, const void* source, size_t size, CopyPath path){
+	StreamCopyNoFence(destination, source, size, path);
+	StreamFence();
+}
+
+void StreamCopyNoFence(void* destination, const void* source, size_t size, CopyPath path){
+	CheckNotWriteCombined(source);
+	if(size < kMinStreamSize){
+		memcpy(destination, source, size);
+		return;
+	}
+	SelectCopy(path, size)(static_cast<uint8_t*>(destination), static_cast<const uint8_t*>(source), size);
+}
+
+void StreamFill(void* destination, uint8_t value, size_t size, CopyPath path){
+	if(size >= kMinStreamSize){
+		SelectFill(path, size)(static_cast<uint8_t*>(destination), value, size);
+	}else{
+		memset(destination, value, size);
+	}
+	StreamFence();
+}
+
+void StreamFence(){
+	#if defined(CPU_X86)
+	_mm_sfence();
+	#else
+	std::atomic_thread_fence(std::memory_order_release);
+	#endif
+}
+
+CopyPath GetBestCopyPath(){
+	#if defined(CPU_X86)
+	return CpuFeatures::Get().avx2 ? CopyPath::AVX2 : CopyPath::SSE2;
+	#else
+	return CopyPath::Scalar;
+	#endif
+}
+
+void RegisterWriteCombined(const void* pointer, size_t size){
+	#if defined(_DEBUG)
+	const uint8_t* begin = static_cast<const uint8_t*>(pointer);
+	std::lock_guard<std::mutex> lock(RangeMutex());
+	Ranges().push_back({ begin, begin + size });
+	#else
+	(void)pointer;
+	(void)size;
+	#endif
+}
+
+void UnregisterWriteCombined(const void* pointer){
+	#if defined(_DEBUG)
+	std::lock_guard<std::mutex> lock(RangeMutex());
+	std::vector<WriteCombinedRange>& ranges = Ranges();
+	for(size_t i = 0; i < ranges.size(); i++){
+		if(ranges[i].begin == pointer){
+			ranges[i] = ranges.back();
+			ranges.pop_back();
+			return;
+		}
+	}
+	#else
+	(void)pointer;
+	#endif
+}
+
+bool IsWriteCombined(const void* pointer){
+	#if defined(_DEBUG)
+	const uint8_t* address = static_cast<const uint8_t*>(pointer);
+	{
+		std::lock_guard<std::mutex> lock(RangeMutex());
+		for(const WriteCombinedRange& range : Ranges()){
+			if(address >= range.begin && address < range.end){
+				return true;
+			}
+		}
+	}
+
+	#if defined(_WIN32)
+	// Upload heaps the driver maps write combined say so in the page protection.
+	MEMORY_BASIC_INFORMATION info;
+	if(VirtualQuery(pointer, &info, sizeof(info)) == sizeof(info) && (info.Protect & PAGE_WRITECOMBINE)){
+		return true;
+	}
+	#endif
+	return false;
+	#else
+	(void)pointer;
+	return false;
+	#endif
+}
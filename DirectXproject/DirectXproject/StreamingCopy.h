@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Copies and fills for memory the CPU only ever writes, mapped upload heaps
+// in particular. Those pages are write combined: stores collect in a few
+// line sized buffers and go out as whole bursts, so streaming stores that
+// fill complete lines are the fast way in, and they leave the cache alone.
+// Reading such memory back is uncached and very slow, debug builds assert
+// when a StreamCopy source is write combined.
+
+// Which kernels copy. Auto picks the widest the CPU supports, Scalar is
+// plain memcpy and memset.
+enum class CopyPath { Auto, Scalar, SSE2, AVX2 };
+
+// Same contract as memcpy, the ranges must not overlap. Returns once the
+// streaming stores are ordered before any later store, so the data can be
+// handed to the GPU right after.
+void StreamCopy(void* destination, const void* source, size_t size, CopyPath path = CopyPath::Auto);
+// StreamCopy without the fence, for many small copies in a row. The fence
+// costs more than a small copy, call StreamFence once after the last one.
+void StreamCopyNoFence(void* destination, const void* source, size_t size, CopyPath path = CopyPath::Auto);
+// memset with streaming stores, fenced like StreamCopy.
+void StreamFill(void* destination, uint8_t value, size_t size, CopyPath path = CopyPath::Auto);
+void StreamFence();
+
+CopyPath GetBestCopyPath();
+
+// Mapped write combined ranges, remembered in debug builds only. Release
+// builds keep the calls but they do nothing.
+void RegisterWriteCombined(const void* pointer, size_t size);
+void UnregisterWriteCombined(const void* pointer);
+// True when pointer is inside a registered range or, on Windows, a page
+// mapped write combined. Always false in release builds.
+bool IsWriteCombined(const void* pointer);
@@ -0,0 +1,221 @@
+#include "TestMain.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "AssetStreamer.h"
+
+// AssetStreamer with one I/O thread and a fake loader. A "blocker" asset
+// holds the thread until the test opens the gate, so everything requested
+// meanwhile sits in the queue and the load order is deterministic.
+
+namespace {
+	struct FakeLoader {
+		std::mutex mutex;
+		std::condition_variable changed;
+		bool gateOpen = false;
+		bool blockerStarted = false;
+		std::vector<std::string> loaded;
+
+		// Loads path as its own name, 100 bytes. "fail" fails, "blocker"
+		// waits for OpenGate first.
+		AssetLoader Loader(){
+			return [this](const std::string& path, std::shared_ptr<const void>& data, size_t& size){
+				std::unique_lock<std::mutex> lock(mutex);
+				if(path == "blocker"){
+					blockerStarted = true;
+					changed.notify_all();
+					changed.wait(lock, [this]{ return gateOpen; });
+				}
+				loaded.push_back(path);
+				if(path == "fail"){
+					return false;
+				}
+				data = std::make_shared<const std::string>(path);
+				size = 100;
+				return true;
+			};
+		}
+
+		void WaitForBlocker(){
+			std::unique_lock<std::mutex> lock(mutex);
+			changed.wait(lock, [this]{ return blockerStarted; });
+		}
+
+		void OpenGate(){
+			std::lock_guard<std::mutex> lock(mutex);
+			gateOpen = true;
+			changed.notify_all();
+		}
+
+		std::vector<std::string> GetLoaded(){
+			std::lock_guard<std::mutex> lock(mutex);
+			return loaded;
+		}
+	};
+
+	// Polls until done returns true, false after two seconds.
+	bool WaitUntil(const std::function<bool()>& done){
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while(!done()){
+			if(std::chrono::steady_clock::now() > deadline){
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+
+	bool WaitIdle(AssetStreamer* streamer){
+		return WaitUntil([streamer]{
+			AssetStreamerStats stats = streamer->GetStats();
+			return stats.queued == 0 && stats.loading == 0;
+		});
+	}
+
+	std::string GetName(AssetStreamer* streamer, AssetHandle handle){
+		std::shared_ptr<const std::string> name = streamer->Get<std::string>(handle);
+		return name ? *name : std::string();
+	}
+}
+
+TEST(AssetsLoadByPriorityThenRequestOrder){
+	AssetStreamer* streamer = AssetStreamer::GetInstance();
+	streamer->Init(1, 1 << 20);
+	FakeLoader loader;
+	streamer->Request("blocker", 100.0f, loader.Loader());
+	loader.WaitForBlocker();
+
+	streamer->Request("low", 1.0f, loader.Loader());
+	streamer->Request("first", 5.0f, loader.Loader());
+	streamer->Request("high", 9.0f, loader.Loader());
+	streamer->Request("second", 5.0f, loader.Loader());
+	// Raising a queued asset moves it up, its old entry is skipped.
+	AssetHandle raised = streamer->Request("raised", 0.0f, loader.Loader());
+	streamer->SetPriority(raised, 7.0f);
+	// Lowering works the same way.
+	AssetHandle lowered = streamer->Request("lowered", 8.0f, loader.Loader());
+	streamer->SetPriority(lowered, 0.5f);
+	CHECK_EQUAL(6u, streamer->GetStats().queued);
+
+	loader.OpenGate();
+	CHECK(WaitIdle(streamer));
+	const std::vector<std::string> expected = { "blocker", "high", "raised", "first", "second", "low", "lowered" };
+	CHECK(loader.GetLoaded() == expected);
+	CHECK_EQUAL(7u, streamer->GetStats().resident);
+	CHECK_EQUAL(uint64_t(7), streamer->GetStats().loadsCompleted);
+	streamer->Shutdown();
+}
+
+TEST(CancelDropsQueuedAndInFlightLoads){
+	AssetStreamer* streamer = AssetStreamer::GetInstance();
+	streamer->Init(1, 1 << 20);
+	FakeLoader loader;
+	AssetHandle blocker = streamer->Request("blocker", 100.0f, loader.Loader());
+	loader.WaitForBlocker();
+	CHECK(streamer->GetState(blocker) == AssetState::Loading);
+	AssetHandle queued = streamer->Request("queued", 1.0f, loader.Loader());
+	AssetHandle kept = streamer->Request("kept", 0.0f, loader.Loader());
+
+	// Cancelled while queued: never loaded.
+	streamer->Cancel(queued);
+	CHECK(streamer->GetState(queued) == AssetState::Unloaded);
+	// Cancelled while loading: the load finishes but its result is dropped.
+	streamer->Cancel(blocker);
+	CHECK(streamer->GetState(blocker) == AssetState::Unloaded);
+
+	loader.OpenGate();
+	CHECK(WaitIdle(streamer));
+	CHECK(WaitUntil([&]{ return streamer->GetState(kept) == AssetState::Resident; }));
+	const std::vector<std::string> expected = { "blocker", "kept" };
+	CHECK(loader.GetLoaded() == expected);
+	CHECK(streamer->GetState(blocker) == AssetState::Unloaded);
+	CHECK(streamer->Get(blocker) == nullptr);
+	AssetStreamerStats stats = streamer->GetStats();
+	CHECK_EQUAL(1u, stats.resident);
+	CHECK_EQUAL(size_t(100), stats.residentBytes);
+	CHECK_EQUAL(uint64_t(1), stats.loadsCompleted);
+
+	// The cancelled path starts over under a new handle.
+	AssetHandle again = streamer->Request("queued", 1.0f, loader.Loader());
+	CHECK(again != queued);
+	CHECK(WaitUntil([&]{ return streamer->GetState(again) == AssetState::Resident; }));
+	streamer->Shutdown();
+}
+
+TEST(BudgetEvictsTheLeastRecentlyUsedUnreferencedAssets){
+	AssetStreamer* streamer = AssetStreamer::GetInstance();
+	streamer->Init(1, 1 << 20);
+	FakeLoader loader;
+	loader.OpenGate();
+	const char* paths[4] = { "a", "b", "c", "d" };
+	AssetHandle handles[4];
+	for(int i = 0; i < 4; i++){
+		handles[i] = streamer->Request(paths[i], 1.0f, loader.Loader());
+		CHECK(WaitUntil([&]{ return streamer->GetState(handles[i]) == AssetState::Resident; }));
+		streamer->Update();
+	}
+	CHECK_EQUAL(size_t(400), streamer->GetStats().residentBytes);
+
+	// b stays referenced. a is the oldest but is used again, so c goes
+	// first, then d, then a.
+	streamer->Release(handles[0]);
+	streamer->Release(handles[2]);
+	streamer->Release(handles[3]);
+	streamer->Update();
+	CHECK_EQUAL(std::string("a"), GetName(streamer, handles[0]));
+
+	streamer->SetBudget(300);
+	CHECK(streamer->GetState(handles[2]) == AssetState::Unloaded);
+	CHECK(streamer->GetState(handles[3]) == AssetState::Resident);
+	streamer->SetBudget(200);
+	CHECK(streamer->GetState(handles[3]) == AssetState::Unloaded);
+	CHECK(streamer->GetState(handles[0]) == AssetState::Resident);
+	// Referenced assets stay even over budget.
+	streamer->SetBudget(0);
+	CHECK(streamer->GetState(handles[0]) == AssetState::Unloaded);
+	CHECK(streamer->GetState(handles[1]) == AssetState::Resident);
+	AssetStreamerStats stats = streamer->GetStats();
+	CHECK_EQUAL(size_t(100), stats.residentBytes);
+	CHECK_EQUAL(uint64_t(3), stats.evictions);
+
+	// Evicted entries are forgotten, a new request loads again.
+	AssetHandle reloaded = streamer->Request("c", 1.0f, loader.Loader());
+	CHECK(reloaded != handles[2]);
+	streamer->SetBudget(1 << 20);
+	CHECK(WaitUntil([&]{ return streamer->GetState(reloaded) == AssetState::Resident; }));
+	CHECK_EQUAL(size_t(5), loader.GetLoaded().size());
+	streamer->Shutdown();
+}
+
+TEST(GetReturnsThePlaceholderUntilResident){
+	AssetStreamer* streamer = AssetStreamer::GetInstance();
+	streamer->Init(1, 1 << 20);
+	FakeLoader loader;
+	const std::shared_ptr<const std::string> placeholder = std::make_shared<const std::string>("placeholder");
+	streamer->Request("blocker", 100.0f, loader.Loader());
+	loader.WaitForBlocker();
+
+	AssetHandle mesh = streamer->Request("mesh", 1.0f, loader.Loader());
+	AssetHandle broken = streamer->Request("fail", 1.0f, loader.Loader());
+	CHECK(streamer->Get<std::string>(mesh, placeholder) == placeholder);
+	CHECK(streamer->Get<std::string>(kInvalidAsset, placeholder) == placeholder);
+
+	loader.OpenGate();
+	CHECK(WaitIdle(streamer));
+	CHECK_EQUAL(std::string("mesh"), *streamer->Get<std::string>(mesh, placeholder));
+	// A failed load keeps the placeholder.
+	CHECK(streamer->GetState(broken) == AssetState::Failed);
+	CHECK(streamer->Get<std::string>(broken, placeholder) == placeholder);
+	CHECK_EQUAL(uint64_t(1), streamer->GetStats().loadsFailed);
+	// Released, the failed entry is forgotten.
+	streamer->Release(broken);
+	CHECK(streamer->GetState(broken) == AssetState::Unloaded);
+	streamer->Shutdown();
+}
@@ -0,0 +1,178 @@
+#include "TestMain.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "DeferredReleaseQueue.h"
+
+// DeferredReleaseQueue against a fake fence: a counter for the value the
+// next frame signals and one for what the "GPU" has completed.
+
+namespace {
+	struct FakeFence {
+		uint64_t nextValue = 1;
+		uint64_t completedValue = 0;
+
+		uint64_t Signal(){ return nextValue++; }
+	};
+}
+
+TEST(ReleasesWaitForTheirFenceValue){
+	DeferredReleaseQueue queue;
+	FakeFence fence;
+	std::vector<int> released;
+
+	queue.SetFenceValue(fence.nextValue);
+	queue.Defer([&]{ released.push_back(1); });
+	fence.Signal();
+	queue.SetFenceValue(fence.nextValue);
+	queue.Defer([&]{ released.push_back(2); });
+	queue.Defer([&]{ released.push_back(3); });
+	fence.Signal();
+	CHECK_EQUAL(3u, queue.GetPendingCount());
+
+	CHECK_EQUAL(0u, queue.Retire(fence.completedValue));
+	CHECK(released.empty());
+
+	fence.completedValue = 1;
+	CHECK_EQUAL(1u, queue.Retire(fence.completedValue));
+	CHECK_EQUAL(size_t(1), released.size());
+	CHECK_EQUAL(2u, queue.GetPendingCount());
+
+	// Nothing new completed, nothing new runs.
+	CHECK_EQUAL(0u, queue.Retire(fence.completedValue));
+
+	fence.completedValue = 2;
+	CHECK_EQUAL(2u, queue.Retire(fence.completedValue));
+	CHECK_EQUAL(size_t(3), released.size());
+	CHECK_EQUAL(0u, queue.GetPendingCount());
+}
+
+TEST(ReleasesRunInDeferOrder){
+	DeferredReleaseQueue queue;
+	std::vector<int> released;
+
+	queue.SetFenceValue(1);
+	for(int i = 0; i < 100; i++){
+		queue.Defer([&released, i]{ released.push_back(i); });
+	}
+	CHECK_EQUAL(100u, queue.Retire(1));
+	CHECK_EQUAL(size_t(100), released.size());
+	for(int i = 0; i < 100 && i < static_cast<int>(released.size()); i++){
+		CHECK_EQUAL(i, released[i]);
+	}
+}
+
+TEST(LaterFramesStayQueuedBehindEarlierOnes){
+	DeferredReleaseQueue queue;
+	std::vector<int> released;
+
+	// Tags out of order, as threads racing the frame boundary produce.
+	queue.SetFenceValue(3);
+	queue.Defer([&]{ released.push_back(3); });
+	queue.SetFenceValue(2);
+	queue.Defer([&]{ released.push_back(2); });
+	queue.SetFenceValue(4);
+	queue.Defer([&]{ released.push_back(4); });
+
+	CHECK_EQUAL(1u, queue.Retire(2));
+	CHECK_EQUAL(size_t(1), released.size());
+	CHECK_EQUAL(2, released[0]);
+	CHECK_EQUAL(2u, queue.Retire(4));
+	CHECK_EQUAL(size_t(3), released.size());
+	CHECK_EQUAL(3, released[1]);
+	CHECK_EQUAL(4, released[2]);
+}
+
+TEST(FlushRunsEverything){
+	DeferredReleaseQueue queue;
+	int released = 0;
+	queue.SetFenceValue(10);
+	queue.Defer([&]{ released++; });
+	queue.SetFenceValue(11);
+	queue.Defer([&]{ released++; });
+	CHECK_EQUAL(0u, queue.Retire(9));
+	CHECK_EQUAL(2u, queue.Flush());
+	CHECK_EQUAL(2, released);
+	CHECK_EQUAL(0u, queue.GetPendingCount());
+}
+
+TEST(ConcurrentProducersAreTaggedAndRetiredSafely){
+	const int kProducers = 4;
+	const int kReleasesPerProducer = 20000;
+
+	DeferredReleaseQueue queue;
+	FakeFence fence;
+	queue.SetFenceValue(fence.nextValue);
+
+	struct Record {
+		// Fence values the producer saw around Defer, the tag is in between.
+		uint64_t seenBefore;
+		uint64_t seenAfter;
+		// Completed value of the Retire that ran it, 0 until then.
+		uint64_t retiredAt;
+		int order;
+	};
+	std::vector<std::vector<Record>> records(kProducers, std::vector<Record>(kReleasesPerProducer));
+	// Only the retiring thread writes these, Retire and Flush run there.
+	uint64_t currentCompleted = 0;
+	int runOrder = 0;
+
+	std::atomic<int> running(kProducers);
+	std::vector<std::thread> producers;
+	for(int p = 0; p < kProducers; p++){
+		producers.emplace_back([&, p]{
+			for(int i = 0; i < kReleasesPerProducer; i++){
+				Record& record = records[p][i];
+				record.retiredAt = 0;
+				record.seenBefore = queue.GetFenceValue();
+				queue.Defer([&record, &currentCompleted, &runOrder]{
+					record.retiredAt = currentCompleted;
+					record.order = runOrder++;
+				});
+				record.seenAfter = queue.GetFenceValue();
+			}
+			running.fetch_sub(1);
+		});
+	}
+
+	// The render thread: the GPU lags two frames behind the CPU.
+	while(running.load() > 0){
+		fence.Signal();
+		queue.SetFenceValue(fence.nextValue);
+		fence.completedValue = fence.nextValue > 3 ? fence.nextValue - 3 : 0;
+		currentCompleted = fence.completedValue;
+		queue.Retire(fence.completedValue);
+	}
+	for(std::thread& producer : producers){
+		producer.join();
+	}
+
+	// Everything up to the last tag completes, then the rest drains.
+	fence.completedValue = fence.nextValue;
+	currentCompleted = fence.completedValue;
+	queue.Retire(fence.completedValue);
+	CHECK_EQUAL(0u, queue.GetPendingCount());
+	CHECK_EQUAL(0u, queue.Flush());
+	CHECK_EQUAL(kProducers * kReleasesPerProducer, runOrder);
+
+	bool allRan = true;
+	bool neverEarly = true;
+	bool producerOrderKept = true;
+	for(int p = 0; p < kProducers; p++){
+		for(int i = 0; i < kReleasesPerProducer; i++){
+			const Record& record = records[p][i];
+			allRan = allRan && record.retiredAt != 0;
+			// Never before the GPU finished the frame it was deferred in.
+			neverEarly = neverEarly && record.retiredAt >= record.seenBefore;
+			if(i > 0){
+				producerOrderKept = producerOrderKept && records[p][i - 1].order < record.order;
+			}
+		}
+	}
+	CHECK(allRan);
+	CHECK(neverEarly);
+	CHECK(producerOrderKept);
+}
@@ -0,0 +1,184 @@
+#include "TestMain.h"
+
+#include "DrawPacket.h"
+
+namespace {
+	// Records nothing, counts every call. Pipelines below 4 share root
+	// signature 0, the rest use 1.
+	struct CountingSink {
+		uint32_t rootSignatures = 0;
+		uint32_t pipelines = 0;
+		uint32_t vertexBuffers = 0;
+		uint32_t indexBuffers = 0;
+		uint32_t constantBuffers = 0;
+		uint32_t rootConstants = 0;
+		uint32_t draws = 0;
+		uint32_t indexedDraws = 0;
+
+		uint32_t GetRootSignature(PipelineHandle pipeline) { return pipeline < 4 ? 0 : 1; }
+		void SetRootSignature(uint32_t) { rootSignatures++; }
+		void SetPipeline(PipelineHandle) { pipelines++; }
+		void SetVertexBuffer(BufferHandle) { vertexBuffers++; }
+		void SetIndexBuffer(BufferHandle) { indexBuffers++; }
+		void SetConstantBuffer(PipelineHandle, BufferHandle, uint32_t) { constantBuffers++; }
+		void SetRootConstants(PipelineHandle, uint32_t, const uint32_t*) { rootConstants++; }
+		void Draw(const DrawPacket&) { draws++; }
+		void DrawIndexed(const DrawPacket&) { indexedDraws++; }
+	};
+
+	DrawPacketStats Translate(const DrawPacket* packets, uint32_t count, CountingSink& sink){
+		DrawPacketState state;
+		state.Invalidate();
+		DrawPacketStats stats = {};
+		TranslateDrawPackets(packets, count, state, stats, sink);
+		return stats;
+	}
+
+	void EmitDraw(DrawPacketStream& stream, uint64_t key, PipelineHandle pipeline, BufferHandle vertexBuffer, uint32_t first){
+		DrawPacket& packet = stream.Emit(key);
+		packet.pipeline = pipeline;
+		packet.vertexBuffer = vertexBuffer;
+		packet.count = 3;
+		packet.first = first;
+	}
+}
+
+TEST(TranslateSkipsStateThatIsAlreadyBound){
+	DrawPacketStream stream;
+	for(uint32_t i = 0; i < 4; i++){
+		DrawPacket& packet = stream.Emit(0);
+		packet.pipeline = 1;
+		packet.vertexBuffer = 2;
+		packet.indexBuffer = 3;
+		packet.constantBuffer = 4;
+		packet.constantOffset = 256 * (i / 2);
+		packet.rootConstantCount = 1;
+		packet.rootConstants[0] = 7;
+		packet.count = 6;
+		packet.first = i;
+	}
+
+	CountingSink sink;
+	const DrawPacketStats stats = Translate(stream.GetPackets(), stream.GetCount(), sink);
+	CHECK_EQUAL(4u, stats.packets);
+	CHECK_EQUAL(1u, stats.rootSignatureChanges);
+	CHECK_EQUAL(1u, stats.pipelineChanges);
+	CHECK_EQUAL(1u, stats.vertexBufferChanges);
+	CHECK_EQUAL(1u, stats.indexBufferChanges);
+	// Two constant slots, one root constant value.
+	CHECK_EQUAL(2u, stats.constantBufferChanges);
+	CHECK_EQUAL(1u, stats.rootConstantChanges);
+	// The stats count exactly what reached the sink.
+	CHECK_EQUAL(stats.pipelineChanges, sink.pipelines);
+	CHECK_EQUAL(stats.constantBufferChanges, sink.constantBuffers);
+	CHECK_EQUAL(4u, sink.indexedDraws);
+	CHECK_EQUAL(0u, sink.draws);
+}
+
+TEST(TranslateRebindsRootArgumentsAfterRootSignatureChange){
+	// Same constants throughout, pipelines 1 and 2 share a root signature, 5 does not.
+	const PipelineHandle pipelines[] = { 1, 2, 5, 1 };
+	DrawPacketStream stream;
+	for(PipelineHandle pipeline : pipelines){
+		DrawPacket& packet = stream.Emit(0);
+		packet.pipeline = pipeline;
+		packet.vertexBuffer = 0;
+		packet.constantBuffer = 1;
+		packet.rootConstantCount = 2;
+		packet.rootConstants[0] = 10;
+		packet.rootConstants[1] = 20;
+		packet.count = 3;
+	}
+
+	CountingSink sink;
+	const DrawPacketStats stats = Translate(stream.GetPackets(), stream.GetCount(), sink);
+	CHECK_EQUAL(4u, stats.pipelineChanges);
+	CHECK_EQUAL(3u, stats.rootSignatureChanges);
+	CHECK_EQUAL(3u, stats.constantBufferChanges);
+	CHECK_EQUAL(3u, stats.rootConstantChanges);
+	CHECK_EQUAL(1u, stats.vertexBufferChanges);
+	CHECK_EQUAL(4u, sink.draws);
+}
+
+TEST(TranslateAfterInvalidateSetsEverythingAgain){
+	DrawPacketStream stream;
+	EmitDraw(stream, 0, 1, 0, 0);
+
+	DrawPacketState state;
+	state.Invalidate();
+	DrawPacketStats stats = {};
+	CountingSink sink;
+	TranslateDrawPackets(stream.GetPackets(), stream.GetCount(), state, stats, sink);
+	TranslateDrawPackets(stream.GetPackets(), stream.GetCount(), state, stats, sink);
+	CHECK_EQUAL(1u, stats.pipelineChanges);
+
+	state.Invalidate();
+	TranslateDrawPackets(stream.GetPackets(), stream.GetCount(), state, stats, sink);
+	CHECK_EQUAL(2u, stats.pipelineChanges);
+	CHECK_EQUAL(2u, stats.rootSignatureChanges);
+	CHECK_EQUAL(2u, stats.vertexBufferChanges);
+	CHECK_EQUAL(3u, stats.packets);
+}
+
+TEST(SortedPacketsChangeLessState){
+	// Four pipelines by eight meshes, emitted interleaved so the pipeline
+	// changes on every packet.
+	DrawPacketStream stream;
+	for(uint32_t i = 0; i < 256; i++){
+		DrawKeyFields fields = {};
+		fields.pipeline = i % 4;
+		fields.mesh = (i / 4) % 8;
+		fields.depth = i;
+		EmitDraw(stream, EncodeDrawKey(fields), static_cast<PipelineHandle>(fields.pipeline * 2), static_cast<BufferHandle>(fields.mesh), i);
+	}
+
+	CountingSink unsortedSink;
+	const DrawPacketStats unsorted = Translate(stream.GetPackets(), stream.GetCount(), unsortedSink);
+	CHECK_EQUAL(256u, unsorted.pipelineChanges);
+
+	DrawList order;
+	DrawPacketStream sorted;
+	SortDrawPackets(&stream, 1, order, sorted);
+	CHECK_EQUAL(256u, sorted.GetCount());
+	CountingSink sortedSink;
+	const DrawPacketStats stats = Translate(sorted.GetPackets(), sorted.GetCount(), sortedSink);
+	CHECK_EQUAL(256u, stats.packets);
+	CHECK_EQUAL(4u, stats.pipelineChanges);
+	// Pipelines 0 and 2 share a root signature, 4 and 6 the other.
+	CHECK_EQUAL(2u, stats.rootSignatureChanges);
+	CHECK_EQUAL(32u, stats.vertexBufferChanges);
+	CHECK(stats.vertexBufferChanges < unsorted.vertexBufferChanges);
+}
+
+TEST(SortDrawPacketsMergesStreamsInKeyOrder){
+	// Three streams with interleaved keys and one tie across streams.
+	DrawPacketStream streams[3];
+	EmitDraw(streams[0], 5, 0, 0, 0);
+	EmitDraw(streams[0], 1, 0, 0, 1);
+	EmitDraw(streams[1], 3, 0, 0, 10);
+	EmitDraw(streams[1], 5, 0, 0, 11);
+	EmitDraw(streams[2], 0, 0, 0, 20);
+	EmitDraw(streams[2], 4, 0, 0, 21);
+	EmitDraw(streams[2], 5, 0, 0, 22);
+
+	DrawList order;
+	DrawPacketStream sorted;
+	SortDrawPackets(streams, 3, order, sorted);
+	CHECK_EQUAL(7u, sorted.GetCount());
+
+	// Equal keys keep stream order, then emit order.
+	const uint64_t keys[] = { 0, 1, 3, 4, 5, 5, 5 };
+	const uint32_t firsts[] = { 20, 1, 10, 21, 0, 11, 22 };
+	for(uint32_t i = 0; i < 7; i++){
+		CHECK_EQUAL(keys[i], sorted.GetKeys()[i]);
+		CHECK_EQUAL(firsts[i], sorted.GetPackets()[i].first);
+	}
+
+	// Sorting again into the same outputs replaces them.
+	SortDrawPackets(streams + 2, 1, order, sorted);
+	CHECK_EQUAL(3u, sorted.GetCount());
+	CHECK_EQUAL(20u, sorted.GetPackets()[0].first);
+
+	SortDrawPackets(streams, 0, order, sorted);
+	CHECK_EQUAL(0u, sorted.GetCount());
+}
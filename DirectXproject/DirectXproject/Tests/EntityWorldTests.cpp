@@ -0,0 +1,143 @@
+#include "TestMain.h"
+
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "EntityWorld.h"
+
+namespace {
+	struct Position { float x, y, z; };
+	struct Velocity { float x, y, z; };
+	struct Health { int value; };
+
+	// Distinct component types of distinct sizes, only ever registered by
+	// ConcurrentRegistrationGivesUniqueIds.
+	template<int N>
+	struct Tagged { uint8_t bytes[N + 1]; };
+
+	const int kTaggedTypes = 32;
+
+	template<int... N>
+	void GetTaggedIds(ComponentId* ids, bool reverse, std::integer_sequence<int, N...>){
+		if(reverse){
+			((ids[kTaggedTypes - 1 - N] = GetComponentId<Tagged<kTaggedTypes - 1 - N>>()), ...);
+		}else{
+			((ids[N] = GetComponentId<Tagged<N>>()), ...);
+		}
+	}
+}
+
+TEST(ComponentsMoveBetweenArchetypes){
+	EntityWorld world;
+	Entity entity = world.CreateEntity(Position{ 1.0f, 2.0f, 3.0f });
+	world.AddComponent(entity, Velocity{ 4.0f, 5.0f, 6.0f });
+	CHECK(world.HasComponent<Position>(entity));
+	CHECK(world.HasComponent<Velocity>(entity));
+	CHECK_EQUAL(2.0f, world.GetComponent<Position>(entity)->y);
+	CHECK_EQUAL(6.0f, world.GetComponent<Velocity>(entity)->z);
+
+	world.RemoveComponent<Position>(entity);
+	CHECK(!world.HasComponent<Position>(entity));
+	CHECK_EQUAL(4.0f, world.GetComponent<Velocity>(entity)->x);
+
+	world.DestroyEntity(entity);
+	CHECK(!world.IsAlive(entity));
+	CHECK_EQUAL(0u, world.GetEntityCount());
+}
+
+TEST(ForEachVisitsEveryMatchingEntity){
+	EntityWorld world;
+	const int kCount = 5000;
+	for(int i = 0; i < kCount; i++){
+		if(i % 2){
+			world.CreateEntity(Position{ 1.0f, 0.0f, 0.0f }, Velocity{ 1.0f, 0.0f, 0.0f });
+		}else{
+			world.CreateEntity(Position{ 1.0f, 0.0f, 0.0f });
+		}
+	}
+
+	int positions = 0;
+	world.ForEach<Position>([&](Entity, Position&){ positions++; });
+	int moving = 0;
+	world.ForEach<Position, Velocity>([&](Entity, Position& position, Velocity& velocity){
+		position.x += velocity.x;
+		moving++;
+	});
+	CHECK_EQUAL(kCount, positions);
+	CHECK_EQUAL(kCount / 2, moving);
+
+	float sum = 0.0f;
+	world.ForEachChunk<Position>([&](uint32_t count, const Entity*, Position* array){
+		for(uint32_t i = 0; i < count; i++){
+			sum += array[i].x;
+		}
+	});
+	CHECK_EQUAL(static_cast<float>(kCount + kCount / 2), sum);
+}
+
+TEST(CommandBufferDefersChangesUntilPlayback){
+	EntityWorld world;
+	std::vector<Entity> entities;
+	for(int i = 0; i < 10; i++){
+		entities.push_back(world.CreateEntity(Health{ i }));
+	}
+
+	// Structural changes recorded from inside a query.
+	EntityCommandBuffer commands(world);
+	Entity spawned = kNullEntity;
+	world.ForEach<Health>([&](Entity entity, Health& health){
+		if(health.value % 2){
+			commands.DestroyEntity(entity);
+		}else{
+			commands.AddComponent(entity, Position{ static_cast<float>(health.value), 0.0f, 0.0f });
+		}
+		if(health.value == 9){
+			spawned = commands.CreateEntity();
+			commands.AddComponent(spawned, Health{ 100 });
+		}
+	});
+	CHECK(!commands.IsEmpty());
+	CHECK(!world.HasComponent<Position>(entities[0]));
+	CHECK(world.IsAlive(entities[1]));
+
+	commands.Playback();
+	CHECK(commands.IsEmpty());
+	CHECK_EQUAL(6u, world.GetEntityCount());
+	CHECK(!world.IsAlive(entities[1]));
+	CHECK(world.HasComponent<Position>(entities[4]));
+	CHECK_EQUAL(4.0f, world.GetComponent<Position>(entities[4])->x);
+	CHECK_EQUAL(100, world.GetComponent<Health>(spawned)->value);
+}
+
+TEST(ConcurrentRegistrationGivesUniqueIds){
+	// Several threads meet the same new component types at once, in
+	// opposite orders, and have to agree on one id per type.
+	const int kThreads = 4;
+	ComponentId ids[kThreads][kTaggedTypes];
+	std::vector<std::thread> threads;
+	for(int t = 0; t < kThreads; t++){
+		threads.emplace_back([&ids, t]{
+			GetTaggedIds(ids[t], t % 2 == 1, std::make_integer_sequence<int, kTaggedTypes>());
+		});
+	}
+	for(std::thread& thread : threads){
+		thread.join();
+	}
+
+	bool agree = true;
+	bool unique = true;
+	bool sized = true;
+	for(int i = 0; i < kTaggedTypes; i++){
+		for(int t = 1; t < kThreads; t++){
+			agree = agree && ids[t][i] == ids[0][i];
+		}
+		for(int j = 0; j < i; j++){
+			unique = unique && ids[0][j] != ids[0][i];
+		}
+		sized = sized && EcsDetail::GetComponentInfo(ids[0][i]).size == static_cast<uint32_t>(i + 1);
+	}
+	CHECK(agree);
+	CHECK(unique);
+	CHECK(sized);
+}
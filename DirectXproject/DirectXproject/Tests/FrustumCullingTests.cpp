@@ -0,0 +1,150 @@
+#include "TestMain.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "FrustumCulling.h"
+#include "MathBatch.h"
+
+namespace {
+	// Small deterministic generator, the same bounds on every run.
+	struct Random {
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		float Next(float low, float high){
+			state = state * 1664525u + 1013904223u;
+			return low + (high - low) * static_cast<float>(state >> 8) / 16777216.0f;
+		}
+	};
+
+	Frustum MakePerspectiveFrustum(){
+		// 90 degree vertical field of view, 16:9, depth [0.1, 100].
+		const float nearZ = 0.1f;
+		const float farZ = 100.0f;
+		Float4x4 projection = {};
+		projection.m[0][0] = 1.0f / (16.0f / 9.0f);
+		projection.m[1][1] = 1.0f;
+		projection.m[2][2] = farZ / (farZ - nearZ);
+		projection.m[2][3] = 1.0f;
+		projection.m[3][2] = -nearZ * farZ / (farZ - nearZ);
+		return Frustum::FromViewProjection(&projection.m[0][0]);
+	}
+
+	// Bounds spread around the frustum so a good share lands on each side
+	// of every plane, some straddling.
+	void MakeSpheres(uint32_t count, SphereBoundsSoA& bounds){
+		Random random(count);
+		bounds.Clear();
+		for(uint32_t i = 0; i < count; i++){
+			float center[3] = { random.Next(-120.0f, 120.0f), random.Next(-120.0f, 120.0f), random.Next(-20.0f, 120.0f) };
+			bounds.Add(center, random.Next(0.0f, 4.0f));
+		}
+	}
+
+	void MakeAabbs(uint32_t count, AabbBoundsSoA& bounds){
+		Random random(count + 1);
+		bounds.Clear();
+		for(uint32_t i = 0; i < count; i++){
+			float boxMin[3] = { random.Next(-120.0f, 120.0f), random.Next(-120.0f, 120.0f), random.Next(-20.0f, 120.0f) };
+			float boxMax[3] = { boxMin[0] + random.Next(0.0f, 8.0f), boxMin[1] + random.Next(0.0f, 8.0f), boxMin[2] + random.Next(0.0f, 8.0f) };
+			bounds.Add(boxMin, boxMax);
+		}
+	}
+
+	const CullPath kPaths[] = { CullPath::Scalar, CullPath::SSE, CullPath::AVX2, CullPath::Auto };
+}
+
+TEST(ScalarSpheresMatchFrustumIntersects){
+	const Frustum frustum = MakePerspectiveFrustum();
+	SphereBoundsSoA bounds;
+	MakeSpheres(1000, bounds);
+
+	std::vector<uint32_t> expected;
+	for(uint32_t i = 0; i < bounds.Size(); i++){
+		const float center[3] = { bounds.centerX[i], bounds.centerY[i], bounds.centerZ[i] };
+		if(frustum.IntersectsSphere(center, bounds.radius[i])){
+			expected.push_back(i);
+		}
+	}
+	CHECK(!expected.empty());
+	CHECK(expected.size() < bounds.Size());
+
+	std::vector<uint32_t> visible;
+	CullSpheres(frustum, bounds, visible, CullPath::Scalar);
+	CHECK(expected == visible);
+}
+
+TEST(ScalarAabbsAreConservative){
+	const Frustum frustum = MakePerspectiveFrustum();
+	AabbBoundsSoA bounds;
+	MakeAabbs(1000, bounds);
+
+	std::vector<uint32_t> visible;
+	CullAabbs(frustum, bounds, visible, CullPath::Scalar);
+	CHECK(!visible.empty());
+
+	// Center and extents test the same corner as IntersectsAABB, so every
+	// box it keeps is kept here too.
+	size_t next = 0;
+	bool conservative = true;
+	for(uint32_t i = 0; i < bounds.Size(); i++){
+		const float boxMin[3] = { bounds.centerX[i] - bounds.extentX[i], bounds.centerY[i] - bounds.extentY[i], bounds.centerZ[i] - bounds.extentZ[i] };
+		const float boxMax[3] = { bounds.centerX[i] + bounds.extentX[i], bounds.centerY[i] + bounds.extentY[i], bounds.centerZ[i] + bounds.extentZ[i] };
+		const bool kept = next < visible.size() && visible[next] == i;
+		if(kept){
+			next++;
+		}else if(frustum.IntersectsAABB(boxMin, boxMax)){
+			conservative = false;
+		}
+	}
+	CHECK(conservative);
+}
+
+TEST(EveryPathAgreesOnSpheres){
+	const Frustum frustum = MakePerspectiveFrustum();
+	// Odd counts leave scalar tails, the large one goes through the JobSystem.
+	const uint32_t counts[] = { 0, 1, 7, 13, 1001, 40003 };
+	for(uint32_t count : counts){
+		SphereBoundsSoA bounds;
+		MakeSpheres(count, bounds);
+		std::vector<uint32_t> expected;
+		CullSpheres(frustum, bounds, expected, CullPath::Scalar);
+		for(CullPath path : kPaths){
+			std::vector<uint32_t> visible;
+			CullSpheres(frustum, bounds, visible, path);
+			CHECK(expected == visible);
+		}
+	}
+}
+
+TEST(EveryPathAgreesOnAabbs){
+	const Frustum frustum = MakePerspectiveFrustum();
+	const uint32_t counts[] = { 0, 1, 7, 13, 1001, 40003 };
+	for(uint32_t count : counts){
+		AabbBoundsSoA bounds;
+		MakeAabbs(count, bounds);
+		std::vector<uint32_t> expected;
+		CullAabbs(frustum, bounds, expected, CullPath::Scalar);
+		for(CullPath path : kPaths){
+			std::vector<uint32_t> visible;
+			CullAabbs(frustum, bounds, visible, path);
+			CHECK(expected == visible);
+		}
+	}
+}
+
+TEST(TouchingBoundsAreKept){
+	// Clip space, a sphere exactly touching the left plane from outside.
+	const Frustum frustum = Frustum::Identity();
+	SphereBoundsSoA bounds;
+	for(int i = 0; i < 9; i++){
+		const float center[3] = { -1.25f, 0.0f, 0.5f };
+		bounds.Add(center, 0.25f);
+	}
+	for(CullPath path : kPaths){
+		std::vector<uint32_t> visible;
+		CullSpheres(frustum, bounds, visible, path);
+		CHECK_EQUAL(size_t(9), visible.size());
+	}
+}
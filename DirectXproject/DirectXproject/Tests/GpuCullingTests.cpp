@@ -0,0 +1,196 @@
+#include "TestMain.h"
+
+#include <cmath>
+#include <vector>
+
+#include "GpuCulling.h"
+#include "HiZCulling.h"
+
+// The CPU references of CSMain and CSCullOcclusion in cull.hlsl, against
+// frusta and depth pyramids small enough to work out by hand.
+
+namespace {
+	// Row vector, left handed perspective looking down +z, D3D depth [0, 1].
+	void Perspective(float m[16], float fovY, float aspect, float nearZ, float farZ){
+		const float yScale = 1.0f / std::tan(fovY * 0.5f);
+		const float range = farZ / (farZ - nearZ);
+		const float values[16] = {
+			yScale / aspect, 0.0f, 0.0f, 0.0f,
+			0.0f, yScale, 0.0f, 0.0f,
+			0.0f, 0.0f, range, 1.0f,
+			0.0f, 0.0f, -nearZ * range, 0.0f
+		};
+		for(int i = 0; i < 16; i++){
+			m[i] = values[i];
+		}
+	}
+
+	const float kHalfPi = 1.57079632679f;
+
+	GpuDrawArguments Draw(uint32_t vertexCount, uint32_t startVertex){
+		return { vertexCount, 1, startVertex, 0 };
+	}
+
+	bool IsVisible(const Frustum& frustum, float x, float y, float z, float radius){
+		const GpuObjectBounds bounds[] = { { { x, y, z }, radius } };
+		const GpuDrawArguments drawArgs[] = { Draw(3, 0) };
+		GpuIndirectCommand command;
+		return CullAndCompactReference(MakeCullConstants(frustum, 1), bounds, drawArgs, &command) == 1;
+	}
+
+	// width x height depth buffer cleared to far, nearer depth on the left
+	// coveredColumns columns.
+	std::vector<float> WallDepth(uint32_t width, uint32_t height, uint32_t coveredColumns, float wallDepth){
+		std::vector<float> depth(width * height, 1.0f);
+		for(uint32_t y = 0; y < height; y++){
+			for(uint32_t x = 0; x < coveredColumns; x++){
+				depth[y * width + x] = wallDepth;
+			}
+		}
+		return depth;
+	}
+}
+
+TEST(MakeCullConstantsCopiesPlanesAndCount){
+	const Frustum frustum = Frustum::Identity();
+	const GpuCullConstants constants = MakeCullConstants(frustum, 42);
+	CHECK_EQUAL(42u, constants.objectCount);
+	for(int p = 0; p < Frustum::Count; p++){
+		for(int i = 0; i < 4; i++){
+			CHECK_EQUAL(frustum.planes[p][i], constants.planes[p][i]);
+		}
+	}
+}
+
+TEST(ClipSpaceFrustumKeepsInsideAndStraddlingSpheres){
+	const Frustum frustum = Frustum::Identity();
+	CHECK(IsVisible(frustum, 0.0f, 0.0f, 0.5f, 0.1f));
+	// Straddles the right plane.
+	CHECK(IsVisible(frustum, 1.1f, 0.0f, 0.5f, 0.2f));
+	// Touches it from outside, the kernel only rejects strictly outside.
+	CHECK(IsVisible(frustum, 1.25f, 0.0f, 0.5f, 0.25f));
+	CHECK(!IsVisible(frustum, 1.5f, 0.0f, 0.5f, 0.2f));
+	CHECK(!IsVisible(frustum, -1.5f, 0.0f, 0.5f, 0.2f));
+	CHECK(!IsVisible(frustum, 0.0f, 1.5f, 0.5f, 0.2f));
+	CHECK(!IsVisible(frustum, 0.0f, -1.5f, 0.5f, 0.2f));
+	// Behind the near plane at z 0 and past the far plane at z 1.
+	CHECK(!IsVisible(frustum, 0.0f, 0.0f, -0.5f, 0.2f));
+	CHECK(!IsVisible(frustum, 0.0f, 0.0f, 1.5f, 0.2f));
+}
+
+TEST(PerspectiveFrustumRejectsEachPlane){
+	// 90 degrees, so the side planes are x = +-z and y = +-z.
+	float viewProjection[16];
+	Perspective(viewProjection, kHalfPi, 1.0f, 1.0f, 100.0f);
+	const Frustum frustum = Frustum::FromViewProjection(viewProjection);
+
+	CHECK(IsVisible(frustum, 0.0f, 0.0f, 10.0f, 1.0f));
+	CHECK(!IsVisible(frustum, 0.0f, 0.0f, -5.0f, 1.0f));
+	CHECK(!IsVisible(frustum, 0.0f, 0.0f, 150.0f, 1.0f));
+	// Straddles the far plane.
+	CHECK(IsVisible(frustum, 0.0f, 0.0f, 100.5f, 1.0f));
+	CHECK(!IsVisible(frustum, 20.0f, 0.0f, 10.0f, 1.0f));
+	CHECK(!IsVisible(frustum, -20.0f, 0.0f, 10.0f, 1.0f));
+	CHECK(!IsVisible(frustum, 0.0f, 20.0f, 10.0f, 1.0f));
+	CHECK(!IsVisible(frustum, 0.0f, -20.0f, 10.0f, 1.0f));
+	// 0.35 outside x = z with a radius of 1.
+	CHECK(IsVisible(frustum, 10.5f, 0.0f, 10.0f, 1.0f));
+}
+
+TEST(CompactionKeepsObjectOrderAndDrawArguments){
+	const Frustum frustum = Frustum::Identity();
+	const std::vector<GpuObjectBounds> bounds = {
+		{ { 0.0f, 0.0f, 0.5f }, 0.1f },
+		{ { 5.0f, 0.0f, 0.5f }, 0.1f },
+		{ { 0.5f, 0.5f, 0.5f }, 0.1f },
+		{ { 0.0f, 0.0f, 5.0f }, 0.1f },
+		{ { -0.5f, 0.0f, 0.2f }, 0.1f },
+	};
+	const std::vector<GpuDrawArguments> drawArgs = { Draw(3, 0), Draw(6, 3), Draw(9, 9), Draw(12, 18), Draw(15, 30) };
+
+	const std::vector<GpuIndirectCommand> commands = CullAndCompactReference(MakeCullConstants(frustum, 5), bounds, drawArgs);
+	CHECK_EQUAL(size_t(3), commands.size());
+	const uint32_t expected[] = { 0, 2, 4 };
+	for(size_t i = 0; i < commands.size() && i < 3; i++){
+		CHECK_EQUAL(expected[i], commands[i].objectIndex);
+		CHECK_EQUAL(drawArgs[expected[i]].vertexCountPerInstance, commands[i].draw.vertexCountPerInstance);
+		CHECK_EQUAL(drawArgs[expected[i]].startVertexLocation, commands[i].draw.startVertexLocation);
+		CHECK_EQUAL(1u, commands[i].draw.instanceCount);
+	}
+}
+
+TEST(EmptyPyramidOccludesNothing){
+	float viewProjection[16];
+	Perspective(viewProjection, kHalfPi, 1.0f, 1.0f, 100.0f);
+	HiZPyramid pyramid;
+	pyramid.width = 0;
+	pyramid.height = 0;
+	const float center[3] = { 0.0f, 0.0f, 20.0f };
+	CHECK(!IsSphereOccluded(pyramid, viewProjection, center, 1.0f));
+}
+
+TEST(SpheresBehindAWallAreOccluded){
+	float viewProjection[16];
+	Perspective(viewProjection, kHalfPi, 1.0f, 1.0f, 100.0f);
+
+	// A wall at depth 0.5, about z = 2, over the left half of the screen.
+	const uint32_t width = 64;
+	const uint32_t height = 48;
+	const std::vector<float> depth = WallDepth(width, height, width / 2, 0.5f);
+	HiZPyramid pyramid;
+	BuildHiZPyramid(pyramid, depth.data(), width, height);
+
+	const float behindLeft[3] = { -5.0f, 0.0f, 20.0f };
+	const float behindRight[3] = { 5.0f, 0.0f, 20.0f };
+	const float inFront[3] = { -0.5f, 0.0f, 1.5f };
+	const float crossingNear[3] = { -5.0f, 0.0f, 0.5f };
+	CHECK(IsSphereOccluded(pyramid, viewProjection, behindLeft, 1.0f));
+	CHECK(!IsSphereOccluded(pyramid, viewProjection, behindRight, 1.0f));
+	CHECK(!IsSphereOccluded(pyramid, viewProjection, inFront, 0.2f));
+	CHECK(!IsSphereOccluded(pyramid, viewProjection, crossingNear, 1.0f));
+
+	// Large enough to reach past the wall's edge into the far right half.
+	CHECK(!IsSphereOccluded(pyramid, viewProjection, behindLeft, 6.0f));
+}
+
+TEST(SecondPhaseOnlyRetestsFirstPhaseRejects){
+	float viewProjection[16];
+	Perspective(viewProjection, kHalfPi, 1.0f, 1.0f, 100.0f);
+	const GpuCullConstants constants = MakeCullConstants(Frustum::FromViewProjection(viewProjection), 4);
+
+	const GpuObjectBounds bounds[] = {
+		{ { -0.5f, 0.0f, 1.5f }, 0.2f },
+		{ { -5.0f, 0.0f, 20.0f }, 1.0f },
+		{ { 0.0f, 0.0f, -20.0f }, 1.0f },
+		{ { 5.0f, 0.0f, 20.0f }, 1.0f },
+	};
+	const GpuDrawArguments drawArgs[] = { Draw(3, 0), Draw(3, 3), Draw(3, 6), Draw(3, 9) };
+	uint32_t visibility[4] = { 0, 0, 0, 0 };
+	GpuIndirectCommand commands[4];
+
+	// Last frame's pyramid has the wall, object 1 hides behind it.
+	const uint32_t width = 64;
+	const uint32_t height = 48;
+	std::vector<float> depth = WallDepth(width, height, width / 2, 0.5f);
+	HiZPyramid pyramid;
+	BuildHiZPyramid(pyramid, depth.data(), width, height);
+
+	uint32_t count = CullOcclusionReference(constants, pyramid, viewProjection, 0, bounds, drawArgs, visibility, commands);
+	CHECK_EQUAL(2u, count);
+	CHECK_EQUAL(0u, commands[0].objectIndex);
+	CHECK_EQUAL(3u, commands[1].objectIndex);
+	CHECK_EQUAL(1u, visibility[0]);
+	CHECK_EQUAL(0u, visibility[1]);
+	// Outside the frustum, marked so phase 1 leaves it alone.
+	CHECK_EQUAL(1u, visibility[2]);
+	CHECK_EQUAL(1u, visibility[3]);
+
+	// The wall is gone this frame, only object 1 is drawn by phase 1.
+	depth = WallDepth(width, height, 0, 0.5f);
+	BuildHiZPyramid(pyramid, depth.data(), width, height);
+	count = CullOcclusionReference(constants, pyramid, viewProjection, 1, bounds, drawArgs, visibility, commands);
+	CHECK_EQUAL(1u, count);
+	CHECK_EQUAL(1u, commands[0].objectIndex);
+	CHECK_EQUAL(3u, commands[0].draw.startVertexLocation);
+	CHECK_EQUAL(1u, visibility[1]);
+}
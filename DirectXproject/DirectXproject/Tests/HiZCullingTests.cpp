@@ -0,0 +1,117 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "HiZCulling.h"
+
+namespace {
+	// Random depth in [0, 1), so any texel dropped or read twice shows up.
+	std::vector<float> MakeDepth(uint32_t width, uint32_t height, uint32_t seed){
+		std::vector<float> depth(size_t(width) * height);
+		uint32_t state = seed;
+		for(float& value : depth){
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<float>(state >> 8) / 16777216.0f;
+		}
+		return depth;
+	}
+
+	// Reduction straight from the depth buffer: texel (x, y) of level mip
+	// covers a 2^(mip+1) square of depth texels, cut off at the buffer edge.
+	float ReferenceTexel(const std::vector<float>& depth, uint32_t width, uint32_t height, uint32_t mip, uint32_t x, uint32_t y){
+		const uint32_t footprint = 2u << mip;
+		const uint32_t x1 = std::min(width, (x + 1) * footprint);
+		const uint32_t y1 = std::min(height, (y + 1) * footprint);
+		float farthest = 0.0f;
+		for(uint32_t sy = y * footprint; sy < y1; sy++){
+			for(uint32_t sx = x * footprint; sx < x1; sx++){
+				farthest = std::max(farthest, depth[size_t(sy) * width + sx]);
+			}
+		}
+		return farthest;
+	}
+
+	bool MatchesReference(uint32_t width, uint32_t height){
+		const std::vector<float> depth = MakeDepth(width, height, width * 131 + height);
+		HiZPyramid pyramid;
+		BuildHiZPyramid(pyramid, depth.data(), width, height);
+
+		const HiZLayout layout = GetHiZLayout(width, height);
+		bool matches = pyramid.width == layout.width && pyramid.height == layout.height && pyramid.GetMipCount() == layout.mipCount;
+		for(uint32_t mip = 0; mip < pyramid.GetMipCount() && matches; mip++){
+			// Every texel of the level reads at least one depth texel.
+			matches = pyramid.GetMipWidth(mip) * (2u << mip) < width + (2u << mip)
+				&& pyramid.GetMipHeight(mip) * (2u << mip) < height + (2u << mip);
+			for(uint32_t y = 0; y < pyramid.GetMipHeight(mip) && matches; y++){
+				for(uint32_t x = 0; x < pyramid.GetMipWidth(mip) && matches; x++){
+					matches = pyramid.Load(mip, x, y) == ReferenceTexel(depth, width, height, mip, x, y);
+				}
+			}
+		}
+		return matches && pyramid.GetMipWidth(pyramid.GetMipCount() - 1) == 1 && pyramid.GetMipHeight(pyramid.GetMipCount() - 1) == 1;
+	}
+}
+
+TEST(PowerOfTwoPyramidMatchesReference){
+	CHECK(MatchesReference(64, 64));
+	CHECK(MatchesReference(128, 32));
+	CHECK(MatchesReference(2, 2));
+}
+
+TEST(NonPowerOfTwoPyramidMatchesReference){
+	// Odd sizes at some level of the chain, where the edge texel repeats.
+	CHECK(MatchesReference(1, 1));
+	CHECK(MatchesReference(1, 7));
+	CHECK(MatchesReference(3, 5));
+	CHECK(MatchesReference(17, 9));
+	CHECK(MatchesReference(100, 37));
+	CHECK(MatchesReference(1366, 768));
+	CHECK(MatchesReference(1920, 1080));
+}
+
+TEST(EdgeTexelsSeeTheLastRowAndColumn){
+	// Far depth only in the last column and row of an odd sized buffer,
+	// which the odd edge of every level has to carry down to 1x1.
+	const uint32_t width = 13;
+	const uint32_t height = 11;
+	std::vector<float> depth(width * height, 0.25f);
+	depth[width - 1] = 0.75f;
+	depth[(height - 1) * width] = 0.5f;
+	HiZPyramid pyramid;
+	BuildHiZPyramid(pyramid, depth.data(), width, height);
+	CHECK_EQUAL(7u, pyramid.width);
+	CHECK_EQUAL(6u, pyramid.height);
+	CHECK_EQUAL(0.75f, pyramid.Load(0, 6, 0));
+	CHECK_EQUAL(0.5f, pyramid.Load(0, 0, 5));
+	CHECK_EQUAL(0.25f, pyramid.Load(0, 3, 3));
+	CHECK_EQUAL(0.75f, pyramid.Load(pyramid.GetMipCount() - 1, 0, 0));
+}
+
+TEST(PaddedTextureHoldsEveryLevel){
+	const uint32_t sizes[][2] = { { 1, 1 }, { 3, 5 }, { 17, 9 }, { 640, 480 }, { 1366, 768 }, { 1920, 1080 }, { 2560, 1440 }, { 3840, 2160 } };
+	for(const uint32_t* size : sizes){
+		const HiZLayout layout = GetHiZLayout(size[0], size[1]);
+		// Powers of two at least as big as level 0.
+		CHECK((layout.textureWidth & (layout.textureWidth - 1)) == 0);
+		CHECK((layout.textureHeight & (layout.textureHeight - 1)) == 0);
+		CHECK(layout.textureWidth >= layout.width && layout.textureWidth < layout.width * 2);
+		CHECK(layout.textureHeight >= layout.height && layout.textureHeight < layout.height * 2);
+
+		HiZPyramid pyramid;
+		const std::vector<float> depth(size_t(size[0]) * size[1], 1.0f);
+		BuildHiZPyramid(pyramid, depth.data(), size[0], size[1]);
+		CHECK_EQUAL(pyramid.GetMipCount(), layout.mipCount);
+		for(uint32_t mip = 0; mip < layout.mipCount; mip++){
+			// D3D mip sizes round down, the padded ones still fit each level.
+			CHECK(pyramid.GetMipWidth(mip) <= std::max(1u, layout.textureWidth >> mip));
+			CHECK(pyramid.GetMipHeight(mip) <= std::max(1u, layout.textureHeight >> mip));
+		}
+	}
+}
+
+TEST(MipCountIsCapped){
+	const HiZLayout layout = GetHiZLayout(1u << 20, 4);
+	CHECK_EQUAL(kHiZMaxMips, layout.mipCount);
+}
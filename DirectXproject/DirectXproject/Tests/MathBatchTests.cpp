@@ -0,0 +1,170 @@
+// The reference below must round every multiply and add on its own, like
+// the kernels it is compared against.
+#if defined(_MSC_VER)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "TestMain.h"
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MathBatch.h"
+
+namespace {
+	struct Random {
+		uint32_t state;
+
+		explicit Random(uint32_t seed) : state(seed) {}
+		// Mixed signs and magnitudes, where a different rounding order shows.
+		float Next(){
+			state = state * 1664525u + 1013904223u;
+			const float unit = static_cast<float>(state >> 8) / 16777216.0f;
+			const float scales[] = { 1e-3f, 1.0f, 37.0f, 1e4f };
+			return (unit - 0.5f) * scales[state & 3];
+		}
+	};
+
+	std::vector<Float4x4> MakeMatrices(size_t count, uint32_t seed){
+		Random random(seed);
+		std::vector<Float4x4> matrices(count);
+		for(Float4x4& matrix : matrices){
+			for(int i = 0; i < 4; i++){
+				for(int j = 0; j < 4; j++){
+					matrix.m[i][j] = random.Next();
+				}
+			}
+		}
+		return matrices;
+	}
+
+	// Written out the way MathBatch.h documents the order.
+	Float4x4 ReferenceMultiply(const Float4x4& a, const Float4x4& b){
+		Float4x4 result;
+		for(int i = 0; i < 4; i++){
+			for(int j = 0; j < 4; j++){
+				result.m[i][j] = ((a.m[i][0] * b.m[0][j] + a.m[i][1] * b.m[1][j]) + a.m[i][2] * b.m[2][j]) + a.m[i][3] * b.m[3][j];
+			}
+		}
+		return result;
+	}
+
+	template<typename T>
+	bool BitEqual(const std::vector<T>& a, const std::vector<T>& b){
+		return a.size() == b.size() && (a.empty() || memcmp(a.data(), b.data(), a.size() * sizeof(T)) == 0);
+	}
+
+	std::vector<MathPath> GetSupportedPaths(){
+		std::vector<MathPath> paths;
+		const MathPath all[] = { MathPath::Scalar, MathPath::SSE4, MathPath::AVX2, MathPath::NEON, MathPath::Auto };
+		for(MathPath path : all){
+			if(IsMathPathSupported(path)){
+				paths.push_back(path);
+			}
+		}
+		return paths;
+	}
+
+	// Every remainder of the 4 and 8 wide loops, and a long run.
+	const size_t kCounts[] = { 0, 1, 2, 3, 5, 7, 8, 9, 15, 16, 17, 1000 };
+}
+
+TEST(ScalarMultiplyMatchesTheDocumentedOrder){
+	std::vector<Float4x4> a = MakeMatrices(100, 1);
+	std::vector<Float4x4> b = MakeMatrices(100, 2);
+	std::vector<Float4x4> expected(100);
+	for(size_t i = 0; i < a.size(); i++){
+		expected[i] = ReferenceMultiply(a[i], b[i]);
+	}
+	std::vector<Float4x4> out(100);
+	MultiplyMatrices(a.data(), b.data(), out.data(), out.size(), MathPath::Scalar);
+	CHECK(BitEqual(expected, out));
+	const Float4x4 single = Multiply(a[7], b[7]);
+	CHECK(memcmp(&expected[7], &single, sizeof(Float4x4)) == 0);
+}
+
+TEST(MultiplyMatricesIsBitExactOnEveryPath){
+	for(size_t count : kCounts){
+		std::vector<Float4x4> a = MakeMatrices(count, 3);
+		std::vector<Float4x4> b = MakeMatrices(count, 4);
+		std::vector<Float4x4> expected(count);
+		MultiplyMatrices(a.data(), b.data(), expected.data(), count, MathPath::Scalar);
+		for(MathPath path : GetSupportedPaths()){
+			std::vector<Float4x4> out(count);
+			MultiplyMatrices(a.data(), b.data(), out.data(), count, path);
+			CHECK(BitEqual(expected, out));
+
+			// In place, out aliasing a and then b.
+			std::vector<Float4x4> inPlace = a;
+			MultiplyMatrices(inPlace.data(), b.data(), inPlace.data(), count, path);
+			CHECK(BitEqual(expected, inPlace));
+			inPlace = b;
+			MultiplyMatrices(a.data(), inPlace.data(), inPlace.data(), count, path);
+			CHECK(BitEqual(expected, inPlace));
+		}
+	}
+}
+
+TEST(TransformPointsIsBitExactOnEveryPath){
+	const Float4x4 m = MakeMatrices(1, 5)[0];
+	for(size_t count : kCounts){
+		Random random(static_cast<uint32_t>(count) + 6);
+		std::vector<Float3> points(count);
+		for(Float3& point : points){
+			point = { random.Next(), random.Next(), random.Next() };
+		}
+
+		std::vector<Float4> expected(count);
+		TransformPoints(m, points.data(), expected.data(), count, MathPath::Scalar);
+		bool matchesReference = true;
+		for(size_t i = 0; i < count; i++){
+			const Float3& p = points[i];
+			matchesReference = matchesReference && expected[i].x == ((p.x * m.m[0][0] + p.y * m.m[1][0]) + p.z * m.m[2][0]) + m.m[3][0]
+				&& expected[i].w == ((p.x * m.m[0][3] + p.y * m.m[1][3]) + p.z * m.m[2][3]) + m.m[3][3];
+		}
+		CHECK(matchesReference);
+
+		for(MathPath path : GetSupportedPaths()){
+			std::vector<Float4> out(count);
+			TransformPoints(m, points.data(), out.data(), count, path);
+			CHECK(BitEqual(expected, out));
+		}
+	}
+}
+
+TEST(ModelViewProjectionIsBitExactOnEveryPath){
+	const Float4x4 view = MakeMatrices(1, 7)[0];
+	const Float4x4 projection = MakeMatrices(1, 8)[0];
+	const Float4x4 viewProjection = ReferenceMultiply(view, projection);
+	for(size_t count : kCounts){
+		std::vector<Float4x4> models = MakeMatrices(count, 9);
+		std::vector<Float4x4> expected(count);
+		for(size_t i = 0; i < count; i++){
+			expected[i] = ReferenceMultiply(models[i], viewProjection);
+		}
+		for(MathPath path : GetSupportedPaths()){
+			std::vector<Float4x4> out(count);
+			ComputeModelViewProjection(models.data(), view, projection, out.data(), count, path);
+			CHECK(BitEqual(expected, out));
+		}
+	}
+}
+
+TEST(UnsupportedPathsFallBackToScalar){
+	std::vector<Float4x4> a = MakeMatrices(9, 10);
+	std::vector<Float4x4> b = MakeMatrices(9, 11);
+	std::vector<Float4x4> expected(9);
+	MultiplyMatrices(a.data(), b.data(), expected.data(), 9, MathPath::Scalar);
+	const MathPath all[] = { MathPath::SSE4, MathPath::AVX2, MathPath::NEON };
+	for(MathPath path : all){
+		std::vector<Float4x4> out(9);
+		MultiplyMatrices(a.data(), b.data(), out.data(), 9, path);
+		CHECK(BitEqual(expected, out));
+	}
+}
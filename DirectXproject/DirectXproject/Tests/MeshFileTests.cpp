@@ -0,0 +1,211 @@
+#include "TestMain.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "MeshFile.h"
+
+namespace {
+	const char* kTestPath = "MeshFileTests.mesh";
+
+	// A size x size grid of float3 positions, two triangles per cell.
+	void MakeGrid(uint32_t size, std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		for(uint32_t y = 0; y <= size; y++){
+			for(uint32_t x = 0; x <= size; x++){
+				positions.push_back(static_cast<float>(x));
+				positions.push_back(static_cast<float>(y));
+				positions.push_back(static_cast<float>((x + y) % 3));
+			}
+		}
+		for(uint32_t y = 0; y < size; y++){
+			for(uint32_t x = 0; x < size; x++){
+				uint32_t a = y * (size + 1) + x;
+				uint32_t c = a + size + 1;
+				indices.insert(indices.end(), { a, a + 1, c + 1, a, c + 1, c });
+			}
+		}
+	}
+
+	MeshFileDesc MakeDesc(const std::vector<float>& positions, const std::vector<uint32_t>& indices){
+		MeshFileDesc desc;
+		desc.vertices = reinterpret_cast<const uint8_t*>(positions.data());
+		desc.vertexCount = static_cast<uint32_t>(positions.size() / 3);
+		desc.format.ComputeLayout();
+		desc.indices = indices.data();
+		desc.indexCount = static_cast<uint32_t>(indices.size());
+		desc.positions = positions.data();
+		return desc;
+	}
+
+	std::vector<uint8_t> ReadWholeFile(const char* path){
+		std::vector<uint8_t> bytes;
+		FILE* file = fopen(path, "rb");
+		if(file){
+			uint8_t buffer[4096];
+			size_t read;
+			while((read = fread(buffer, 1, sizeof(buffer), file)) > 0){
+				bytes.insert(bytes.end(), buffer, buffer + read);
+			}
+			fclose(file);
+		}
+		return bytes;
+	}
+
+	void WriteWholeFile(const char* path, const std::vector<uint8_t>& bytes){
+		FILE* file = fopen(path, "wb");
+		if(file){
+			fwrite(bytes.data(), 1, bytes.size(), file);
+			fclose(file);
+		}
+	}
+
+	std::vector<uint32_t> UnpackIndices(const MeshFile& mesh){
+		std::vector<uint32_t> indices(mesh.GetHeader().indexCount);
+		for(size_t i = 0; i < indices.size(); i++){
+			if(mesh.GetIndexFormat() == IndexFormat::UInt16){
+				uint16_t index;
+				memcpy(&index, mesh.GetIndexData() + i * 2, 2);
+				indices[i] = index;
+			}else{
+				memcpy(&indices[i], mesh.GetIndexData() + i * 4, 4);
+			}
+		}
+		return indices;
+	}
+
+	bool IsAligned(const uint8_t* base, const uint8_t* pointer){
+		return (pointer - base) % kMeshFileAlignment == 0;
+	}
+}
+
+TEST(RoundTripKeepsStreamsAndBounds){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(8, positions, indices);
+	MeshFileDesc desc = MakeDesc(positions, indices);
+	// Two submeshes, the lower and upper half of the grid.
+	const uint32_t half = desc.indexCount / 2;
+	desc.submeshes.push_back({ 0, half, 0, 3, { 0.0f, 0.0f, 0.0f }, 0.0f });
+	desc.submeshes.push_back({ half, desc.indexCount - half, 0, 7, { 0.0f, 0.0f, 0.0f }, 0.0f });
+	CHECK(WriteMeshFile(kTestPath, desc));
+
+	MeshFile mesh;
+	CHECK(mesh.Open(kTestPath));
+	if(mesh.IsOpen()){
+		const MeshFileHeader& header = mesh.GetHeader();
+		const uint8_t* base = reinterpret_cast<const uint8_t*>(&header);
+		CHECK_EQUAL(desc.vertexCount, header.vertexCount);
+		CHECK_EQUAL(desc.indexCount, header.indexCount);
+		CHECK_EQUAL(desc.format.stride, mesh.GetVertexFormat().stride);
+		CHECK(mesh.GetIndexFormat() == IndexFormat::UInt16);
+		CHECK_EQUAL(positions.size() * sizeof(float), mesh.GetVertexDataSize());
+		CHECK(memcmp(positions.data(), mesh.GetVertexData(), mesh.GetVertexDataSize()) == 0);
+		CHECK(indices == UnpackIndices(mesh));
+		CHECK(IsAligned(base, mesh.GetVertexData()));
+		CHECK(IsAligned(base, mesh.GetIndexData()));
+		CHECK(IsAligned(base, reinterpret_cast<const uint8_t*>(mesh.GetSubmeshes())));
+
+		CHECK_EQUAL(0.0f, header.aabbMin[0]);
+		CHECK_EQUAL(8.0f, header.aabbMax[1]);
+		CHECK_EQUAL(2.0f, header.aabbMax[2]);
+		CHECK_EQUAL(4.0f, header.sphereCenter[0]);
+
+		CHECK_EQUAL(2u, mesh.GetSubmeshCount());
+		const MeshFileSubmesh* submeshes = mesh.GetSubmeshes();
+		CHECK_EQUAL(half, submeshes[1].indexStart);
+		CHECK_EQUAL(7u, submeshes[1].material);
+		// The lower half never reaches the top row, the upper half does.
+		CHECK(submeshes[0].center[1] < submeshes[1].center[1]);
+		CHECK(submeshes[0].radius > 0.0f);
+	}
+	mesh.Close();
+	remove(kTestPath);
+}
+
+TEST(LargeMeshesUse32BitIndices){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(256, positions, indices);
+	CHECK(positions.size() / 3 >= 0x10000);
+	CHECK(WriteMeshFile(kTestPath, MakeDesc(positions, indices)));
+
+	MeshFile mesh;
+	CHECK(mesh.Open(kTestPath));
+	if(mesh.IsOpen()){
+		CHECK(mesh.GetIndexFormat() == IndexFormat::UInt32);
+		CHECK(indices == UnpackIndices(mesh));
+		// No submeshes given, one covers everything.
+		CHECK_EQUAL(1u, mesh.GetSubmeshCount());
+		CHECK_EQUAL(static_cast<uint32_t>(indices.size()), mesh.GetSubmeshes()[0].indexCount);
+	}
+	mesh.Close();
+	remove(kTestPath);
+}
+
+TEST(WriteRejectsOutOfRangeIndices){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(2, positions, indices);
+	indices[4] = static_cast<uint32_t>(positions.size() / 3);
+	CHECK(!WriteMeshFile(kTestPath, MakeDesc(positions, indices)));
+
+	indices[4] = 0;
+	MeshFileDesc desc = MakeDesc(positions, indices);
+	desc.submeshes.push_back({ 3, desc.indexCount, 0, 0, { 0.0f, 0.0f, 0.0f }, 0.0f });
+	CHECK(!WriteMeshFile(kTestPath, desc));
+}
+
+TEST(OpenRejectsDamagedFiles){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(4, positions, indices);
+	CHECK(WriteMeshFile(kTestPath, MakeDesc(positions, indices)));
+	const std::vector<uint8_t> original = ReadWholeFile(kTestPath);
+	CHECK(original.size() > sizeof(MeshFileHeader));
+
+	MeshFile mesh;
+	// Cut off inside the index stream.
+	std::vector<uint8_t> bytes(original.begin(), original.end() - 2);
+	WriteWholeFile(kTestPath, bytes);
+	CHECK(!mesh.Open(kTestPath));
+
+	// Shorter than a header.
+	bytes.assign(original.begin(), original.begin() + 16);
+	WriteWholeFile(kTestPath, bytes);
+	CHECK(!mesh.Open(kTestPath));
+
+	// Wrong magic.
+	bytes = original;
+	bytes[0] ^= 0xFF;
+	WriteWholeFile(kTestPath, bytes);
+	CHECK(!mesh.Open(kTestPath));
+
+	// A vertex stream pointing past the end.
+	bytes = original;
+	MeshFileHeader header;
+	memcpy(&header, bytes.data(), sizeof(header));
+	header.vertexOffset = header.fileSize;
+	memcpy(bytes.data(), &header, sizeof(header));
+	WriteWholeFile(kTestPath, bytes);
+	CHECK(!mesh.Open(kTestPath));
+
+	// A submesh reaching past the index count.
+	bytes = original;
+	memcpy(&header, bytes.data(), sizeof(header));
+	MeshFileSubmesh submesh;
+	memcpy(&submesh, bytes.data() + header.submeshOffset, sizeof(submesh));
+	submesh.indexCount++;
+	memcpy(bytes.data() + header.submeshOffset, &submesh, sizeof(submesh));
+	WriteWholeFile(kTestPath, bytes);
+	CHECK(!mesh.Open(kTestPath));
+
+	// And the untouched file still opens.
+	WriteWholeFile(kTestPath, original);
+	CHECK(mesh.Open(kTestPath));
+	mesh.Close();
+	remove(kTestPath);
+}
@@ -0,0 +1,159 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "MeshOptimizer.h"
+
+namespace {
+	// A grid of quads with its triangles shuffled, the worst case for the cache.
+	void MakeShuffledGrid(int size, std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		for(int y = 0; y <= size; y++){
+			for(int x = 0; x <= size; x++){
+				positions.push_back(static_cast<float>(x));
+				positions.push_back(static_cast<float>(y));
+				positions.push_back(0.0f);
+			}
+		}
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for(int y = 0; y < size; y++){
+			for(int x = 0; x < size; x++){
+				uint32_t a = y * (size + 1) + x;
+				uint32_t b = a + 1;
+				uint32_t c = a + size + 1;
+				uint32_t d = c + 1;
+				triangles.push_back({ a, b, d });
+				triangles.push_back({ a, d, c });
+			}
+		}
+		uint32_t state = 12345;
+		for(size_t i = triangles.size(); i > 1; i--){
+			state = state * 1664525u + 1013904223u;
+			std::swap(triangles[i - 1], triangles[(state >> 8) % i]);
+		}
+		for(const std::array<uint32_t, 3>& triangle : triangles){
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	// Triangles as sorted position triples, so reordering and rotating
+	// corners compares equal but any change to the geometry does not.
+	std::vector<std::array<float, 9>> GetTriangleSet(const float* positions, const uint32_t* indices, size_t indexCount){
+		std::vector<std::array<float, 9>> set;
+		for(size_t i = 0; i < indexCount; i += 3){
+			// Rotate so the smallest index comes first, which keeps the winding.
+			size_t first = i;
+			for(size_t k = 1; k < 3; k++){
+				const float* candidate = positions + indices[i + k] * 3;
+				const float* best = positions + indices[first] * 3;
+				if(std::lexicographical_compare(candidate, candidate + 3, best, best + 3)){
+					first = i + k;
+				}
+			}
+			std::array<float, 9> triangle;
+			for(size_t k = 0; k < 3; k++){
+				const size_t corner = i + (first - i + k) % 3;
+				memcpy(&triangle[k * 3], positions + indices[corner] * 3, sizeof(float) * 3);
+			}
+			set.push_back(triangle);
+		}
+		std::sort(set.begin(), set.end());
+		return set;
+	}
+
+	// Two unit quads facing +z, one at z = 0 and one at z = 1.
+	void MakeStackedQuads(std::vector<float>& positions, std::vector<uint32_t>& farFirst, std::vector<uint32_t>& nearFirst){
+		positions = {
+			0.0f, 0.0f, 0.0f,  1.0f, 0.0f, 0.0f,  1.0f, 1.0f, 0.0f,  0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 1.0f,  1.0f, 0.0f, 1.0f,  1.0f, 1.0f, 1.0f,  0.0f, 1.0f, 1.0f
+		};
+		farFirst = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 4, 6, 7 };
+		nearFirst = { 4, 5, 6, 4, 6, 7, 0, 1, 2, 0, 2, 3 };
+	}
+}
+
+TEST(VertexCacheOptimizationKeepsTrianglesAndLowersAcmr){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeShuffledGrid(32, positions, indices);
+	const size_t vertexCount = positions.size() / 3;
+
+	const VertexCacheStats before = AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+	std::vector<uint32_t> optimized(indices.size());
+	OptimizeVertexCache(optimized.data(), indices.data(), indices.size(), vertexCount);
+	const VertexCacheStats after = AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount);
+
+	CHECK(GetTriangleSet(positions.data(), indices.data(), indices.size()) == GetTriangleSet(positions.data(), optimized.data(), optimized.size()));
+	CHECK(before.acmr > 2.0f);
+	// A regular grid should end up close to one miss per two triangles.
+	CHECK(after.acmr < 0.8f);
+	CHECK(after.atvr < before.atvr);
+}
+
+TEST(OverdrawCountsEveryShadedLayer){
+	std::vector<float> positions;
+	std::vector<uint32_t> farFirst;
+	std::vector<uint32_t> nearFirst;
+	MakeStackedQuads(positions, farFirst, nearFirst);
+
+	// Seen from +z only, the quads are edge on or facing away elsewhere.
+	const OverdrawStats far = AnalyzeOverdraw(farFirst.data(), farFirst.size(), positions.data(), 8, sizeof(float) * 3);
+	const OverdrawStats near = AnalyzeOverdraw(nearFirst.data(), nearFirst.size(), positions.data(), 8, sizeof(float) * 3);
+	CHECK_EQUAL(far.pixelsCovered, near.pixelsCovered);
+	CHECK(far.pixelsCovered > 0);
+	CHECK_EQUAL(1.0f, near.overdraw);
+	CHECK_EQUAL(2.0f, far.overdraw);
+}
+
+TEST(OverdrawOptimizationDrawsOutsideFirst){
+	// Both quads face +z, the one at z = 1 sits further out along its
+	// normal from the mesh center and has to move to the front.
+	std::vector<float> positions;
+	std::vector<uint32_t> farFirst;
+	std::vector<uint32_t> nearFirst;
+	MakeStackedQuads(positions, farFirst, nearFirst);
+
+	std::vector<uint32_t> optimized(farFirst.size());
+	OptimizeOverdraw(optimized.data(), farFirst.data(), farFirst.size(), positions.data(), 8, sizeof(float) * 3, 100.0f);
+	const OverdrawStats after = AnalyzeOverdraw(optimized.data(), optimized.size(), positions.data(), 8, sizeof(float) * 3);
+	CHECK_EQUAL(1.0f, after.overdraw);
+}
+
+TEST(OptimizeMeshKeepsGeometryAndPacksVertices){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeShuffledGrid(16, positions, indices);
+	// One vertex no triangle uses, it must be dropped.
+	positions.push_back(99.0f);
+	positions.push_back(99.0f);
+	positions.push_back(99.0f);
+	const std::vector<std::array<float, 9>> original = GetTriangleSet(positions.data(), indices.data(), indices.size());
+
+	std::vector<uint8_t> vertices(positions.size() * sizeof(float));
+	memcpy(vertices.data(), positions.data(), vertices.size());
+	const MeshOptimizationReport report = OptimizeMesh(vertices, sizeof(float) * 3, 0, indices);
+
+	CHECK_EQUAL(positions.size() / 3, report.vertexCountBefore);
+	CHECK_EQUAL(positions.size() / 3 - 1, report.vertexCountAfter);
+	CHECK_EQUAL(report.vertexCountAfter * sizeof(float) * 3, vertices.size());
+	CHECK(report.after.acmr < report.before.acmr);
+	CHECK(report.indexFormat == IndexFormat::UInt16);
+	CHECK(original == GetTriangleSet(reinterpret_cast<const float*>(vertices.data()), indices.data(), indices.size()));
+
+	// Vertex fetch order: vertices appear in the order indices first use them.
+	uint32_t next = 0;
+	bool ordered = true;
+	for(uint32_t index : indices){
+		if(index == next){
+			next++;
+		}else{
+			ordered = ordered && index < next;
+		}
+	}
+	CHECK(ordered);
+}
@@ -0,0 +1,294 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <vector>
+
+#include "MeshSimplifier.h"
+
+namespace {
+	struct Position {
+		float p[3];
+	};
+
+	struct TestMesh {
+		std::vector<Position> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// Unit UV sphere, closed. With seam set the first column is duplicated
+	// at the end like a UV seam, same positions under other indices.
+	TestMesh MakeSphere(int rings, int segments, bool seam){
+		TestMesh mesh;
+		const int columns = seam ? segments + 1 : segments;
+		mesh.positions.push_back({ { 0.0f, 1.0f, 0.0f } });
+		for(int r = 1; r < rings; r++){
+			const float theta = 3.14159265f * r / rings;
+			for(int s = 0; s < columns; s++){
+				const float phi = 2.0f * 3.14159265f * (s % segments) / segments;
+				mesh.positions.push_back({ { sinf(theta) * cosf(phi), cosf(theta), sinf(theta) * sinf(phi) } });
+			}
+		}
+		mesh.positions.push_back({ { 0.0f, -1.0f, 0.0f } });
+		const uint32_t south = static_cast<uint32_t>(mesh.positions.size() - 1);
+
+		auto at = [&](int r, int s){ return static_cast<uint32_t>(1 + (r - 1) * columns + (seam ? s : s % segments)); };
+		for(int s = 0; s < segments; s++){
+			mesh.indices.insert(mesh.indices.end(), { 0u, at(1, s + 1), at(1, s) });
+			mesh.indices.insert(mesh.indices.end(), { south, at(rings - 1, s), at(rings - 1, s + 1) });
+		}
+		for(int r = 1; r < rings - 1; r++){
+			for(int s = 0; s < segments; s++){
+				const uint32_t a = at(r, s), b = at(r, s + 1), c = at(r + 1, s), d = at(r + 1, s + 1);
+				mesh.indices.insert(mesh.indices.end(), { a, b, d, a, d, c });
+			}
+		}
+		return mesh;
+	}
+
+	// Cube from -1 to 1 with every face split into a cells by cells grid,
+	// closed, vertices shared along the edges.
+	TestMesh MakeGridCube(int cells){
+		TestMesh mesh;
+		std::map<std::vector<int>, uint32_t> vertexAt;
+		auto vertex = [&](const int grid[3]){
+			std::vector<int> key(grid, grid + 3);
+			auto found = vertexAt.find(key);
+			if(found != vertexAt.end()){
+				return found->second;
+			}
+			const uint32_t index = static_cast<uint32_t>(mesh.positions.size());
+			mesh.positions.push_back({ { grid[0] * 2.0f / cells - 1.0f, grid[1] * 2.0f / cells - 1.0f, grid[2] * 2.0f / cells - 1.0f } });
+			vertexAt[key] = index;
+			return index;
+		};
+
+		for(int axis = 0; axis < 3; axis++){
+			for(int side = 0; side < 2; side++){
+				const int u = (axis + 1) % 3, v = (axis + 2) % 3;
+				for(int i = 0; i < cells; i++){
+					for(int j = 0; j < cells; j++){
+						uint32_t corners[4];
+						for(int c = 0; c < 4; c++){
+							int grid[3];
+							grid[axis] = side * cells;
+							grid[u] = i + (c == 1 || c == 2 ? 1 : 0);
+							grid[v] = j + (c >= 2 ? 1 : 0);
+							corners[c] = vertex(grid);
+						}
+						// Outward facing, clockwise seen from outside.
+						if(side == 0){
+							mesh.indices.insert(mesh.indices.end(), { corners[0], corners[1], corners[2], corners[0], corners[2], corners[3] });
+						}else{
+							mesh.indices.insert(mesh.indices.end(), { corners[0], corners[2], corners[1], corners[0], corners[3], corners[2] });
+						}
+					}
+				}
+			}
+		}
+		return mesh;
+	}
+
+	float Distance(const float* a, const float* b){
+		const float d[3] = { a[0] - b[0], a[1] - b[1], a[2] - b[2] };
+		return sqrtf(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+	}
+
+	float SegmentDistance(const float* p, const float* a, const float* b){
+		const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float ap[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+		const float length = ab[0] * ab[0] + ab[1] * ab[1] + ab[2] * ab[2];
+		const float t = length > 0.0f ? std::min(std::max((ap[0] * ab[0] + ap[1] * ab[1] + ap[2] * ab[2]) / length, 0.0f), 1.0f) : 0.0f;
+		const float closest[3] = { a[0] + t * ab[0], a[1] + t * ab[1], a[2] + t * ab[2] };
+		return Distance(p, closest);
+	}
+
+	// Reference point to triangle distance: the plane when p projects
+	// inside, otherwise the nearest edge.
+	float TriangleDistance(const float* p, const float* a, const float* b, const float* c){
+		const float ab[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+		const float ac[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+		float n[3] = { ab[1] * ac[2] - ab[2] * ac[1], ab[2] * ac[0] - ab[0] * ac[2], ab[0] * ac[1] - ab[1] * ac[0] };
+		const float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+		if(length > 0.0f){
+			for(float& k : n){
+				k /= length;
+			}
+			const float height = (p[0] - a[0]) * n[0] + (p[1] - a[1]) * n[1] + (p[2] - a[2]) * n[2];
+			const float q[3] = { p[0] - height * n[0], p[1] - height * n[1], p[2] - height * n[2] };
+			const float* corners[3] = { a, b, c };
+			bool inside = true;
+			for(int k = 0; k < 3; k++){
+				const float* e0 = corners[k];
+				const float* e1 = corners[(k + 1) % 3];
+				const float edge[3] = { e1[0] - e0[0], e1[1] - e0[1], e1[2] - e0[2] };
+				const float toQ[3] = { q[0] - e0[0], q[1] - e0[1], q[2] - e0[2] };
+				const float cross[3] = { edge[1] * toQ[2] - edge[2] * toQ[1], edge[2] * toQ[0] - edge[0] * toQ[2], edge[0] * toQ[1] - edge[1] * toQ[0] };
+				inside = inside && cross[0] * n[0] + cross[1] * n[1] + cross[2] * n[2] >= 0.0f;
+			}
+			if(inside){
+				return fabsf(height);
+			}
+		}
+		return std::min(SegmentDistance(p, a, b), std::min(SegmentDistance(p, b, c), SegmentDistance(p, c, a)));
+	}
+
+	// Largest distance from an input vertex to the simplified triangles.
+	float MeasureDeviation(const TestMesh& mesh, const std::vector<uint32_t>& indices){
+		float deviation = 0.0f;
+		for(const Position& position : mesh.positions){
+			float best = 1e30f;
+			for(size_t i = 0; i < indices.size(); i += 3){
+				best = std::min(best, TriangleDistance(position.p, mesh.positions[indices[i]].p,
+					mesh.positions[indices[i + 1]].p, mesh.positions[indices[i + 2]].p));
+			}
+			deviation = std::max(deviation, best);
+		}
+		return deviation;
+	}
+
+	float Simplify(const TestMesh& mesh, std::vector<uint32_t>& out, size_t targetIndexCount, float maxError){
+		return SimplifyMesh(out, mesh.indices.data(), mesh.indices.size(), mesh.positions[0].p, mesh.positions.size(),
+			sizeof(Position), targetIndexCount, maxError);
+	}
+}
+
+TEST(SimplifyMeshKeepsEveryVertexWithinTheReportedError){
+	const TestMesh sphere = MakeSphere(16, 32, false);
+	const float maxErrors[] = { 0.005f, 0.02f, 0.05f };
+	size_t previousCount = sphere.indices.size();
+	for(float maxError : maxErrors){
+		std::vector<uint32_t> out;
+		const float error = Simplify(sphere, out, 0, maxError);
+		CHECK(error <= maxError);
+		CHECK(error > 0.0f);
+		// A looser bound removes more.
+		CHECK(out.size() < previousCount);
+		previousCount = out.size();
+		CHECK(MeasureDeviation(sphere, out) <= error * 1.001f + 1e-6f);
+	}
+}
+
+TEST(SimplifyMeshStopsAtTheTargetCount){
+	const TestMesh sphere = MakeSphere(16, 32, false);
+	std::vector<uint32_t> out;
+	const float error = Simplify(sphere, out, 300 * 3, 1.0f);
+	// Each collapse removes two triangles.
+	CHECK(out.size() <= 300 * 3);
+	CHECK(out.size() >= 298 * 3);
+	CHECK(MeasureDeviation(sphere, out) <= error * 1.001f + 1e-6f);
+
+	// Nothing to do: the input comes back as is, with no error.
+	CHECK_EQUAL(0.0f, Simplify(sphere, out, sphere.indices.size(), 1.0f));
+	CHECK(out == sphere.indices);
+}
+
+TEST(SimplifyMeshCollapsesFlatFacesWithoutError){
+	const TestMesh cube = MakeGridCube(6);
+	CHECK_EQUAL(size_t(6 * 6 * 6 * 2 * 3), cube.indices.size());
+	std::vector<uint32_t> out;
+	const float error = Simplify(cube, out, 0, 1e-4f);
+	CHECK(error <= 1e-4f);
+	CHECK(out.size() * 8 < cube.indices.size());
+	CHECK(MeasureDeviation(cube, out) <= 1e-4f);
+}
+
+TEST(SimplifyMeshKeepsSeamVertices){
+	const TestMesh sphere = MakeSphere(16, 32, true);
+	std::vector<uint32_t> out;
+	Simplify(sphere, out, 0, 0.1f);
+	CHECK(out.size() * 2 < sphere.indices.size());
+
+	// Both copies of every seam vertex are still used.
+	const uint32_t columns = 33;
+	int missing = 0;
+	for(uint32_t r = 0; r < 15; r++){
+		const uint32_t first = 1 + r * columns;
+		const uint32_t last = first + 32;
+		missing += std::find(out.begin(), out.end(), first) == out.end() ? 1 : 0;
+		missing += std::find(out.begin(), out.end(), last) == out.end() ? 1 : 0;
+	}
+	CHECK_EQUAL(0, missing);
+}
+
+TEST(LodChainErrorsGrowWithinTheBudget){
+	const TestMesh sphere = MakeSphere(24, 48, false);
+	LodChainSettings settings;
+	std::vector<MeshLod> lods;
+	BuildLodChain(lods, sphere.indices.data(), sphere.indices.size(), sphere.positions[0].p, sphere.positions.size(), sizeof(Position), settings);
+
+	CHECK(lods.size() >= 3);
+	CHECK(lods.size() <= settings.maxLods);
+	CHECK(lods[0].indices == sphere.indices);
+	CHECK_EQUAL(0.0f, lods[0].error);
+	// Half diagonal of the unit sphere's box.
+	const float maxError = sqrtf(3.0f) * settings.maxRelativeError;
+	for(size_t i = 1; i < lods.size(); i++){
+		CHECK(lods[i].error >= lods[i - 1].error);
+		CHECK(lods[i].error <= maxError);
+		CHECK(lods[i].indices.size() <= lods[i - 1].indices.size() * (1.0f - settings.minSaving));
+		// Errors add up along the chain, so they bound the distance to LOD 0 too.
+		CHECK(MeasureDeviation(sphere, lods[i].indices) <= lods[i].error * 1.001f + 1e-6f);
+	}
+}
+
+TEST(LodChainsMatchOneChainPerMesh){
+	const TestMesh sphere = MakeSphere(12, 24, false);
+	const TestMesh cube = MakeGridCube(4);
+	std::vector<LodSourceMesh> meshes = {
+		{ sphere.indices.data(), sphere.indices.size(), sphere.positions[0].p, sphere.positions.size(), sizeof(Position) },
+		{ cube.indices.data(), cube.indices.size(), cube.positions[0].p, cube.positions.size(), sizeof(Position) },
+	};
+	std::vector<std::vector<MeshLod>> chains;
+	BuildLodChains(chains, meshes);
+	CHECK_EQUAL(size_t(2), chains.size());
+	for(size_t m = 0; m < meshes.size(); m++){
+		std::vector<MeshLod> expected;
+		BuildLodChain(expected, meshes[m].indices, meshes[m].indexCount, meshes[m].positions, meshes[m].vertexCount, meshes[m].positionStride);
+		CHECK_EQUAL(expected.size(), chains[m].size());
+		for(size_t i = 0; i < expected.size() && i < chains[m].size(); i++){
+			CHECK(expected[i].indices == chains[m][i].indices);
+			CHECK_EQUAL(expected[i].error, chains[m][i].error);
+		}
+	}
+}
+
+TEST(SelectLodPicksTheCoarsestLevelUnderThePixelThreshold){
+	// At distance d an error e covers e * 1000 / d pixels.
+	const MeshLod lods[4] = { { {}, 0.0f }, { {}, 0.01f }, { {}, 0.04f }, { {}, 0.16f } };
+	CHECK_EQUAL(540.0f, ComputeProjectionScale(1080.0f, 3.14159265f * 0.5f));
+
+	// Near: 0.5, 2 and 8 pixels. Level 1 is under the coarser threshold of 0.8.
+	CHECK_EQUAL(1u, SelectLod(lods, 4, 20.0f, 1000.0f, 1.0f, 0));
+	// Too coarse goes finer at once, as far as needed.
+	CHECK_EQUAL(1u, SelectLod(lods, 4, 20.0f, 1000.0f, 1.0f, 3));
+	CHECK_EQUAL(0u, SelectLod(lods, 4, 5.0f, 1000.0f, 1.0f, 3));
+	// Far enough for everything.
+	CHECK_EQUAL(3u, SelectLod(lods, 4, 1000.0f, 1000.0f, 1.0f, 0));
+	// No levels, or a current level past the end.
+	CHECK_EQUAL(0u, SelectLod(lods, 0, 20.0f, 1000.0f, 1.0f, 2));
+	CHECK_EQUAL(3u, SelectLod(lods, 4, 1000.0f, 1000.0f, 1.0f, 9));
+}
+
+TEST(SelectLodHysteresisKeepsTheLevelAtTheBoundary){
+	const MeshLod lods[4] = { { {}, 0.0f }, { {}, 0.01f }, { {}, 0.04f }, { {}, 0.16f } };
+	// At 45 level 2 covers 0.89 pixels: fine to keep, not enough to switch to.
+	CHECK_EQUAL(1u, SelectLod(lods, 4, 45.0f, 1000.0f, 1.0f, 1));
+	CHECK_EQUAL(2u, SelectLod(lods, 4, 45.0f, 1000.0f, 1.0f, 2));
+	CHECK_EQUAL(2u, SelectLod(lods, 4, 60.0f, 1000.0f, 1.0f, 1));
+	// Without hysteresis the boundary is the threshold itself.
+	CHECK_EQUAL(2u, SelectLod(lods, 4, 45.0f, 1000.0f, 1.0f, 1, 0.0f));
+
+	// Jitter around the distance where level 2 reaches one pixel switches
+	// once and then holds.
+	uint32_t lod = 2;
+	int switches = 0;
+	for(int frame = 0; frame < 100; frame++){
+		const uint32_t picked = SelectLod(lods, 4, frame % 2 ? 38.0f : 42.0f, 1000.0f, 1.0f, lod);
+		switches += picked != lod ? 1 : 0;
+		lod = picked;
+	}
+	CHECK_EQUAL(1, switches);
+	CHECK_EQUAL(1u, lod);
+}
@@ -0,0 +1,221 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "MeshletBuilder.h"
+
+namespace {
+	// size x size quads in the z = 0 plane. With shuffle the triangle order
+	// is randomized, so growth can't just follow the input.
+	void MakeGrid(uint32_t size, bool shuffle, std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		for(uint32_t y = 0; y <= size; y++){
+			for(uint32_t x = 0; x <= size; x++){
+				positions.insert(positions.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+			}
+		}
+		std::vector<std::array<uint32_t, 3>> triangles;
+		for(uint32_t y = 0; y < size; y++){
+			for(uint32_t x = 0; x < size; x++){
+				uint32_t a = y * (size + 1) + x;
+				uint32_t c = a + size + 1;
+				triangles.push_back({ a, c + 1, a + 1 });
+				triangles.push_back({ a, c, c + 1 });
+			}
+		}
+		uint32_t state = 12345;
+		for(size_t i = triangles.size(); shuffle && i > 1; i--){
+			state = state * 1664525u + 1013904223u;
+			std::swap(triangles[i - 1], triangles[(state >> 8) % i]);
+		}
+		for(const std::array<uint32_t, 3>& triangle : triangles){
+			indices.insert(indices.end(), triangle.begin(), triangle.end());
+		}
+	}
+
+	// Triangles sharing no vertices, so the vertex limit is what fills a meshlet.
+	void MakeSoup(uint32_t triangleCount, std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		for(uint32_t t = 0; t < triangleCount; t++){
+			const float x = static_cast<float>(t % 100) * 2.0f;
+			const float y = static_cast<float>(t / 100) * 2.0f;
+			positions.insert(positions.end(), { x, y, 0.0f, x, y + 1.0f, 0.0f, x + 1.0f, y, 0.0f });
+			indices.insert(indices.end(), { t * 3, t * 3 + 1, t * 3 + 2 });
+		}
+	}
+
+	// Every triangle over a dozen points on a sphere, 220 triangles on 12
+	// vertices, so the triangle limit is what fills a meshlet.
+	void MakeDense(std::vector<float>& positions, std::vector<uint32_t>& indices){
+		positions.clear();
+		indices.clear();
+		const uint32_t count = 12;
+		for(uint32_t i = 0; i < count; i++){
+			const float theta = 2.39996f * i;
+			const float z = 1.0f - 2.0f * (i + 0.5f) / count;
+			const float r = sqrtf(1.0f - z * z);
+			positions.insert(positions.end(), { r * cosf(theta), r * sinf(theta), z });
+		}
+		for(uint32_t a = 0; a < count; a++){
+			for(uint32_t b = a + 1; b < count; b++){
+				for(uint32_t c = b + 1; c < count; c++){
+					indices.insert(indices.end(), { a, b, c });
+				}
+			}
+		}
+	}
+
+	// Triangles rotated to start at their smallest index, which keeps the winding.
+	std::vector<std::array<uint32_t, 3>> Canonical(std::vector<std::array<uint32_t, 3>> triangles){
+		for(std::array<uint32_t, 3>& triangle : triangles){
+			std::rotate(triangle.begin(), std::min_element(triangle.begin(), triangle.end()), triangle.end());
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	// Checks every limit and that the meshlets hold each input triangle
+	// exactly once with its winding. Returns the meshlet count.
+	size_t CheckMeshlets(const std::vector<float>& positions, const std::vector<uint32_t>& indices){
+		MeshletMesh mesh;
+		BuildMeshlets(positions.data(), positions.size() / 3, sizeof(float) * 3, indices.data(), indices.size(), mesh);
+		CHECK_EQUAL(mesh.meshlets.size(), mesh.bounds.size());
+
+		std::vector<std::array<uint32_t, 3>> input;
+		for(size_t i = 0; i < indices.size(); i += 3){
+			input.push_back({ indices[i], indices[i + 1], indices[i + 2] });
+		}
+
+		std::vector<std::array<uint32_t, 3>> output;
+		uint32_t vertexOffset = 0;
+		uint32_t triangleOffset = 0;
+		for(size_t m = 0; m < mesh.meshlets.size(); m++){
+			const Meshlet& meshlet = mesh.meshlets[m];
+			CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= kMeshletMaxVertices);
+			CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= kMeshletMaxTriangles);
+			// Packed back to back.
+			CHECK_EQUAL(vertexOffset, meshlet.vertexOffset);
+			CHECK_EQUAL(triangleOffset, meshlet.triangleOffset);
+			vertexOffset += meshlet.vertexCount;
+			triangleOffset += meshlet.triangleCount;
+
+			std::vector<uint32_t> vertices(mesh.vertices.begin() + meshlet.vertexOffset, mesh.vertices.begin() + meshlet.vertexOffset + meshlet.vertexCount);
+			std::sort(vertices.begin(), vertices.end());
+			CHECK(std::adjacent_find(vertices.begin(), vertices.end()) == vertices.end());
+
+			const MeshletBounds& bounds = mesh.bounds[m];
+			for(uint32_t vertex : vertices){
+				const float* p = &positions[vertex * 3];
+				const float dx = p[0] - bounds.center[0];
+				const float dy = p[1] - bounds.center[1];
+				const float dz = p[2] - bounds.center[2];
+				CHECK(sqrtf(dx * dx + dy * dy + dz * dz) <= bounds.radius * 1.0001f + 1e-6f);
+			}
+
+			for(uint32_t t = 0; t < meshlet.triangleCount; t++){
+				const uint32_t packed = mesh.triangles[meshlet.triangleOffset + t];
+				CHECK_EQUAL(0u, packed >> 24);
+				std::array<uint32_t, 3> triangle;
+				for(int k = 0; k < 3; k++){
+					const uint32_t local = (packed >> (k * 8)) & 0xFF;
+					CHECK(local < meshlet.vertexCount);
+					triangle[k] = mesh.vertices[meshlet.vertexOffset + std::min(local, meshlet.vertexCount - 1)];
+				}
+				output.push_back(triangle);
+			}
+		}
+		CHECK_EQUAL(mesh.vertices.size(), size_t(vertexOffset));
+		CHECK_EQUAL(mesh.triangles.size(), size_t(triangleOffset));
+		CHECK(Canonical(input) == Canonical(output));
+		return mesh.meshlets.size();
+	}
+}
+
+TEST(GridMeshletsCoverEveryTriangleOnce){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(64, false, positions, indices);
+	const size_t meshlets = CheckMeshlets(positions, indices);
+	// 8192 triangles. A 7x7 quad patch fits in 64 vertices, so close to
+	// 98 triangles per meshlet is the best a grid can do.
+	CHECK(meshlets >= 8192 / kMeshletMaxTriangles);
+	CHECK(meshlets < 8192 / 70);
+}
+
+TEST(ShuffledGridMeshletsCoverEveryTriangleOnce){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(64, true, positions, indices);
+	const size_t meshlets = CheckMeshlets(positions, indices);
+	CHECK(meshlets < 8192 / 70);
+}
+
+TEST(VertexLimitSplitsUnsharedTriangles){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeSoup(100, positions, indices);
+	// 21 triangles use 63 vertices, the 22nd would need 66.
+	CHECK_EQUAL(size_t(5), CheckMeshlets(positions, indices));
+
+	MeshletMesh mesh;
+	BuildMeshlets(positions.data(), positions.size() / 3, sizeof(float) * 3, indices.data(), indices.size(), mesh);
+	CHECK_EQUAL(21u, mesh.meshlets[0].triangleCount);
+	CHECK_EQUAL(63u, mesh.meshlets[0].vertexCount);
+}
+
+TEST(TriangleLimitSplitsDenseMeshes){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeDense(positions, indices);
+	CHECK_EQUAL(size_t(2), CheckMeshlets(positions, indices));
+
+	MeshletMesh mesh;
+	BuildMeshlets(positions.data(), positions.size() / 3, sizeof(float) * 3, indices.data(), indices.size(), mesh);
+	CHECK_EQUAL(kMeshletMaxTriangles, mesh.meshlets[0].triangleCount);
+	CHECK_EQUAL(220u - kMeshletMaxTriangles, mesh.meshlets[1].triangleCount);
+}
+
+TEST(ExactlyFullMeshlet){
+	// 21 unshared triangles fill 63 vertices, one more starts a new meshlet.
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeSoup(21, positions, indices);
+	CHECK_EQUAL(size_t(1), CheckMeshlets(positions, indices));
+	MakeSoup(22, positions, indices);
+	CHECK_EQUAL(size_t(2), CheckMeshlets(positions, indices));
+}
+
+TEST(EmptyInputGivesNoMeshlets){
+	std::vector<float> positions = { 0.0f, 0.0f, 0.0f };
+	MeshletMesh mesh;
+	BuildMeshlets(positions.data(), 1, sizeof(float) * 3, nullptr, 0, mesh);
+	CHECK(mesh.meshlets.empty());
+	CHECK(mesh.triangles.empty());
+}
+
+TEST(BackfacingGridIsConeCulled){
+	std::vector<float> positions;
+	std::vector<uint32_t> indices;
+	MakeGrid(16, false, positions, indices);
+	MeshletMesh mesh;
+	BuildMeshlets(positions.data(), positions.size() / 3, sizeof(float) * 3, indices.data(), indices.size(), mesh);
+
+	// The grid is flat, so every cone is tight. Its triangles are clockwise
+	// seen from -z, from +z all of them face away.
+	const Frustum everything = {
+		{ { 1, 0, 0, 1e6f }, { -1, 0, 0, 1e6f }, { 0, 1, 0, 1e6f }, { 0, -1, 0, 1e6f }, { 0, 0, 1, 1e6f }, { 0, 0, -1, 1e6f } }
+	};
+	const float front[3] = { 8.0f, 8.0f, -10.0f };
+	const float back[3] = { 8.0f, 8.0f, 10.0f };
+	std::vector<uint32_t> visible;
+	CullMeshletsReference(mesh, everything, front, visible);
+	CHECK_EQUAL(mesh.meshlets.size(), visible.size());
+	CullMeshletsReference(mesh, everything, back, visible);
+	CHECK(visible.empty());
+}
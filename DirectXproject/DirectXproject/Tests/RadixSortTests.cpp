@@ -0,0 +1,117 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "DrawSortKey.h"
+#include "RadixSort.h"
+
+// RadixSortPairs against std::stable_sort on the same pairs, from empty
+// inputs up to 1M keys, so both the inline and the JobSystem paths and
+// every pass skipping case are covered.
+
+namespace {
+	enum class KeyPattern { Random, FewFields, Duplicates, Sorted, Reversed, Equal, DrawKeys };
+
+	uint64_t Random64(uint64_t& state){
+		state = state * 6364136223846793005ull + 1442695040888963407ull;
+		return state ^ (state >> 29);
+	}
+
+	std::vector<uint64_t> MakeKeys(KeyPattern pattern, uint32_t count){
+		std::vector<uint64_t> keys(count);
+		uint64_t state = count * 31ull + static_cast<uint64_t>(pattern);
+		for(uint32_t i = 0; i < count; i++){
+			switch(pattern){
+				case KeyPattern::Random: keys[i] = Random64(state); break;
+				// Only a mid and a top digit vary, the other passes are skipped.
+				case KeyPattern::FewFields: keys[i] = (Random64(state) & 0x7FF0000000000000ull) | ((Random64(state) & 0x3F) << 24); break;
+				// Few distinct keys, so stability decides most of the order.
+				case KeyPattern::Duplicates: keys[i] = Random64(state) % 7; break;
+				case KeyPattern::Sorted: keys[i] = i * 3ull; break;
+				case KeyPattern::Reversed: keys[i] = (count - i) * 0x100000001ull; break;
+				case KeyPattern::Equal: keys[i] = 0x0123456789ABCDEFull; break;
+				case KeyPattern::DrawKeys: {
+					DrawKeyFields fields;
+					fields.layer = static_cast<uint32_t>(Random64(state) % 3);
+					fields.pass = static_cast<DrawPass>(Random64(state) % 3);
+					fields.pipeline = static_cast<uint32_t>(Random64(state) % 20);
+					fields.material = static_cast<uint32_t>(Random64(state) % 500);
+					fields.mesh = static_cast<uint32_t>(Random64(state) % 2000);
+					fields.depth = static_cast<uint32_t>(Random64(state) % (kDrawKeyMaxDepth + 1));
+					keys[i] = EncodeDrawKey(fields);
+					break;
+				}
+			}
+		}
+		return keys;
+	}
+
+	bool MatchesStableSort(KeyPattern pattern, uint32_t count){
+		std::vector<uint64_t> keys = MakeKeys(pattern, count);
+		std::vector<uint32_t> values(count);
+		std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+		for(uint32_t i = 0; i < count; i++){
+			values[i] = i;
+			expected[i] = { keys[i], i };
+		}
+		std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b){
+			return a.first < b.first;
+		});
+
+		std::vector<uint64_t> scratchKeys(count);
+		std::vector<uint32_t> scratchValues(count);
+		RadixSortPairs(keys.data(), values.data(), scratchKeys.data(), scratchValues.data(), count);
+
+		for(uint32_t i = 0; i < count; i++){
+			if(keys[i] != expected[i].first || values[i] != expected[i].second){
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const KeyPattern kPatterns[] = { KeyPattern::Random, KeyPattern::FewFields, KeyPattern::Duplicates, KeyPattern::Sorted,
+		KeyPattern::Reversed, KeyPattern::Equal, KeyPattern::DrawKeys };
+}
+
+TEST(SmallInputsMatchStableSort){
+	const uint32_t counts[] = { 0, 1, 2, 3, 17, 1000, 2048, 2049 };
+	for(KeyPattern pattern : kPatterns){
+		for(uint32_t count : counts){
+			CHECK(MatchesStableSort(pattern, count));
+		}
+	}
+}
+
+TEST(BlockedInputsMatchStableSort){
+	// Above the block size the histograms and scatters run on the JobSystem,
+	// the odd count leaves a partial last block.
+	const uint32_t counts[] = { 32 * 1024 + 1, 100003 };
+	for(KeyPattern pattern : kPatterns){
+		for(uint32_t count : counts){
+			CHECK(MatchesStableSort(pattern, count));
+		}
+	}
+}
+
+TEST(MillionKeysMatchStableSort){
+	CHECK(MatchesStableSort(KeyPattern::Random, 1000000));
+	CHECK(MatchesStableSort(KeyPattern::Duplicates, 1000000));
+	CHECK(MatchesStableSort(KeyPattern::DrawKeys, 1000000));
+}
+
+TEST(DrawListSortKeepsAddOrderOnTies){
+	DrawList drawList;
+	const uint64_t keys[] = { 5, 3, 5, 1, 3, 5 };
+	for(uint32_t i = 0; i < 6; i++){
+		drawList.Add(keys[i], i);
+	}
+	drawList.Sort();
+	const uint32_t expected[] = { 3, 1, 4, 0, 2, 5 };
+	for(uint32_t i = 0; i < 6; i++){
+		CHECK_EQUAL(expected[i], drawList.GetDraws()[i]);
+	}
+}
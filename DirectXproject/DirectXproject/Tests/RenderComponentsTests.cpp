@@ -0,0 +1,200 @@
+#include "TestMain.h"
+
+#include <vector>
+
+#include "RenderComponents.h"
+
+namespace {
+	void CreateRenderable(EntityWorld& world, const Float4x4& transform, float radius, uint32_t mesh){
+		TransformComponent component = { transform };
+		RenderableComponent renderable = {};
+		renderable.mesh = mesh;
+		renderable.vertexCount = 3;
+		world.CreateEntity(component, BoundsComponent{ { 0.0f, 0.0f, 0.0f }, radius }, renderable);
+	}
+}
+
+TEST(GatherRenderObjectsMovesBoundsToWorldSpace){
+	EntityWorld world;
+	Float4x4 scaled = Float4x4::Translation(1.0f, 2.0f, 3.0f);
+	scaled.m[1][1] = 4.0f;
+	CreateRenderable(world, scaled, 0.5f, 0);
+
+	std::vector<GpuObjectBounds> bounds;
+	std::vector<GpuDrawArguments> drawArgs;
+	GatherRenderObjects(world, bounds, drawArgs);
+	CHECK_EQUAL(size_t(1), bounds.size());
+	CHECK_EQUAL(1.0f, bounds[0].center[0]);
+	CHECK_EQUAL(2.0f, bounds[0].center[1]);
+	CHECK_EQUAL(3.0f, bounds[0].center[2]);
+	// Grows with the largest axis scale.
+	CHECK_EQUAL(2.0f, bounds[0].radius);
+	CHECK_EQUAL(3u, drawArgs[0].vertexCountPerInstance);
+}
+
+TEST(GatherDrawListKeepsWorldsAndSortsByDepth){
+	EntityWorld world;
+	CreateRenderable(world, Float4x4::Translation(0.0f, 0.0f, 0.75f), 0.1f, 0);
+	CreateRenderable(world, Float4x4::Translation(0.0f, 0.0f, 0.25f), 0.1f, 0);
+
+	DrawGatherScratch scratch;
+	std::vector<RenderableComponent> draws;
+	std::vector<Float4x4> worlds;
+	DrawList drawList;
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList);
+	drawList.Sort();
+
+	CHECK_EQUAL(2u, drawList.GetCount());
+	CHECK_EQUAL(size_t(2), worlds.size());
+	// Same state, so front to back: the nearer one, added second, first.
+	CHECK_EQUAL(1u, drawList.GetDraws()[0]);
+	CHECK_EQUAL(0.25f, worlds[drawList.GetDraws()[0]].m[3][2]);
+	CHECK_EQUAL(0.75f, worlds[drawList.GetDraws()[1]].m[3][2]);
+}
+
+TEST(GatherDrawListSkipsEntitiesOutsideTheFrustum){
+	// Clip space, one inside, one past the right edge, one touching it.
+	EntityWorld world;
+	CreateRenderable(world, Float4x4::Translation(0.0f, 0.0f, 0.5f), 0.25f, 0);
+	CreateRenderable(world, Float4x4::Translation(2.0f, 0.0f, 0.5f), 0.25f, 1);
+	CreateRenderable(world, Float4x4::Translation(1.25f, 0.0f, 0.5f), 0.25f, 2);
+
+	DrawGatherScratch scratch;
+	std::vector<RenderableComponent> draws;
+	std::vector<Float4x4> worlds;
+	DrawList drawList;
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList);
+
+	CHECK_EQUAL(2u, drawList.GetCount());
+	CHECK_EQUAL(size_t(2), draws.size());
+	CHECK_EQUAL(0u, draws[0].mesh);
+	CHECK_EQUAL(2u, draws[1].mesh);
+	CHECK_EQUAL(1.25f, worlds[1].m[3][0]);
+}
+
+TEST(GatherDrawListSkipsOccludedEntities){
+	// A wall over the left half of clip space at depth 0.5, placed by its
+	// entity's transform. Entities behind it on the left are hidden, the
+	// one in front of it and the one to the right are not.
+	const Float3 wall[4] = { { -1.0f, -1.0f, 0.0f }, { -1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, -1.0f, 0.0f } };
+	const uint32_t wallIndices[6] = { 0, 1, 2, 0, 2, 3 };
+	EntityWorld world;
+	world.CreateEntity(TransformComponent{ Float4x4::Translation(0.0f, 0.0f, 0.5f) }, OccluderComponent{ wall, 4, wallIndices, 6, false });
+	CreateRenderable(world, Float4x4::Translation(-0.5f, 0.0f, 0.8f), 0.1f, 0);
+	CreateRenderable(world, Float4x4::Translation(-0.5f, 0.0f, 0.2f), 0.1f, 1);
+	CreateRenderable(world, Float4x4::Translation(0.5f, 0.0f, 0.8f), 0.1f, 2);
+	CreateRenderable(world, Float4x4::Translation(-0.5f, 0.5f, 0.9f), 0.1f, 3);
+
+	SoftwareOcclusion occlusion;
+	occlusion.Resize(64, 32);
+	occlusion.BeginFrame(Float4x4::Identity());
+	GatherOccluders(world, occlusion);
+	occlusion.RasterizeOccluders();
+	CHECK_EQUAL(2u, occlusion.GetStats().occluderTriangles);
+
+	DrawGatherScratch scratch;
+	std::vector<RenderableComponent> draws;
+	std::vector<Float4x4> worlds;
+	DrawList drawList;
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList, &occlusion);
+	CHECK_EQUAL(size_t(2), draws.size());
+	CHECK_EQUAL(1u, draws[0].mesh);
+	CHECK_EQUAL(2u, draws[1].mesh);
+	CHECK_EQUAL(0.8f, worlds[1].m[3][2]);
+	CHECK_EQUAL(4u, occlusion.GetStats().testedOccludees);
+	CHECK_EQUAL(2u, occlusion.GetStats().culledOccludees);
+
+	// Without occlusion everything in the frustum is drawn.
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList);
+	CHECK_EQUAL(size_t(4), draws.size());
+}
+
+TEST(GatherDrawListPicksLevelsOfDetailByDepth){
+	// At depth d an error e covers e * 500 / d pixels.
+	const MeshLod lods[3] = { { {}, 0.0f }, { {}, 0.001f }, { {}, 0.004f } };
+	const LodRange ranges[3] = { { 300, 0 }, { 120, 300 }, { 30, 420 } };
+	const LodComponent levels = { lods, ranges, 3, 0 };
+	Float4x4 scaled = Float4x4::Translation(0.0f, 0.0f, 0.9f);
+	scaled.m[0][0] = scaled.m[1][1] = scaled.m[2][2] = 4.0f;
+
+	EntityWorld world;
+	RenderableComponent renderable = {};
+	renderable.vertexCount = 3;
+	Entity entities[3];
+	renderable.mesh = 0;
+	entities[0] = world.CreateEntity(TransformComponent{ Float4x4::Translation(0.0f, 0.0f, 0.9f) }, BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.1f }, renderable, levels);
+	renderable.mesh = 1;
+	entities[1] = world.CreateEntity(TransformComponent{ Float4x4::Translation(0.0f, 0.0f, 0.2f) }, BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.1f }, renderable, levels);
+	// Four times the size, so as detailed as one at a quarter of the depth.
+	renderable.mesh = 2;
+	entities[2] = world.CreateEntity(TransformComponent{ scaled }, BoundsComponent{ { 0.0f, 0.0f, 0.0f }, 0.1f }, renderable, levels);
+	CreateRenderable(world, Float4x4::Translation(0.0f, 0.0f, 0.9f), 0.1f, 3);
+
+	DrawGatherScratch scratch;
+	std::vector<RenderableComponent> draws;
+	std::vector<Float4x4> worlds;
+	DrawList drawList;
+	const LodSelection selection = { 500.0f, 1.0f, 0.2f };
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList, nullptr, &selection);
+	CHECK_EQUAL(size_t(4), draws.size());
+	const uint32_t expectedCounts[4] = { 120, 300, 300, 3 };
+	const uint32_t expectedStarts[4] = { 300, 0, 0, 0 };
+	for(const RenderableComponent& draw : draws){
+		CHECK_EQUAL(expectedCounts[draw.mesh], draw.vertexCount);
+		CHECK_EQUAL(expectedStarts[draw.mesh], draw.startVertex);
+	}
+	CHECK_EQUAL(1u, world.GetComponent<LodComponent>(entities[0])->currentLod);
+	CHECK_EQUAL(0u, world.GetComponent<LodComponent>(entities[1])->currentLod);
+	CHECK_EQUAL(0u, world.GetComponent<LodComponent>(entities[2])->currentLod);
+	// The pick is only drawn, the component keeps its own range.
+	CHECK_EQUAL(3u, world.GetComponent<RenderableComponent>(entities[0])->vertexCount);
+
+	// Without a selection the renderable's own range is drawn.
+	GatherDrawList(world, Float4x4::Identity(), Frustum::Identity(), 0.0f, 1.0f, scratch, draws, worlds, drawList);
+	for(const RenderableComponent& draw : draws){
+		CHECK_EQUAL(3u, draw.vertexCount);
+	}
+}
+
+TEST(CopyHierarchyTransformsFillsEntityWorlds){
+	TransformHierarchy hierarchy;
+	const TransformHierarchy::Handle parent = hierarchy.Create();
+	const TransformHierarchy::Handle child = hierarchy.Create(parent);
+	hierarchy.SetLocal(parent, Float4x4::Translation(0.0f, 2.0f, 0.0f));
+	hierarchy.SetLocal(child, Float4x4::Translation(1.0f, 0.0f, 0.0f));
+	hierarchy.Update();
+
+	EntityWorld world;
+	const Entity entity = world.CreateEntity(TransformComponent{ Float4x4::Identity() }, HierarchyComponent{ child });
+	CopyHierarchyTransforms(world, hierarchy);
+
+	const TransformComponent* transform = world.GetComponent<TransformComponent>(entity);
+	CHECK(transform != nullptr);
+	if(transform){
+		CHECK_EQUAL(1.0f, transform->world.m[3][0]);
+		CHECK_EQUAL(2.0f, transform->world.m[3][1]);
+	}
+}
+
+TEST(AttachToHierarchyKeepsWorldsAndSkipsAttachedEntities){
+	TransformHierarchy hierarchy;
+	const TransformHierarchy::Handle row = hierarchy.Create();
+	hierarchy.SetLocal(row, Float4x4::Translation(0.0f, 5.0f, 0.0f));
+
+	EntityWorld world;
+	const Entity first = world.CreateEntity(TransformComponent{ Float4x4::Translation(1.0f, 0.0f, 0.0f) });
+	AttachToHierarchy(world, hierarchy, row);
+	const Entity second = world.CreateEntity(TransformComponent{ Float4x4::Translation(2.0f, 0.0f, 0.0f) });
+	AttachToHierarchy(world, hierarchy, row);
+
+	// One node each, the first entity was not attached twice.
+	CHECK_EQUAL(3u, hierarchy.GetNodeCount());
+	CHECK(world.HasComponent<HierarchyComponent>(first));
+	CHECK(world.HasComponent<HierarchyComponent>(second));
+
+	hierarchy.Update();
+	CopyHierarchyTransforms(world, hierarchy);
+	CHECK_EQUAL(1.0f, world.GetComponent<TransformComponent>(first)->world.m[3][0]);
+	CHECK_EQUAL(5.0f, world.GetComponent<TransformComponent>(first)->world.m[3][1]);
+	CHECK_EQUAL(2.0f, world.GetComponent<TransformComponent>(second)->world.m[3][0]);
+}
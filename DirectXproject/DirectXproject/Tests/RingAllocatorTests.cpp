@@ -0,0 +1,275 @@
+#include "TestMain.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "RingAllocator.h"
+
+// RingAllocator with fence values standing in for frames the GPU finished.
+
+namespace {
+	// The same ring kept as one owner per byte: the fence value of the frame
+	// that holds it, kOpenFrame until EndFrame, kFree once retired. Padding
+	// and skipped tails belong to the frame that allocated past them.
+	struct ReferenceRing {
+		static const int64_t kFree = -1;
+		static const int64_t kOpenFrame = -2;
+
+		std::vector<int64_t> owners;
+		uint64_t cursor = 0;
+
+		explicit ReferenceRing(uint64_t size) : owners(size, kFree) {}
+
+		bool IsFree(uint64_t begin, uint64_t end) const {
+			for(uint64_t i = begin; i < end; i++){
+				if(owners[i] != kFree){
+					return false;
+				}
+			}
+			return true;
+		}
+
+		void Take(uint64_t begin, uint64_t end){
+			for(uint64_t i = begin; i < end; i++){
+				owners[i] = kOpenFrame;
+			}
+		}
+
+		uint64_t GetUsed() const {
+			uint64_t used = 0;
+			for(int64_t owner : owners){
+				used += owner != kFree ? 1 : 0;
+			}
+			return used;
+		}
+
+		// Right after the last allocation, or at zero past the end.
+		bool Allocate(uint64_t size, uint64_t alignment, uint64_t& offset){
+			const uint64_t ringSize = owners.size();
+			if(GetUsed() == 0){
+				cursor = 0;
+			}
+			const uint64_t start = (cursor + alignment - 1) / alignment * alignment;
+			if(start + size <= ringSize && IsFree(cursor, start + size)){
+				Take(cursor, start + size);
+				offset = start;
+			}else if(size <= ringSize && IsFree(cursor, ringSize) && IsFree(0, size)){
+				Take(cursor, ringSize);
+				Take(0, size);
+				offset = 0;
+			}else{
+				return false;
+			}
+			cursor = (offset + size) % ringSize;
+			return true;
+		}
+
+		void EndFrame(uint64_t fenceValue){
+			for(int64_t& owner : owners){
+				if(owner == kOpenFrame){
+					owner = static_cast<int64_t>(fenceValue);
+				}
+			}
+		}
+
+		void Retire(uint64_t completedFenceValue){
+			for(int64_t& owner : owners){
+				if(owner >= 0 && static_cast<uint64_t>(owner) <= completedFenceValue){
+					owner = kFree;
+				}
+			}
+		}
+	};
+
+	const uint64_t kFailed = ~0ull;
+
+	uint64_t AllocateOrFail(RingAllocator& ring, uint64_t size, uint64_t alignment = 1){
+		uint64_t offset = 0;
+		return ring.Allocate(size, alignment, offset) ? offset : kFailed;
+	}
+}
+
+TEST(FramesAreFreedWhenTheirFenceCompletes){
+	RingAllocator ring;
+	ring.Init(1024);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 100));
+	CHECK_EQUAL(uint64_t(100), AllocateOrFail(ring, 100));
+	ring.EndFrame(1);
+	CHECK_EQUAL(uint64_t(200), AllocateOrFail(ring, 50));
+	ring.EndFrame(2);
+	CHECK_EQUAL(uint64_t(250), ring.GetUsed());
+
+	ring.Retire(0);
+	CHECK_EQUAL(uint64_t(250), ring.GetUsed());
+	ring.Retire(1);
+	CHECK_EQUAL(uint64_t(50), ring.GetUsed());
+	// The open frame is not freed by anything.
+	CHECK_EQUAL(uint64_t(250), AllocateOrFail(ring, 10));
+	ring.Retire(2);
+	CHECK_EQUAL(uint64_t(10), ring.GetUsed());
+	ring.EndFrame(3);
+	ring.Retire(3);
+	CHECK_EQUAL(uint64_t(0), ring.GetUsed());
+
+	// Empty again, the next frame starts at zero.
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 1024));
+}
+
+TEST(AllocationsAreAlignedFromTheHead){
+	RingAllocator ring;
+	ring.Init(1024);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 3));
+	CHECK_EQUAL(uint64_t(16), AllocateOrFail(ring, 8, 16));
+	// Padding counts as used until its frame is freed.
+	CHECK_EQUAL(uint64_t(24), ring.GetUsed());
+	CHECK_EQUAL(uint64_t(256), AllocateOrFail(ring, 1, 256));
+	CHECK_EQUAL(uint64_t(257), ring.GetUsed());
+	// Nothing in use, the head starts over at zero.
+	ring.EndFrame(1);
+	ring.Retire(1);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 512, 512));
+	CHECK_EQUAL(uint64_t(512), AllocateOrFail(ring, 512, 512));
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+}
+
+TEST(AllocationsSkipTheTailInsteadOfStraddlingTheEnd){
+	RingAllocator ring;
+	ring.Init(100);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 60));
+	ring.EndFrame(1);
+	CHECK_EQUAL(uint64_t(60), AllocateOrFail(ring, 30));
+	ring.EndFrame(2);
+	ring.Retire(1);
+	CHECK_EQUAL(uint64_t(30), ring.GetUsed());
+
+	// 20 bytes do not fit in [90, 100), the tail is skipped and counted.
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 20));
+	CHECK_EQUAL(uint64_t(60), ring.GetUsed());
+	// Wrapped, only [20, 60) is free now.
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 41));
+	CHECK_EQUAL(uint64_t(60), ring.GetUsed());
+	CHECK_EQUAL(uint64_t(20), AllocateOrFail(ring, 40));
+	CHECK_EQUAL(uint64_t(100), ring.GetUsed());
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+	ring.EndFrame(3);
+
+	// Frame 2 held [60, 90), the skipped tail stays with frame 3.
+	ring.Retire(2);
+	CHECK_EQUAL(uint64_t(70), ring.GetUsed());
+	CHECK_EQUAL(uint64_t(60), AllocateOrFail(ring, 30));
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+	ring.EndFrame(4);
+	ring.Retire(4);
+	CHECK_EQUAL(uint64_t(0), ring.GetUsed());
+}
+
+TEST(ExactFitsFillTheRing){
+	RingAllocator ring;
+	ring.Init(100);
+	// Ending exactly at the end, the head goes back to zero.
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 40));
+	ring.EndFrame(1);
+	CHECK_EQUAL(uint64_t(40), AllocateOrFail(ring, 60));
+	CHECK_EQUAL(uint64_t(100), ring.GetUsed());
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+
+	// Head and tail meet after the wrap, the ring is full rather than empty.
+	ring.Retire(1);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 40));
+	CHECK_EQUAL(uint64_t(100), ring.GetUsed());
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+	ring.EndFrame(2);
+	ring.Retire(2);
+	CHECK_EQUAL(uint64_t(0), ring.GetUsed());
+
+	// Skipping the tail into exactly the space before the tail.
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 30));
+	ring.EndFrame(3);
+	CHECK_EQUAL(uint64_t(30), AllocateOrFail(ring, 50));
+	ring.EndFrame(4);
+	ring.Retire(3);
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 31));
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 30));
+	CHECK_EQUAL(uint64_t(100), ring.GetUsed());
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 1));
+	ring.EndFrame(5);
+	ring.Retire(4);
+	CHECK_EQUAL(uint64_t(50), ring.GetUsed());
+	ring.Retire(5);
+	CHECK_EQUAL(uint64_t(0), ring.GetUsed());
+}
+
+TEST(PendingEmptyFramesRestartAtZero){
+	RingAllocator ring;
+	ring.Init(100);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 70));
+	ring.EndFrame(1);
+	ring.Retire(1);
+	// Ends at 70 but holds nothing.
+	ring.EndFrame(2);
+
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 90));
+	ring.EndFrame(3);
+	// Frame 2 was moved to zero with the head, retiring it must not free
+	// [0, 70) under frame 3.
+	ring.Retire(2);
+	CHECK_EQUAL(uint64_t(90), ring.GetUsed());
+	CHECK_EQUAL(kFailed, AllocateOrFail(ring, 20));
+	ring.Retire(3);
+	CHECK_EQUAL(uint64_t(0), AllocateOrFail(ring, 20));
+}
+
+TEST(RingMatchesTheReferenceModel){
+	const uint64_t ringSize = 256;
+	RingAllocator ring;
+	ring.Init(ringSize);
+	ReferenceRing reference(ringSize);
+
+	uint32_t state = 12345u;
+	auto next = [&state]{
+		state = state * 1664525u + 1013904223u;
+		return state >> 8;
+	};
+
+	uint64_t fenceValue = 0;
+	uint64_t completedValue = 0;
+	int allocations = 0;
+	int failures = 0;
+	for(int step = 0; step < 20000; step++){
+		const uint32_t op = next() % 8;
+		if(op < 5){
+			const uint64_t size = 1 + next() % 96;
+			const uint64_t alignment = 1ull << (next() % 5);
+			uint64_t offset = kFailed;
+			uint64_t expectedOffset = kFailed;
+			const bool allocated = ring.Allocate(size, alignment, offset);
+			const bool expected = reference.Allocate(size, alignment, expectedOffset);
+			CHECK_EQUAL(expected, allocated);
+			if(allocated != expected){
+				break;
+			}
+			if(allocated){
+				CHECK_EQUAL(expectedOffset, offset);
+				CHECK(offset % alignment == 0 && offset + size <= ringSize);
+				allocations++;
+			}else{
+				failures++;
+			}
+		}else if(op < 7){
+			ring.EndFrame(++fenceValue);
+			reference.EndFrame(fenceValue);
+		}else{
+			// The GPU catches up by some number of frames.
+			completedValue += next() % (fenceValue - completedValue + 1);
+			ring.Retire(completedValue);
+			reference.Retire(completedValue);
+		}
+		CHECK_EQUAL(reference.GetUsed(), ring.GetUsed());
+		if(reference.GetUsed() != ring.GetUsed()){
+			break;
+		}
+	}
+	// Both outcomes were exercised.
+	CHECK(allocations > 1000);
+	CHECK(failures > 100);
+}
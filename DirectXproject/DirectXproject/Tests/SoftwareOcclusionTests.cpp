@@ -0,0 +1,191 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "SoftwareOcclusion.h"
+
+namespace {
+	// Left handed, row vector, depth [0, 1], like XMMatrixPerspectiveFovLH.
+	Float4x4 Perspective(float fovY, float aspect, float nearZ, float farZ){
+		Float4x4 m;
+		memset(&m, 0, sizeof(m));
+		const float yScale = 1.0f / tanf(fovY * 0.5f);
+		m.m[0][0] = yScale / aspect;
+		m.m[1][1] = yScale;
+		m.m[2][2] = farZ / (farZ - nearZ);
+		m.m[2][3] = 1.0f;
+		m.m[3][2] = -nearZ * farZ / (farZ - nearZ);
+		return m;
+	}
+
+	float Random(uint32_t& state){
+		state = state * 1664525u + 1013904223u;
+		return static_cast<float>(state >> 8) / 16777216.0f;
+	}
+
+	// Triangles scattered in front of, around and behind the camera, in
+	// every size from sub-pixel to screen covering, both windings.
+	struct Soup {
+		std::vector<Float3> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	Soup MakeSoup(uint32_t triangleCount, uint32_t seed){
+		Soup soup;
+		uint32_t state = seed;
+		for(uint32_t t = 0; t < triangleCount; t++){
+			const float size = 0.05f + 8.0f * Random(state) * Random(state);
+			const Float3 center = { (Random(state) - 0.5f) * 30.0f, (Random(state) - 0.5f) * 20.0f, -2.0f + 40.0f * Random(state) };
+			for(int k = 0; k < 3; k++){
+				soup.indices.push_back(static_cast<uint32_t>(soup.positions.size()));
+				soup.positions.push_back({ center.x + (Random(state) - 0.5f) * size, center.y + (Random(state) - 0.5f) * size,
+					center.z + (Random(state) - 0.5f) * size });
+			}
+		}
+		return soup;
+	}
+
+	void Rasterize(SoftwareOcclusion& occlusion, OcclusionPath path, const Float4x4& viewProjection, const Soup& soup, bool twoSided){
+		occlusion.SetPath(path);
+		occlusion.BeginFrame(viewProjection);
+		// Split over several occluders so their offsets get exercised too.
+		const uint32_t perOccluder = 300;
+		for(uint32_t first = 0; first < soup.indices.size(); first += perOccluder){
+			OccluderMesh mesh;
+			mesh.positions = soup.positions.data();
+			mesh.vertexCount = static_cast<uint32_t>(soup.positions.size());
+			mesh.indices = soup.indices.data() + first;
+			mesh.indexCount = std::min(perOccluder, static_cast<uint32_t>(soup.indices.size()) - first);
+			mesh.world = Float4x4::Identity();
+			mesh.twoSided = twoSided;
+			occlusion.AddOccluder(mesh);
+		}
+		occlusion.RasterizeOccluders();
+	}
+
+	// A two triangle quad at depth z covering clip space x and y in [-1, 1].
+	void AddScreenQuad(SoftwareOcclusion& occlusion, const Float3* positions, const uint32_t* indices, bool twoSided){
+		OccluderMesh mesh = { positions, 4, indices, 6, Float4x4::Identity(), twoSided };
+		occlusion.AddOccluder(mesh);
+	}
+}
+
+TEST(Avx2DepthMatchesScalar){
+	if(GetBestOcclusionPath() != OcclusionPath::AVX2){
+		return;
+	}
+	const Float4x4 projection = Perspective(1.0f, 16.0f / 9.0f, 0.5f, 100.0f);
+	const uint32_t sizes[][2] = { { 32, 8 }, { 250, 130 }, { 320, 180 }, { 512, 256 } };
+	for(const uint32_t* size : sizes){
+		for(int twoSided = 0; twoSided < 2; twoSided++){
+			const Soup soup = MakeSoup(3000, size[0] * 7 + twoSided);
+			SoftwareOcclusion scalar;
+			SoftwareOcclusion avx2;
+			scalar.Resize(size[0], size[1]);
+			avx2.Resize(size[0], size[1]);
+			Rasterize(scalar, OcclusionPath::Scalar, projection, soup, twoSided != 0);
+			Rasterize(avx2, OcclusionPath::AVX2, projection, soup, twoSided != 0);
+
+			const size_t pixels = size_t(scalar.GetWidth()) * scalar.GetHeight();
+			CHECK(memcmp(scalar.GetDepth(), avx2.GetDepth(), pixels * sizeof(float)) == 0);
+			CHECK_EQUAL(scalar.GetStats().rasterizedTriangles, avx2.GetStats().rasterizedTriangles);
+
+			// And the soup actually drew something, but not everywhere.
+			uint32_t written = 0;
+			for(size_t i = 0; i < pixels; i++){
+				written += scalar.GetDepth()[i] < 1.0f ? 1 : 0;
+			}
+			CHECK(written > 0 && written < pixels);
+		}
+	}
+}
+
+TEST(Avx2OccludeeTestMatchesScalar){
+	if(GetBestOcclusionPath() != OcclusionPath::AVX2){
+		return;
+	}
+	const Float4x4 projection = Perspective(1.0f, 2.0f, 0.5f, 100.0f);
+	const Soup soup = MakeSoup(2000, 99);
+	SoftwareOcclusion scalar;
+	SoftwareOcclusion avx2;
+	scalar.Resize(256, 128);
+	avx2.Resize(256, 128);
+	Rasterize(scalar, OcclusionPath::Scalar, projection, soup, true);
+	Rasterize(avx2, OcclusionPath::AVX2, projection, soup, true);
+
+	// Enough boxes to split the test across jobs.
+	AabbBoundsSoA boxes;
+	std::vector<uint32_t> candidates;
+	uint32_t state = 7;
+	for(uint32_t i = 0; i < 5000; i++){
+		const float center[3] = { (Random(state) - 0.5f) * 30.0f, (Random(state) - 0.5f) * 20.0f, 40.0f * Random(state) };
+		const float extent = 0.01f + 2.0f * Random(state);
+		const float boxMin[3] = { center[0] - extent, center[1] - extent, center[2] - extent };
+		const float boxMax[3] = { center[0] + extent, center[1] + extent, center[2] + extent };
+		candidates.push_back(boxes.Add(boxMin, boxMax));
+	}
+	std::vector<uint32_t> scalarVisible;
+	std::vector<uint32_t> avx2Visible;
+	scalar.CullOccludees(boxes, candidates.data(), static_cast<uint32_t>(candidates.size()), scalarVisible);
+	avx2.CullOccludees(boxes, candidates.data(), static_cast<uint32_t>(candidates.size()), avx2Visible);
+	CHECK(scalarVisible == avx2Visible);
+	CHECK(!scalarVisible.empty() && scalarVisible.size() < candidates.size());
+}
+
+TEST(BoxesBehindAWallAreCulled){
+	// Identity camera: clip space is world space and z is the depth.
+	const Float3 wall[4] = { { -1.0f, -1.0f, 0.5f }, { -1.0f, 1.0f, 0.5f }, { 1.0f, 1.0f, 0.5f }, { 1.0f, -1.0f, 0.5f } };
+	const uint32_t indices[6] = { 0, 1, 2, 0, 2, 3 };
+	const OcclusionPath paths[] = { OcclusionPath::Scalar, OcclusionPath::AVX2 };
+	for(OcclusionPath path : paths){
+		if(path == OcclusionPath::AVX2 && GetBestOcclusionPath() != OcclusionPath::AVX2){
+			continue;
+		}
+		SoftwareOcclusion occlusion;
+		occlusion.Resize(64, 32);
+		occlusion.SetPath(path);
+		occlusion.BeginFrame(Float4x4::Identity());
+		AddScreenQuad(occlusion, wall, indices, true);
+		occlusion.RasterizeOccluders();
+		for(uint32_t i = 0; i < occlusion.GetWidth() * occlusion.GetHeight(); i++){
+			CHECK(fabsf(occlusion.GetDepth()[i] - 0.5f) < 1e-6f);
+		}
+
+		const float behindMin[3] = { -0.1f, -0.1f, 0.6f }, behindMax[3] = { 0.1f, 0.1f, 0.7f };
+		const float frontMin[3] = { -0.1f, -0.1f, 0.2f }, frontMax[3] = { 0.1f, 0.1f, 0.3f };
+		const float throughMin[3] = { -0.1f, -0.1f, 0.4f }, throughMax[3] = { 0.1f, 0.1f, 0.6f };
+		const float nearMin[3] = { -0.1f, -0.1f, -0.1f }, nearMax[3] = { 0.1f, 0.1f, 0.9f };
+		CHECK(!occlusion.IsAabbVisible(behindMin, behindMax));
+		CHECK(occlusion.IsAabbVisible(frontMin, frontMax));
+		CHECK(occlusion.IsAabbVisible(throughMin, throughMax));
+		CHECK(occlusion.IsAabbVisible(nearMin, nearMax));
+	}
+}
+
+TEST(BackFacesAreSkippedUnlessTwoSided){
+	const Float3 quad[4] = { { -1.0f, -1.0f, 0.5f }, { -1.0f, 1.0f, 0.5f }, { 1.0f, 1.0f, 0.5f }, { 1.0f, -1.0f, 0.5f } };
+	const uint32_t clockwise[6] = { 0, 1, 2, 0, 2, 3 };
+	const uint32_t counterClockwise[6] = { 0, 2, 1, 0, 3, 2 };
+	const float boxMin[3] = { -0.1f, -0.1f, 0.6f }, boxMax[3] = { 0.1f, 0.1f, 0.7f };
+
+	SoftwareOcclusion occlusion;
+	occlusion.Resize(64, 32);
+	occlusion.BeginFrame(Float4x4::Identity());
+	AddScreenQuad(occlusion, quad, counterClockwise, false);
+	occlusion.RasterizeOccluders();
+	CHECK(occlusion.IsAabbVisible(boxMin, boxMax));
+
+	occlusion.BeginFrame(Float4x4::Identity());
+	AddScreenQuad(occlusion, quad, counterClockwise, true);
+	occlusion.RasterizeOccluders();
+	CHECK(!occlusion.IsAabbVisible(boxMin, boxMax));
+
+	occlusion.BeginFrame(Float4x4::Identity());
+	AddScreenQuad(occlusion, quad, clockwise, false);
+	occlusion.RasterizeOccluders();
+	CHECK(!occlusion.IsAabbVisible(boxMin, boxMax));
+}
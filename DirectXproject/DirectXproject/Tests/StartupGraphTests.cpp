@@ -0,0 +1,67 @@
+#include "TestMain.h"
+
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "StartupGraph.h"
+
+TEST(StartupGraphRunsStagesAfterTheirDependencies){
+	std::mutex mutex;
+	std::vector<std::string> order;
+	auto record = [&](const char* name){
+		return [&, name](){
+			std::lock_guard<std::mutex> lock(mutex);
+			order.push_back(name);
+		};
+	};
+	const std::thread::id caller = std::this_thread::get_id();
+	bool windowOnCaller = false;
+
+	StartupGraph graph;
+	StartupGraph::Stage factory = graph.Add("Factory", record("Factory"));
+	StartupGraph::Stage window = graph.AddMainThread("Window", [&](){
+		windowOnCaller = std::this_thread::get_id() == caller;
+		record("Window")();
+	});
+	StartupGraph::Stage device = graph.Add("Device", record("Device"), { factory });
+	graph.AddMainThread("SwapChain", record("SwapChain"), { device, window });
+	graph.Run();
+
+	auto position = [&](const char* name){
+		for(size_t i = 0; i < order.size(); i++){
+			if(order[i] == name){
+				return static_cast<int>(i);
+			}
+		}
+		return -1;
+	};
+	CHECK_EQUAL(size_t(4), order.size());
+	CHECK(position("Factory") < position("Device"));
+	CHECK(position("Device") < position("SwapChain"));
+	CHECK(position("Window") < position("SwapChain"));
+	CHECK(windowOnCaller);
+	CHECK(graph.GetTotalMilliseconds() >= 0.0);
+}
+
+TEST(StartupGraphFailedStageSkipsItsDependentsAndRethrows){
+	// The window failing, the way RenderEngine sees it: nothing that needs
+	// it may run and Run reports the failure.
+	std::atomic<int> ran(0);
+	StartupGraph graph;
+	StartupGraph::Stage window = graph.AddMainThread("Window", [](){ throw std::runtime_error("no window"); });
+	StartupGraph::Stage swapChain = graph.AddMainThread("SwapChain", [&](){ ran++; }, { window });
+	graph.Add("Fence", [&](){ ran++; }, { swapChain });
+
+	std::string error;
+	try{
+		graph.Run();
+	} catch(const std::exception& e){
+		error = e.what();
+	}
+	CHECK(error == "no window");
+	CHECK_EQUAL(0, ran.load());
+}
@@ -0,0 +1,100 @@
+#include "TestMain.h"
+
+#include <cstring>
+#include <vector>
+
+#include "StreamingCopy.h"
+
+namespace {
+	const CopyPath kPaths[] = { CopyPath::Auto, CopyPath::Scalar, CopyPath::SSE2, CopyPath::AVX2 };
+	// Around every kernel boundary: below one line, the 16, 32, 64 and 128
+	// byte loops and their tails, and the Auto switch to AVX2 at 4 KB.
+	const size_t kSizes[] = { 0, 1, 15, 16, 17, 31, 32, 33, 63, 64, 65, 127, 128, 129, 191, 255, 256, 1000, 4095, 4096, 4097, 65536 + 77 };
+	// Guard bytes on both sides of the destination must survive.
+	const size_t kGuard = 64;
+
+	std::vector<uint8_t> MakeSource(size_t size){
+		std::vector<uint8_t> source(size);
+		uint32_t state = 12345;
+		for(uint8_t& byte : source){
+			state = state * 1664525u + 1013904223u;
+			byte = static_cast<uint8_t>(state >> 24);
+		}
+		return source;
+	}
+}
+
+TEST(StreamCopyMatchesMemcpyOnEveryPath){
+	const std::vector<uint8_t> source = MakeSource(65536 + 256);
+	std::vector<uint8_t> expected(65536 + 256 + 2 * kGuard);
+	std::vector<uint8_t> actual(expected.size());
+	int mismatches = 0;
+	for(CopyPath path : kPaths){
+		for(size_t size : kSizes){
+			// Misaligned destinations and sources exercise the head copy.
+			for(size_t destinationOffset = 0; destinationOffset < 4; destinationOffset++){
+				for(size_t sourceOffset = 0; sourceOffset < 40; sourceOffset += 13){
+					memset(expected.data(), 0xAB, expected.size());
+					memset(actual.data(), 0xAB, actual.size());
+					memcpy(expected.data() + kGuard + destinationOffset, source.data() + sourceOffset, size);
+					StreamCopy(actual.data() + kGuard + destinationOffset, source.data() + sourceOffset, size, path);
+					mismatches += memcmp(expected.data(), actual.data(), size + 2 * kGuard + destinationOffset) != 0 ? 1 : 0;
+				}
+			}
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+}
+
+TEST(StreamCopyNoFenceMatchesMemcpyAfterFence){
+	// Many small copies in a row, the way constants are written.
+	const std::vector<uint8_t> source = MakeSource(64 * 100);
+	std::vector<uint8_t> destination(256 * 100, 0);
+	for(CopyPath path : kPaths){
+		for(size_t i = 0; i < 100; i++){
+			StreamCopyNoFence(destination.data() + i * 256, source.data() + i * 64, 64, path);
+		}
+		StreamFence();
+		int mismatches = 0;
+		for(size_t i = 0; i < 100; i++){
+			mismatches += memcmp(destination.data() + i * 256, source.data() + i * 64, 64) != 0 ? 1 : 0;
+		}
+		CHECK_EQUAL(0, mismatches);
+	}
+}
+
+TEST(StreamFillMatchesMemsetOnEveryPath){
+	std::vector<uint8_t> expected(65536 + 256 + 2 * kGuard);
+	std::vector<uint8_t> actual(expected.size());
+	int mismatches = 0;
+	for(CopyPath path : kPaths){
+		for(size_t size : kSizes){
+			for(size_t offset = 0; offset < 36; offset += 7){
+				memset(expected.data(), 0xAB, expected.size());
+				memset(actual.data(), 0xAB, actual.size());
+				memset(expected.data() + kGuard + offset, 0x5C, size);
+				StreamFill(actual.data() + kGuard + offset, 0x5C, size, path);
+				mismatches += memcmp(expected.data(), actual.data(), size + 2 * kGuard + offset) != 0 ? 1 : 0;
+			}
+		}
+	}
+	CHECK_EQUAL(0, mismatches);
+}
+
+TEST(GetBestCopyPathIsNeverAuto){
+	CHECK(GetBestCopyPath() != CopyPath::Auto);
+}
+
+TEST(RegisteredRangesAreWriteCombinedInDebugOnly){
+	std::vector<uint8_t> mapped(1024);
+	RegisterWriteCombined(mapped.data(), mapped.size());
+	#if defined(_DEBUG)
+	CHECK(IsWriteCombined(mapped.data()));
+	CHECK(IsWriteCombined(mapped.data() + 1023));
+	CHECK(!IsWriteCombined(mapped.data() + 1024));
+	#else
+	CHECK(!IsWriteCombined(mapped.data()));
+	#endif
+	UnregisterWriteCombined(mapped.data());
+	CHECK(!IsWriteCombined(mapped.data()));
+}
@@ -0,0 +1,42 @@
+#include "TestMain.h"
+
+#include <cstring>
+
+namespace {
+	int gFailures = 0;
+}
+
+std::vector<TestCase>& GetTestCases(){
+	static std::vector<TestCase> testCases;
+	return testCases;
+}
+
+void ReportFailure(const char* file, int line, const char* expression){
+	printf("  %s:%d: CHECK(%s) failed\n", file, line, expression);
+	gFailures++;
+}
+
+// Runs every test, or only those whose name contains the first argument.
+int main(int argc, char* argv[]){
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+	int failedTests = 0;
+	int ranTests = 0;
+	for(const TestCase& testCase : GetTestCases()){
+		if(filter && strstr(testCase.name, filter) == nullptr){
+			continue;
+		}
+
+		const int failuresBefore = gFailures;
+		testCase.function();
+		ranTests++;
+		if(gFailures != failuresBefore){
+			printf("FAILED %s\n", testCase.name);
+			failedTests++;
+		}else{
+			printf("passed %s\n", testCase.name);
+		}
+	}
+
+	printf("%d of %d tests passed\n", ranTests - failedTests, ranTests);
+	return failedTests == 0 ? 0 : 1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdio>
+#include <vector>
+
+// Just enough of a test harness for the portable modules. TEST registers a
+// function, CHECK records a failure and keeps going, TestMain.cpp runs
+// every registered test and returns non-zero when any check failed.
+
+typedef void(*TestFunction)();
+
+struct TestCase {
+	const char* name;
+	TestFunction function;
+};
+
+std::vector<TestCase>& GetTestCases();
+void ReportFailure(const char* file, int line, const char* expression);
+
+struct TestRegistrar {
+	TestRegistrar(const char* name, TestFunction function){ GetTestCases().push_back({ name, function }); }
+};
+
+#define TEST(name) \
+	static void name(); \
+	static TestRegistrar name##Registrar(#name, name); \
+	static void name()
+
+#define CHECK(expression) \
+	do { if(!(expression)){ ReportFailure(__FILE__, __LINE__, #expression); } } while(false)
+
+#define CHECK_EQUAL(expected, actual) \
+	do { if(!((expected) == (actual))){ ReportFailure(__FILE__, __LINE__, #expected " == " #actual); } } while(false)
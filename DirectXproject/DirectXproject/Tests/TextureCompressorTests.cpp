@@ -0,0 +1,143 @@
+#include "TestMain.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "TextureCompressor.h"
+
+namespace {
+	// Smooth color ramps with a gentle wave through them and an alpha ramp
+	// the other way, the kind of content BC1 and BC3 are built for.
+	std::vector<uint8_t> MakeGradient(uint32_t width, uint32_t height){
+		std::vector<uint8_t> rgba(size_t(width) * height * 4);
+		for(uint32_t y = 0; y < height; y++){
+			for(uint32_t x = 0; x < width; x++){
+				uint8_t* pixel = &rgba[(size_t(y) * width + x) * 4];
+				const float u = float(x) / width;
+				const float v = float(y) / height;
+				pixel[0] = static_cast<uint8_t>(255.0f * u);
+				pixel[1] = static_cast<uint8_t>(255.0f * v);
+				pixel[2] = static_cast<uint8_t>(127.5f + 127.0f * sinf(6.0f * u + 4.0f * v));
+				pixel[3] = static_cast<uint8_t>(255.0f * (1.0f - v));
+			}
+		}
+		return rgba;
+	}
+
+	// Independent random pixels, as bad as it gets for a 4x4 endpoint fit.
+	std::vector<uint8_t> MakeNoise(uint32_t width, uint32_t height){
+		std::vector<uint8_t> rgba(size_t(width) * height * 4);
+		uint32_t state = 12345;
+		for(uint8_t& value : rgba){
+			state = state * 1664525u + 1013904223u;
+			value = static_cast<uint8_t>(state >> 24);
+		}
+		return rgba;
+	}
+
+	double TopMipPsnr(const std::vector<uint8_t>& rgba, uint32_t width, uint32_t height, BcFormat format, CompressionQuality quality, CompressionPath path){
+		CompressedTexture texture;
+		TextureCookReport report;
+		if(!CompressTexture(rgba.data(), width, height, width * 4, format, quality, false, texture, &report, path)){
+			return 0.0;
+		}
+		return report.psnr;
+	}
+}
+
+TEST(SolidBlocksRoundTripExactly){
+	// 5:6:5 representable colors, so BC1 can hit them exactly.
+	uint8_t pixels[64];
+	for(int i = 0; i < 16; i++){
+		pixels[i * 4 + 0] = 0xFF;
+		pixels[i * 4 + 1] = 0x82;
+		pixels[i * 4 + 2] = 0x08;
+		pixels[i * 4 + 3] = 0xFF;
+	}
+	const BcFormat formats[] = { BcFormat::BC1, BcFormat::BC3 };
+	for(BcFormat format : formats){
+		uint8_t block[16];
+		uint8_t decoded[64];
+		CompressBlock(format, CompressionQuality::Normal, pixels, block);
+		DecompressBlock(format, block, decoded);
+		CHECK(ComputePsnr(pixels, decoded, 16, GetChannelMask(format)) == std::numeric_limits<double>::infinity());
+	}
+}
+
+TEST(Bc1GradientPsnr){
+	const std::vector<uint8_t> image = MakeGradient(256, 256);
+	const double fast = TopMipPsnr(image, 256, 256, BcFormat::BC1, CompressionQuality::Fast, CompressionPath::Scalar);
+	const double normal = TopMipPsnr(image, 256, 256, BcFormat::BC1, CompressionQuality::Normal, CompressionPath::Scalar);
+	const double high = TopMipPsnr(image, 256, 256, BcFormat::BC1, CompressionQuality::High, CompressionPath::Scalar);
+	// Around 44 dB at the time of writing, each level buys a bit more.
+	CHECK(fast > 42.0);
+	CHECK(normal > fast);
+	CHECK(high > normal);
+}
+
+TEST(Bc3GradientPsnrCoversAlpha){
+	const std::vector<uint8_t> image = MakeGradient(256, 256);
+	const double psnr = TopMipPsnr(image, 256, 256, BcFormat::BC3, CompressionQuality::Normal, CompressionPath::Scalar);
+	CHECK(psnr > 44.0);
+
+	// BC1 has no alpha channel to speak of, so over RGBA it falls far behind.
+	CompressedTexture texture;
+	CompressTexture(image.data(), 256, 256, 256 * 4, BcFormat::BC1, CompressionQuality::Normal, false, texture, nullptr, CompressionPath::Scalar);
+	std::vector<uint8_t> decoded(image.size());
+	uint8_t pixels[64];
+	for(uint32_t blockY = 0; blockY < 64; blockY++){
+		for(uint32_t blockX = 0; blockX < 64; blockX++){
+			DecompressBlock(BcFormat::BC1, texture.mips[0].data.data() + (blockY * 64 + blockX) * 8, pixels);
+			for(uint32_t y = 0; y < 4; y++){
+				memcpy(&decoded[((blockY * 4 + y) * 256 + blockX * 4) * 4], pixels + y * 16, 16);
+			}
+		}
+	}
+	CHECK(ComputePsnr(image.data(), decoded.data(), 256 * 256, 0xF) < psnr - 10.0);
+}
+
+TEST(NoiseStaysAboveFloor){
+	// Nothing fits noise well, but the fit must still beat flat gray.
+	const std::vector<uint8_t> image = MakeNoise(64, 64);
+	const std::vector<uint8_t> gray(image.size(), 128);
+	const double floor = ComputePsnr(image.data(), gray.data(), 64 * 64, 0x7);
+	CHECK(TopMipPsnr(image, 64, 64, BcFormat::BC1, CompressionQuality::Normal, CompressionPath::Scalar) > floor);
+	CHECK(TopMipPsnr(image, 64, 64, BcFormat::BC3, CompressionQuality::Normal, CompressionPath::Scalar) > floor);
+}
+
+TEST(SsePathMatchesScalarBlocks){
+	if(GetBestCompressionPath() != CompressionPath::SSE){
+		return;
+	}
+	const std::vector<uint8_t> image = MakeGradient(128, 128);
+	const BcFormat formats[] = { BcFormat::BC1, BcFormat::BC3 };
+	const CompressionQuality qualities[] = { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High };
+	for(BcFormat format : formats){
+		for(CompressionQuality quality : qualities){
+			CompressedTexture scalar;
+			CompressedTexture sse;
+			CompressTexture(image.data(), 128, 128, 128 * 4, format, quality, false, scalar, nullptr, CompressionPath::Scalar);
+			CompressTexture(image.data(), 128, 128, 128 * 4, format, quality, false, sse, nullptr, CompressionPath::SSE);
+			CHECK(scalar.mips[0].data == sse.mips[0].data);
+		}
+	}
+}
+
+TEST(MipChainAndOddSizes){
+	const std::vector<uint8_t> image = MakeGradient(70, 33);
+	CompressedTexture texture;
+	CHECK(CompressTexture(image.data(), 70, 33, 70 * 4, BcFormat::BC3, CompressionQuality::Fast, true, texture));
+	// 70x33 down to 1x1 is seven levels.
+	CHECK_EQUAL(7u, static_cast<uint32_t>(texture.mips.size()));
+	CHECK_EQUAL(18u, texture.mips[0].blocksWide);
+	CHECK_EQUAL(9u, texture.mips[0].blocksHigh);
+	CHECK_EQUAL(size_t(18) * 9 * 16, texture.mips[0].data.size());
+	CHECK_EQUAL(1u, texture.mips.back().width);
+	CHECK_EQUAL(1u, texture.mips.back().height);
+	CHECK_EQUAL(size_t(16), texture.mips.back().data.size());
+
+	CHECK(!CompressTexture(image.data(), 70, 33, 60 * 4, BcFormat::BC1, CompressionQuality::Fast, false, texture));
+}
@@ -0,0 +1,260 @@
+#include "TestMain.h"
+
+#include <vector>
+
+#include "TextureResidency.h"
+
+namespace {
+	// Stands in for ReservedTexture and the GPU. Load transitions map the mip
+	// and start an upload that lands latency frames later, drops unmap it.
+	// Every transition is checked against what is mapped.
+	struct FakeResidencyBackend {
+		struct Upload {
+			StreamedTextureId texture;
+			uint32_t mip;
+			uint32_t framesLeft;
+		};
+
+		TextureResidency& residency;
+		uint32_t latency;
+		std::vector<std::vector<bool>> mapped;
+		std::vector<Upload> uploads;
+		std::vector<MipTransition> transitions;
+		uint32_t loads = 0;
+		uint32_t drops = 0;
+		uint32_t errors = 0;
+
+		FakeResidencyBackend(TextureResidency& residency, uint32_t latency) :residency(residency), latency(latency) {}
+
+		StreamedTextureId Register(const StreamedTextureDesc& desc){
+			const StreamedTextureId id = residency.Register(desc);
+			if(mapped.size() <= id){
+				mapped.resize(id + 1);
+			}
+			// The packed tail is mapped for the texture's whole life.
+			mapped[id].assign(desc.mipCount, false);
+			for(uint32_t mip = desc.pinnedMip; mip < desc.mipCount; mip++){
+				mapped[id][mip] = true;
+			}
+			return id;
+		}
+
+		// One frame: finished uploads first, the way the release queue
+		// retires them, then Update and its transitions.
+		void Frame(){
+			size_t kept = 0;
+			for(Upload& upload : uploads){
+				if(upload.framesLeft == 0){
+					residency.OnMipLoaded(upload.texture, upload.mip);
+				}else{
+					upload.framesLeft--;
+					uploads[kept++] = upload;
+				}
+			}
+			uploads.resize(kept);
+
+			transitions.clear();
+			residency.Update(transitions);
+			for(const MipTransition& transition : transitions){
+				std::vector<bool>::reference isMapped = mapped[transition.texture][transition.mip];
+				if(transition.load){
+					// Coarse to fine, next to what is resident.
+					errors += isMapped || transition.mip + 1 != residency.GetResidentMip(transition.texture) ? 1 : 0;
+					isMapped = true;
+					uploads.push_back({ transition.texture, transition.mip, latency });
+					loads++;
+				}else{
+					errors += isMapped ? 0 : 1;
+					isMapped = false;
+					drops++;
+				}
+			}
+
+			// Whatever may be sampled is mapped.
+			for(StreamedTextureId id = 0; id < mapped.size(); id++){
+				for(uint32_t mip = residency.GetResidentMip(id); mip < mapped[id].size(); mip++){
+					errors += mapped[id][mip] ? 0 : 1;
+				}
+			}
+		}
+
+		uint32_t CountMapped(StreamedTextureId id) const {
+			uint32_t count = 0;
+			for(bool isMapped : mapped[id]){
+				count += isMapped ? 1 : 0;
+			}
+			return count;
+		}
+	};
+
+	// 1024 square RGBA8, mips 6 and up are the packed tail.
+	StreamedTextureDesc MakeDesc(uint32_t size = 1024, uint32_t mipCount = 11, uint32_t pinnedMip = 6){
+		return { size, size, mipCount, 1, 4, pinnedMip };
+	}
+}
+
+TEST(MipBytesFollowTheBlockLayout){
+	const StreamedTextureDesc rgba = MakeDesc();
+	CHECK_EQUAL(size_t(4u << 20), TextureResidency::GetMipBytes(rgba, 0));
+	CHECK_EQUAL(size_t(4), TextureResidency::GetMipBytes(rgba, 10));
+	CHECK_EQUAL(size_t(0), TextureResidency::GetMipBytes(rgba, 11));
+	CHECK_EQUAL(size_t(4 + 16 + 64), TextureResidency::GetChainBytes(rgba, 8));
+
+	// BC1, mips below one block still take a whole block.
+	const StreamedTextureDesc bc1 = { 256, 128, 9, 4, 8, 4 };
+	CHECK_EQUAL(size_t(64 * 32 * 8), TextureResidency::GetMipBytes(bc1, 0));
+	CHECK_EQUAL(size_t(8), TextureResidency::GetMipBytes(bc1, 6));
+	CHECK_EQUAL(size_t(8), TextureResidency::GetMipBytes(bc1, 8));
+}
+
+TEST(FootprintPicksTheMipOfOneTexelPerPixel){
+	CHECK_EQUAL(0.0f, TextureResidency::ComputeMipFromFootprint(1024, 1024, 2048.0f, 2048.0f));
+	CHECK_EQUAL(0.0f, TextureResidency::ComputeMipFromFootprint(1024, 1024, 1024.0f, 1024.0f));
+	CHECK_EQUAL(2.0f, TextureResidency::ComputeMipFromFootprint(1024, 1024, 256.0f, 256.0f));
+	// The more minified axis decides.
+	CHECK_EQUAL(3.0f, TextureResidency::ComputeMipFromFootprint(1024, 1024, 512.0f, 128.0f));
+	CHECK(TextureResidency::ComputeMipFromFootprint(1024, 1024, 0.0f, 10.0f) > 11.0f);
+}
+
+TEST(LoadsGoCoarseToFineOneMipAtATime){
+	TextureResidency residency;
+	residency.Init(64u << 20);
+	FakeResidencyBackend backend(residency, 2);
+	const StreamedTextureId id = backend.Register(MakeDesc());
+	CHECK_EQUAL(6u, residency.GetResidentMip(id));
+	CHECK_EQUAL(TextureResidency::GetChainBytes(MakeDesc(), 6), residency.GetCommittedBytes());
+
+	// Each mip takes three frames: the one that issues it and the two of
+	// upload latency. Mip 0 lands at the start of the nineteenth.
+	for(int frame = 0; frame < 18; frame++){
+		residency.ReportSampledMip(id, 0.4f);
+		backend.Frame();
+	}
+	CHECK_EQUAL(0u, residency.GetTargetMip(id));
+	CHECK_EQUAL(1u, residency.GetResidentMip(id));
+	residency.ReportSampledMip(id, 0.4f);
+	backend.Frame();
+	CHECK_EQUAL(0u, residency.GetResidentMip(id));
+
+	CHECK_EQUAL(6u, backend.loads);
+	CHECK_EQUAL(0u, backend.drops);
+	CHECK_EQUAL(11u, backend.CountMapped(id));
+	CHECK_EQUAL(TextureResidency::GetChainBytes(MakeDesc(), 0), residency.GetCommittedBytes());
+	CHECK_EQUAL(0u, backend.errors);
+}
+
+TEST(CoarserFeedbackDropsOnlyAfterTheDelay){
+	TextureResidency residency;
+	residency.Init(64u << 20, 5);
+	FakeResidencyBackend backend(residency, 0);
+	const StreamedTextureId id = backend.Register(MakeDesc());
+	for(int frame = 0; frame < 20; frame++){
+		residency.ReportSampledMip(id, 0.0f);
+		backend.Frame();
+	}
+	CHECK_EQUAL(0u, residency.GetResidentMip(id));
+
+	// A few frames of coarser feedback, then fine again: nothing dropped.
+	for(int frame = 0; frame < 4; frame++){
+		residency.ReportSampledMip(id, 3.0f);
+		backend.Frame();
+	}
+	residency.ReportSampledMip(id, 0.0f);
+	backend.Frame();
+	CHECK_EQUAL(0u, backend.drops);
+
+	// Coarser for the whole delay drops mips 0 to 2 at once.
+	for(int frame = 0; frame < 4; frame++){
+		residency.ReportSampledMip(id, 3.0f);
+		backend.Frame();
+	}
+	CHECK_EQUAL(0u, backend.drops);
+	residency.ReportSampledMip(id, 3.0f);
+	backend.Frame();
+	CHECK_EQUAL(3u, backend.drops);
+	CHECK_EQUAL(3u, residency.GetResidentMip(id));
+	CHECK_EQUAL(8u, backend.CountMapped(id));
+	CHECK_EQUAL(0u, backend.errors);
+}
+
+TEST(BudgetCoarsensTheLeastRecentlySeenTextureFirst){
+	// Two 256 square textures, mips 4 and up packed. Dropping on their own
+	// is delayed past the test, only the budget takes mips away.
+	const StreamedTextureDesc desc = MakeDesc(256, 9, 4);
+	TextureResidency residency;
+	residency.Init(400000, 1000);
+	FakeResidencyBackend backend(residency, 0);
+	const StreamedTextureId first = backend.Register(desc);
+	const StreamedTextureId second = backend.Register(desc);
+
+	// Both full chains do not fit, one mip 0 each is too much as well.
+	for(int frame = 0; frame < 10; frame++){
+		residency.ReportSampledMip(first, 0.0f);
+		residency.ReportSampledMip(second, 0.0f);
+		backend.Frame();
+		CHECK(residency.GetCommittedBytes() <= residency.GetBudgetBytes());
+	}
+	CHECK_EQUAL(1u, residency.GetResidentMip(first));
+	CHECK_EQUAL(1u, residency.GetResidentMip(second));
+
+	// Memory pressure while only the second one is on screen. The first
+	// gives up everything down to its packed tail before the second loses
+	// its mip 0.
+	residency.SetBudget(100000);
+	residency.ReportSampledMip(second, 0.0f);
+	backend.Frame();
+	CHECK(residency.GetCommittedBytes() <= residency.GetBudgetBytes());
+	CHECK_EQUAL(4u, residency.GetResidentMip(first));
+	CHECK_EQUAL(1u, residency.GetResidentMip(second));
+	CHECK_EQUAL(3u, backend.drops);
+
+	// More than every streamed mip is asked to go: stops at the packed tails.
+	residency.SetBudget(0);
+	residency.ReportSampledMip(second, 0.0f);
+	backend.Frame();
+	CHECK_EQUAL(4u, residency.GetResidentMip(first));
+	CHECK_EQUAL(4u, residency.GetResidentMip(second));
+	CHECK_EQUAL(2 * TextureResidency::GetChainBytes(desc, 4), residency.GetCommittedBytes());
+	CHECK_EQUAL(0u, backend.errors);
+}
+
+TEST(LoadThatLandsAfterItIsUnwantedIsDropped){
+	TextureResidency residency;
+	residency.Init(64u << 20, 0);
+	FakeResidencyBackend backend(residency, 2);
+	const StreamedTextureId id = backend.Register(MakeDesc());
+
+	residency.ReportSampledMip(id, 0.0f);
+	backend.Frame();
+	CHECK_EQUAL(1u, backend.loads);
+	CHECK_EQUAL(TextureResidency::GetChainBytes(MakeDesc(), 5), residency.GetCommittedBytes());
+
+	// Off screen from now on, the mip 5 upload is still in flight.
+	for(int frame = 0; frame < 5; frame++){
+		backend.Frame();
+	}
+	CHECK_EQUAL(1u, backend.loads);
+	CHECK_EQUAL(1u, backend.drops);
+	CHECK_EQUAL(6u, residency.GetResidentMip(id));
+	CHECK_EQUAL(5u, backend.CountMapped(id));
+	CHECK_EQUAL(TextureResidency::GetChainBytes(MakeDesc(), 6), residency.GetCommittedBytes());
+	CHECK_EQUAL(0u, backend.errors);
+}
+
+TEST(UnregisterReturnsCommittedBytesAndReusesTheId){
+	TextureResidency residency;
+	residency.Init(64u << 20);
+	FakeResidencyBackend backend(residency, 1);
+	const StreamedTextureId id = backend.Register(MakeDesc());
+	residency.ReportSampledMip(id, 0.0f);
+	backend.Frame();
+	CHECK(residency.GetCommittedBytes() > TextureResidency::GetChainBytes(MakeDesc(), 6));
+
+	// In flight bytes go too.
+	residency.Unregister(id);
+	CHECK_EQUAL(size_t(0), residency.GetCommittedBytes());
+	const StreamedTextureId reused = residency.Register(MakeDesc(256, 9, 4));
+	CHECK_EQUAL(id, reused);
+	CHECK_EQUAL(4u, residency.GetResidentMip(reused));
+	CHECK_EQUAL(TextureResidency::GetChainBytes(MakeDesc(256, 9, 4), 4), residency.GetCommittedBytes());
+}
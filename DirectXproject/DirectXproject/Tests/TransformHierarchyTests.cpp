@@ -0,0 +1,203 @@
+#include "TestMain.h"
+
+#include <cstring>
+#include <vector>
+
+#include "TransformHierarchy.h"
+
+namespace {
+	typedef TransformHierarchy::Handle Handle;
+
+	bool Equal(const Float4x4& a, const Float4x4& b){
+		for(int r = 0; r < 4; r++){
+			for(int c = 0; c < 4; c++){
+				if(a.m[r][c] != b.m[r][c]){
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	Float4x4 Scale(float s){
+		Float4x4 scale = Float4x4::Identity();
+		scale.m[0][0] = s;
+		scale.m[1][1] = s;
+		scale.m[2][2] = s;
+		return scale;
+	}
+}
+
+TEST(WorldIsLocalTimesParentWorld){
+	TransformHierarchy hierarchy;
+	Handle root = hierarchy.Create();
+	Handle child = hierarchy.Create(root);
+	Handle grandchild = hierarchy.Create(child);
+	hierarchy.SetLocal(root, Scale(2.0f));
+	hierarchy.SetLocal(child, Float4x4::Translation(1.0f, 0.0f, 0.0f));
+	hierarchy.SetLocal(grandchild, Float4x4::Translation(0.0f, 3.0f, 0.0f));
+	hierarchy.Update();
+
+	CHECK_EQUAL(3u, hierarchy.GetLastUpdatedCount());
+	CHECK(Equal(Scale(2.0f), hierarchy.GetWorld(root)));
+	const Float4x4 childWorld = Multiply(Float4x4::Translation(1.0f, 0.0f, 0.0f), Scale(2.0f));
+	CHECK(Equal(childWorld, hierarchy.GetWorld(child)));
+	CHECK(Equal(Multiply(Float4x4::Translation(0.0f, 3.0f, 0.0f), childWorld), hierarchy.GetWorld(grandchild)));
+	CHECK_EQUAL(2.0f, hierarchy.GetWorld(grandchild).m[3][0]);
+	CHECK_EQUAL(6.0f, hierarchy.GetWorld(grandchild).m[3][1]);
+}
+
+TEST(OnlyDirtySubtreesAreUpdated){
+	TransformHierarchy hierarchy;
+	Handle rootA = hierarchy.Create();
+	Handle childA = hierarchy.Create(rootA);
+	Handle leafA = hierarchy.Create(childA);
+	Handle rootB = hierarchy.Create();
+	Handle childB = hierarchy.Create(rootB);
+	hierarchy.Update();
+	CHECK_EQUAL(5u, hierarchy.GetLastUpdatedCount());
+
+	// Nothing changed, nothing recomputed.
+	hierarchy.Update();
+	CHECK_EQUAL(0u, hierarchy.GetLastUpdatedCount());
+
+	// A parent change reaches everything below it, and nothing in the other tree.
+	hierarchy.SetLocal(childA, Float4x4::Translation(5.0f, 0.0f, 0.0f));
+	hierarchy.Update();
+	CHECK_EQUAL(2u, hierarchy.GetLastUpdatedCount());
+	CHECK_EQUAL(5.0f, hierarchy.GetWorld(leafA).m[3][0]);
+
+	// A leaf change only updates the leaf.
+	hierarchy.SetLocal(childB, Float4x4::Translation(0.0f, 1.0f, 0.0f));
+	hierarchy.Update();
+	CHECK_EQUAL(1u, hierarchy.GetLastUpdatedCount());
+	CHECK_EQUAL(1.0f, hierarchy.GetWorld(childB).m[3][1]);
+
+	// A root change goes all the way down.
+	hierarchy.SetLocal(rootA, Float4x4::Translation(0.0f, 0.0f, 2.0f));
+	hierarchy.Update();
+	CHECK_EQUAL(3u, hierarchy.GetLastUpdatedCount());
+	CHECK_EQUAL(5.0f, hierarchy.GetWorld(leafA).m[3][0]);
+	CHECK_EQUAL(2.0f, hierarchy.GetWorld(leafA).m[3][2]);
+}
+
+TEST(ParentsAreUpdatedBeforeChildren){
+	// Children created before their parents and reparented afterwards sit
+	// ahead of them until Update restores depth-first order.
+	TransformHierarchy hierarchy;
+	Handle leaf = hierarchy.Create();
+	Handle middle = hierarchy.Create();
+	Handle root = hierarchy.Create();
+	hierarchy.SetLocal(leaf, Float4x4::Translation(1.0f, 0.0f, 0.0f));
+	hierarchy.SetLocal(middle, Float4x4::Translation(10.0f, 0.0f, 0.0f));
+	hierarchy.SetLocal(root, Float4x4::Translation(100.0f, 0.0f, 0.0f));
+	CHECK(hierarchy.SetParent(leaf, middle));
+	CHECK(hierarchy.SetParent(middle, root));
+	hierarchy.Update();
+
+	// One forward pass only gets this right when every parent came first.
+	CHECK_EQUAL(111.0f, hierarchy.GetWorld(leaf).m[3][0]);
+	CHECK_EQUAL(110.0f, hierarchy.GetWorld(middle).m[3][0]);
+
+	// Moving a subtree under another node keeps working after the rebuild.
+	Handle other = hierarchy.Create();
+	hierarchy.SetLocal(other, Float4x4::Translation(0.0f, 7.0f, 0.0f));
+	CHECK(hierarchy.SetParent(middle, other));
+	hierarchy.Update();
+	CHECK_EQUAL(11.0f, hierarchy.GetWorld(leaf).m[3][0]);
+	CHECK_EQUAL(7.0f, hierarchy.GetWorld(leaf).m[3][1]);
+}
+
+TEST(CyclesAreRefused){
+	TransformHierarchy hierarchy;
+	Handle root = hierarchy.Create();
+	Handle child = hierarchy.Create(root);
+	Handle grandchild = hierarchy.Create(child);
+	CHECK(!hierarchy.SetParent(root, grandchild));
+	CHECK(!hierarchy.SetParent(child, child));
+	hierarchy.Update();
+	CHECK_EQUAL(3u, hierarchy.GetNodeCount());
+}
+
+TEST(DestroyRemovesTheSubtreeAndReusesHandles){
+	TransformHierarchy hierarchy;
+	Handle root = hierarchy.Create();
+	Handle child = hierarchy.Create(root);
+	hierarchy.Create(child);
+	Handle other = hierarchy.Create();
+	hierarchy.SetLocal(other, Float4x4::Translation(4.0f, 0.0f, 0.0f));
+	hierarchy.Destroy(child);
+	hierarchy.Update();
+
+	CHECK_EQUAL(2u, hierarchy.GetNodeCount());
+	CHECK_EQUAL(4.0f, hierarchy.GetWorld(other).m[3][0]);
+
+	// Freed handles come back, the survivors keep theirs.
+	Handle reused = hierarchy.Create(other);
+	CHECK(reused != root && reused != other);
+	hierarchy.Update();
+	CHECK_EQUAL(4.0f, hierarchy.GetWorld(reused).m[3][0]);
+}
+
+TEST(ParallelUpdateMatchesSerial){
+	// Enough dirty nodes in enough roots to go through the JobSystem.
+	const int kRoots = 64;
+	const int kChildren = 127;
+	TransformHierarchy hierarchy;
+	std::vector<Handle> leaves;
+	for(int r = 0; r < kRoots; r++){
+		Handle root = hierarchy.Create();
+		hierarchy.SetLocal(root, Float4x4::Translation(static_cast<float>(r), 0.0f, 0.0f));
+		Handle parent = root;
+		for(int c = 0; c < kChildren; c++){
+			Handle node = hierarchy.Create(c % 8 == 0 ? root : parent);
+			hierarchy.SetLocal(node, Float4x4::Translation(0.0f, 1.0f, 0.0f));
+			leaves.push_back(node);
+			parent = node;
+		}
+	}
+	hierarchy.Update();
+	CHECK_EQUAL(static_cast<uint32_t>(kRoots * (kChildren + 1)), hierarchy.GetLastUpdatedCount());
+
+	bool match = true;
+	for(int r = 0; r < kRoots; r++){
+		for(int c = 0; c < kChildren; c++){
+			// Chains restart under the root every 8 nodes.
+			const Float4x4& world = hierarchy.GetWorld(leaves[r * kChildren + c]);
+			match = match && world.m[3][0] == static_cast<float>(r) && world.m[3][1] == static_cast<float>(c % 8 + 1);
+		}
+	}
+	CHECK(match);
+}
+
+TEST(BatchedUpdateMatchesMultiply){
+	// Wide levels go through MultiplyMatrices in batches, chains flush one
+	// at a time. Both must give exactly what Multiply gives.
+	TransformHierarchy hierarchy;
+	std::vector<Handle> nodes;
+	std::vector<Handle> parents;
+	Handle root = hierarchy.Create();
+	hierarchy.SetLocal(root, Scale(1.5f));
+	for(int i = 0; i < 300; i++){
+		Handle parent = i < 150 ? root : nodes[i % 150];
+		if(i % 7 == 0 && !nodes.empty()){
+			parent = nodes.back();
+		}
+		Handle node = hierarchy.Create(parent);
+		Float4x4 local = Float4x4::Translation(0.1f * i, -0.3f * i, 0.7f);
+		local.m[0][1] = 0.25f;
+		local.m[2][0] = -0.125f * (i % 5);
+		hierarchy.SetLocal(node, local);
+		nodes.push_back(node);
+		parents.push_back(parent);
+	}
+	hierarchy.Update();
+	CHECK_EQUAL(301u, hierarchy.GetLastUpdatedCount());
+
+	bool exact = true;
+	for(size_t i = 0; i < nodes.size(); i++){
+		const Float4x4 expected = Multiply(hierarchy.GetLocal(nodes[i]), hierarchy.GetWorld(parents[i]));
+		exact = exact && memcmp(&expected, &hierarchy.GetWorld(nodes[i]), sizeof(Float4x4)) == 0;
+	}
+	CHECK(exact);
+}
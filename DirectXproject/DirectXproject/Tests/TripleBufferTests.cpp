@@ -0,0 +1,161 @@
+#include "TestMain.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+#include "RenderThread.h"
+#include "TripleBuffer.h"
+
+// TripleBuffer on one thread for the slot handoff, on two for the races,
+// and RenderThread for the wait that shutdown has to end.
+
+namespace {
+	// Every field holds the sequence number, a reader that sees two
+	// different ones got a slot the writer was still filling.
+	struct Sequenced {
+		uint64_t values[16];
+
+		void Fill(uint64_t sequence){
+			for(uint64_t& value : values){
+				value = sequence;
+			}
+		}
+
+		bool IsWhole() const {
+			for(uint64_t value : values){
+				if(value != values[0]){
+					return false;
+				}
+			}
+			return true;
+		}
+	};
+
+	// Polls until done returns true, false after two seconds.
+	template<typename Done>
+	bool WaitUntil(Done done){
+		const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+		while(!done()){
+			if(std::chrono::steady_clock::now() > deadline){
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		return true;
+	}
+}
+
+TEST(PublishedValuesReachTheReaderInOrder){
+	TripleBuffer<int> buffer;
+	CHECK(!buffer.Acquire());
+
+	buffer.GetWriteSlot() = 1;
+	CHECK(!buffer.Publish());
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(1, buffer.GetReadSlot());
+	// Nothing new, the front stays.
+	CHECK(!buffer.Acquire());
+	CHECK_EQUAL(1, buffer.GetReadSlot());
+
+	// The writer never gets the slot the reader holds.
+	CHECK(&buffer.GetWriteSlot() != &buffer.GetReadSlot());
+	buffer.GetWriteSlot() = 2;
+	CHECK(!buffer.Publish());
+	CHECK_EQUAL(1, buffer.GetReadSlot());
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(2, buffer.GetReadSlot());
+}
+
+TEST(TheLatestPublishWins){
+	TripleBuffer<int> buffer;
+	buffer.GetWriteSlot() = 1;
+	CHECK(!buffer.Publish());
+	// Replaces values the reader never acquired, and says so.
+	buffer.GetWriteSlot() = 2;
+	CHECK(buffer.Publish());
+	buffer.GetWriteSlot() = 3;
+	CHECK(buffer.Publish());
+
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(3, buffer.GetReadSlot());
+	CHECK(!buffer.Acquire());
+	CHECK_EQUAL(3, buffer.GetReadSlot());
+}
+
+TEST(ReaderNeverSeesATornOrOlderValue){
+	const uint64_t count = 200000;
+	TripleBuffer<Sequenced> buffer;
+	buffer.GetWriteSlot().Fill(0);
+
+	uint64_t dropped = 0;
+	std::thread writer([&]{
+		for(uint64_t sequence = 1; sequence <= count; sequence++){
+			buffer.GetWriteSlot().Fill(sequence);
+			dropped += buffer.Publish() ? 1 : 0;
+		}
+	});
+
+	uint64_t acquired = 0;
+	uint64_t last = 0;
+	bool torn = false;
+	bool older = false;
+	while(last < count){
+		buffer.WaitForPublish();
+		if(!buffer.Acquire()){
+			continue;
+		}
+		const Sequenced& value = buffer.GetReadSlot();
+		torn = torn || !value.IsWhole();
+		older = older || value.values[0] <= last;
+		last = value.values[0];
+		acquired++;
+	}
+	writer.join();
+
+	CHECK(!torn);
+	CHECK(!older);
+	CHECK_EQUAL(count, last);
+	// Every value was either read or replaced before it could be.
+	CHECK_EQUAL(count, acquired + dropped);
+}
+
+TEST(WaitForPublishWakesOnPublish){
+	TripleBuffer<int> buffer;
+	std::atomic<bool> woken(false);
+	std::thread reader([&]{
+		buffer.WaitForPublish();
+		woken.store(true);
+	});
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	CHECK(!woken.load());
+	buffer.GetWriteSlot() = 1;
+	buffer.Publish();
+	CHECK(WaitUntil([&]{ return woken.load(); }));
+	reader.join();
+
+	// Already published, no wait at all.
+	buffer.WaitForPublish();
+	CHECK(buffer.Acquire());
+	CHECK_EQUAL(1, buffer.GetReadSlot());
+}
+
+TEST(RenderThreadStopsWhileWaiting){
+	RenderThread thread;
+	std::atomic<uint64_t> rendered(0);
+	CHECK(thread.Start([&](const RenderSnapshot& snapshot){
+		rendered.store(snapshot.frame + 1);
+	}));
+	CHECK(thread.IsRunning());
+
+	thread.Publish();
+	CHECK(WaitUntil([&]{ return rendered.load() == 1; }));
+	// Asleep in WaitForPublish now, Stop has to wake it without a frame.
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	thread.Stop();
+	CHECK(!thread.IsRunning());
+	CHECK_EQUAL(uint64_t(1), rendered.load());
+	CHECK_EQUAL(uint64_t(1), thread.GetStats().framesRendered);
+}
@@ -0,0 +1,243 @@
+#include "TestMain.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "VertexFormat.h"
+
+namespace {
+	float Random(uint32_t& state){
+		state = state * 1664525u + 1013904223u;
+		return (state >> 8) / 16777216.0f;
+	}
+
+	// Unit normals spread over the whole sphere, the other attributes zero.
+	std::vector<SourceVertex> MakeNormals(size_t count){
+		std::vector<SourceVertex> vertices(count);
+		uint32_t state = 12345;
+		for(SourceVertex& vertex : vertices){
+			vertex = SourceVertex();
+			float n[3];
+			float length;
+			do{
+				for(float& k : n){
+					k = Random(state) * 2.0f - 1.0f;
+				}
+				length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+			}while(length < 0.1f || length > 1.0f);
+			for(int k = 0; k < 3; k++){
+				vertex.normal[k] = n[k] / length;
+			}
+		}
+		return vertices;
+	}
+
+	// Positions in [low, high] on every axis, uvs in [0, uvRange].
+	std::vector<SourceVertex> MakeVertices(size_t count, float low, float high, float uvRange){
+		std::vector<SourceVertex> vertices(count);
+		uint32_t state = 777;
+		for(SourceVertex& vertex : vertices){
+			vertex = SourceVertex();
+			for(float& k : vertex.position){
+				k = low + Random(state) * (high - low);
+			}
+			for(float& k : vertex.uv){
+				k = Random(state) * uvRange;
+			}
+		}
+		return vertices;
+	}
+
+	// Encodes with format and returns the decoded vertices.
+	std::vector<SourceVertex> RoundTrip(const std::vector<SourceVertex>& vertices, VertexFormat format, const QuantizationBounds& bounds){
+		format.ComputeLayout();
+		const std::vector<uint8_t> encoded = EncodeVertices(vertices.data(), vertices.size(), format, bounds);
+		std::vector<SourceVertex> decoded(vertices.size());
+		for(size_t i = 0; i < vertices.size(); i++){
+			DecodeVertex(encoded.data() + i * format.stride, format, bounds, decoded[i]);
+		}
+		return decoded;
+	}
+
+	float MaxNormalDegrees(NormalEncoding encoding){
+		const std::vector<SourceVertex> vertices = MakeNormals(20000);
+		VertexFormat format;
+		format.normal = encoding;
+		const std::vector<SourceVertex> decoded = RoundTrip(vertices, format, ComputeQuantizationBounds(vertices.data(), vertices.size()));
+		float maxDegrees = 0.0f;
+		for(size_t i = 0; i < vertices.size(); i++){
+			const float* a = vertices[i].normal;
+			const float* b = decoded[i].normal;
+			const float cosine = std::min(a[0] * b[0] + a[1] * b[1] + a[2] * b[2], 1.0f);
+			maxDegrees = std::max(maxDegrees, acosf(cosine) * 57.29578f);
+		}
+		return maxDegrees;
+	}
+
+	float Bits(uint32_t bits){
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+}
+
+TEST(FloatToHalfRoundTripsEveryHalf){
+	// Every finite half, subnormals included, and both infinities.
+	int mismatches = 0;
+	for(uint32_t half = 0; half <= 0xFFFF; half++){
+		if((half & 0x7C00) == 0x7C00 && (half & 0x3FF) != 0){
+			continue;
+		}
+		mismatches += FloatToHalf(HalfToFloat(static_cast<uint16_t>(half))) != half ? 1 : 0;
+	}
+	CHECK_EQUAL(0, mismatches);
+	CHECK_EQUAL(1.0f, HalfToFloat(0x3C00));
+	CHECK_EQUAL(-2.0f, HalfToFloat(0xC000));
+	CHECK_EQUAL(65504.0f, HalfToFloat(0x7BFF));
+}
+
+TEST(FloatToHalfRoundsToNearestEven){
+	CHECK_EQUAL(uint16_t(0x3C00), FloatToHalf(1.0f));
+	// Halfway between 1 and the next half goes to the even one, below.
+	CHECK_EQUAL(uint16_t(0x3C00), FloatToHalf(1.0f + 1.0f / 2048.0f));
+	CHECK_EQUAL(uint16_t(0x3C02), FloatToHalf(1.0f + 3.0f / 2048.0f));
+	CHECK_EQUAL(uint16_t(0x3C01), FloatToHalf(1.0f + 1.5f / 2048.0f));
+	// Rounding up carries into the exponent.
+	CHECK_EQUAL(uint16_t(0x4000), FloatToHalf(2.0f - 1.0f / 4096.0f));
+}
+
+TEST(FloatToHalfHandlesSubnormalsAndUnderflow){
+	const float smallest = ldexpf(1.0f, -24);
+	CHECK_EQUAL(uint16_t(0x0001), FloatToHalf(smallest));
+	CHECK_EQUAL(uint16_t(0x8001), FloatToHalf(-smallest));
+	CHECK_EQUAL(uint16_t(0x03FF), FloatToHalf(1023.0f * smallest));
+	// The largest subnormal rounds up into the smallest normal.
+	CHECK_EQUAL(uint16_t(0x0400), FloatToHalf(1023.75f * smallest));
+	// Half the smallest ties to zero, a bit more rounds up to it.
+	CHECK_EQUAL(uint16_t(0x0000), FloatToHalf(0.5f * smallest));
+	CHECK_EQUAL(uint16_t(0x0001), FloatToHalf(0.75f * smallest));
+	CHECK_EQUAL(uint16_t(0x0000), FloatToHalf(1e-10f));
+	CHECK_EQUAL(uint16_t(0x8000), FloatToHalf(-1e-10f));
+	// A float subnormal is far below every half.
+	CHECK_EQUAL(uint16_t(0x0000), FloatToHalf(Bits(0x00000001)));
+	CHECK_EQUAL(smallest, HalfToFloat(0x0001));
+}
+
+TEST(FloatToHalfOverflowsToInfinity){
+	const float infinity = std::numeric_limits<float>::infinity();
+	CHECK_EQUAL(uint16_t(0x7C00), FloatToHalf(infinity));
+	CHECK_EQUAL(uint16_t(0xFC00), FloatToHalf(-infinity));
+	CHECK_EQUAL(uint16_t(0x7BFF), FloatToHalf(65504.0f));
+	// Just under halfway to the next power of two still rounds to the max,
+	// halfway and beyond overflow.
+	CHECK_EQUAL(uint16_t(0x7BFF), FloatToHalf(65519.0f));
+	CHECK_EQUAL(uint16_t(0x7C00), FloatToHalf(65520.0f));
+	CHECK_EQUAL(uint16_t(0x7C00), FloatToHalf(1e6f));
+	CHECK_EQUAL(uint16_t(0xFC00), FloatToHalf(-1e30f));
+	CHECK_EQUAL(infinity, HalfToFloat(0x7C00));
+
+	// NaN stays NaN.
+	const uint16_t nan = FloatToHalf(std::numeric_limits<float>::quiet_NaN());
+	CHECK((nan & 0x7C00) == 0x7C00 && (nan & 0x3FF) != 0);
+	CHECK(std::isnan(HalfToFloat(nan)));
+}
+
+TEST(OctahedralNormalsStayWithinTheirErrorBounds){
+	// float acos alone is off by about 0.02 degrees next to 1.
+	CHECK(MaxNormalDegrees(NormalEncoding::Oct16) < 0.05f);
+	CHECK(MaxNormalDegrees(NormalEncoding::Oct8) < 1.0f);
+	CHECK(MaxNormalDegrees(NormalEncoding::Oct8) > 0.1f);
+
+	// The axes, lower hemisphere included, come back exactly.
+	const float directions[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+	for(const float* direction : directions){
+		float encoded[2];
+		float decoded[3];
+		EncodeOctahedral(direction, encoded);
+		DecodeOctahedral(encoded, decoded);
+		for(int k = 0; k < 3; k++){
+			CHECK(fabsf(decoded[k] - direction[k]) < 1e-6f);
+		}
+	}
+}
+
+TEST(Unorm16DecodesWithinHalfAStepOfTheBounds){
+	std::vector<SourceVertex> vertices = MakeVertices(1000, -3.0f, 5.0f, 8.0f);
+	// A flat axis gets a scale of one rather than zero.
+	for(SourceVertex& vertex : vertices){
+		vertex.position[2] = 2.0f;
+	}
+	const QuantizationBounds bounds = ComputeQuantizationBounds(vertices.data(), vertices.size());
+	for(int k = 0; k < 2; k++){
+		CHECK(bounds.positionOffset[k] >= -3.0f && bounds.positionOffset[k] < -2.9f);
+		CHECK(bounds.positionOffset[k] + bounds.positionScale[k] <= 5.0f);
+		CHECK(bounds.positionOffset[k] + bounds.positionScale[k] > 4.9f);
+	}
+	CHECK_EQUAL(2.0f, bounds.positionOffset[2]);
+	CHECK_EQUAL(1.0f, bounds.positionScale[2]);
+
+	VertexFormat format;
+	format.position = PositionEncoding::Unorm16;
+	format.uv = UvEncoding::Unorm16;
+	const std::vector<SourceVertex> decoded = RoundTrip(vertices, format, bounds);
+	int outside = 0;
+	for(size_t i = 0; i < vertices.size(); i++){
+		for(int k = 0; k < 3; k++){
+			const float step = bounds.positionScale[k] / 65535.0f;
+			outside += fabsf(decoded[i].position[k] - vertices[i].position[k]) > step * 0.5f + 1e-6f ? 1 : 0;
+		}
+		for(int k = 0; k < 2; k++){
+			const float step = bounds.uvScale[k] / 65535.0f;
+			outside += fabsf(decoded[i].uv[k] - vertices[i].uv[k]) > step * 0.5f + 1e-6f ? 1 : 0;
+		}
+	}
+	CHECK_EQUAL(0, outside);
+}
+
+TEST(ChooseVertexFormatPicksTheSmallestEncodingWithinTolerance){
+	const uint32_t positionAndUv = VertexAttributePosition | VertexAttributeUv;
+
+	// Small positions and uvs fit in halves.
+	std::vector<SourceVertex> unit = MakeVertices(1000, -1.0f, 1.0f, 1.0f);
+	VertexFormat format = ChooseVertexFormat(unit.data(), unit.size(), positionAndUv);
+	CHECK(format.position == PositionEncoding::Half);
+	CHECK(format.uv == UvEncoding::Half);
+	CHECK(format.normal == NormalEncoding::None);
+	CHECK(format.color == ColorEncoding::None);
+	CHECK_EQUAL(12u, format.stride);
+	CHECK_EQUAL(8u, format.uvOffset);
+
+	// Far from the origin halves are too coarse. Unorm16 would fit the
+	// small box, but the shaders cannot dequantize it, so full floats.
+	std::vector<SourceVertex> distant = MakeVertices(1000, 5000.0f, 5001.0f, 8.0f);
+	format = ChooseVertexFormat(distant.data(), distant.size(), positionAndUv);
+	CHECK(format.position == PositionEncoding::Float32);
+	CHECK(format.uv == UvEncoding::Float32);
+	CHECK_EQUAL(20u, format.stride);
+
+	// Normals: the default degree fits Oct8, a tighter one needs Oct16.
+	std::vector<SourceVertex> normals = MakeNormals(2000);
+	QuantizationTolerance tolerance;
+	CHECK(ChooseVertexFormat(normals.data(), normals.size(), VertexAttributeNormal, tolerance).normal == NormalEncoding::Oct8);
+	tolerance.normalDegrees = 0.1f;
+	CHECK(ChooseVertexFormat(normals.data(), normals.size(), VertexAttributeNormal, tolerance).normal == NormalEncoding::Oct16);
+	tolerance.normalDegrees = 0.0f;
+	CHECK(ChooseVertexFormat(normals.data(), normals.size(), VertexAttributeNormal, tolerance).normal == NormalEncoding::Float32);
+
+	// Colors on the 8 bit grid pack, colors between its steps do not once
+	// the tolerance is below half a step.
+	for(size_t i = 0; i < normals.size(); i++){
+		for(int k = 0; k < 4; k++){
+			normals[i].color[k] = static_cast<float>((i * 7 + k * 31) % 256) / 255.0f;
+		}
+	}
+	tolerance.color = 1e-4f;
+	CHECK(ChooseVertexFormat(normals.data(), normals.size(), VertexAttributeColor, tolerance).color == ColorEncoding::Unorm8);
+	for(SourceVertex& vertex : normals){
+		vertex.color[0] = std::min(vertex.color[0] + 0.4f / 255.0f, 1.0f);
+	}
+	CHECK(ChooseVertexFormat(normals.data(), normals.size(), VertexAttributeColor, tolerance).color == ColorEncoding::Float32);
+}
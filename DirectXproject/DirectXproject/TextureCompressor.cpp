@@ -0,0 +1,901 @@
+// The SIMD index fit has to pick the same palette entries as the scalar one,
+// which needs every multiply and add rounded on its own.
+#if defined(_MSC_VER)
+#pragma float_control(precise, on)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+#include "TextureCompressor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include "CpuFeatures.h"
+#include "JobSystem.h"
+
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+namespace {
+	// A 4x4 block as one array of 16 values per channel, 0 to 255.
+	struct Block {
+		float channel[4][16];
+	};
+
+	// Up to 16 palette entries, one array per channel.
+	struct Palette {
+		float channel[4][16];
+		int size;
+	};
+
+	// Writes the nearest palette entry of every pixel to indices and its
+	// squared error to errors. Only channels [first, first + count) count.
+	typedef void(*FitKernel)(const Block&, const Palette&, int first, int count, uint8_t* indices, float* errors);
+
+	void FitScalar(const Block& block, const Palette& palette, int first, int count, uint8_t* indices, float* errors){
+		for(int i = 0; i < 16; i++){
+			float best = std::numeric_limits<float>::max();
+			int bestIndex = 0;
+			for(int e = 0; e < palette.size; e++){
+				float distance = 0.0f;
+				for(int c = first; c < first + count; c++){
+					float difference = block.channel[c][i] - palette.channel[c][e];
+					distance = distance + difference * difference;
+				}
+				if(distance < best){
+					best = distance;
+					bestIndex = e;
+				}
+			}
+			indices[i] = static_cast<uint8_t>(bestIndex);
+			errors[i] = best;
+		}
+	}
+
+	#if defined(CPU_X86)
+	// Four pixels per iteration against one palette entry at a time.
+	SIMD_TARGET_SSE41 void FitSSE(const Block& block, const Palette& palette, int first, int count, uint8_t* indices, float* errors){
+		for(int i = 0; i < 16; i += 4){
+			__m128 best = _mm_set1_ps(std::numeric_limits<float>::max());
+			__m128 bestIndex = _mm_setzero_ps();
+			for(int e = 0; e < palette.size; e++){
+				__m128 distance = _mm_setzero_ps();
+				for(int c = first; c < first + count; c++){
+					__m128 difference = _mm_sub_ps(_mm_loadu_ps(&block.channel[c][i]), _mm_set1_ps(palette.channel[c][e]));
+					distance = _mm_add_ps(distance, _mm_mul_ps(difference, difference));
+				}
+				__m128 closer = _mm_cmplt_ps(distance, best);
+				best = _mm_blendv_ps(best, distance, closer);
+				bestIndex = _mm_blendv_ps(bestIndex, _mm_set1_ps(static_cast<float>(e)), closer);
+			}
+			_mm_storeu_ps(errors + i, best);
+			__m128i packed = _mm_cvttps_epi32(bestIndex);
+			packed = _mm_packs_epi32(packed, packed);
+			packed = _mm_packus_epi16(packed, packed);
+			int four = _mm_cvtsi128_si32(packed);
+			memcpy(indices + i, &four, 4);
+		}
+	}
+	#endif
+
+	FitKernel SelectKernel(CompressionPath path){
+		if(path == CompressionPath::Auto){
+			path = GetBestCompressionPath();
+		}
+
+		#if defined(CPU_X86)
+		if(path == CompressionPath::SSE && CpuFeatures::Get().sse41){
+			return FitSSE;
+		}
+		#endif
+		return FitScalar;
+	}
+
+	// Fits indices and returns the total error, summed in pixel order so
+	// every kernel gives the same total.
+	float Fit(FitKernel kernel, const Block& block, const Palette& palette, int first, int count, uint8_t* indices){
+		float errors[16];
+		kernel(block, palette, first, count, indices, errors);
+		float total = 0.0f;
+		for(int i = 0; i < 16; i++){
+			total += errors[i];
+		}
+		return total;
+	}
+
+	int Clamp(int value, int low, int high){
+		return std::min(high, std::max(low, value));
+	}
+
+	int RoundToInt(float value){
+		return static_cast<int>(floorf(value + 0.5f));
+	}
+
+	// Endpoints along the principal axis of the selected channels. Fast
+	// uses the bounding box diagonal instead, flipped to follow the sign of
+	// each channel's covariance with the first one.
+	void FitEndpoints(const Block& block, int first, int count, CompressionQuality quality, float* e0, float* e1){
+		float mean[4] = {};
+		for(int c = 0; c < count; c++){
+			for(int i = 0; i < 16; i++){
+				mean[c] += block.channel[first + c][i];
+			}
+			mean[c] /= 16.0f;
+		}
+
+		float covariance[4][4] = {};
+		for(int i = 0; i < 16; i++){
+			for(int a = 0; a < count; a++){
+				for(int b = 0; b < count; b++){
+					covariance[a][b] += (block.channel[first + a][i] - mean[a]) * (block.channel[first + b][i] - mean[b]);
+				}
+			}
+		}
+
+		if(quality == CompressionQuality::Fast){
+			for(int c = 0; c < count; c++){
+				float low = 255.0f;
+				float high = 0.0f;
+				for(int i = 0; i < 16; i++){
+					low = std::min(low, block.channel[first + c][i]);
+					high = std::max(high, block.channel[first + c][i]);
+				}
+				// Pull in a little, the extremes are rarely worth an endpoint.
+				float inset = (high - low) / 16.0f;
+				low += inset;
+				high -= inset;
+				bool flip = c > 0 && covariance[0][c] < 0.0f;
+				e0[c] = flip ? low : high;
+				e1[c] = flip ? high : low;
+			}
+			return;
+		}
+
+		// Power iteration from the largest variance channel.
+		float axis[4] = {};
+		int start = 0;
+		for(int c = 1; c < count; c++){
+			if(covariance[c][c] > covariance[start][start]){
+				start = c;
+			}
+		}
+		axis[start] = 1.0f;
+		for(int iteration = 0; iteration < 8; iteration++){
+			float next[4] = {};
+			for(int a = 0; a < count; a++){
+				for(int b = 0; b < count; b++){
+					next[a] += covariance[a][b] * axis[b];
+				}
+			}
+			float length = 0.0f;
+			for(int c = 0; c < count; c++){
+				length += next[c] * next[c];
+			}
+			length = sqrtf(length);
+			if(length < 1e-6f){
+				break;
+			}
+			for(int c = 0; c < count; c++){
+				axis[c] = next[c] / length;
+			}
+		}
+
+		float low = std::numeric_limits<float>::max();
+		float high = -std::numeric_limits<float>::max();
+		for(int i = 0; i < 16; i++){
+			float t = 0.0f;
+			for(int c = 0; c < count; c++){
+				t += (block.channel[first + c][i] - mean[c]) * axis[c];
+			}
+			low = std::min(low, t);
+			high = std::max(high, t);
+		}
+		for(int c = 0; c < count; c++){
+			e0[c] = Clamp(RoundToInt(mean[c] + axis[c] * high), 0, 255);
+			e1[c] = Clamp(RoundToInt(mean[c] + axis[c] * low), 0, 255);
+		}
+	}
+
+	// Least squares endpoints for fixed indices, where weights[index] is the
+	// share of e1 in that palette entry. False when the system is singular.
+	bool RefineEndpoints(const Block& block, int first, int count, const uint8_t* indices, const float* weights, float* e0, float* e1){
+		float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for(int i = 0; i < 16; i++){
+			float beta = weights[indices[i]];
+			float alpha = 1.0f - beta;
+			aa += alpha * alpha;
+			bb += beta * beta;
+			ab += alpha * beta;
+			for(int c = 0; c < count; c++){
+				ax[c] += alpha * block.channel[first + c][i];
+				bx[c] += beta * block.channel[first + c][i];
+			}
+		}
+
+		float determinant = aa * bb - ab * ab;
+		if(fabsf(determinant) < 1e-6f){
+			return false;
+		}
+		for(int c = 0; c < count; c++){
+			e0[c] = std::min(255.0f, std::max(0.0f, (bb * ax[c] - ab * bx[c]) / determinant));
+			e1[c] = std::min(255.0f, std::max(0.0f, (aa * bx[c] - ab * ax[c]) / determinant));
+		}
+		return true;
+	}
+
+	// Little endian bit writer and reader for the 64 and 128 bit blocks.
+	void WriteBits(uint8_t* out, uint32_t& position, uint32_t value, uint32_t bits){
+		for(uint32_t i = 0; i < bits; i++, position++){
+			if(value & (1u << i)){
+				out[position >> 3] |= static_cast<uint8_t>(1u << (position & 7));
+			}
+		}
+	}
+
+	uint32_t ReadBits(const uint8_t* in, uint32_t& position, uint32_t bits){
+		uint32_t value = 0;
+		for(uint32_t i = 0; i < bits; i++, position++){
+			value |= static_cast<uint32_t>((in[position >> 3] >> (position & 7)) & 1) << i;
+		}
+		return value;
+	}
+
+	void LoadBlock(const uint8_t rgba[64], Block& block){
+		for(int i = 0; i < 16; i++){
+			for(int c = 0; c < 4; c++){
+				block.channel[c][i] = rgba[i * 4 + c];
+			}
+		}
+	}
+
+	// BC1 ----------------------------------------------------------------
+
+	int Expand5(int value){ return (value << 3) | (value >> 2); }
+	int Expand6(int value){ return (value << 2) | (value >> 4); }
+
+	uint16_t Pack565(const float* color){
+		int r = Clamp(RoundToInt(color[0] * 31.0f / 255.0f), 0, 31);
+		int g = Clamp(RoundToInt(color[1] * 63.0f / 255.0f), 0, 63);
+		int b = Clamp(RoundToInt(color[2] * 31.0f / 255.0f), 0, 31);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void Unpack565(uint16_t packed, int* color){
+		color[0] = Expand5((packed >> 11) & 31);
+		color[1] = Expand6((packed >> 5) & 63);
+		color[2] = Expand5(packed & 31);
+	}
+
+	// Palette of a BC1 color block. fourColor is false only for BC1 blocks
+	// with color0 <= color1, where entry 3 is transparent black.
+	void Bc1Palette(uint16_t color0, uint16_t color1, bool fourColor, int palette[4][4]){
+		int c0[3], c1[3];
+		Unpack565(color0, c0);
+		Unpack565(color1, c1);
+		for(int c = 0; c < 3; c++){
+			palette[0][c] = c0[c];
+			palette[1][c] = c1[c];
+			if(fourColor){
+				palette[2][c] = (2 * c0[c] + c1[c] + 1) / 3;
+				palette[3][c] = (c0[c] + 2 * c1[c] + 1) / 3;
+			}else{
+				palette[2][c] = (c0[c] + c1[c]) / 2;
+				palette[3][c] = 0;
+			}
+		}
+		for(int e = 0; e < 4; e++){
+			palette[e][3] = (fourColor || e < 3) ? 255 : 0;
+		}
+	}
+
+	struct Bc1Candidate {
+		uint16_t color0;
+		uint16_t color1;
+		uint8_t indices[16];
+		float error;
+	};
+
+	// Always four color mode, as BC3 requires. Equal endpoints mean a solid
+	// block, where index 0 is right in either mode.
+	void EvaluateBc1(FitKernel kernel, const Block& block, uint16_t color0, uint16_t color1, Bc1Candidate& candidate){
+		if(color0 < color1){
+			std::swap(color0, color1);
+		}
+		candidate.color0 = color0;
+		candidate.color1 = color1;
+
+		int entries[4][4];
+		Bc1Palette(color0, color1, true, entries);
+		Palette palette;
+		palette.size = color0 == color1 ? 1 : 4;
+		for(int e = 0; e < 4; e++){
+			for(int c = 0; c < 4; c++){
+				palette.channel[c][e] = static_cast<float>(entries[e][c]);
+			}
+		}
+		candidate.error = Fit(kernel, block, palette, 0, 3, candidate.indices);
+	}
+
+	void EncodeBc1(FitKernel kernel, CompressionQuality quality, const Block& block, uint8_t* out){
+		static const float kWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float e0[4], e1[4];
+		FitEndpoints(block, 0, 3, quality, e0, e1);
+
+		Bc1Candidate best;
+		EvaluateBc1(kernel, block, Pack565(e0), Pack565(e1), best);
+
+		int refinements = quality == CompressionQuality::Fast ? 0 : (quality == CompressionQuality::Normal ? 1 : 4);
+		for(int i = 0; i < refinements && best.color0 != best.color1; i++){
+			if(!RefineEndpoints(block, 0, 3, best.indices, kWeights, e0, e1)){
+				break;
+			}
+			Bc1Candidate candidate;
+			EvaluateBc1(kernel, block, Pack565(e0), Pack565(e1), candidate);
+			if(candidate.error >= best.error){
+				break;
+			}
+			best = candidate;
+		}
+
+		// Nudge each endpoint channel by one step and keep what helps.
+		if(quality == CompressionQuality::High){
+			static const int kShifts[3] = { 11, 5, 0 };
+			static const int kMasks[3] = { 31, 63, 31 };
+			for(int endpoint = 0; endpoint < 2; endpoint++){
+				for(int c = 0; c < 3; c++){
+					for(int step = -1; step <= 1; step += 2){
+						uint16_t colors[2] = { best.color0, best.color1 };
+						int value = ((colors[endpoint] >> kShifts[c]) & kMasks[c]) + step;
+						if(value < 0 || value > kMasks[c]){
+							continue;
+						}
+						colors[endpoint] = static_cast<uint16_t>((colors[endpoint] & ~(kMasks[c] << kShifts[c])) | (value << kShifts[c]));
+						Bc1Candidate candidate;
+						EvaluateBc1(kernel, block, colors[0], colors[1], candidate);
+						if(candidate.error < best.error){
+							best = candidate;
+						}
+					}
+				}
+			}
+		}
+
+		memset(out, 0, 8);
+		out[0] = static_cast<uint8_t>(best.color0);
+		out[1] = static_cast<uint8_t>(best.color0 >> 8);
+		out[2] = static_cast<uint8_t>(best.color1);
+		out[3] = static_cast<uint8_t>(best.color1 >> 8);
+		uint32_t position = 32;
+		for(int i = 0; i < 16; i++){
+			WriteBits(out, position, best.indices[i], 2);
+		}
+	}
+
+	void DecodeBc1(const uint8_t* in, bool forceFourColor, uint8_t rgba[64]){
+		uint16_t color0 = static_cast<uint16_t>(in[0] | (in[1] << 8));
+		uint16_t color1 = static_cast<uint16_t>(in[2] | (in[3] << 8));
+		int palette[4][4];
+		Bc1Palette(color0, color1, forceFourColor || color0 > color1, palette);
+
+		uint32_t position = 32;
+		for(int i = 0; i < 16; i++){
+			uint32_t index = ReadBits(in, position, 2);
+			for(int c = 0; c < 4; c++){
+				rgba[i * 4 + c] = static_cast<uint8_t>(palette[index][c]);
+			}
+		}
+	}
+
+	// BC4 ----------------------------------------------------------------
+
+	void Bc4Palette(int value0, int value1, int palette[8]){
+		palette[0] = value0;
+		palette[1] = value1;
+		if(value0 > value1){
+			for(int i = 2; i < 8; i++){
+				palette[i] = ((8 - i) * value0 + (i - 1) * value1 + 3) / 7;
+			}
+		}else{
+			for(int i = 2; i < 6; i++){
+				palette[i] = ((6 - i) * value0 + (i - 1) * value1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	struct Bc4Candidate {
+		int value0;
+		int value1;
+		uint8_t indices[16];
+		float error;
+	};
+
+	void EvaluateBc4(FitKernel kernel, const Block& block, int channel, int value0, int value1, Bc4Candidate& candidate){
+		candidate.value0 = value0;
+		candidate.value1 = value1;
+
+		int entries[8];
+		Bc4Palette(value0, value1, entries);
+		Palette palette;
+		palette.size = 8;
+		for(int e = 0; e < 8; e++){
+			palette.channel[channel][e] = static_cast<float>(entries[e]);
+		}
+		candidate.error = Fit(kernel, block, palette, channel, 1, candidate.indices);
+	}
+
+	// Also used for the BC3 alpha and both BC5 channels.
+	void EncodeBc4(FitKernel kernel, CompressionQuality quality, const Block& block, int channel, uint8_t* out){
+		static const float kWeights[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+		int low = 255, high = 0;
+		int innerLow = 255, innerHigh = 0;
+		for(int i = 0; i < 16; i++){
+			int value = static_cast<int>(block.channel[channel][i]);
+			low = std::min(low, value);
+			high = std::max(high, value);
+			if(value > 0 && value < 255){
+				innerLow = std::min(innerLow, value);
+				innerHigh = std::max(innerHigh, value);
+			}
+		}
+
+		Bc4Candidate best;
+		EvaluateBc4(kernel, block, channel, high, low, best);
+
+		if(quality != CompressionQuality::Fast && high > low){
+			float e0 = static_cast<float>(high), e1 = static_cast<float>(low);
+			if(RefineEndpoints(block, channel, 1, best.indices, kWeights, &e0, &e1)){
+				int value0 = Clamp(RoundToInt(e0), 0, 255);
+				int value1 = Clamp(RoundToInt(e1), 0, 255);
+				if(value0 > value1){
+					Bc4Candidate candidate;
+					EvaluateBc4(kernel, block, channel, value0, value1, candidate);
+					if(candidate.error < best.error){
+						best = candidate;
+					}
+				}
+			}
+		}
+
+		if(quality == CompressionQuality::High){
+			// Six value mode spends its range on the values between the
+			// exact 0 and 255 pixels.
+			if(innerLow <= innerHigh){
+				Bc4Candidate candidate;
+				EvaluateBc4(kernel, block, channel, innerLow, innerHigh, candidate);
+				if(candidate.error < best.error){
+					best = candidate;
+				}
+			}
+			for(int shrink = 1; shrink <= 4 && high - low > 2 * shrink; shrink++){
+				for(int side = 0; side < 3; side++){
+					int value0 = high - (side != 1 ? shrink : 0);
+					int value1 = low + (side != 0 ? shrink : 0);
+					Bc4Candidate candidate;
+					EvaluateBc4(kernel, block, channel, value0, value1, candidate);
+					if(candidate.error < best.error){
+						best = candidate;
+					}
+				}
+			}
+		}
+
+		memset(out, 0, 8);
+		out[0] = static_cast<uint8_t>(best.value0);
+		out[1] = static_cast<uint8_t>(best.value1);
+		uint32_t position = 16;
+		for(int i = 0; i < 16; i++){
+			WriteBits(out, position, best.indices[i], 3);
+		}
+	}
+
+	void DecodeBc4(const uint8_t* in, int channel, uint8_t rgba[64]){
+		int palette[8];
+		Bc4Palette(in[0], in[1], palette);
+		uint32_t position = 16;
+		for(int i = 0; i < 16; i++){
+			rgba[i * 4 + channel] = static_cast<uint8_t>(palette[ReadBits(in, position, 3)]);
+		}
+	}
+
+	// BC7 mode 6: one subset, 7 bit RGBA endpoints with a p-bit each and
+	// 4 bit indices. -------------------------------------------------------
+
+	const int kBc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	struct Bc7Candidate {
+		int endpoint[2][4];
+		int pbit[2];
+		uint8_t indices[16];
+		float error;
+	};
+
+	void EvaluateBc7(FitKernel kernel, const Block& block, const float* e0, const float* e1, int pbit0, int pbit1, Bc7Candidate& candidate){
+		const float* source[2] = { e0, e1 };
+		const int pbits[2] = { pbit0, pbit1 };
+		for(int e = 0; e < 2; e++){
+			candidate.pbit[e] = pbits[e];
+			for(int c = 0; c < 4; c++){
+				candidate.endpoint[e][c] = Clamp(RoundToInt((source[e][c] - pbits[e]) / 2.0f), 0, 127);
+			}
+		}
+
+		Palette palette;
+		palette.size = 16;
+		for(int c = 0; c < 4; c++){
+			int value0 = (candidate.endpoint[0][c] << 1) | pbit0;
+			int value1 = (candidate.endpoint[1][c] << 1) | pbit1;
+			for(int i = 0; i < 16; i++){
+				palette.channel[c][i] = static_cast<float>(((64 - kBc7Weights[i]) * value0 + kBc7Weights[i] * value1 + 32) >> 6);
+			}
+		}
+		candidate.error = Fit(kernel, block, palette, 0, 4, candidate.indices);
+	}
+
+	void EvaluateBc7AllPbits(FitKernel kernel, const Block& block, const float* e0, const float* e1, Bc7Candidate& best){
+		best.error = std::numeric_limits<float>::max();
+		for(int combination = 0; combination < 4; combination++){
+			Bc7Candidate candidate;
+			EvaluateBc7(kernel, block, e0, e1, combination & 1, combination >> 1, candidate);
+			if(candidate.error < best.error){
+				best = candidate;
+			}
+		}
+	}
+
+	void EncodeBc7(FitKernel kernel, CompressionQuality quality, const Block& block, uint8_t* out){
+		float weights[16];
+		for(int i = 0; i < 16; i++){
+			weights[i] = kBc7Weights[i] / 64.0f;
+		}
+
+		float e0[4], e1[4];
+		FitEndpoints(block, 0, 4, quality, e0, e1);
+
+		Bc7Candidate best;
+		EvaluateBc7AllPbits(kernel, block, e0, e1, best);
+
+		int refinements = quality == CompressionQuality::Fast ? 0 : (quality == CompressionQuality::Normal ? 1 : 3);
+		for(int i = 0; i < refinements; i++){
+			if(!RefineEndpoints(block, 0, 4, best.indices, weights, e0, e1)){
+				break;
+			}
+			Bc7Candidate candidate;
+			EvaluateBc7AllPbits(kernel, block, e0, e1, candidate);
+			if(candidate.error >= best.error){
+				break;
+			}
+			best = candidate;
+		}
+
+		if(quality == CompressionQuality::High){
+			for(int endpoint = 0; endpoint < 2; endpoint++){
+				for(int c = 0; c < 4; c++){
+					for(int step = -1; step <= 1; step += 2){
+						float values[2][4];
+						for(int e = 0; e < 2; e++){
+							for(int k = 0; k < 4; k++){
+								values[e][k] = static_cast<float>((best.endpoint[e][k] << 1) | best.pbit[e]);
+							}
+						}
+						values[endpoint][c] += 2.0f * step;
+						if(values[endpoint][c] < 0.0f || values[endpoint][c] > 255.0f){
+							continue;
+						}
+						Bc7Candidate candidate;
+						EvaluateBc7(kernel, block, values[0], values[1], best.pbit[0], best.pbit[1], candidate);
+						if(candidate.error < best.error){
+							best = candidate;
+						}
+					}
+				}
+			}
+		}
+
+		// The anchor index is stored with its top bit implied zero.
+		if(best.indices[0] >= 8){
+			for(int c = 0; c < 4; c++){
+				std::swap(best.endpoint[0][c], best.endpoint[1][c]);
+			}
+			std::swap(best.pbit[0], best.pbit[1]);
+			for(int i = 0; i < 16; i++){
+				best.indices[i] = static_cast<uint8_t>(15 - best.indices[i]);
+			}
+		}
+
+		memset(out, 0, 16);
+		uint32_t position = 0;
+		WriteBits(out, position, 1u << 6, 7);
+		for(int c = 0; c < 4; c++){
+			WriteBits(out, position, best.endpoint[0][c], 7);
+			WriteBits(out, position, best.endpoint[1][c], 7);
+		}
+		WriteBits(out, position, best.pbit[0], 1);
+		WriteBits(out, position, best.pbit[1], 1);
+		for(int i = 0; i < 16; i++){
+			WriteBits(out, position, best.indices[i], i == 0 ? 3 : 4);
+		}
+	}
+
+	void DecodeBc7(const uint8_t* in, uint8_t rgba[64]){
+		if((in[0] & 0x7F) != 0x40){
+			memset(rgba, 0, 64);
+			return;
+		}
+
+		uint32_t position = 7;
+		int endpoint[2][4];
+		for(int c = 0; c < 4; c++){
+			endpoint[0][c] = static_cast<int>(ReadBits(in, position, 7));
+			endpoint[1][c] = static_cast<int>(ReadBits(in, position, 7));
+		}
+		int pbit0 = static_cast<int>(ReadBits(in, position, 1));
+		int pbit1 = static_cast<int>(ReadBits(in, position, 1));
+
+		for(int i = 0; i < 16; i++){
+			int weight = kBc7Weights[ReadBits(in, position, i == 0 ? 3 : 4)];
+			for(int c = 0; c < 4; c++){
+				int value0 = (endpoint[0][c] << 1) | pbit0;
+				int value1 = (endpoint[1][c] << 1) | pbit1;
+				rgba[i * 4 + c] = static_cast<uint8_t>(((64 - weight) * value0 + weight * value1 + 32) >> 6);
+			}
+		}
+	}
+
+	// Mips and blocks ----------------------------------------------------
+
+	// 2x2 box filter, clamping at odd edges.
+	std::vector<uint8_t> Downsample(const std::vector<uint8_t>& source, uint32_t width, uint32_t height){
+		uint32_t outWidth = std::max(width / 2, 1u);
+		uint32_t outHeight = std::max(height / 2, 1u);
+		std::vector<uint8_t> result(size_t(outWidth) * outHeight * 4);
+		for(uint32_t y = 0; y < outHeight; y++){
+			uint32_t y0 = std::min(y * 2, height - 1);
+			uint32_t y1 = std::min(y * 2 + 1, height - 1);
+			for(uint32_t x = 0; x < outWidth; x++){
+				uint32_t x0 = std::min(x * 2, width - 1);
+				uint32_t x1 = std::min(x * 2 + 1, width - 1);
+				for(int c = 0; c < 4; c++){
+					int sum = source[(size_t(y0) * width + x0) * 4 + c] + source[(size_t(y0) * width + x1) * 4 + c]
+						+ source[(size_t(y1) * width + x0) * 4 + c] + source[(size_t(y1) * width + x1) * 4 + c];
+					result[(size_t(y) * outWidth + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+				}
+			}
+		}
+		return result;
+	}
+
+	// Copies the 4x4 block at (blockX, blockY), repeating edge pixels for
+	// images that are not a multiple of 4.
+	void GatherBlock(const uint8_t* image, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, uint8_t rgba[64]){
+		for(uint32_t y = 0; y < 4; y++){
+			uint32_t sourceY = std::min(blockY * 4 + y, height - 1);
+			for(uint32_t x = 0; x < 4; x++){
+				uint32_t sourceX = std::min(blockX * 4 + x, width - 1);
+				memcpy(rgba + (y * 4 + x) * 4, image + (size_t(sourceY) * width + sourceX) * 4, 4);
+			}
+		}
+	}
+
+	void CompressBlockWith(FitKernel kernel, BcFormat format, CompressionQuality quality, const uint8_t rgba[64], uint8_t* out){
+		Block block;
+		LoadBlock(rgba, block);
+		switch(format){
+			case BcFormat::BC1:
+				EncodeBc1(kernel, quality, block, out);
+				break;
+			case BcFormat::BC3:
+				EncodeBc4(kernel, quality, block, 3, out);
+				EncodeBc1(kernel, quality, block, out + 8);
+				break;
+			case BcFormat::BC4:
+				EncodeBc4(kernel, quality, block, 0, out);
+				break;
+			case BcFormat::BC5:
+				EncodeBc4(kernel, quality, block, 0, out);
+				EncodeBc4(kernel, quality, block, 1, out + 8);
+				break;
+			case BcFormat::BC7:
+				EncodeBc7(kernel, quality, block, out);
+				break;
+		}
+	}
+}
+
+uint32_t GetBlockBytes(BcFormat format){
+	return (format == BcFormat::BC1 || format == BcFormat::BC4) ? 8 : 16;
+}
+
+uint32_t GetDxgiFormat(BcFormat format){
+	// Values of DXGI_FORMAT_BC*_UNORM, kept numeric so the cooker builds
+	// without the Windows headers.
+	switch(format){
+		case BcFormat::BC1: return 71;
+		case BcFormat::BC3: return 77;
+		case BcFormat::BC4: return 80;
+		case BcFormat::BC5: return 83;
+		case BcFormat::BC7: return 98;
+	}
+	return 0;
+}
+
+uint32_t GetChannelMask(BcFormat format){
+	switch(format){
+		case BcFormat::BC1: return 0x7;
+		case BcFormat::BC4: return 0x1;
+		case BcFormat::BC5: return 0x3;
+		default: return 0xF;
+	}
+}
+
+CompressionPath GetBestCompressionPath(){
+	#if defined(CPU_X86)
+	if(CpuFeatures::Get().sse41){
+		return CompressionPath::SSE;
+	}
+	#endif
+	return CompressionPath::Scalar;
+}
+
+void CompressBlock(BcFormat format, CompressionQuality quality, const uint8_t rgba[64], uint8_t* block, CompressionPath path){
+	CompressBlockWith(SelectKernel(path), format, quality, rgba, block);
+}
+
+void DecompressBlock(BcFormat format, const uint8_t* block, uint8_t rgba[64]){
+	switch(format){
+		case BcFormat::BC1:
+			DecodeBc1(block, false, rgba);
+			break;
+		case BcFormat::BC3:
+			DecodeBc1(block + 8, true, rgba);
+			DecodeBc4(block, 3, rgba);
+			break;
+		case BcFormat::BC4:
+			memset(rgba, 0, 64);
+			DecodeBc4(block, 0, rgba);
+			for(int i = 0; i < 16; i++){
+				rgba[i * 4 + 3] = 255;
+			}
+			break;
+		case BcFormat::BC5:
+			memset(rgba, 0, 64);
+			DecodeBc4(block, 0, rgba);
+			DecodeBc4(block + 8, 1, rgba);
+			for(int i = 0; i < 16; i++){
+				rgba[i * 4 + 3] = 255;
+			}
+			break;
+		case BcFormat::BC7:
+			DecodeBc7(block, rgba);
+			break;
+	}
+}
+
+double ComputePsnr(const uint8_t* a, const uint8_t* b, size_t pixelCount, uint32_t channelMask){
+	double squaredError = 0.0;
+	size_t samples = 0;
+	for(size_t i = 0; i < pixelCount; i++){
+		for(int c = 0; c < 4; c++){
+			if(channelMask & (1u << c)){
+				double difference = double(a[i * 4 + c]) - double(b[i * 4 + c]);
+				squaredError += difference * difference;
+				samples++;
+			}
+		}
+	}
+	if(samples == 0 || squaredError == 0.0){
+		return std::numeric_limits<double>::infinity();
+	}
+	return 10.0 * log10(255.0 * 255.0 / (squaredError / samples));
+}
+
+bool CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch, BcFormat format,
+	CompressionQuality quality, bool generateMips, CompressedTexture& out, TextureCookReport* report, CompressionPath path){
+	if(!rgba || width == 0 || height == 0 || rowPitch < width * 4){
+		return false;
+	}
+
+	auto startTime = std::chrono::steady_clock::now();
+
+	// Mip images, tightly packed.
+	std::vector<std::vector<uint8_t>> images(1);
+	images[0].resize(size_t(width) * height * 4);
+	for(uint32_t y = 0; y < height; y++){
+		memcpy(images[0].data() + size_t(y) * width * 4, rgba + size_t(y) * rowPitch, size_t(width) * 4);
+	}
+
+	out.format = format;
+	out.width = width;
+	out.height = height;
+	out.mips.clear();
+
+	uint32_t mipWidth = width, mipHeight = height;
+	while(true){
+		CompressedMip mip;
+		mip.width = mipWidth;
+		mip.height = mipHeight;
+		mip.blocksWide = (mipWidth + 3) / 4;
+		mip.blocksHigh = (mipHeight + 3) / 4;
+		mip.data.resize(size_t(mip.blocksWide) * mip.blocksHigh * GetBlockBytes(format));
+		out.mips.push_back(std::move(mip));
+
+		if(!generateMips || (mipWidth == 1 && mipHeight == 1)){
+			break;
+		}
+		images.push_back(Downsample(images.back(), mipWidth, mipHeight));
+		mipWidth = std::max(mipWidth / 2, 1u);
+		mipHeight = std::max(mipHeight / 2, 1u);
+	}
+
+	// One job per block row, over every mip at once, so the small mips do
+	// not serialize behind the big one.
+	struct RowJob {
+		uint32_t mip;
+		uint32_t row;
+	};
+	std::vector<RowJob> rows;
+	for(uint32_t mip = 0; mip < out.mips.size(); mip++){
+		for(uint32_t row = 0; row < out.mips[mip].blocksHigh; row++){
+			rows.push_back({ mip, row });
+		}
+	}
+
+	const FitKernel kernel = SelectKernel(path);
+	const uint32_t blockBytes = GetBlockBytes(format);
+	JobSystem::GetInstance()->ParallelFor(static_cast<uint32_t>(rows.size()), 1, [&](uint32_t begin, uint32_t end){
+		uint8_t pixels[64];
+		for(uint32_t r = begin; r < end; r++){
+			CompressedMip& mip = out.mips[rows[r].mip];
+			const uint8_t* image = images[rows[r].mip].data();
+			for(uint32_t blockX = 0; blockX < mip.blocksWide; blockX++){
+				GatherBlock(image, mip.width, mip.height, blockX, rows[r].row, pixels);
+				uint8_t* block = mip.data.data() + (size_t(rows[r].row) * mip.blocksWide + blockX) * blockBytes;
+				CompressBlockWith(kernel, format, quality, pixels, block);
+			}
+		}
+	});
+
+	if(report){
+		auto endTime = std::chrono::steady_clock::now();
+		report->seconds = std::chrono::duration<double>(endTime - startTime).count();
+		double pixels = 0.0;
+		report->uncompressedBytes = 0;
+		report->compressedBytes = 0;
+		for(size_t mip = 0; mip < out.mips.size(); mip++){
+			pixels += double(out.mips[mip].width) * out.mips[mip].height;
+			report->uncompressedBytes += images[mip].size();
+			report->compressedBytes += out.mips[mip].data.size();
+		}
+		report->megapixelsPerSecond = report->seconds > 0.0 ? pixels / 1e6 / report->seconds : 0.0;
+
+		// Quality of the top mip, decoded back to RGBA8.
+		const CompressedMip& top = out.mips[0];
+		std::vector<uint8_t> decoded(images[0].size());
+		uint8_t pixelsOut[64];
+		for(uint32_t blockY = 0; blockY < top.blocksHigh; blockY++){
+			for(uint32_t blockX = 0; blockX < top.blocksWide; blockX++){
+				DecompressBlock(format, top.data.data() + (size_t(blockY) * top.blocksWide + blockX) * blockBytes, pixelsOut);
+				for(uint32_t y = 0; y < 4 && blockY * 4 + y < height; y++){
+					for(uint32_t x = 0; x < 4 && blockX * 4 + x < width; x++){
+						memcpy(decoded.data() + ((size_t(blockY) * 4 + y) * width + blockX * 4 + x) * 4, pixelsOut + (y * 4 + x) * 4, 4);
+					}
+				}
+			}
+		}
+		report->psnr = ComputePsnr(images[0].data(), decoded.data(), size_t(width) * height, GetChannelMask(format));
+	}
+
+	return true;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Offline block compression of RGBA8 images into the BC formats D3D12 can
+// sample directly. Blocks are independent, so the work is spread over the
+// JobSystem by block row across every mip.
+
+enum class BcFormat { BC1, BC3, BC4, BC5, BC7 };
+
+// Fast fits endpoints to the bounding box, Normal to the principal axis
+// with one least squares pass, High refines further and searches around
+// the quantized endpoints.
+enum class CompressionQuality { Fast, Normal, High };
+
+// Which kernel fits the block indices. Auto picks the widest one the CPU has.
+enum class CompressionPath { Auto, Scalar, SSE };
+
+struct CompressedMip {
+	uint32_t width;
+	uint32_t height;
+	// Tightly packed rows of blocks.
+	uint32_t blocksWide;
+	uint32_t blocksHigh;
+	std::vector<uint8_t> data;
+};
+
+struct CompressedTexture {
+	BcFormat format;
+	uint32_t width;
+	uint32_t height;
+	std::vector<CompressedMip> mips;
+};
+
+struct TextureCookReport {
+	double seconds;
+	double megapixelsPerSecond;
+	// Over the top mip and the channels the format stores.
+	double psnr;
+	size_t uncompressedBytes;
+	size_t compressedBytes;
+};
+
+// rgba is width by height RGBA8 pixels, rowPitch bytes apart. With
+// generateMips the full chain is built with a box filter before encoding.
+bool CompressTexture(const uint8_t* rgba, uint32_t width, uint32_t height, uint32_t rowPitch, BcFormat format,
+	CompressionQuality quality, bool generateMips, CompressedTexture& out, TextureCookReport* report = nullptr,
+	CompressionPath path = CompressionPath::Auto);
+
+// One 4x4 block: 64 bytes of RGBA8 in, GetBlockBytes(format) bytes out.
+void CompressBlock(BcFormat format, CompressionQuality quality, const uint8_t rgba[64], uint8_t* block, CompressionPath path = CompressionPath::Auto);
+// Decodes everything CompressBlock writes. For BC7 that is mode 6 only,
+// other modes decode to zero.
+void DecompressBlock(BcFormat format, const uint8_t* block, uint8_t rgba[64]);
+
+// Peak signal to noise ratio in dB over the channels in channelMask
+// (bit 0 red ... bit 3 alpha). Identical images give infinity.
+double ComputePsnr(const uint8_t* a, const uint8_t* b, size_t pixelCount, uint32_t channelMask);
+
+uint32_t GetBlockBytes(BcFormat format);
+// DXGI_FORMAT value of the UNORM variant.
+uint32_t GetDxgiFormat(BcFormat format);
+uint32_t GetChannelMask(BcFormat format);
+
+// The kernel Auto resolves to on this machine.
+CompressionPath GetBestCompressionPath();
@@ -0,0 +1,130 @@
+#include "TextureFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+	uint64_t AlignUp(uint64_t value, uint64_t alignment){
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+}
+
+bool WriteTextureFile(const char* path, const CompressedTexture& texture){
+	if(texture.mips.empty()){
+		return false;
+	}
+
+	const uint32_t blockBytes = GetBlockBytes(texture.format);
+	const uint32_t mipCount = static_cast<uint32_t>(texture.mips.size());
+
+	TextureFileHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = kTextureFileMagic;
+	header.version = kTextureFileVersion;
+	header.headerSize = sizeof(TextureFileHeader);
+	header.dxgiFormat = GetDxgiFormat(texture.format);
+	header.width = texture.width;
+	header.height = texture.height;
+	header.mipCount = mipCount;
+	header.blockBytes = blockBytes;
+	header.dataOffset = AlignUp(sizeof(TextureFileHeader) + sizeof(TextureFileMip) * mipCount, kTextureFilePlacementAlignment);
+
+	std::vector<TextureFileMip> mips(mipCount);
+	uint64_t offset = header.dataOffset;
+	for(uint32_t i = 0; i < mipCount; i++){
+		const CompressedMip& source = texture.mips[i];
+		TextureFileMip& mip = mips[i];
+		offset = AlignUp(offset, kTextureFilePlacementAlignment);
+		mip.offset = offset;
+		mip.width = source.width;
+		mip.height = source.height;
+		mip.rowPitch = static_cast<uint32_t>(AlignUp(uint64_t(source.blocksWide) * blockBytes, kTextureFileRowPitchAlignment));
+		mip.rowCount = source.blocksHigh;
+		// The last row is not padded, matching GetCopyableFootprints.
+		mip.size = uint64_t(mip.rowPitch) * (mip.rowCount - 1) + uint64_t(source.blocksWide) * blockBytes;
+		offset += mip.size;
+	}
+	header.fileSize = offset;
+
+	FILE* file = fopen(path, "wb");
+	if(!file){
+		return false;
+	}
+
+	bool written = fwrite(&header, sizeof(header), 1, file) == 1
+		&& fwrite(mips.data(), sizeof(TextureFileMip), mipCount, file) == mipCount;
+
+	std::vector<uint8_t> row;
+	uint64_t position = sizeof(header) + sizeof(TextureFileMip) * mipCount;
+	for(uint32_t i = 0; i < mipCount && written; i++){
+		const CompressedMip& source = texture.mips[i];
+		const size_t sourcePitch = size_t(source.blocksWide) * blockBytes;
+
+		row.assign(static_cast<size_t>(mips[i].offset - position), 0);
+		written = row.empty() || fwrite(row.data(), 1, row.size(), file) == row.size();
+		position = mips[i].offset;
+
+		for(uint32_t y = 0; y < source.blocksHigh && written; y++){
+			size_t bytes = (y + 1 < source.blocksHigh) ? mips[i].rowPitch : sourcePitch;
+			row.assign(bytes, 0);
+			memcpy(row.data(), source.data.data() + y * sourcePitch, sourcePitch);
+			written = fwrite(row.data(), 1, bytes, file) == bytes;
+			position += bytes;
+		}
+	}
+
+	if(fclose(file) != 0){
+		written = false;
+	}
+	if(!written){
+		remove(path);
+	}
+	return written;
+}
+
+bool TextureFile::Open(const char* path){
+	Close();
+	if(!mFile.Open(path)){
+		return false;
+	}
+
+	const size_t size = mFile.Size();
+	const TextureFileHeader* header = reinterpret_cast<const TextureFileHeader*>(mFile.Data());
+	bool valid = size >= sizeof(TextureFileHeader)
+		&& header->magic == kTextureFileMagic
+		&& header->version == kTextureFileVersion
+		&& header->headerSize == sizeof(TextureFileHeader)
+		&& header->fileSize == size
+		&& header->mipCount > 0 && header->mipCount <= 32
+		&& (header->blockBytes == 8 || header->blockBytes == 16)
+		&& sizeof(TextureFileHeader) + uint64_t(header->mipCount) * sizeof(TextureFileMip) <= header->dataOffset
+		&& header->dataOffset <= size;
+
+	const TextureFileMip* mips = valid ? reinterpret_cast<const TextureFileMip*>(mFile.Data() + sizeof(TextureFileHeader)) : nullptr;
+	for(uint32_t i = 0; valid && i < header->mipCount; i++){
+		const TextureFileMip& mip = mips[i];
+		uint64_t blocksWide = (uint64_t(mip.width) + 3) / 4;
+		valid = mip.offset % kTextureFilePlacementAlignment == 0
+			&& mip.rowPitch % kTextureFileRowPitchAlignment == 0
+			&& mip.rowCount == (mip.height + 3) / 4 && mip.rowCount > 0
+			&& blocksWide * header->blockBytes <= mip.rowPitch
+			&& mip.size == uint64_t(mip.rowPitch) * (mip.rowCount - 1) + blocksWide * header->blockBytes
+			&& mip.offset >= header->dataOffset && mip.offset <= size && mip.size <= size - mip.offset;
+	}
+
+	if(!valid){
+		Close();
+		return false;
+	}
+
+	mHeader = header;
+	mMips = mips;
+	return true;
+}
+
+void TextureFile::Close(){
+	mHeader = nullptr;
+	mMips = nullptr;
+	mFile.Close();
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "MappedFile.h"
+#include "TextureCompressor.h"
+
+// Mip chained container for cooked textures. Each mip is stored with the
+// row pitch and placement D3D12 uses for buffer to texture copies (256 and
+// 512 byte alignment), so the whole payload can be copied into an upload
+// buffer as is and each mip addressed with a placed footprint.
+//
+// All values are little endian.
+
+static constexpr uint32_t kTextureFileMagic = 0x58455442; // "BTEX"
+static constexpr uint16_t kTextureFileVersion = 1;
+static constexpr uint32_t kTextureFileRowPitchAlignment = 256;
+static constexpr uint32_t kTextureFilePlacementAlignment = 512;
+
+struct TextureFileHeader {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t headerSize;
+	uint64_t fileSize;
+	uint32_t dxgiFormat;
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	uint32_t blockBytes;
+	uint32_t padding;
+	// Start of mip 0. Mip offsets are relative to the file, not to this.
+	uint64_t dataOffset;
+};
+
+static_assert(sizeof(TextureFileHeader) == 48, "TextureFileHeader layout is part of the file format");
+
+// Follows the header, one per mip.
+struct TextureFileMip {
+	uint64_t offset;
+	uint64_t size;
+	uint32_t width;
+	uint32_t height;
+	// Bytes between block rows, and how many block rows there are.
+	uint32_t rowPitch;
+	uint32_t rowCount;
+};
+
+bool WriteTextureFile(const char* path, const CompressedTexture& texture);
+
+class TextureFile {
+public:
+	// Maps the file and validates the header and mip table.
+	bool Open(const char* path);
+	void Close();
+
+	const TextureFileHeader& GetHeader() const { return *mHeader; }
+	const TextureFileMip& GetMip(uint32_t mip) const { return mMips[mip]; }
+	uint32_t GetMipCount() const { return mHeader->mipCount; }
+	// Pointer into the mapping, valid until Close.
+	const uint8_t* GetMipData(uint32_t mip) const { return mFile.Data() + mMips[mip].offset; }
+
+	// Every mip from GetHeader().dataOffset on. A mip sits at
+	// GetMip(i).offset - dataOffset inside it.
+	const uint8_t* GetPayload() const { return mFile.Data() + mHeader->dataOffset; }
+	size_t GetPayloadSize() const { return static_cast<size_t>(mHeader->fileSize - mHeader->dataOffset); }
+
+	bool IsOpen() const { return mHeader != nullptr; }
+
+private:
+	MappedFile mFile;
+	const TextureFileHeader* mHeader = nullptr;
+	const TextureFileMip* mMips = nullptr;
+};
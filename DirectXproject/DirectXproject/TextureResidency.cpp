@@ -0,0 +1,194 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TextureResidency::Init(size_t budgetBytes, uint32_t dropDelayFrames){
+	mTextures.clear();
+	mFreeIds.clear();
+	mPendingDrops.clear();
+	mBudgetBytes = budgetBytes;
+	mCommittedBytes = 0;
+	mDropDelayFrames = dropDelayFrames;
+	mFrame = 0;
+}
+
+size_t TextureResidency::GetMipBytes(const StreamedTextureDesc& desc, uint32_t mip){
+	if(mip >= desc.mipCount){
+		return 0;
+	}
+	uint32_t width = std::max(desc.width >> mip, 1u);
+	uint32_t height = std::max(desc.height >> mip, 1u);
+	size_t blocksWide = (width + desc.blockDim - 1) / desc.blockDim;
+	size_t blocksHigh = (height + desc.blockDim - 1) / desc.blockDim;
+	return blocksWide * blocksHigh * desc.bytesPerBlock;
+}
+
+size_t TextureResidency::GetChainBytes(const StreamedTextureDesc& desc, uint32_t mip){
+	size_t bytes = 0;
+	for(uint32_t i = mip; i < desc.mipCount; i++){
+		bytes += GetMipBytes(desc, i);
+	}
+	return bytes;
+}
+
+float TextureResidency::ComputeMipFromFootprint(uint32_t width, uint32_t height, float screenWidth, float screenHeight){
+	if(screenWidth <= 0.0f || screenHeight <= 0.0f){
+		return static_cast<float>(UINT32_MAX);
+	}
+	float ratio = std::max(width / screenWidth, height / screenHeight);
+	return ratio > 1.0f ? log2f(ratio) : 0.0f;
+}
+
+StreamedTextureId TextureResidency::Register(const StreamedTextureDesc& desc){
+	StreamedTextureId id;
+	if(!mFreeIds.empty()){
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}else{
+		id = static_cast<StreamedTextureId>(mTextures.size());
+		mTextures.emplace_back();
+	}
+
+	TextureState& texture = mTextures[id];
+	texture = TextureState();
+	texture.desc = desc;
+	texture.desc.mipCount = std::max(desc.mipCount, 1u);
+	texture.desc.pinnedMip = std::min(desc.pinnedMip, texture.desc.mipCount - 1);
+	texture.active = true;
+	texture.reportedMip = static_cast<float>(texture.desc.mipCount);
+	texture.lastSeenFrame = mFrame;
+	texture.coarserSinceFrame = mFrame;
+	// The packed tail is resident from creation on.
+	texture.targetMip = texture.desc.pinnedMip;
+	texture.residentMip = texture.desc.pinnedMip;
+	mCommittedBytes += GetChainBytes(texture.desc, texture.residentMip);
+	return id;
+}
+
+void TextureResidency::Unregister(StreamedTextureId id){
+	if(id >= mTextures.size() || !mTextures[id].active){
+		return;
+	}
+
+	TextureState& texture = mTextures[id];
+	uint32_t committedMip = std::min(texture.residentMip, texture.loadingMip);
+	mCommittedBytes -= GetChainBytes(texture.desc, committedMip);
+	texture.active = false;
+	mFreeIds.push_back(id);
+}
+
+void TextureResidency::ReportSampledMip(StreamedTextureId id, float mip){
+	if(id >= mTextures.size() || !mTextures[id].active){
+		return;
+	}
+
+	TextureState& texture = mTextures[id];
+	texture.reportedMip = std::min(texture.reportedMip, std::max(mip, 0.0f));
+	texture.lastSeenFrame = mFrame;
+}
+
+void TextureResidency::Update(std::vector<MipTransition>& transitions){
+	// Target from feedback. Finer targets apply at once, coarser ones only
+	// after the feedback has agreed for mDropDelayFrames.
+	size_t wantedBytes = 0;
+	for(TextureState& texture : mTextures){
+		if(!texture.active){
+			continue;
+		}
+
+		uint32_t wanted = texture.desc.pinnedMip;
+		if(texture.reportedMip < static_cast<float>(texture.desc.pinnedMip)){
+			wanted = static_cast<uint32_t>(floorf(texture.reportedMip));
+		}
+
+		if(wanted <= texture.targetMip){
+			texture.targetMip = wanted;
+			texture.coarserSinceFrame = mFrame;
+		}else if(mFrame - texture.coarserSinceFrame >= mDropDelayFrames){
+			texture.targetMip = wanted;
+		}
+
+		texture.reportedMip = static_cast<float>(texture.desc.mipCount);
+		wantedBytes += GetChainBytes(texture.desc, texture.targetMip);
+	}
+
+	// Over budget: coarsen the texture whose finest wanted mip is the most
+	// expensive, preferring ones that were not seen recently, until it fits.
+	while(wantedBytes > mBudgetBytes){
+		TextureState* victim = nullptr;
+		for(TextureState& texture : mTextures){
+			if(!texture.active || texture.targetMip >= texture.desc.pinnedMip){
+				continue;
+			}
+			if(!victim || texture.lastSeenFrame < victim->lastSeenFrame
+				|| (texture.lastSeenFrame == victim->lastSeenFrame && GetMipBytes(texture.desc, texture.targetMip) > GetMipBytes(victim->desc, victim->targetMip))){
+				victim = &texture;
+			}
+		}
+		if(!victim){
+			break;
+		}
+		wantedBytes -= GetMipBytes(victim->desc, victim->targetMip);
+		victim->targetMip++;
+	}
+
+	// Drops first so the memory is free before the loads are issued.
+	transitions.insert(transitions.end(), mPendingDrops.begin(), mPendingDrops.end());
+	mPendingDrops.clear();
+	for(StreamedTextureId id = 0; id < mTextures.size(); id++){
+		TextureState& texture = mTextures[id];
+		if(!texture.active){
+			continue;
+		}
+
+		// An in flight load that is no longer wanted is dropped when it lands.
+		while(texture.residentMip < texture.targetMip){
+			transitions.push_back({ id, texture.residentMip, false });
+			mCommittedBytes -= GetMipBytes(texture.desc, texture.residentMip);
+			texture.residentMip++;
+		}
+	}
+
+	for(StreamedTextureId id = 0; id < mTextures.size(); id++){
+		TextureState& texture = mTextures[id];
+		if(!texture.active || texture.loadingMip != UINT32_MAX || texture.residentMip <= texture.targetMip){
+			continue;
+		}
+
+		uint32_t mip = texture.residentMip - 1;
+		size_t bytes = GetMipBytes(texture.desc, mip);
+		if(mCommittedBytes + bytes > mBudgetBytes){
+			continue;
+		}
+		transitions.push_back({ id, mip, true });
+		texture.loadingMip = mip;
+		mCommittedBytes += bytes;
+	}
+
+	mFrame++;
+}
+
+void TextureResidency::OnMipLoaded(StreamedTextureId id, uint32_t mip){
+	if(id >= mTextures.size() || !mTextures[id].active || mTextures[id].loadingMip != mip){
+		return;
+	}
+
+	TextureState& texture = mTextures[id];
+	texture.loadingMip = UINT32_MAX;
+	if(mip + 1 == texture.residentMip && mip >= texture.targetMip){
+		texture.residentMip = mip;
+	}else{
+		// The target moved past it while it was in flight, drop it next Update.
+		mPendingDrops.push_back({ id, mip, false });
+		mCommittedBytes -= GetMipBytes(texture.desc, mip);
+	}
+}
+
+uint32_t TextureResidency::GetResidentMip(StreamedTextureId id) const {
+	return id < mTextures.size() ? mTextures[id].residentMip : 0;
+}
+
+uint32_t TextureResidency::GetTargetMip(StreamedTextureId id) const {
+	return id < mTextures.size() ? mTextures[id].targetMip : 0;
+}
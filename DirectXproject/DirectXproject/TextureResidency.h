@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// CPU side of texture streaming: decides which mips of each texture should
+// be resident from sampling feedback and a memory budget. It owns no GPU
+// objects, the renderer applies the transitions it emits to ReservedTexture.
+
+using StreamedTextureId = uint32_t;
+static constexpr StreamedTextureId kInvalidStreamedTexture = UINT32_MAX;
+
+struct StreamedTextureDesc {
+	uint32_t width;
+	uint32_t height;
+	uint32_t mipCount;
+	// 1 and the texel size for plain formats, 4 and 8 or 16 for BC formats.
+	uint32_t blockDim;
+	uint32_t bytesPerBlock;
+	// First mip of the packed tail. It and everything coarser stays resident.
+	uint32_t pinnedMip;
+};
+
+struct MipTransition {
+	StreamedTextureId texture;
+	uint32_t mip;
+	// Load and upload the mip, or drop it.
+	bool load;
+};
+
+class TextureResidency {
+public:
+	// dropDelayFrames is how long a mip must go unused before it is dropped
+	// when there is no memory pressure.
+	void Init(size_t budgetBytes, uint32_t dropDelayFrames = 30);
+
+	StreamedTextureId Register(const StreamedTextureDesc& desc);
+	void Unregister(StreamedTextureId id);
+
+	// The finest mip a material sampled this frame. Lower wins when reported
+	// more than once.
+	void ReportSampledMip(StreamedTextureId id, float mip);
+
+	// Ends the frame: picks the target mip of every texture, trims to the
+	// budget and appends the work to transitions. Drops come before loads.
+	// Loads go one mip at a time, coarse to fine.
+	void Update(std::vector<MipTransition>& transitions);
+	// The upload of a load transition finished, the mip can be sampled.
+	void OnMipLoaded(StreamedTextureId id, uint32_t mip);
+
+	// Finest mip safe to sample, for the SRV min LOD clamp.
+	uint32_t GetResidentMip(StreamedTextureId id) const;
+	uint32_t GetTargetMip(StreamedTextureId id) const;
+	// Resident plus in flight bytes.
+	size_t GetCommittedBytes() const { return mCommittedBytes; }
+	size_t GetBudgetBytes() const { return mBudgetBytes; }
+	void SetBudget(size_t budgetBytes) { mBudgetBytes = budgetBytes; }
+
+	static size_t GetMipBytes(const StreamedTextureDesc& desc, uint32_t mip);
+	// Bytes of mip and every coarser mip.
+	static size_t GetChainBytes(const StreamedTextureDesc& desc, uint32_t mip);
+	// Mip that maps about one texel to one pixel for a texture covering
+	// screenWidth by screenHeight pixels.
+	static float ComputeMipFromFootprint(uint32_t width, uint32_t height, float screenWidth, float screenHeight);
+
+private:
+	struct TextureState {
+		StreamedTextureDesc desc;
+		bool active = false;
+		// Finest mip reported this frame, mipCount when not seen.
+		float reportedMip = 0.0f;
+		uint64_t lastSeenFrame = 0;
+		// Since when the feedback has asked for something coarser than the target.
+		uint64_t coarserSinceFrame = 0;
+		uint32_t targetMip = 0;
+		uint32_t residentMip = 0;
+		// Mip being loaded, or UINT32_MAX.
+		uint32_t loadingMip = UINT32_MAX;
+	};
+
+	std::vector<TextureState> mTextures;
+	std::vector<StreamedTextureId> mFreeIds;
+	// Loads that finished after they stopped being wanted.
+	std::vector<MipTransition> mPendingDrops;
+	size_t mBudgetBytes = 0;
+	size_t mCommittedBytes = 0;
+	uint32_t mDropDelayFrames = 30;
+	uint64_t mFrame = 0;
+};
@@ -0,0 +1,154 @@
+#include "TimelineFence.h"
+
+#include "Helpers.h"
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+using Microsoft::WRL::ComPtr;
+
+namespace {
+	typedef std::chrono::high_resolution_clock Clock;
+
+	// Long enough to cover a GPU that is about to finish, short next to a
+	// frame. A kernel wait and wake costs a few microseconds on its own.
+	const uint32_t kDefaultSpinMicroseconds = 50;
+
+	// Auto reset events handed out for one wait at a time. A wait always
+	// consumes its signal, so a returned event is ready for the next one.
+	class FenceEventPool {
+	public:
+		~FenceEventPool(){
+			for(HANDLE event : mEvents){
+				CloseHandle(event);
+			}
+		}
+
+		HANDLE Acquire(){
+			{
+				std::lock_guard<std::mutex> lock(mMutex);
+				if(!mEvents.empty()){
+					HANDLE event = mEvents.back();
+					mEvents.pop_back();
+					return event;
+				}
+			}
+
+			HANDLE event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+			if(event == nullptr){
+				ThrowIfFailed(HRESULT_FROM_WIN32(GetLastError()));
+			}
+			return event;
+		}
+
+		void Return(HANDLE event){
+			std::lock_guard<std::mutex> lock(mMutex);
+			mEvents.push_back(event);
+		}
+
+	private:
+		std::mutex mMutex;
+		std::vector<HANDLE> mEvents;
+	};
+
+	FenceEventPool& GetEventPool(){
+		static FenceEventPool pool;
+		return pool;
+	}
+
+	uint64_t MicrosecondsSince(Clock::time_point start){
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+	}
+}
+
+TimelineFence::TimelineFence() : mNextValue(1), mCompletedValue(0), mSpinMicroseconds(kDefaultSpinMicroseconds) {
+	ResetStats();
+}
+
+TimelineFence::~TimelineFence(){
+
+}
+
+void TimelineFence::Init(ComPtr<ID3D12Device2> device, ComPtr<ID3D12CommandQueue> queue){
+	mQueue = queue;
+	ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+	mNextValue.store(1, std::memory_order_release);
+	mCompletedValue.store(0, std::memory_order_release);
+}
+
+uint64_t TimelineFence::Signal(){
+	uint64_t value = mNextValue.load(std::memory_order_relaxed);
+	ThrowIfFailed(mQueue->Signal(mFence.Get(), value));
+	mNextValue.store(value + 1, std::memory_order_release);
+	return value;
+}
+
+uint64_t TimelineFence::GetCompletedValue(){
+	uint64_t completed = mFence->GetCompletedValue();
+	// Other threads may have raised the cache meanwhile, never lower it.
+	uint64_t cached = mCompletedValue.load(std::memory_order_relaxed);
+	while(completed > cached && !mCompletedValue.compare_exchange_weak(cached, completed, std::memory_order_relaxed)){
+	}
+	return completed > cached ? completed : cached;
+}
+
+bool TimelineFence::IsComplete(uint64_t value){
+	if(value <= mCompletedValue.load(std::memory_order_relaxed)){
+		return true;
+	}
+	return value <= GetCompletedValue();
+}
+
+void TimelineFence::CpuWait(uint64_t value){
+	if(IsComplete(value)){
+		return;
+	}
+
+	Clock::time_point start = Clock::now();
+	bool spinHit = false;
+	if(mSpinMicroseconds > 0){
+		const Clock::time_point spinEnd = start + std::chrono::microseconds(mSpinMicroseconds);
+		do{
+			YieldProcessor();
+			if(IsComplete(value)){
+				spinHit = true;
+				break;
+			}
+		}while(Clock::now() < spinEnd);
+	}
+
+	if(!spinHit){
+		HANDLE event = GetEventPool().Acquire();
+		ThrowIfFailed(mFence->SetEventOnCompletion(value, event));
+		WaitForSingleObject(event, INFINITE);
+		GetEventPool().Return(event);
+		GetCompletedValue();
+	}
+
+	uint64_t waited = MicrosecondsSince(start);
+	mWaits.fetch_add(1, std::memory_order_relaxed);
+	if(spinHit){
+		mSpinHits.fetch_add(1, std::memory_order_relaxed);
+	}
+	mWaitMicroseconds.fetch_add(waited, std::memory_order_relaxed);
+	uint64_t maxWait = mMaxWaitMicroseconds.load(std::memory_order_relaxed);
+	while(waited > maxWait && !mMaxWaitMicroseconds.compare_exchange_weak(maxWait, waited, std::memory_order_relaxed)){
+	}
+}
+
+TimelineFenceStats TimelineFence::GetStats() const {
+	TimelineFenceStats stats;
+	stats.waits = mWaits.load(std::memory_order_relaxed);
+	stats.spinHits = mSpinHits.load(std::memory_order_relaxed);
+	stats.totalWaitMilliseconds = mWaitMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+	stats.maxWaitMilliseconds = mMaxWaitMicroseconds.load(std::memory_order_relaxed) / 1000.0;
+	return stats;
+}
+
+void TimelineFence::ResetStats(){
+	mWaits.store(0, std::memory_order_relaxed);
+	mSpinHits.store(0, std::memory_order_relaxed);
+	mWaitMicroseconds.store(0, std::memory_order_relaxed);
+	mMaxWaitMicroseconds.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <wrl.h>
+
+#include <d3d12.h>
+
+#include <atomic>
+#include <cstdint>
+
+struct TimelineFenceStats {
+	// CpuWait calls that found the value not yet complete.
+	uint64_t waits;
+	// Of those, how many finished while spinning, without an event.
+	uint64_t spinHits;
+	double totalWaitMilliseconds;
+	double maxWaitMilliseconds;
+};
+
+// One ID3D12Fence per queue, counting up once per Signal. A value is
+// complete once the queue has executed everything submitted before it was
+// signaled.
+//
+// CpuWait spins on GetCompletedValue for a short while first. Most frame
+// waits end within a few microseconds of being started or not for
+// milliseconds, so the short ones never pay for SetEventOnCompletion and a
+// kernel wait. Only the long ones take an event, from a pool shared by every
+// fence so any thread can wait on any fence.
+class TimelineFence {
+public:
+	TimelineFence();
+	~TimelineFence();
+
+	void Init(Microsoft::WRL::ComPtr<ID3D12Device2> device, Microsoft::WRL::ComPtr<ID3D12CommandQueue> queue);
+
+	// Signals the next value on the queue and returns it.
+	uint64_t Signal();
+	// What the next Signal will write.
+	inline uint64_t GetNextValue() const { return mNextValue.load(std::memory_order_acquire); }
+	inline uint64_t GetLastSignaledValue() const { return GetNextValue() - 1; }
+
+	bool IsComplete(uint64_t value);
+	uint64_t GetCompletedValue();
+
+	// Blocks the calling thread until value completes.
+	void CpuWait(uint64_t value);
+
+	// How long CpuWait polls before it blocks. Zero always blocks.
+	inline void SetSpinMicroseconds(uint32_t microseconds) { mSpinMicroseconds = microseconds; }
+
+	inline ID3D12Fence* GetFence() const { return mFence.Get(); }
+
+	TimelineFenceStats GetStats() const;
+	void ResetStats();
+
+private:
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue> mQueue;
+	std::atomic<uint64_t> mNextValue;
+	// Highest value seen completed, saves asking the fence again.
+	std::atomic<uint64_t> mCompletedValue;
+	uint32_t mSpinMicroseconds;
+
+	std::atomic<uint64_t> mWaits;
+	std::atomic<uint64_t> mSpinHits;
+	std::atomic<uint64_t> mWaitMicroseconds;
+	std::atomic<uint64_t> mMaxWaitMicroseconds;
+
+	TimelineFence(const TimelineFence&) = delete;
+	TimelineFence& operator=(const TimelineFence&) = delete;
+};
@@ -0,0 +1,157 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+// Offline mesh cooking. Loads an OBJ, runs OptimizeMesh and reports what
+// the vertex cache and overdraw passes bought. Given an output path it
+// also writes the result as a MeshFile and maps it back to check it:
+//
+//   MeshTool input.obj [output.mesh]
+//
+// Only positions are read, faces with more than three corners are fanned.
+
+namespace {
+	struct ObjMesh {
+		std::vector<float> positions;
+		std::vector<uint32_t> indices;
+	};
+
+	// Parses the position index of one "v", "v/t", "v//n" or "v/t/n" corner.
+	// Negative indices count back from the last position read.
+	bool ParseCorner(const char* token, size_t positionCount, uint32_t& index){
+		char* end = nullptr;
+		long value = strtol(token, &end, 10);
+		if(end == token || value == 0){
+			return false;
+		}
+		long resolved = value > 0 ? value - 1 : static_cast<long>(positionCount) + value;
+		if(resolved < 0 || static_cast<size_t>(resolved) >= positionCount){
+			return false;
+		}
+		index = static_cast<uint32_t>(resolved);
+		return true;
+	}
+
+	bool LoadObj(const char* path, ObjMesh& mesh){
+		FILE* file = fopen(path, "r");
+		if(!file){
+			printf("Can't open %s\n", path);
+			return false;
+		}
+
+		char line[1024];
+		int lineNumber = 0;
+		std::vector<uint32_t> face;
+		while(fgets(line, sizeof(line), file)){
+			lineNumber++;
+			if(line[0] == 'v' && line[1] == ' '){
+				float x, y, z;
+				if(sscanf(line + 2, "%f %f %f", &x, &y, &z) != 3){
+					printf("%s:%d: bad vertex\n", path, lineNumber);
+					fclose(file);
+					return false;
+				}
+				mesh.positions.push_back(x);
+				mesh.positions.push_back(y);
+				mesh.positions.push_back(z);
+			}else if(line[0] == 'f' && line[1] == ' '){
+				face.clear();
+				const size_t positionCount = mesh.positions.size() / 3;
+				for(char* token = strtok(line + 2, " \t\r\n"); token; token = strtok(nullptr, " \t\r\n")){
+					uint32_t index;
+					if(!ParseCorner(token, positionCount, index)){
+						printf("%s:%d: bad face corner %s\n", path, lineNumber, token);
+						fclose(file);
+						return false;
+					}
+					face.push_back(index);
+				}
+				for(size_t k = 2; k < face.size(); k++){
+					mesh.indices.push_back(face[0]);
+					mesh.indices.push_back(face[k - 1]);
+					mesh.indices.push_back(face[k]);
+				}
+			}
+		}
+		fclose(file);
+
+		if(mesh.indices.empty()){
+			printf("%s has no faces\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	void PrintStats(const char* label, const VertexCacheStats& cache, const OverdrawStats& overdraw, size_t vertexCount){
+		printf("%-8s ACMR %6.3f  ATVR %6.3f  overdraw %6.3f  vertices %zu\n", label, cache.acmr, cache.atvr, overdraw.overdraw, vertexCount);
+	}
+
+	// Writes float3 positions and the optimized indices, then opens the file
+	// the way the streamer does and compares the streams with what went in.
+	bool WriteMesh(const char* path, const std::vector<uint8_t>& vertices, size_t vertexCount, const std::vector<uint32_t>& indices){
+		MeshFileDesc desc;
+		desc.vertices = vertices.data();
+		desc.vertexCount = static_cast<uint32_t>(vertexCount);
+		desc.format.ComputeLayout();
+		desc.indices = indices.data();
+		desc.indexCount = static_cast<uint32_t>(indices.size());
+		desc.positions = reinterpret_cast<const float*>(vertices.data());
+		if(!WriteMeshFile(path, desc)){
+			printf("Can't write %s\n", path);
+			return false;
+		}
+
+		MeshFile mesh;
+		if(!mesh.Open(path)){
+			printf("%s doesn't validate\n", path);
+			return false;
+		}
+		const std::vector<uint8_t> packed = PackIndices(indices.data(), indices.size(), ChooseIndexFormat(vertexCount));
+		if(mesh.GetVertexDataSize() != vertices.size() || memcmp(mesh.GetVertexData(), vertices.data(), vertices.size()) != 0
+			|| mesh.GetIndexDataSize() != packed.size() || memcmp(mesh.GetIndexData(), packed.data(), packed.size()) != 0){
+			printf("%s doesn't match the optimized mesh\n", path);
+			return false;
+		}
+		printf("wrote    %s, %llu bytes\n", path, static_cast<unsigned long long>(mesh.GetHeader().fileSize));
+		return true;
+	}
+}
+
+int main(int argc, char** argv){
+	if(argc < 2){
+		printf("Usage: MeshTool input.obj [output.mesh]\n");
+		return 1;
+	}
+
+	ObjMesh mesh;
+	if(!LoadObj(argv[1], mesh)){
+		return 1;
+	}
+
+	const size_t vertexSize = sizeof(float) * 3;
+	const size_t vertexCount = mesh.positions.size() / 3;
+	printf("%s: %zu triangles, %zu vertices\n", argv[1], mesh.indices.size() / 3, vertexCount);
+
+	const OverdrawStats overdrawBefore = AnalyzeOverdraw(mesh.indices.data(), mesh.indices.size(), mesh.positions.data(), vertexCount, vertexSize);
+
+	std::vector<uint8_t> vertices(mesh.positions.size() * sizeof(float));
+	memcpy(vertices.data(), mesh.positions.data(), vertices.size());
+	const MeshOptimizationReport report = OptimizeMesh(vertices, vertexSize, 0, mesh.indices);
+
+	const OverdrawStats overdrawAfter = AnalyzeOverdraw(mesh.indices.data(), mesh.indices.size(),
+		reinterpret_cast<const float*>(vertices.data()), report.vertexCountAfter, vertexSize);
+
+	PrintStats("before", report.before, overdrawBefore, report.vertexCountBefore);
+	PrintStats("after", report.after, overdrawAfter, report.vertexCountAfter);
+	printf("indices  %s\n", report.indexFormat == IndexFormat::UInt16 ? "16 bit" : "32 bit");
+
+	if(argc > 2 && !WriteMesh(argv[2], vertices, report.vertexCountAfter, mesh.indices)){
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,128 @@
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "TextureCompressor.h"
+#include "TextureFile.h"
+
+// Offline texture cooking. Loads a TGA, block compresses it with the full
+// mip chain and writes a TextureFile, then maps it back to check it:
+//
+//   TextureTool input.tga output.btex [bc1|bc3|bc4|bc5|bc7] [fast|normal|high]
+//
+// Defaults to BC3 at normal quality. Only uncompressed 24 and 32 bit TGAs
+// are read, which is what every paint package can save.
+
+namespace {
+	struct Image {
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> rgba;
+	};
+
+	bool LoadTga(const char* path, Image& image){
+		FILE* file = fopen(path, "rb");
+		if(!file){
+			printf("Can't open %s\n", path);
+			return false;
+		}
+
+		uint8_t header[18];
+		bool valid = fread(header, 1, sizeof(header), file) == sizeof(header);
+		const uint32_t bitsPerPixel = header[16];
+		// Image type 2 is uncompressed true color, no color map.
+		valid = valid && header[1] == 0 && header[2] == 2 && (bitsPerPixel == 24 || bitsPerPixel == 32);
+		valid = valid && fseek(file, header[0], SEEK_CUR) == 0;
+		if(!valid){
+			printf("%s is not an uncompressed 24 or 32 bit TGA\n", path);
+			fclose(file);
+			return false;
+		}
+
+		image.width = header[12] | (header[13] << 8);
+		image.height = header[14] | (header[15] << 8);
+		const uint32_t pixelBytes = bitsPerPixel / 8;
+		const bool topDown = (header[17] & 0x20) != 0;
+		std::vector<uint8_t> row(size_t(image.width) * pixelBytes);
+		image.rgba.resize(size_t(image.width) * image.height * 4);
+		for(uint32_t y = 0; y < image.height && valid; y++){
+			valid = fread(row.data(), 1, row.size(), file) == row.size();
+			uint8_t* out = image.rgba.data() + size_t(topDown ? y : image.height - 1 - y) * image.width * 4;
+			for(uint32_t x = 0; x < image.width && valid; x++){
+				// Stored BGR(A).
+				const uint8_t* in = row.data() + size_t(x) * pixelBytes;
+				out[x * 4 + 0] = in[2];
+				out[x * 4 + 1] = in[1];
+				out[x * 4 + 2] = in[0];
+				out[x * 4 + 3] = pixelBytes == 4 ? in[3] : 255;
+			}
+		}
+		fclose(file);
+
+		if(!valid || image.width == 0 || image.height == 0){
+			printf("%s is truncated\n", path);
+			return false;
+		}
+		return true;
+	}
+
+	bool ParseFormat(const char* name, BcFormat& format){
+		const char* names[] = { "bc1", "bc3", "bc4", "bc5", "bc7" };
+		const BcFormat formats[] = { BcFormat::BC1, BcFormat::BC3, BcFormat::BC4, BcFormat::BC5, BcFormat::BC7 };
+		for(int i = 0; i < 5; i++){
+			if(strcmp(name, names[i]) == 0){
+				format = formats[i];
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ParseQuality(const char* name, CompressionQuality& quality){
+		const char* names[] = { "fast", "normal", "high" };
+		const CompressionQuality qualities[] = { CompressionQuality::Fast, CompressionQuality::Normal, CompressionQuality::High };
+		for(int i = 0; i < 3; i++){
+			if(strcmp(name, names[i]) == 0){
+				quality = qualities[i];
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+int main(int argc, char** argv){
+	BcFormat format = BcFormat::BC3;
+	CompressionQuality quality = CompressionQuality::Normal;
+	if(argc < 3 || (argc > 3 && !ParseFormat(argv[3], format)) || (argc > 4 && !ParseQuality(argv[4], quality))){
+		printf("Usage: TextureTool input.tga output.btex [bc1|bc3|bc4|bc5|bc7] [fast|normal|high]\n");
+		return 1;
+	}
+
+	Image image;
+	if(!LoadTga(argv[1], image)){
+		return 1;
+	}
+
+	CompressedTexture texture;
+	TextureCookReport report;
+	if(!CompressTexture(image.rgba.data(), image.width, image.height, image.width * 4, format, quality, true, texture, &report)){
+		printf("Can't compress %s\n", argv[1]);
+		return 1;
+	}
+	printf("%s: %ux%u, %zu mips, %.1f ms, %.1f MP/s, PSNR %.2f dB, %zu -> %zu bytes\n", argv[1], image.width, image.height,
+		texture.mips.size(), report.seconds * 1e3, report.megapixelsPerSecond, report.psnr, report.uncompressedBytes, report.compressedBytes);
+
+	if(!WriteTextureFile(argv[2], texture)){
+		printf("Can't write %s\n", argv[2]);
+		return 1;
+	}
+	TextureFile file;
+	if(!file.Open(argv[2]) || file.GetMipCount() != texture.mips.size()){
+		printf("%s doesn't validate\n", argv[2]);
+		return 1;
+	}
+	printf("wrote %s, %llu bytes\n", argv[2], static_cast<unsigned long long>(file.GetHeader().fileSize));
+	return 0;
+}
@@ -0,0 +1,285 @@
+#include "TransformHierarchy.h"
+
+#include <atomic>
+#include <cassert>
+
+#include "JobSystem.h"
+
+namespace {
+	// Below this many dirty nodes the update stays on the calling thread.
+	const uint32_t kParallelThreshold = 4096;
+	// Matrices multiplied per MultiplyMatrices call.
+	const uint32_t kBatchSize = 64;
+}
+
+TransformHierarchy::TransformHierarchy() :mStructureChanged(false), mLastUpdatedCount(0) {
+
+}
+
+TransformHierarchy::~TransformHierarchy() {
+
+}
+
+TransformHierarchy::Handle TransformHierarchy::Create(Handle parent){
+	Handle handle;
+	if(!mFreeHandles.empty()){
+		handle = mFreeHandles.back();
+		mFreeHandles.pop_back();
+	}else{
+		handle = static_cast<Handle>(mIndexOf.size());
+		mIndexOf.push_back(kInvalidIndex);
+	}
+
+	// Appending keeps parents ahead of children, Rebuild restores the
+	// per-root ranges on the next Update.
+	uint32_t index = static_cast<uint32_t>(mLocal.size());
+	const Float4x4 identity = Float4x4::Identity();
+	mLocal.push_back(identity);
+	mWorld.push_back(identity);
+	mParent.push_back(parent == kInvalidHandle ? kInvalidIndex : mIndexOf[parent]);
+	mDirty.push_back(1);
+	mRemoved.push_back(0);
+	mHandleOf.push_back(handle);
+	mRangeOf.push_back(kInvalidIndex);
+	mIndexOf[handle] = index;
+
+	mStructureChanged = true;
+	return handle;
+}
+
+void TransformHierarchy::Destroy(Handle handle){
+	assert(handle < mIndexOf.size() && mIndexOf[handle] != kInvalidIndex);
+	mRemoved[mIndexOf[handle]] = 1;
+	mStructureChanged = true;
+}
+
+bool TransformHierarchy::SetParent(Handle handle, Handle parent){
+	uint32_t index = mIndexOf[handle];
+	uint32_t parentIndex = parent == kInvalidHandle ? kInvalidIndex : mIndexOf[parent];
+
+	// Refuse to create a cycle.
+	for(uint32_t ancestor = parentIndex; ancestor != kInvalidIndex; ancestor = mParent[ancestor]){
+		if(ancestor == index){
+			return false;
+		}
+	}
+
+	mParent[index] = parentIndex;
+	mDirty[index] = 1;
+	mStructureChanged = true;
+	return true;
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index){
+	mDirty[index] = 1;
+	if(mRangeOf[index] != kInvalidIndex){
+		mRangeDirty[mRangeOf[index]] = 1;
+	}
+}
+
+void TransformHierarchy::SetLocal(Handle handle, const Float4x4& local){
+	uint32_t index = mIndexOf[handle];
+	mLocal[index] = local;
+	MarkDirty(index);
+}
+
+const Float4x4& TransformHierarchy::GetLocal(Handle handle) const {
+	return mLocal[mIndexOf[handle]];
+}
+
+const Float4x4& TransformHierarchy::GetWorld(Handle handle) const {
+	return mWorld[mIndexOf[handle]];
+}
+
+void TransformHierarchy::Rebuild(){
+	const uint32_t count = static_cast<uint32_t>(mLocal.size());
+
+	// Children of every node in compressed rows, in their current order.
+	std::vector<uint32_t> childStart(count + 1, 0);
+	for(uint32_t i = 0; i < count; i++){
+		if(mParent[i] != kInvalidIndex){
+			childStart[mParent[i] + 1]++;
+		}
+	}
+	for(uint32_t i = 0; i < count; i++){
+		childStart[i + 1] += childStart[i];
+	}
+	std::vector<uint32_t> children(childStart[count]);
+	std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+	for(uint32_t i = 0; i < count; i++){
+		if(mParent[i] != kInvalidIndex){
+			children[fill[mParent[i]]++] = i;
+		}
+	}
+
+	// Depth-first walk from each root. Removed nodes and everything under
+	// them are never reached, which is how subtrees get destroyed.
+	std::vector<uint32_t> order;
+	order.reserve(count);
+	std::vector<uint32_t> stack;
+	mRangeBegin.clear();
+	mRangeEnd.clear();
+	for(uint32_t root = 0; root < count; root++){
+		if(mParent[root] != kInvalidIndex || mRemoved[root]){
+			continue;
+		}
+
+		mRangeBegin.push_back(static_cast<uint32_t>(order.size()));
+		stack.push_back(root);
+		while(!stack.empty()){
+			uint32_t node = stack.back();
+			stack.pop_back();
+			order.push_back(node);
+			// Reverse push keeps siblings in their original order.
+			for(uint32_t c = childStart[node + 1]; c > childStart[node]; c--){
+				uint32_t child = children[c - 1];
+				if(!mRemoved[child]){
+					stack.push_back(child);
+				}
+			}
+		}
+		mRangeEnd.push_back(static_cast<uint32_t>(order.size()));
+	}
+
+	std::vector<uint32_t> newIndex(count, kInvalidIndex);
+	for(uint32_t i = 0; i < order.size(); i++){
+		newIndex[order[i]] = i;
+	}
+
+	// Free the handles of everything that was not reached.
+	for(uint32_t i = 0; i < count; i++){
+		if(newIndex[i] == kInvalidIndex){
+			mIndexOf[mHandleOf[i]] = kInvalidIndex;
+			mFreeHandles.push_back(mHandleOf[i]);
+		}
+	}
+
+	const uint32_t newCount = static_cast<uint32_t>(order.size());
+	std::vector<Float4x4> local(newCount);
+	std::vector<Float4x4> world(newCount);
+	std::vector<uint32_t> parent(newCount);
+	std::vector<uint8_t> dirty(newCount);
+	std::vector<Handle> handleOf(newCount);
+	for(uint32_t i = 0; i < newCount; i++){
+		uint32_t old = order[i];
+		local[i] = mLocal[old];
+		world[i] = mWorld[old];
+		parent[i] = mParent[old] == kInvalidIndex ? kInvalidIndex : newIndex[mParent[old]];
+		dirty[i] = mDirty[old];
+		handleOf[i] = mHandleOf[old];
+		mIndexOf[handleOf[i]] = i;
+	}
+
+	mLocal.swap(local);
+	mWorld.swap(world);
+	mParent.swap(parent);
+	mDirty.swap(dirty);
+	mHandleOf.swap(handleOf);
+	mRemoved.assign(newCount, 0);
+
+	mRangeOf.assign(newCount, 0);
+	mRangeDirty.assign(mRangeBegin.size(), 0);
+	for(uint32_t range = 0; range < mRangeBegin.size(); range++){
+		for(uint32_t i = mRangeBegin[range]; i < mRangeEnd[range]; i++){
+			mRangeOf[i] = range;
+			mRangeDirty[range] |= mDirty[i];
+		}
+	}
+
+	mStructureChanged = false;
+}
+
+uint32_t TransformHierarchy::UpdateRange(uint32_t range){
+	const uint32_t begin = mRangeBegin[range];
+	const uint32_t end = mRangeEnd[range];
+	uint32_t updated = 0;
+
+	// Dirty nodes are multiplied kBatchSize at a time. A node whose parent
+	// is still waiting in the batch needs that result first and flushes it,
+	// siblings under an already computed parent go through together.
+	Float4x4 locals[kBatchSize];
+	Float4x4 parents[kBatchSize];
+	uint32_t nodes[kBatchSize];
+	uint32_t pending = 0;
+	auto flush = [&]{
+		MultiplyMatrices(locals, parents, locals, pending);
+		for(uint32_t n = 0; n < pending; n++){
+			mWorld[nodes[n]] = locals[n];
+		}
+		updated += pending;
+		pending = 0;
+	};
+
+	// Parents come first, so one forward pass pushes dirtiness down the tree.
+	for(uint32_t i = begin; i < end; i++){
+		uint32_t parent = mParent[i];
+		if(parent != kInvalidIndex && mDirty[parent]){
+			mDirty[i] = 1;
+		}
+		if(!mDirty[i]){
+			continue;
+		}
+
+		if(parent == kInvalidIndex){
+			mWorld[i] = mLocal[i];
+			updated++;
+			continue;
+		}
+
+		if(pending > 0 && parent >= nodes[0]){
+			flush();
+		}
+		locals[pending] = mLocal[i];
+		parents[pending] = mWorld[parent];
+		nodes[pending] = i;
+		if(++pending == kBatchSize){
+			flush();
+		}
+	}
+	if(pending > 0){
+		flush();
+	}
+
+	for(uint32_t i = begin; i < end; i++){
+		mDirty[i] = 0;
+	}
+	mRangeDirty[range] = 0;
+
+	return updated;
+}
+
+void TransformHierarchy::Update(){
+	if(mStructureChanged){
+		Rebuild();
+	}
+
+	// Untouched subtrees are skipped without looking at their nodes.
+	std::vector<uint32_t> dirtyRanges;
+	uint32_t dirtyNodes = 0;
+	for(uint32_t range = 0; range < mRangeDirty.size(); range++){
+		if(mRangeDirty[range]){
+			dirtyRanges.push_back(range);
+			dirtyNodes += mRangeEnd[range] - mRangeBegin[range];
+		}
+	}
+
+	if(dirtyNodes < kParallelThreshold || dirtyRanges.size() < 2){
+		uint32_t updated = 0;
+		for(uint32_t range : dirtyRanges){
+			updated += UpdateRange(range);
+		}
+		mLastUpdatedCount = updated;
+		return;
+	}
+
+	// Subtrees never share nodes, so they can be updated independently.
+	std::atomic<uint32_t> updated(0);
+	JobSystem::GetInstance()->ParallelFor(static_cast<uint32_t>(dirtyRanges.size()), 16, [&](uint32_t begin, uint32_t end){
+		uint32_t local = 0;
+		for(uint32_t i = begin; i < end; i++){
+			local += UpdateRange(dirtyRanges[i]);
+		}
+		updated.fetch_add(local, std::memory_order_relaxed);
+	});
+	mLastUpdatedCount = updated.load();
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "MathBatch.h"
+
+// Scene transforms stored as flat arrays. Nodes are kept in depth-first
+// order, one contiguous range per root, so parents always come before their
+// children and each root's subtree can be updated on its own thread.
+// World matrices are only recomputed for subtrees that had a local change.
+class TransformHierarchy {
+public:
+	// Stable id of a node, dense indices move around when the tree changes.
+	typedef uint32_t Handle;
+	static constexpr Handle kInvalidHandle = 0xFFFFFFFF;
+
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	Handle Create(Handle parent = kInvalidHandle);
+	// Removes the node and its whole subtree on the next Update.
+	void Destroy(Handle handle);
+	// Returns false when the new parent is inside the node's own subtree.
+	bool SetParent(Handle handle, Handle parent);
+
+	void SetLocal(Handle handle, const Float4x4& local);
+	const Float4x4& GetLocal(Handle handle) const;
+	// Valid after Update.
+	const Float4x4& GetWorld(Handle handle) const;
+
+	// Applies pending structural changes and recomputes dirty world matrices.
+	void Update();
+
+	inline uint32_t GetNodeCount() const { return static_cast<uint32_t>(mLocal.size()); }
+	// Number of world matrices recomputed by the last Update.
+	inline uint32_t GetLastUpdatedCount() const { return mLastUpdatedCount; }
+
+private:
+	void Rebuild();
+	uint32_t UpdateRange(uint32_t range);
+	void MarkDirty(uint32_t index);
+
+private:
+	static constexpr uint32_t kInvalidIndex = 0xFFFFFFFF;
+
+	// Indexed by dense position.
+	std::vector<Float4x4> mLocal;
+	std::vector<Float4x4> mWorld;
+	std::vector<uint32_t> mParent;
+	std::vector<uint8_t> mDirty;
+	std::vector<uint8_t> mRemoved;
+	std::vector<Handle> mHandleOf;
+	// Root subtree each node belongs to, and the [begin, end) of each subtree.
+	std::vector<uint32_t> mRangeOf;
+	std::vector<uint32_t> mRangeBegin;
+	std::vector<uint32_t> mRangeEnd;
+	std::vector<uint8_t> mRangeDirty;
+
+	// Indexed by handle.
+	std::vector<uint32_t> mIndexOf;
+	std::vector<Handle> mFreeHandles;
+
+	bool mStructureChanged;
+	uint32_t mLastUpdatedCount;
+};
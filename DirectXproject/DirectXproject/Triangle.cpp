@@ -1,12 +1,12 @@
-#include "Triangle.h"
-
-#include "DirectXAPI.h"
-
-Triangle::Triangle()
-{
-}
-
-
-Triangle::~Triangle()
-{
-}
+#include "Triangle.h"
+
+#include "DirectXAPI.h"
+
+Triangle::Triangle()
+{
+}
+
+
+Triangle::~Triangle()
+{
+}
@@ -1,7 +1,7 @@
-#pragma once
-class Triangle {
-public:
-	Triangle();
-	~Triangle();
-};
-
+#pragma once
+class Triangle {
+public:
+	Triangle();
+	~Triangle();
+};
+
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Lock-free handoff of whole values from one writer thread to one reader
+// thread. The writer fills its back slot and publishes it, the reader takes
+// the newest published slot. Neither side ever waits on the other, a value
+// the reader did not get to in time is simply replaced by the next one.
+//
+// Three slots: back belongs to the writer, front to the reader, middle holds
+// the last published value. Publish and Acquire each swap their slot with
+// the middle in one atomic exchange, a flag on the middle index tells the
+// reader whether it is newer than what it already has. Only a reader that
+// ran out of values sleeps, on a condition variable the writer takes the
+// mutex for only while someone is waiting.
+template<typename T>
+class TripleBuffer {
+public:
+	TripleBuffer() : mBack(0), mFront(2), mMiddle(1), mWaiting(false) {}
+
+	// Writer side. The slot keeps whatever it held last time it was written,
+	// so containers in T can be refilled without allocating.
+	inline T& GetWriteSlot() { return mSlots[mBack]; }
+
+	// Hands the write slot to the reader and wakes it if it is waiting.
+	// Returns true when the previous value was never acquired.
+	bool Publish(){
+		// Sequentially consistent with the reader's flag and check in
+		// WaitForPublish, one of the two always sees the other.
+		uint32_t previous = mMiddle.exchange(mBack | kFresh);
+		mBack = previous & kIndexMask;
+		if(mWaiting.load()){
+			// The reader holds the mutex from its check until it sleeps,
+			// taking it here means the notify can't slip in between.
+			std::lock_guard<std::mutex> lock(mWakeMutex);
+			mWake.notify_one();
+		}
+		return (previous & kFresh) != 0;
+	}
+
+	// Reader side. Moves the newest published value to the front, returns
+	// false and keeps the current front when nothing new was published.
+	bool Acquire(){
+		if((mMiddle.load(std::memory_order_relaxed) & kFresh) == 0){
+			return false;
+		}
+		mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+
+	// Blocks until something newer than the front has been published.
+	void WaitForPublish(){
+		if((mMiddle.load(std::memory_order_relaxed) & kFresh) != 0){
+			return;
+		}
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWaiting.store(true);
+		while((mMiddle.load() & kFresh) == 0){
+			mWake.wait(lock);
+		}
+		mWaiting.store(false, std::memory_order_relaxed);
+	}
+
+	inline const T& GetReadSlot() const { return mSlots[mFront]; }
+
+private:
+	static const uint32_t kFresh = 4;
+	static const uint32_t kIndexMask = 3;
+
+	T mSlots[3];
+	// Only touched by the writer and the reader respectively.
+	uint32_t mBack;
+	uint32_t mFront;
+	// Kept off the slots' cache lines, both threads hammer it.
+	alignas(64) std::atomic<uint32_t> mMiddle;
+	// Set while the reader sleeps on mWake.
+	std::atomic<bool> mWaiting;
+	std::mutex mWakeMutex;
+	std::condition_variable mWake;
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer& operator=(const TripleBuffer&) = delete;
+};
@@ -0,0 +1,561 @@
+#include "VertexFormat.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+	uint32_t PositionSize(PositionEncoding encoding){
+		switch(encoding){
+			case PositionEncoding::Float32: return 12;
+			// Four halves or unorms, w is written as 1.
+			case PositionEncoding::Half: return 8;
+			case PositionEncoding::Unorm16: return 8;
+		}
+		return 0;
+	}
+
+	uint32_t DirectionSize(NormalEncoding encoding, bool tangent){
+		switch(encoding){
+			case NormalEncoding::None: return 0;
+			case NormalEncoding::Float32: return tangent ? 16 : 12;
+			case NormalEncoding::Oct16: return tangent ? 8 : 4;
+			case NormalEncoding::Oct8: return 4;
+		}
+		return 0;
+	}
+
+	uint32_t ColorSize(ColorEncoding encoding){
+		switch(encoding){
+			case ColorEncoding::None: return 0;
+			case ColorEncoding::Float32: return 16;
+			case ColorEncoding::Unorm8: return 4;
+		}
+		return 0;
+	}
+
+	uint32_t UvSize(UvEncoding encoding){
+		switch(encoding){
+			case UvEncoding::None: return 0;
+			case UvEncoding::Float32: return 8;
+			case UvEncoding::Half: return 4;
+			case UvEncoding::Unorm16: return 4;
+		}
+		return 0;
+	}
+
+	float Clamp(float value, float low, float high){
+		return std::min(high, std::max(low, value));
+	}
+
+	uint16_t ToUnorm16(float value){
+		return static_cast<uint16_t>(Clamp(value, 0.0f, 1.0f) * 65535.0f + 0.5f);
+	}
+
+	int16_t ToSnorm16(float value){
+		return static_cast<int16_t>(std::lround(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	int8_t ToSnorm8(float value){
+		return static_cast<int8_t>(std::lround(Clamp(value, -1.0f, 1.0f) * 127.0f));
+	}
+
+	float FromSnorm16(int16_t value){
+		return std::max(value / 32767.0f, -1.0f);
+	}
+
+	float FromSnorm8(int8_t value){
+		return std::max(value / 127.0f, -1.0f);
+	}
+
+	void EncodeDirection(const float* direction, float handedness, NormalEncoding encoding, bool tangent, uint8_t* out){
+		switch(encoding){
+			case NormalEncoding::None:
+				break;
+			case NormalEncoding::Float32:{
+				float values[4] = { direction[0], direction[1], direction[2], handedness };
+				memcpy(out, values, tangent ? 16 : 12);
+				break;
+			}
+			case NormalEncoding::Oct16:{
+				float oct[2];
+				EncodeOctahedral(direction, oct);
+				int16_t values[4] = { ToSnorm16(oct[0]), ToSnorm16(oct[1]), ToSnorm16(handedness), 0 };
+				memcpy(out, values, tangent ? 8 : 4);
+				break;
+			}
+			case NormalEncoding::Oct8:{
+				float oct[2];
+				EncodeOctahedral(direction, oct);
+				int8_t values[4] = { ToSnorm8(oct[0]), ToSnorm8(oct[1]), tangent ? ToSnorm8(handedness) : int8_t(0), 0 };
+				memcpy(out, values, 4);
+				break;
+			}
+		}
+	}
+
+	void DecodeDirection(const uint8_t* encoded, NormalEncoding encoding, float* direction, float* handedness){
+		switch(encoding){
+			case NormalEncoding::None:
+				break;
+			case NormalEncoding::Float32:{
+				float values[4] = {};
+				memcpy(values, encoded, handedness ? 16 : 12);
+				memcpy(direction, values, sizeof(float) * 3);
+				if(handedness){
+					*handedness = values[3];
+				}
+				break;
+			}
+			case NormalEncoding::Oct16:{
+				int16_t values[4] = {};
+				memcpy(values, encoded, handedness ? 8 : 4);
+				float oct[2] = { FromSnorm16(values[0]), FromSnorm16(values[1]) };
+				DecodeOctahedral(oct, direction);
+				if(handedness){
+					*handedness = values[2] < 0 ? -1.0f : 1.0f;
+				}
+				break;
+			}
+			case NormalEncoding::Oct8:{
+				int8_t values[4];
+				memcpy(values, encoded, 4);
+				float oct[2] = { FromSnorm8(values[0]), FromSnorm8(values[1]) };
+				DecodeOctahedral(oct, direction);
+				if(handedness){
+					*handedness = values[2] < 0 ? -1.0f : 1.0f;
+				}
+				break;
+			}
+		}
+	}
+
+	float AngleDegrees(const float* a, const float* b){
+		float lengthA = sqrtf(a[0] * a[0] + a[1] * a[1] + a[2] * a[2]);
+		float lengthB = sqrtf(b[0] * b[0] + b[1] * b[1] + b[2] * b[2]);
+		if(lengthA == 0.0f || lengthB == 0.0f){
+			return 0.0f;
+		}
+		float cosine = Clamp((a[0] * b[0] + a[1] * b[1] + a[2] * b[2]) / (lengthA * lengthB), -1.0f, 1.0f);
+		return acosf(cosine) * 57.29578f;
+	}
+
+	// Largest decode error of one attribute when the mesh is stored in format.
+	enum class Attribute { Position, Normal, Tangent, Color, Uv };
+
+	float MeasureError(const SourceVertex* vertices, size_t count, const VertexFormat& format, const QuantizationBounds& bounds, Attribute attribute){
+		VertexFormat laidOut = format;
+		laidOut.ComputeLayout();
+		std::vector<uint8_t> encoded = EncodeVertices(vertices, count, laidOut, bounds);
+
+		float maxError = 0.0f;
+		for(size_t i = 0; i < count; i++){
+			SourceVertex decoded;
+			DecodeVertex(encoded.data() + i * laidOut.stride, laidOut, bounds, decoded);
+			const SourceVertex& original = vertices[i];
+
+			float error = 0.0f;
+			switch(attribute){
+				case Attribute::Position:
+					for(int k = 0; k < 3; k++){
+						error = std::max(error, fabsf(decoded.position[k] - original.position[k]));
+					}
+					break;
+				case Attribute::Normal:
+					error = AngleDegrees(decoded.normal, original.normal);
+					break;
+				case Attribute::Tangent:
+					error = AngleDegrees(decoded.tangent, original.tangent);
+					if((decoded.tangent[3] < 0.0f) != (original.tangent[3] < 0.0f)){
+						error = 180.0f;
+					}
+					break;
+				case Attribute::Color:
+					for(int k = 0; k < 4; k++){
+						error = std::max(error, fabsf(decoded.color[k] - original.color[k]));
+					}
+					break;
+				case Attribute::Uv:
+					for(int k = 0; k < 2; k++){
+						error = std::max(error, fabsf(decoded.uv[k] - original.uv[k]));
+					}
+					break;
+			}
+			maxError = std::max(maxError, error);
+		}
+		return maxError;
+	}
+}
+
+void VertexFormat::ComputeLayout(){
+	uint32_t offset = 0;
+	positionOffset = offset;
+	offset += PositionSize(position);
+	normalOffset = offset;
+	offset += DirectionSize(normal, false);
+	tangentOffset = offset;
+	offset += DirectionSize(tangent, true);
+	colorOffset = offset;
+	offset += ColorSize(color);
+	uvOffset = offset;
+	offset += UvSize(uv);
+	stride = offset;
+}
+
+uint16_t FloatToHalf(float value){
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t exponent = (bits >> 23) & 0xFF;
+	uint32_t mantissa = bits & 0x7FFFFF;
+
+	// Infinity and NaN, keeping NaNs quiet.
+	if(exponent == 0xFF){
+		return static_cast<uint16_t>(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	}
+
+	int halfExponent = static_cast<int>(exponent) - 127 + 15;
+	if(halfExponent >= 31){
+		return static_cast<uint16_t>(sign | 0x7C00);
+	}
+
+	// Round to nearest even, on the bits shifted out.
+	if(halfExponent <= 0){
+		if(halfExponent < -10){
+			return static_cast<uint16_t>(sign);
+		}
+		mantissa |= 0x800000;
+		uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if(remainder > halfway || (remainder == halfway && (half & 1))){
+			half++;
+		}
+		return static_cast<uint16_t>(sign | half);
+	}
+
+	uint32_t half = (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1FFF;
+	if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1))){
+		// A carry into the exponent is still the right answer.
+		half++;
+	}
+	return static_cast<uint16_t>(sign | half);
+}
+
+float HalfToFloat(uint16_t value){
+	uint32_t sign = static_cast<uint32_t>(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+
+	uint32_t bits;
+	if(exponent == 0){
+		if(mantissa == 0){
+			bits = sign;
+		}else{
+			// Subnormal half, normalize it.
+			exponent = 127 - 15 + 1;
+			while((mantissa & 0x400) == 0){
+				mantissa <<= 1;
+				exponent--;
+			}
+			mantissa &= 0x3FF;
+			bits = sign | (exponent << 23) | (mantissa << 13);
+		}
+	}else if(exponent == 0x1F){
+		bits = sign | 0x7F800000 | (mantissa << 13);
+	}else{
+		bits = sign | ((exponent - 15 + 127) << 23) | (mantissa << 13);
+	}
+
+	float result;
+	memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+uint32_t PackUnorm8x4(const float value[4]){
+	uint32_t packed = 0;
+	for(int i = 0; i < 4; i++){
+		uint32_t channel = static_cast<uint32_t>(Clamp(value[i], 0.0f, 1.0f) * 255.0f + 0.5f);
+		packed |= channel << (i * 8);
+	}
+	return packed;
+}
+
+void EncodeOctahedral(const float normal[3], float out[2]){
+	float sum = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+	if(sum == 0.0f){
+		out[0] = 0.0f;
+		out[1] = 0.0f;
+		return;
+	}
+
+	float x = normal[0] / sum;
+	float y = normal[1] / sum;
+	// Fold the lower hemisphere over the diagonals.
+	if(normal[2] < 0.0f){
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	out[0] = x;
+	out[1] = y;
+}
+
+void DecodeOctahedral(const float encoded[2], float out[3]){
+	float x = encoded[0];
+	float y = encoded[1];
+	float z = 1.0f - fabsf(x) - fabsf(y);
+	if(z < 0.0f){
+		float unfoldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float unfoldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = unfoldedX;
+		y = unfoldedY;
+	}
+
+	float length = sqrtf(x * x + y * y + z * z);
+	out[0] = x / length;
+	out[1] = y / length;
+	out[2] = z / length;
+}
+
+QuantizationBounds ComputeQuantizationBounds(const SourceVertex* vertices, size_t count){
+	float positionMin[3] = { 0.0f, 0.0f, 0.0f };
+	float positionMax[3] = { 0.0f, 0.0f, 0.0f };
+	float uvMin[2] = { 0.0f, 0.0f };
+	float uvMax[2] = { 0.0f, 0.0f };
+	for(size_t i = 0; i < count; i++){
+		for(int k = 0; k < 3; k++){
+			positionMin[k] = i ? std::min(positionMin[k], vertices[i].position[k]) : vertices[i].position[k];
+			positionMax[k] = i ? std::max(positionMax[k], vertices[i].position[k]) : vertices[i].position[k];
+		}
+		for(int k = 0; k < 2; k++){
+			uvMin[k] = i ? std::min(uvMin[k], vertices[i].uv[k]) : vertices[i].uv[k];
+			uvMax[k] = i ? std::max(uvMax[k], vertices[i].uv[k]) : vertices[i].uv[k];
+		}
+	}
+
+	QuantizationBounds bounds;
+	for(int k = 0; k < 3; k++){
+		bounds.positionOffset[k] = positionMin[k];
+		bounds.positionScale[k] = positionMax[k] > positionMin[k] ? (positionMax[k] - positionMin[k]) : 1.0f;
+	}
+	for(int k = 0; k < 2; k++){
+		bounds.uvOffset[k] = uvMin[k];
+		bounds.uvScale[k] = uvMax[k] > uvMin[k] ? (uvMax[k] - uvMin[k]) : 1.0f;
+	}
+	return bounds;
+}
+
+std::vector<uint8_t> EncodeVertices(const SourceVertex* vertices, size_t count, const VertexFormat& format, const QuantizationBounds& bounds){
+	std::vector<uint8_t> encoded(count * format.stride, 0);
+
+	for(size_t i = 0; i < count; i++){
+		const SourceVertex& vertex = vertices[i];
+		uint8_t* out = encoded.data() + i * format.stride;
+
+		switch(format.position){
+			case PositionEncoding::Float32:
+				memcpy(out + format.positionOffset, vertex.position, 12);
+				break;
+			case PositionEncoding::Half:{
+				uint16_t values[4] = { FloatToHalf(vertex.position[0]), FloatToHalf(vertex.position[1]), FloatToHalf(vertex.position[2]), FloatToHalf(1.0f) };
+				memcpy(out + format.positionOffset, values, 8);
+				break;
+			}
+			case PositionEncoding::Unorm16:{
+				uint16_t values[4];
+				for(int k = 0; k < 3; k++){
+					values[k] = ToUnorm16((vertex.position[k] - bounds.positionOffset[k]) / bounds.positionScale[k]);
+				}
+				values[3] = 0xFFFF;
+				memcpy(out + format.positionOffset, values, 8);
+				break;
+			}
+		}
+
+		EncodeDirection(vertex.normal, 1.0f, format.normal, false, out + format.normalOffset);
+		EncodeDirection(vertex.tangent, vertex.tangent[3], format.tangent, true, out + format.tangentOffset);
+
+		if(format.color == ColorEncoding::Float32){
+			memcpy(out + format.colorOffset, vertex.color, 16);
+		}else if(format.color == ColorEncoding::Unorm8){
+			uint32_t packed = PackUnorm8x4(vertex.color);
+			memcpy(out + format.colorOffset, &packed, 4);
+		}
+
+		if(format.uv == UvEncoding::Float32){
+			memcpy(out + format.uvOffset, vertex.uv, 8);
+		}else if(format.uv == UvEncoding::Half){
+			uint16_t values[2] = { FloatToHalf(vertex.uv[0]), FloatToHalf(vertex.uv[1]) };
+			memcpy(out + format.uvOffset, values, 4);
+		}else if(format.uv == UvEncoding::Unorm16){
+			uint16_t values[2];
+			for(int k = 0; k < 2; k++){
+				values[k] = ToUnorm16((vertex.uv[k] - bounds.uvOffset[k]) / bounds.uvScale[k]);
+			}
+			memcpy(out + format.uvOffset, values, 4);
+		}
+	}
+
+	return encoded;
+}
+
+void DecodeVertex(const uint8_t* encoded, const VertexFormat& format, const QuantizationBounds& bounds, SourceVertex& out){
+	memset(&out, 0, sizeof(out));
+
+	switch(format.position){
+		case PositionEncoding::Float32:
+			memcpy(out.position, encoded + format.positionOffset, 12);
+			break;
+		case PositionEncoding::Half:{
+			uint16_t values[4];
+			memcpy(values, encoded + format.positionOffset, 8);
+			for(int k = 0; k < 3; k++){
+				out.position[k] = HalfToFloat(values[k]);
+			}
+			break;
+		}
+		case PositionEncoding::Unorm16:{
+			uint16_t values[4];
+			memcpy(values, encoded + format.positionOffset, 8);
+			for(int k = 0; k < 3; k++){
+				out.position[k] = bounds.positionOffset[k] + (values[k] / 65535.0f) * bounds.positionScale[k];
+			}
+			break;
+		}
+	}
+
+	DecodeDirection(encoded + format.normalOffset, format.normal, out.normal, nullptr);
+	DecodeDirection(encoded + format.tangentOffset, format.tangent, out.tangent, &out.tangent[3]);
+
+	if(format.color == ColorEncoding::Float32){
+		memcpy(out.color, encoded + format.colorOffset, 16);
+	}else if(format.color == ColorEncoding::Unorm8){
+		for(int k = 0; k < 4; k++){
+			out.color[k] = encoded[format.colorOffset + k] / 255.0f;
+		}
+	}
+
+	if(format.uv == UvEncoding::Float32){
+		memcpy(out.uv, encoded + format.uvOffset, 8);
+	}else if(format.uv == UvEncoding::Half){
+		uint16_t values[2];
+		memcpy(values, encoded + format.uvOffset, 4);
+		out.uv[0] = HalfToFloat(values[0]);
+		out.uv[1] = HalfToFloat(values[1]);
+	}else if(format.uv == UvEncoding::Unorm16){
+		uint16_t values[2];
+		memcpy(values, encoded + format.uvOffset, 4);
+		for(int k = 0; k < 2; k++){
+			out.uv[k] = bounds.uvOffset[k] + (values[k] / 65535.0f) * bounds.uvScale[k];
+		}
+	}
+}
+
+VertexFormat ChooseVertexFormat(const SourceVertex* vertices, size_t count, uint32_t attributes, const QuantizationTolerance& tolerance){
+	const QuantizationBounds bounds = ComputeQuantizationBounds(vertices, count);
+	VertexFormat format;
+
+	// Candidates go from smallest to largest, the first one within
+	// tolerance wins. Unorm16 positions and uvs are never picked: they need
+	// the bounds as shader constants, which the shaders do not take, and
+	// they are no smaller than Half.
+	if(attributes & VertexAttributePosition){
+		VertexFormat trial;
+		trial.position = PositionEncoding::Half;
+		if(MeasureError(vertices, count, trial, bounds, Attribute::Position) <= tolerance.position){
+			format.position = PositionEncoding::Half;
+		}
+	}
+
+	if(attributes & VertexAttributeNormal){
+		format.normal = NormalEncoding::Float32;
+		const NormalEncoding candidates[] = { NormalEncoding::Oct8, NormalEncoding::Oct16 };
+		for(NormalEncoding candidate : candidates){
+			VertexFormat trial;
+			trial.normal = candidate;
+			if(MeasureError(vertices, count, trial, bounds, Attribute::Normal) <= tolerance.normalDegrees){
+				format.normal = candidate;
+				break;
+			}
+		}
+	}
+
+	if(attributes & VertexAttributeTangent){
+		format.tangent = NormalEncoding::Float32;
+		const NormalEncoding candidates[] = { NormalEncoding::Oct8, NormalEncoding::Oct16 };
+		for(NormalEncoding candidate : candidates){
+			VertexFormat trial;
+			trial.tangent = candidate;
+			if(MeasureError(vertices, count, trial, bounds, Attribute::Tangent) <= tolerance.normalDegrees){
+				format.tangent = candidate;
+				break;
+			}
+		}
+	}
+
+	if(attributes & VertexAttributeColor){
+		VertexFormat trial;
+		trial.color = ColorEncoding::Unorm8;
+		bool fits = MeasureError(vertices, count, trial, bounds, Attribute::Color) <= tolerance.color;
+		format.color = fits ? ColorEncoding::Unorm8 : ColorEncoding::Float32;
+	}
+
+	if(attributes & VertexAttributeUv){
+		VertexFormat trial;
+		trial.uv = UvEncoding::Half;
+		bool fits = MeasureError(vertices, count, trial, bounds, Attribute::Uv) <= tolerance.uv;
+		format.uv = fits ? UvEncoding::Half : UvEncoding::Float32;
+	}
+
+	format.ComputeLayout();
+	return format;
+}
+
+#if defined(_WIN32)
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetInputLayout(const VertexFormat& format){
+	std::vector<D3D12_INPUT_ELEMENT_DESC> layout;
+	auto add = [&layout](const char* semantic, DXGI_FORMAT dxgiFormat, uint32_t offset){
+		layout.push_back({ semantic, 0, dxgiFormat, 0, offset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 });
+	};
+
+	switch(format.position){
+		case PositionEncoding::Float32: add("POSITION", DXGI_FORMAT_R32G32B32_FLOAT, format.positionOffset); break;
+		case PositionEncoding::Half: add("POSITION", DXGI_FORMAT_R16G16B16A16_FLOAT, format.positionOffset); break;
+		case PositionEncoding::Unorm16: add("POSITION", DXGI_FORMAT_R16G16B16A16_UNORM, format.positionOffset); break;
+	}
+
+	switch(format.normal){
+		case NormalEncoding::None: break;
+		case NormalEncoding::Float32: add("NORMAL", DXGI_FORMAT_R32G32B32_FLOAT, format.normalOffset); break;
+		case NormalEncoding::Oct16: add("NORMAL", DXGI_FORMAT_R16G16_SNORM, format.normalOffset); break;
+		case NormalEncoding::Oct8: add("NORMAL", DXGI_FORMAT_R8G8B8A8_SNORM, format.normalOffset); break;
+	}
+
+	switch(format.tangent){
+		case NormalEncoding::None: break;
+		case NormalEncoding::Float32: add("TANGENT", DXGI_FORMAT_R32G32B32A32_FLOAT, format.tangentOffset); break;
+		case NormalEncoding::Oct16: add("TANGENT", DXGI_FORMAT_R16G16B16A16_SNORM, format.tangentOffset); break;
+		case NormalEncoding::Oct8: add("TANGENT", DXGI_FORMAT_R8G8B8A8_SNORM, format.tangentOffset); break;
+	}
+
+	switch(format.color){
+		case ColorEncoding::None: break;
+		case ColorEncoding::Float32: add("COLOR", DXGI_FORMAT_R32G32B32A32_FLOAT, format.colorOffset); break;
+		case ColorEncoding::Unorm8: add("COLOR", DXGI_FORMAT_R8G8B8A8_UNORM, format.colorOffset); break;
+	}
+
+	switch(format.uv){
+		case UvEncoding::None: break;
+		case UvEncoding::Float32: add("TEXCOORD", DXGI_FORMAT_R32G32_FLOAT, format.uvOffset); break;
+		case UvEncoding::Half: add("TEXCOORD", DXGI_FORMAT_R16G16_FLOAT, format.uvOffset); break;
+		case UvEncoding::Unorm16: add("TEXCOORD", DXGI_FORMAT_R16G16_UNORM, format.uvOffset); break;
+	}
+
+	return layout;
+}
+#endif
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compact vertex encodings and a converter that picks the tightest one that
+// stays inside an error tolerance. Every attribute is padded to 4 bytes so
+// the offsets stay legal for the input assembler.
+
+enum class PositionEncoding { Float32, Half, Unorm16 };
+enum class NormalEncoding { None, Float32, Oct16, Oct8 };
+enum class ColorEncoding { None, Float32, Unorm8 };
+enum class UvEncoding { None, Float32, Half, Unorm16 };
+
+struct VertexFormat {
+	PositionEncoding position = PositionEncoding::Float32;
+	NormalEncoding normal = NormalEncoding::None;
+	// Tangents carry their handedness, stored next to the encoded direction.
+	NormalEncoding tangent = NormalEncoding::None;
+	ColorEncoding color = ColorEncoding::None;
+	UvEncoding uv = UvEncoding::None;
+
+	// Filled by ComputeLayout.
+	uint32_t stride = 0;
+	uint32_t positionOffset = 0;
+	uint32_t normalOffset = 0;
+	uint32_t tangentOffset = 0;
+	uint32_t colorOffset = 0;
+	uint32_t uvOffset = 0;
+
+	void ComputeLayout();
+};
+
+// Full precision vertex as it comes out of the importer.
+struct SourceVertex {
+	float position[3];
+	float normal[3];
+	// xyz direction, w handedness (+1 or -1).
+	float tangent[4];
+	float color[4];
+	float uv[2];
+};
+
+// Which SourceVertex members hold data.
+enum VertexAttributes : uint32_t {
+	VertexAttributePosition = 1 << 0,
+	VertexAttributeNormal = 1 << 1,
+	VertexAttributeTangent = 1 << 2,
+	VertexAttributeColor = 1 << 3,
+	VertexAttributeUv = 1 << 4
+};
+
+// Per-mesh dequantization: value = offset + encoded * scale, for the
+// Unorm16 position and uv encodings. The shader would need these as
+// constants, shader.hlsl does not take them yet.
+struct QuantizationBounds {
+	float positionOffset[3];
+	float positionScale[3];
+	float uvOffset[2];
+	float uvScale[2];
+};
+
+// Largest acceptable error per attribute: object space units for
+// positions, degrees for normals and tangents, absolute for colors and uvs.
+struct QuantizationTolerance {
+	float position = 1e-3f;
+	float normalDegrees = 1.0f;
+	float color = 1.0f / 255.0f;
+	float uv = 1.0f / 4096.0f;
+};
+
+QuantizationBounds ComputeQuantizationBounds(const SourceVertex* vertices, size_t count);
+
+// Tries the encodings of each attribute against the real data and keeps
+// the smallest one within tolerance. Only encodings shader.hlsl can read
+// as is are tried, so never Unorm16.
+VertexFormat ChooseVertexFormat(const SourceVertex* vertices, size_t count, uint32_t attributes,
+	const QuantizationTolerance& tolerance = QuantizationTolerance());
+
+// Writes count vertices in format. bounds must come from ComputeQuantizationBounds.
+std::vector<uint8_t> EncodeVertices(const SourceVertex* vertices, size_t count, const VertexFormat& format, const QuantizationBounds& bounds);
+// Back to full precision, used to measure the error.
+void DecodeVertex(const uint8_t* encoded, const VertexFormat& format, const QuantizationBounds& bounds, SourceVertex& out);
+
+// Building blocks.
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+uint32_t PackUnorm8x4(const float value[4]);
+void EncodeOctahedral(const float normal[3], float out[2]);
+void DecodeOctahedral(const float encoded[2], float out[3]);
+
+#if defined(_WIN32)
+#include <d3d12.h>
+
+// Input layout matching format. Semantic names follow shader.hlsl.
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetInputLayout(const VertexFormat& format);
+#endif
@@ -0,0 +1,160 @@
+// GPU frustum culling. One thread per object, visible objects are appended
+// to the indirect argument buffer consumed by ExecuteIndirect.
+// The structs mirror GpuCulling.h, keep them in sync.
+
+struct ObjectBounds
+{
+	float3 center;
+	float radius;
+};
+
+struct DrawArguments
+{
+	uint vertexCountPerInstance;
+	uint instanceCount;
+	uint startVertexLocation;
+	uint startInstanceLocation;
+};
+
+struct IndirectCommand
+{
+	uint objectIndex;
+	DrawArguments draw;
+};
+
+cbuffer CullConstants : register(b0)
+{
+	float4 planes[6];
+	uint objectCount;
+};
+
+StructuredBuffer<ObjectBounds> bounds : register(t0);
+StructuredBuffer<DrawArguments> drawArgs : register(t1);
+AppendStructuredBuffer<IndirectCommand> visibleCommands : register(u0);
+
+[numthreads(64, 1, 1)]
+void CSMain(uint3 dispatchId : SV_DispatchThreadID)
+{
+	uint index = dispatchId.x;
+	if (index >= objectCount)
+	{
+		return;
+	}
+
+	ObjectBounds sphere = bounds[index];
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, sphere.center) + planes[i].w < -sphere.radius)
+		{
+			return;
+		}
+	}
+
+	IndirectCommand command;
+	command.objectIndex = index;
+	command.draw = drawArgs[index];
+	visibleCommands.Append(command);
+}
+
+// Hi-Z occlusion culling, see HiZCulling.h for the two phases.
+// OcclusionConstants mirrors GpuOcclusionConstants.
+cbuffer OcclusionConstants : register(b1)
+{
+	row_major float4x4 viewProjection;
+	float2 hiZSize;
+	uint hiZMipCount;
+	uint phase;
+};
+
+Texture2D<float> hiZ : register(t2);
+// Per object, 1 when it passed the occlusion test of the first phase.
+RWStructuredBuffer<uint> visibility : register(u1);
+
+bool IsSphereOccluded(float3 center, float radius)
+{
+	if (hiZMipCount == 0)
+	{
+		return false;
+	}
+
+	float2 minXY = 1.0f;
+	float2 maxXY = -1.0f;
+	float minZ = 1.0f;
+	for (uint corner = 0; corner < 8; corner++)
+	{
+		float3 offset = float3((corner & 1) ? radius : -radius, (corner & 2) ? radius : -radius, (corner & 4) ? radius : -radius);
+		float4 clip = mul(float4(center + offset, 1.0f), viewProjection);
+		if (clip.w <= 1e-5f)
+		{
+			return false;
+		}
+
+		float3 ndc = clip.xyz / clip.w;
+		minXY = corner == 0 ? ndc.xy : min(minXY, ndc.xy);
+		maxXY = corner == 0 ? ndc.xy : max(maxXY, ndc.xy);
+		minZ = corner == 0 ? ndc.z : min(minZ, ndc.z);
+	}
+	if (minZ <= 0.0f || any(maxXY < -1.0f) || any(minXY > 1.0f))
+	{
+		return false;
+	}
+
+	// Screen rectangle in level 0 texels, y grows downwards.
+	float left = clamp((minXY.x * 0.5f + 0.5f) * hiZSize.x, 0.0f, hiZSize.x - 1.0f);
+	float right = clamp((maxXY.x * 0.5f + 0.5f) * hiZSize.x, 0.0f, hiZSize.x - 1.0f);
+	float top = clamp((0.5f - maxXY.y * 0.5f) * hiZSize.y, 0.0f, hiZSize.y - 1.0f);
+	float bottom = clamp((0.5f - minXY.y * 0.5f) * hiZSize.y, 0.0f, hiZSize.y - 1.0f);
+
+	// The level where the rectangle spans at most 2x2 texels.
+	float extent = max(max(right - left, bottom - top), 1.0f);
+	uint mip = min((uint)ceil(log2(extent)), hiZMipCount - 1);
+
+	uint2 first = uint2((uint)left, (uint)top) >> mip;
+	uint2 last = uint2((uint)right, (uint)bottom) >> mip;
+
+	float farthest = 0.0f;
+	for (uint y = first.y; y <= last.y; y++)
+	{
+		for (uint x = first.x; x <= last.x; x++)
+		{
+			farthest = max(farthest, hiZ.Load(int3(x, y, mip)));
+		}
+	}
+
+	return minZ > farthest;
+}
+
+[numthreads(64, 1, 1)]
+void CSCullOcclusion(uint3 dispatchId : SV_DispatchThreadID)
+{
+	uint index = dispatchId.x;
+	if (index >= objectCount)
+	{
+		return;
+	}
+	if (phase == 1 && visibility[index] != 0)
+	{
+		return;
+	}
+
+	ObjectBounds sphere = bounds[index];
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, sphere.center) + planes[i].w < -sphere.radius)
+		{
+			// Outside the frustum there is nothing to re-test in phase 1.
+			visibility[index] = 1;
+			return;
+		}
+	}
+
+	bool occluded = IsSphereOccluded(sphere.center, sphere.radius);
+	visibility[index] = occluded ? 0 : 1;
+	if (!occluded)
+	{
+		IndirectCommand command;
+		command.objectIndex = index;
+		command.draw = drawArgs[index];
+		visibleCommands.Append(command);
+	}
+}
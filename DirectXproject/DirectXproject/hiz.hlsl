@@ -0,0 +1,42 @@
+// Builds the Hi-Z pyramid read by CSCullOcclusion in cull.hlsl. One dispatch
+// per level, every texel keeps the farthest of the 2x2 texels below it.
+// BuildHiZPyramid in HiZCulling.cpp is the CPU reference.
+
+cbuffer DownsampleConstants : register(b0)
+{
+	uint2 sourceSize;
+	uint2 destinationSize;
+};
+
+Texture2D<float> depth : register(t0);
+RWTexture2D<float> source : register(u0);
+RWTexture2D<float> destination : register(u1);
+
+// Level 0 reads the depth buffer.
+[numthreads(8, 8, 1)]
+void CSDownsampleDepth(uint3 dispatchId : SV_DispatchThreadID)
+{
+	if (any(dispatchId.xy >= destinationSize))
+	{
+		return;
+	}
+
+	// The odd edge repeats its last texel.
+	uint2 p0 = min(dispatchId.xy * 2, sourceSize - 1);
+	uint2 p1 = min(dispatchId.xy * 2 + 1, sourceSize - 1);
+	destination[dispatchId.xy] = max(max(depth[p0], depth[uint2(p1.x, p0.y)]), max(depth[uint2(p0.x, p1.y)], depth[p1]));
+}
+
+// Every other level reads the one above it.
+[numthreads(8, 8, 1)]
+void CSDownsample(uint3 dispatchId : SV_DispatchThreadID)
+{
+	if (any(dispatchId.xy >= destinationSize))
+	{
+		return;
+	}
+
+	uint2 p0 = min(dispatchId.xy * 2, sourceSize - 1);
+	uint2 p1 = min(dispatchId.xy * 2 + 1, sourceSize - 1);
+	destination[dispatchId.xy] = max(max(source[p0], source[uint2(p1.x, p0.y)]), max(source[uint2(p0.x, p1.y)], source[p1]));
+}
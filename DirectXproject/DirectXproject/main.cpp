@@ -1,25 +1,25 @@
-#include "GameManager.h"
-#include <iostream>
-
-using namespace std;
-
-int main(int argc, char* args[]){
-	GameManager *ptr = new GameManager();
-
-	if(ptr->Initialize() == false){
-		ptr = nullptr;
-		delete ptr;
-		cout << "Game Manager failed to init!" << endl;
-	}
-
-	ptr->Run();
-
-	ptr = nullptr;
-	delete ptr;
-
-	cout << "Program has ended run" << endl;
-
-	cin.get();
-
-	return 0;
+#include "GameManager.h"
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char* args[]){
+	GameManager *ptr = new GameManager();
+
+	if(ptr->Initialize() == false){
+		delete ptr;
+		cout << "Game Manager failed to init!" << endl;
+		cin.get();
+		return 1;
+	}
+
+	ptr->Run();
+
+	delete ptr;
+
+	cout << "Program has ended run" << endl;
+
+	cin.get();
+
+	return 0;
 }
\ No newline at end of file
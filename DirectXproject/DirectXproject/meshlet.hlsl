@@ -0,0 +1,114 @@
+// Meshlet rendering: the amplification shader culls meshlets against the
+// frustum and their normal cone, the mesh shader expands the survivors.
+// Needs shader model 6.5, so it is compiled offline with dxc rather than
+// D3DCompile:
+//   dxc -T as_6_5 -E ASMain meshlet.hlsl -Fo meshlet_as.cso
+//   dxc -T ms_6_5 -E MSMain meshlet.hlsl -Fo meshlet_ms.cso
+//   dxc -T ps_6_5 -E PSMain meshlet.hlsl -Fo meshlet_ps.cso
+// The structs mirror MeshletBuilder.h, keep them in sync.
+
+#define AS_GROUP_SIZE 32
+
+struct Meshlet
+{
+	uint vertexOffset;
+	uint triangleOffset;
+	uint vertexCount;
+	uint triangleCount;
+};
+
+struct MeshletBounds
+{
+	float3 center;
+	float radius;
+	float3 coneAxis;
+	float coneCutoff;
+};
+
+cbuffer MeshletConstants : register(b0)
+{
+	row_major float4x4 viewProjection;
+	float4 planes[6];
+	float3 cameraPosition;
+	uint meshletCount;
+};
+
+StructuredBuffer<float3> positions : register(t0);
+StructuredBuffer<Meshlet> meshlets : register(t1);
+StructuredBuffer<uint> meshletVertices : register(t2);
+StructuredBuffer<uint> meshletTriangles : register(t3);
+StructuredBuffer<MeshletBounds> meshletBounds : register(t4);
+
+struct Payload
+{
+	uint meshletIndices[AS_GROUP_SIZE];
+};
+
+groupshared Payload payload;
+
+bool IsVisible(MeshletBounds bounds)
+{
+	for (uint i = 0; i < 6; i++)
+	{
+		if (dot(planes[i].xyz, bounds.center) + planes[i].w < -bounds.radius)
+		{
+			return false;
+		}
+	}
+
+	float3 view = bounds.center - cameraPosition;
+	return dot(view, bounds.coneAxis) < bounds.coneCutoff * length(view) + bounds.radius;
+}
+
+[numthreads(AS_GROUP_SIZE, 1, 1)]
+void ASMain(uint dispatchId : SV_DispatchThreadID)
+{
+	bool visible = dispatchId < meshletCount && IsVisible(meshletBounds[dispatchId]);
+
+	if (visible)
+	{
+		uint slot = WavePrefixCountBits(visible);
+		payload.meshletIndices[slot] = dispatchId;
+	}
+
+	uint visibleCount = WaveActiveCountBits(visible);
+	DispatchMesh(visibleCount, 1, 1, payload);
+}
+
+struct PSInput
+{
+	float4 position : SV_POSITION;
+	float4 color : COLOR;
+};
+
+[outputtopology("triangle")]
+[numthreads(128, 1, 1)]
+void MSMain(uint threadId : SV_GroupThreadID, uint groupId : SV_GroupID, in payload Payload inPayload,
+	out vertices PSInput outVertices[64], out indices uint3 outTriangles[124])
+{
+	uint meshletIndex = inPayload.meshletIndices[groupId];
+	Meshlet meshlet = meshlets[meshletIndex];
+
+	SetMeshOutputCounts(meshlet.vertexCount, meshlet.triangleCount);
+
+	if (threadId < meshlet.vertexCount)
+	{
+		float3 position = positions[meshletVertices[meshlet.vertexOffset + threadId]];
+		outVertices[threadId].position = mul(float4(position, 1.0f), viewProjection);
+
+		// A color per meshlet makes the clusters visible.
+		uint hash = meshletIndex * 2654435761u;
+		outVertices[threadId].color = float4(float((hash >> 0) & 255), float((hash >> 8) & 255), float((hash >> 16) & 255), 255.0f) / 255.0f;
+	}
+
+	if (threadId < meshlet.triangleCount)
+	{
+		uint packed = meshletTriangles[meshlet.triangleOffset + threadId];
+		outTriangles[threadId] = uint3(packed & 0xFF, (packed >> 8) & 0xFF, (packed >> 16) & 0xFF);
+	}
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+	return input.color;
+}
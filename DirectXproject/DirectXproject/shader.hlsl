@@ -1,20 +1,57 @@
-struct PSInput
-{
-	float4 position : SV_POSITION;
-	float4 color : COLOR;
-};
-
-PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
-{
-	PSInput result;
-
-	result.position = position;
-	result.color = color;
-
-	return result;
-}
-
-float4 PSMain(PSInput input) : SV_TARGET
-{
-	return input.color;
-}
\ No newline at end of file
+struct PSInput
+{
+	float4 position : SV_POSITION;
+	float4 color : COLOR;
+};
+
+// Classic path. Object constants come from a root CBV per draw, frame
+// constants from one root CBV for every draw, see ConstantBufferRing.
+cbuffer ObjectConstants : register(b1)
+{
+	row_major float4x4 modelViewProjection;
+};
+
+cbuffer FrameConstants : register(b2)
+{
+	row_major float4x4 viewProjection;
+};
+
+PSInput VSMain(float4 position : POSITION, float4 color : COLOR)
+{
+	PSInput result;
+
+	result.position = mul(float4(position.xyz, 1.0f), modelViewProjection);
+	result.color = color;
+
+	return result;
+}
+
+float4 PSMain(PSInput input) : SV_TARGET
+{
+	return input.color;
+}
+
+// GPU-driven path. The object index arrives as a root constant written by
+// ExecuteIndirect, see GpuDrivenRenderer and cull.hlsl.
+struct ObjectBounds
+{
+	float3 center;
+	float radius;
+};
+
+cbuffer DrawConstants : register(b0)
+{
+	uint objectIndex;
+};
+
+StructuredBuffer<ObjectBounds> objects : register(t0);
+
+PSInput VSMainIndirect(float4 position : POSITION, float4 color : COLOR)
+{
+	PSInput result;
+
+	result.position = float4(position.xyz + objects[objectIndex].center, position.w);
+	result.color = color;
+
+	return result;
+}